@@ -61,6 +61,18 @@ def func_to_apply_c(x, y, z, field_value_):
 field3.apply_function(func_to_apply_c.address)
 
 
+# ------------ apply vectorized Python function to field ----------
+
+field4 = create_field()
+
+# the function is called once with arrays of node coordinates and field values
+def func_to_apply_vectorized(x, y, z, Ex, Ey, Ez, Bx, By, Bz):
+    factor = np.cos(np.pi/20.0*x)**2
+    return Ex, Ey*factor, Ez, Bx, By, Bz*factor
+
+field4.apply_function_vectorized(func_to_apply_vectorized)
+
+
 # --------------- show -----------------
 
 import matplotlib.pyplot as plt
@@ -79,7 +91,7 @@ def get_fields(field):
 fig = plt.figure()
 
 def plot(field, index, title):
-    ax = fig.add_subplot(1,3,index)
+    ax = fig.add_subplot(1,4,index)
     ax.plot(x, get_fields(field))
     ax.set_xlim((min_coords.x, max_coords.x))
     ax.set_xlabel("$x$")
@@ -89,6 +101,7 @@ def plot(field, index, title):
 plot(field1, 1, "Original field")
 plot(field2, 2, "Applied Python function")
 plot(field3, 3, "Applied pre-compiled function")
+plot(field4, 4, "Applied vectorized function")
 
 fig.tight_layout()
 plt.show()
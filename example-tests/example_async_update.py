@@ -0,0 +1,32 @@
+import sys
+sys.path.append("../bin/")
+import pyHiChi as hichi
+import numpy as np
+
+def value_Ey(x, y, z):
+    return np.cos(z + np.pi/6)
+
+def value_Bx(x, y, z):
+    return -np.cos(z + np.pi/6)
+
+def null_value(x, y, z):
+    return 0.0
+
+grid_size = hichi.Vector3d(8, 8, 64)
+min_coords = hichi.Vector3d(0.0, 0.0, 0.0)
+max_coords = hichi.Vector3d(1.0, 1.0, 2*np.pi)
+grid_step = (max_coords - min_coords) / grid_size
+time_step = 1e-12
+
+field = hichi.YeeField(grid_size, min_coords, grid_step, time_step)
+field.set_E(null_value, value_Ey, null_value)
+field.set_B(value_Bx, null_value, null_value)
+
+z = np.linspace(0, 2*np.pi, 100, endpoint=False)
+coords = np.stack([0.5*np.ones_like(z), 0.5*np.ones_like(z), z], axis=1)
+
+for step in range(10):
+    E = field.get_E(coords)  # (N, 3) array, evaluated before the update starts
+    update = field.update_fields_async()  # step n+1 runs on a worker thread
+    print(step, np.abs(E[:, 1]).max())  # analysis of step n overlaps with the update
+    update.wait()  # any access to the field also waits for the end of the update
@@ -0,0 +1,61 @@
+import sys
+sys.path.append("../bin/")
+import pyHiChi as hichi
+import numpy as np
+from numba import cfunc, types, carray
+
+# batch callbacks compute a field component in an array of points:
+# f(x[], y[], z[], t, result[], size), they are called from C++ without the GIL
+batch_signature = types.void(types.CPointer(types.float64), types.CPointer(types.float64),
+                             types.CPointer(types.float64), types.float64,
+                             types.CPointer(types.float64), types.int32)
+
+@cfunc(batch_signature)
+def null_value(x_, y_, z_, t, res_, size):
+    res = carray(res_, size)
+    for i in range(size):
+        res[i] = 0.0
+
+@cfunc(batch_signature)
+def pulse_value(x_, y_, z_, t, res_, size):
+    x = carray(x_, size)
+    y = carray(y_, size)
+    res = carray(res_, size)
+    for i in range(size):
+        x_arg = x[i] - hichi.c*t
+        res[i] = np.exp(-x_arg**2 - y[i]**2)*np.sin(6*x_arg)
+
+
+# ------- analytical field ---------------
+
+time_step = 0.05/hichi.c
+
+analytical_field = hichi.AnalyticalField(time_step)
+analytical_field.set_E_batch(null_value.address, pulse_value.address, null_value.address)
+analytical_field.set_B_batch(null_value.address, null_value.address, pulse_value.address)
+
+# the values in arrays of points are computed by the batch callbacks
+N = 256
+with hichi.FieldWriter(analytical_field, hichi.Vector3d(-10, -10, 0), hichi.Vector3d(10, 10, 0),
+                       size=hichi.Vector3d(N, N, 1), components=["Ey"],
+                       path="analytical_field", format="npy") as writer:
+    for step in range(10):
+        writer.write(time=step*time_step)
+        analytical_field.update_fields()
+
+print(np.load("analytical_field_Ey.npy").shape)  # (10, N, N)
+
+
+# ------- field generator of the FDTD solver ---------------
+
+grid_size = hichi.Vector3d(64, 32, 32)
+min_coords = hichi.Vector3d(-10, -5, -5)
+max_coords = hichi.Vector3d(10, 5, 5)
+grid_step = (max_coords - min_coords) / grid_size
+
+field = hichi.YeeField(grid_size, min_coords, grid_step, 0.5*grid_step.x/hichi.c)
+field.set_field_generator_batch(hichi.Vector3i(4, 4, 4), hichi.Vector3i(60, 28, 28),
+                                null_value.address, null_value.address, pulse_value.address,
+                                null_value.address, pulse_value.address, null_value.address)
+for step in range(50):
+    field.update_fields()
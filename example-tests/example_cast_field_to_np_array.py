@@ -27,8 +27,7 @@ scalar_field = field.get_Ey_array()
 # makes 3d np.array of Ey field component
 scalar_field_arr = np.array(scalar_field)
 print(scalar_field_arr)
-print(scalar_field_arr.shape)  # shape of scalar field can be not equal to grid_size
-                               # there may be more elements in the last dimension
+print(scalar_field_arr.shape)  # logical shape of scalar field, padding of the storage is skipped by strides
                                
 scalar_field_arr[N//2, N//2, 0] = 10000000.0
 print(field.get_E(0.0, 0.0, 0.0).y)  # demonstrates that scalar_field_arr is the copy of real field
@@ -36,5 +35,9 @@ print(field.get_E(0.0, 0.0, 0.0).y)  # demonstrates that scalar_field_arr is the
 # makes 3d np.array of Ey field component without copying (be careful!)
 scalar_field_arr = np.array(scalar_field, copy=False)
 scalar_field_arr[N//2, N//2, 0] = 10000000.0  # rewrites value in field
+field.mark_fields_changed()  # needed after writing through a view, so that the gathers see the new values
 print(field.get_E(0.0, 0.0, 0.0).y)
 
+# the same view without copying, keeps the field alive while the array is used
+scalar_field_arr = scalar_field.to_numpy()
+print(scalar_field_arr[N//2, N//2, 0])
@@ -33,3 +33,21 @@ for elem in ensemble[hichi.ELECTRON] :
 positron_array = ensemble[hichi.POSITRON]
 print('Position second Positron')
 print(positron_array[1].get_position())
+
+
+# bulk exchange with numpy: positions (N, 3), momenta (N, 3), weights (N,), types (N,)
+import numpy as np
+N = 100000
+positions = np.random.rand(N, 3)
+momenta = np.random.rand(N, 3)*1e-17
+weights = np.full(N, 0.5)
+types = np.random.randint(0, 3, N)
+
+big_ensemble = hichi.Ensemble.from_numpy(positions, momenta, weights, types)
+big_ensemble.extend_numpy(positions, momenta, weights, types)
+print('Count Particles: ', big_ensemble.size())
+
+positions, momenta, weights, types = big_ensemble.to_numpy()  # particles are ordered by type
+electrons = hichi.ParticleArray.from_numpy(positions[types == int(hichi.ELECTRON)],
+                                           momenta[types == int(hichi.ELECTRON)], weights=0.5)
+print('Count Electron: ', electrons.size())
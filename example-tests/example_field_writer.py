@@ -0,0 +1,35 @@
+import sys
+sys.path.append("../bin/")
+import pyHiChi as hichi
+import numpy as np
+
+
+def field_value(x, y, z):
+    return np.exp(-x**2-y**2-z**2)*np.cos(5*x)
+
+def null_value(x, y, z):
+    return 0.0
+
+min_coords = hichi.Vector3d(-5, -5, -5)
+max_coords = hichi.Vector3d(5, 5, 5)
+
+grid_size = hichi.Vector3d(64, 64, 64)
+grid_step = (max_coords - min_coords) / grid_size
+time_step = 0.1/hichi.c
+
+field = hichi.PSATDField(grid_size, min_coords, grid_step, time_step)
+field.set_E(null_value, field_value, null_value)
+field.set_B(null_value, null_value, field_value)
+
+# xy plane (one point along z) is written as a time series to field_xy.npz
+N = 128
+with hichi.FieldWriter(field, hichi.Vector3d(-5, -5, 0), hichi.Vector3d(5, 5, 0),
+                       size=hichi.Vector3d(N, N, 1), components=["Ey", "Bz"],
+                       path="field_xy", format="npz") as writer:
+    for step in range(10):
+        writer.write(time=step*time_step)
+        field.update_fields()
+
+data = np.load("field_xy.npz")
+print(data["Ey"].shape)  # (10, N, N)
+print(data["time"])
@@ -0,0 +1,64 @@
+import sys
+sys.path.append("../bin/")
+import pyHiChi as hichi
+import numpy as np
+import os
+
+
+def field_value(x, y, z):
+    return np.exp(-x**2-y**2-z**2)*np.cos(5*x)
+
+def null_value(x, y, z):
+    return 0.0
+
+min_coords = hichi.Vector3d(-5, -5, -5)
+max_coords = hichi.Vector3d(5, 5, 5)
+
+grid_size = hichi.Vector3d(32, 32, 32)
+grid_step = (max_coords - min_coords) / grid_size
+time_step = 0.1/hichi.c
+
+field = hichi.PSATDField(grid_size, min_coords, grid_step, time_step)
+field.set_E(null_value, field_value, null_value)
+field.set_B(null_value, null_value, field_value)
+
+# the frames written by FieldWriter are read back with numpy
+# and compared with the values of the field in the same points
+N = (16, 8)
+x = -5 + 10.0 / N[0] * np.arange(N[0])
+y = -5 + 10.0 / N[1] * np.arange(N[1])
+
+def expected_frame(get_value):
+    return np.array([[get_value(xi, yi, 0.0) for yi in y] for xi in x])
+
+for format in ["npy", "npz", "raw"]:
+    path = "field_writer_check_" + format
+    expected = {"Ey": [], "Bz": []}
+    with hichi.FieldWriter(field, hichi.Vector3d(-5, -5, 0), hichi.Vector3d(5, 5, 0),
+                           size=hichi.Vector3d(N[0], N[1], 1), components=["Ey", "Bz"],
+                           path=path, format=format) as writer:
+        for step in range(3):
+            writer.write(time=step*time_step)
+            expected["Ey"].append(expected_frame(field.get_Ey))
+            expected["Bz"].append(expected_frame(field.get_Bz))
+            field.update_fields()
+
+    if format == "npz":
+        data = np.load(path + ".npz")
+    elif format == "npy":
+        data = {name: np.load(path + "_" + name + ".npy") for name in ["Ey", "Bz", "time"]}
+    else:
+        dtype = np.load("field_writer_check_npy_Ey.npy").dtype
+        data = {name: np.fromfile(path + "_" + name + ".bin", dtype=dtype) for name in ["Ey", "Bz", "time"]}
+        data["Ey"] = data["Ey"].reshape((3,) + N)
+        data["Bz"] = data["Bz"].reshape((3,) + N)
+
+    for name in ["Ey", "Bz"]:
+        assert data[name].shape == (3,) + N
+        assert np.allclose(data[name], np.array(expected[name]))
+    assert np.allclose(data["time"], time_step*np.arange(3))
+    print(format, "ok")
+
+for name in os.listdir("."):
+    if name.startswith("field_writer_check_"):
+        os.remove(name)
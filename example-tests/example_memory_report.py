@@ -0,0 +1,25 @@
+import sys
+sys.path.append("../bin/")
+import pyHiChi as hichi
+
+grid_size = hichi.Vector3d(64, 64, 64)
+min_coords = hichi.Vector3d(-10, -10, -10)
+max_coords = hichi.Vector3d(10, 10, 10)
+grid_step = (max_coords - min_coords) / grid_size
+time_step = 0.1/hichi.c
+
+field = hichi.PSATDField(grid_size, min_coords, grid_step, time_step)
+field.set_PML(8, 8, 8)
+
+ensemble = hichi.Ensemble()
+for i in range(10000):
+    ensemble.add(hichi.Particle(hichi.Vector3d(0, 0, 0), hichi.Vector3d(0, 0, 0), 1.0,
+                                hichi.ELECTRON))
+
+# live and peak memory of each component in bytes
+for category, stats in hichi.get_memory_report().items():
+    print("%-18s %4d allocations %12d bytes, peak %12d bytes" % (category,
+          stats.num_allocations, stats.allocated_bytes, stats.peak_allocated_bytes))
+
+print("particles: %d bytes" % ensemble.get_memory_usage())
+print("fields: %d bytes" % hichi.get_memory_stats(hichi.MemoryCategory.Fields).allocated_bytes)
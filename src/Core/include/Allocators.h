@@ -1,19 +1,213 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <cstring>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <omp.h>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "MemoryAccounting.h"
 
 namespace pfc {
 
-    // NUMA allocator for ScalarField
+    // alignment of field storage in bytes: a cache line and the widest SIMD vector
+    const size_t fieldAlignment = 64;
+
+    // size of a huge page on x86-64
+    const size_t hugePageSize = 2 * 1024 * 1024;
+
+    /* Page policy for field storage of at least one huge page:
+    Default - the storage is aligned to fieldAlignment;
+    Aligned - the storage is aligned to 2 MB, huge pages are used by the kernel
+        when transparent huge pages are enabled in the "always" mode;
+    Advised - 2 MB alignment and madvise(MADV_HUGEPAGE), for transparent huge pages
+        in the "madvise" mode (Linux only, otherwise the same as Aligned). */
+    enum class HugePagesPolicy { Default, Aligned, Advised };
+
+    // statistics of the live field storage
+    struct FieldAllocationStats {
+        size_t numAllocations = 0;
+        size_t allocatedBytes = 0;
+        size_t peakAllocatedBytes = 0;
+        size_t hugePageBytes = 0;  // bytes allocated with 2 MB alignment
+    };
+
+    // settings and statistics shared by all the field allocators
+    class FieldAllocationRegistry {
+    public:
+
+        static FieldAllocationRegistry& instance() {
+            static FieldAllocationRegistry registry;
+            return registry;
+        }
+
+        HugePagesPolicy getHugePagesPolicy() const {
+            return hugePagesPolicy.load(std::memory_order_relaxed);
+        }
+
+        void setHugePagesPolicy(HugePagesPolicy policy) {
+            hugePagesPolicy.store(policy, std::memory_order_relaxed);
+        }
+
+        FieldAllocationStats getStats() const {
+            FieldAllocationStats stats;
+            stats.numAllocations = numAllocations.load();
+            stats.allocatedBytes = allocatedBytes.load();
+            stats.peakAllocatedBytes = peakAllocatedBytes.load();
+            stats.hugePageBytes = hugePageBytes.load();
+            return stats;
+        }
+
+        /* Field storage is accounted to MemoryCategory::Fields,
+        the owner can move it to another category with setCategory */
+        void registerAllocation(const void* p, size_t bytes, bool isHugePage) {
+            numAllocations++;
+            const size_t current = allocatedBytes += bytes;
+            size_t peak = peakAllocatedBytes.load();
+            while (current > peak && !peakAllocatedBytes.compare_exchange_weak(peak, current));
+            if (isHugePage)
+                hugePageBytes += bytes;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                allocations[p] = Allocation(bytes, MemoryCategory::Fields, isHugePage);
+            }
+            MemoryRegistry::instance().registerAllocation(MemoryCategory::Fields, bytes);
+        }
+
+        void registerDeallocation(const void* p, size_t bytes) {
+            numAllocations--;
+            allocatedBytes -= bytes;
+            MemoryCategory category = MemoryCategory::Fields;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = allocations.find(p);
+                if (it != allocations.end()) {
+                    if (it->second.isHugePage)
+                        hugePageBytes -= bytes;
+                    category = it->second.category;
+                    allocations.erase(it);
+                }
+            }
+            MemoryRegistry::instance().registerDeallocation(category, bytes);
+        }
+
+        // moves the live allocation p to the category
+        void setCategory(const void* p, MemoryCategory category) {
+            MemoryCategory oldCategory;
+            size_t bytes = 0;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = allocations.find(p);
+                if (it == allocations.end() || it->second.category == category)
+                    return;
+                oldCategory = it->second.category;
+                bytes = it->second.bytes;
+                it->second.category = category;
+            }
+            MemoryRegistry::instance().registerDeallocation(oldCategory, bytes);
+            MemoryRegistry::instance().registerAllocation(category, bytes);
+        }
+
+    private:
+
+        struct Allocation {
+            size_t bytes;
+            MemoryCategory category;
+            bool isHugePage;
+            Allocation() : bytes(0), category(MemoryCategory::Fields), isHugePage(false) {}
+            Allocation(size_t bytes, MemoryCategory category, bool isHugePage) :
+                bytes(bytes), category(category), isHugePage(isHugePage) {}
+        };
+
+        FieldAllocationRegistry() : hugePagesPolicy(HugePagesPolicy::Default),
+            numAllocations(0), allocatedBytes(0), peakAllocatedBytes(0), hugePageBytes(0) {}
+
+        std::atomic<HugePagesPolicy> hugePagesPolicy;
+        std::atomic<size_t> numAllocations, allocatedBytes, peakAllocatedBytes, hugePageBytes;
+        std::mutex mutex;
+        std::unordered_map<const void*, Allocation> allocations;
+    };
+
+    inline void* alignedMalloc(size_t size, size_t alignment)
+    {
+#ifdef _MSC_VER
+        void* p = _aligned_malloc(size ? size : alignment, alignment);
+#else
+        void* p = 0;
+        if (posix_memalign(&p, alignment, size ? size : alignment) != 0)
+            p = 0;
+#endif
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+
+    inline void alignedFree(void* p)
+    {
+#ifdef _MSC_VER
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+
+    /* Returns the number of pages of [data, data + size) placed at each NUMA node,
+    pages that were not touched yet are not counted.
+    Returns an empty vector if the placement is unknown (not Linux or no NUMA support). */
+    inline std::vector<size_t> getNumaPlacement(const void* data, size_t size)
+    {
+        std::vector<size_t> result;
+#if defined(__linux__) && defined(SYS_move_pages)
+        const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+        const size_t begin = (size_t)data / pageSize * pageSize;
+        const size_t numPages = ((size_t)data + size - begin + pageSize - 1) / pageSize;
+        const size_t batchSize = 4096;
+        std::vector<void*> pages(batchSize);
+        std::vector<int> status(batchSize);
+        for (size_t first = 0; first < numPages; first += batchSize) {
+            const size_t count = std::min(batchSize, numPages - first);
+            for (size_t i = 0; i < count; i++)
+                pages[i] = (void*)(begin + (first + i) * pageSize);
+            // move_pages without target nodes only queries the placement
+            if (syscall(SYS_move_pages, 0, (unsigned long)count, pages.data(), (const int*)0,
+                status.data(), 0) != 0)
+                return std::vector<size_t>();
+            for (size_t i = 0; i < count; i++)
+                if (status[i] >= 0) {
+                    if ((size_t)status[i] >= result.size()) result.resize(status[i] + 1, 0);
+                    result[status[i]]++;
+                }
+        }
+#endif
+        return result;
+    }
+
+    // NUMA allocator for ScalarField, the storage is aligned to fieldAlignment
+    // (or to 2 MB, see HugePagesPolicy) and is not touched here:
+    // default construction of trivially copyable elements leaves them uninitialized,
+    // the owner initializes the storage in parallel to place the pages at the NUMA
+    // nodes of the threads processing them (first touch)
     // Based upon ideas by Georg Hager and Gerhard Wellein
     template <class Data>
     class NUMA_Allocator {
     public:
 
         using value_type = Data;
-        using propagate_on_container_move_assignment = true_type;
-        using is_always_equal = true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using is_always_equal = std::true_type;
 
         constexpr NUMA_Allocator() noexcept {}
         constexpr NUMA_Allocator(const NUMA_Allocator&) noexcept = default;
@@ -22,28 +216,36 @@ namespace pfc {
 
         value_type * allocate(const size_t num)
         {
-            const size_t size_vt = sizeof(value_type);
-            const size_t len = num * size_vt;
-            const size_t num_threads = OMP_GET_MAX_THREADS();
-            if (num_threads > num) {
-                char * p = reinterpret_cast<char*>(std::malloc(len));
-                std::memset(p, 0, len);
-                return reinterpret_cast<value_type*>(p);
-            }
-            const size_t block_size = (num / num_threads) * size_vt;
-            const size_t block_size_rem = len - block_size * (num_threads - 1);
-            char * p = reinterpret_cast<char*>(std::malloc(len));
-            OMP_FOR()
-            for (int thr = 0; thr < num_threads; thr++) {
-                const size_t cur_block_size = thr == num_threads - 1 ? block_size_rem : block_size;
-                std::memset(p + thr * block_size, 0, cur_block_size);
-            }
+            const size_t len = num * sizeof(value_type);
+            const bool isHugePage = useHugePages(len);
+            void * p = alignedMalloc(len, isHugePage ? hugePageSize : fieldAlignment);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+            // the advice has to be given before the first touch
+            if (isHugePage && FieldAllocationRegistry::instance().getHugePagesPolicy() ==
+                HugePagesPolicy::Advised)
+                madvise(p, len, MADV_HUGEPAGE);
+#endif
+            FieldAllocationRegistry::instance().registerAllocation(p, len, isHugePage);
             return reinterpret_cast<value_type*>(p);
         }
 
         void deallocate(value_type * const p, const size_t num)
         {
-            std::free(p);
+            const size_t len = num * sizeof(value_type);
+            FieldAllocationRegistry::instance().registerDeallocation(p, len);
+            alignedFree(p);
+        }
+
+        template <class U>
+        void construct(U* p)
+        {
+            constructDefault(p, std::is_trivially_copyable<U>());
+        }
+
+        template <class U, class... Args>
+        void construct(U* p, Args&&... args)
+        {
+            ::new((void*)p) U(std::forward<Args>(args)...);
         }
 
         friend int operator==(const NUMA_Allocator& a1, const NUMA_Allocator& a2) {
@@ -54,6 +256,23 @@ namespace pfc {
             return false;
         }
 
+    private:
+
+        static bool useHugePages(size_t len)
+        {
+            return len >= hugePageSize &&
+                FieldAllocationRegistry::instance().getHugePagesPolicy() != HugePagesPolicy::Default;
+        }
+
+        template <class U>
+        static void constructDefault(U* p, std::true_type) {}
+
+        template <class U>
+        static void constructDefault(U* p, std::false_type)
+        {
+            ::new((void*)p) U();
+        }
+
     };
 
 }
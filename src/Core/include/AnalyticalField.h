@@ -1,13 +1,15 @@
 #pragma once
 #include "Vectors.h"
 
+#include <algorithm>
+#include <array>
 #include <functional>
 
 
 namespace pfc {
 
     namespace analytical_field {
-        FP defaultFieldFunction(FP x, FP y, FP z, FP t) {
+        inline FP defaultFieldFunction(FP x, FP y, FP z, FP t) {
             return (FP)0.0;
         }
     };
@@ -18,6 +20,8 @@ namespace pfc {
     public:
 
         using FunctionType = std::function<FP(FP, FP, FP, FP)>;
+        // f(x[], y[], z[], t, result[], size), computes a field component in an array of points
+        using BatchFunctionType = std::function<void(const FP*, const FP*, const FP*, FP, FP*, int)>;
 
         AnalyticalField()
         {
@@ -49,16 +53,39 @@ namespace pfc {
             this->funcEx = funcEx;
             this->funcEy = funcEy;
             this->funcEz = funcEz;
+            this->batchFuncEx = this->batchFuncEy = this->batchFuncEz = nullptr;
         }      
         void setB(FunctionType funcBx, FunctionType funcBy, FunctionType funcBz) {
             this->funcBx = funcBx;
             this->funcBy = funcBy;
             this->funcBz = funcBz;
+            this->batchFuncBx = this->batchFuncBy = this->batchFuncBz = nullptr;
         }
         void setJ(FunctionType funcJx, FunctionType funcJy, FunctionType funcJz) {
             this->funcJx = funcJx;
             this->funcJy = funcJy;
             this->funcJz = funcJz;
+            this->batchFuncJx = this->batchFuncJy = this->batchFuncJz = nullptr;
+        }
+
+        // scalar getters of components set by batch functions call them for one point
+        void setEBatch(BatchFunctionType funcEx, BatchFunctionType funcEy, BatchFunctionType funcEz) {
+            setE(toScalarFunction(funcEx), toScalarFunction(funcEy), toScalarFunction(funcEz));
+            this->batchFuncEx = funcEx;
+            this->batchFuncEy = funcEy;
+            this->batchFuncEz = funcEz;
+        }
+        void setBBatch(BatchFunctionType funcBx, BatchFunctionType funcBy, BatchFunctionType funcBz) {
+            setB(toScalarFunction(funcBx), toScalarFunction(funcBy), toScalarFunction(funcBz));
+            this->batchFuncBx = funcBx;
+            this->batchFuncBy = funcBy;
+            this->batchFuncBz = funcBz;
+        }
+        void setJBatch(BatchFunctionType funcJx, BatchFunctionType funcJy, BatchFunctionType funcJz) {
+            setJ(toScalarFunction(funcJx), toScalarFunction(funcJy), toScalarFunction(funcJz));
+            this->batchFuncJx = funcJx;
+            this->batchFuncJy = funcJy;
+            this->batchFuncJz = funcJz;
         }
 
         FP3 getE(FP x, FP y, FP z, FP t) const {
@@ -119,6 +146,24 @@ namespace pfc {
         FP getJy(const FP3& coords) const { return this->funcJy(coords.x, coords.y, coords.z, this->globalTime); }
         FP getJz(const FP3& coords) const { return this->funcJz(coords.x, coords.y, coords.z, this->globalTime); }
 
+        // values in an array of points at globalTime,
+        // batch functions are called once per chunk of points
+        void getE(const FP3* coords, FP3* values, int size) const {
+            getValues(coords, values, size,
+                { &this->funcEx, &this->funcEy, &this->funcEz },
+                { &this->batchFuncEx, &this->batchFuncEy, &this->batchFuncEz });
+        }
+        void getB(const FP3* coords, FP3* values, int size) const {
+            getValues(coords, values, size,
+                { &this->funcBx, &this->funcBy, &this->funcBz },
+                { &this->batchFuncBx, &this->batchFuncBy, &this->batchFuncBz });
+        }
+        void getJ(const FP3* coords, FP3* values, int size) const {
+            getValues(coords, values, size,
+                { &this->funcJx, &this->funcJy, &this->funcJz },
+                { &this->batchFuncJx, &this->batchFuncJy, &this->batchFuncJz });
+        }
+
         void save(std::ostream& ostr) {
             ostr.write((char*)&globalTime, sizeof(globalTime));
             // TODO: save functions
@@ -138,6 +183,44 @@ namespace pfc {
     private:
 
         FunctionType funcEx, funcEy, funcEz, funcBx, funcBy, funcBz, funcJx, funcJy, funcJz;
+        BatchFunctionType batchFuncEx, batchFuncEy, batchFuncEz, batchFuncBx, batchFuncBy, batchFuncBz,
+            batchFuncJx, batchFuncJy, batchFuncJz;
+
+        static FunctionType toScalarFunction(const BatchFunctionType& batchFunc) {
+            return [batchFunc](FP x, FP y, FP z, FP t) {
+                FP result = 0.0;
+                batchFunc(&x, &y, &z, t, &result, 1);
+                return result;
+            };
+        }
+
+        void getValues(const FP3* coords, FP3* values, int size,
+            const std::array<const FunctionType*, 3>& funcs,
+            const std::array<const BatchFunctionType*, 3>& batchFuncs) const
+        {
+            const int chunkSize = 256;
+            const int numChunks = (size + chunkSize - 1) / chunkSize;
+            OMP_FOR()
+            for (int chunk = 0; chunk < numChunks; chunk++) {
+                const int begin = chunk * chunkSize;
+                const int length = std::min(chunkSize, size - begin);
+                FP x[chunkSize], y[chunkSize], z[chunkSize], result[chunkSize];
+                for (int i = 0; i < length; i++) {
+                    x[i] = coords[begin + i].x;
+                    y[i] = coords[begin + i].y;
+                    z[i] = coords[begin + i].z;
+                }
+                for (int c = 0; c < 3; c++) {
+                    if (*batchFuncs[c])
+                        (*batchFuncs[c])(x, y, z, this->globalTime, result, length);
+                    else
+                        for (int i = 0; i < length; i++)
+                            result[i] = (*funcs[c])(x[i], y[i], z[i], this->globalTime);
+                    for (int i = 0; i < length; i++)
+                        values[begin + i][c] = result[i];
+                }
+            }
+        }
 
     };
 
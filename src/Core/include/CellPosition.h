@@ -0,0 +1,127 @@
+#pragma once
+
+#include "macros.h"
+
+#include "Dimension.h"
+#include "FP.h"
+#include "Vectors.h"
+
+#include <cmath>
+
+namespace pfc {
+
+    // Position given by the index of a cell and the offset inside of the cell,
+    // the offset is normalized by the cell size and lies in [0, 1)
+    struct CellPosition {
+        Int3 cell;
+        FP3 offset;
+
+        CellPosition() {}
+        CellPosition(const Int3& cell, const FP3& offset) :
+            cell(cell), offset(offset)
+        {}
+    };
+
+    // Cells for the cell-relative positions of particles,
+    // cell (0, 0, 0) starts at origin. To gather fields without conversion
+    // to coords, the cells should be the cells of the grid
+    struct CellGeometry {
+        FP3 origin;
+        FP3 steps;
+        FP3 invSteps;
+
+        CellGeometry(const FP3& origin = FP3(0, 0, 0), const FP3& steps = FP3(1, 1, 1)) :
+            origin(origin), steps(steps), invSteps(FP3(1, 1, 1) / steps)
+        {}
+
+        // splits the coordinate along the axis into the cell index and the offset
+        template<typename TOffset>
+        forceinline void split(FP coord, int axis, int& cell, TOffset& offset) const
+        {
+            const FP normalized = (coord - origin[axis]) * invSteps[axis];
+            FP floorCoord = std::floor(normalized);
+            offset = static_cast<TOffset>(normalized - floorCoord);
+            // rounding of the offset to TOffset can give 1
+            if (offset >= static_cast<TOffset>(1)) {
+                offset = static_cast<TOffset>(0);
+                floorCoord += 1;
+            }
+            cell = static_cast<int>(floorCoord);
+        }
+
+        forceinline FP join(int cell, FP offset, int axis) const
+        {
+            return origin[axis] + ((FP)cell + offset) * steps[axis];
+        }
+
+        bool operator==(const CellGeometry& other) const
+        {
+            return origin == other.origin && steps == other.steps;
+        }
+    };
+
+    // Proxy of a cell-relative position stored in separate arrays of cells and offsets,
+    // behaves as the position vector in coords
+    template<Dimension dimension, typename TOffset>
+    class CellPositionProxy {
+    public:
+
+        typedef typename VectorTypeHelper<dimension, FP>::Type PositionType;
+
+        CellPositionProxy(int* const cells[], TOffset* const offsets[], const CellGeometry* geometry) :
+            geometry(geometry)
+        {
+            for (int d = 0; d < dimension; d++) {
+                cell[d] = cells[d];
+                offset[d] = offsets[d];
+            }
+        }
+
+        PositionType toVector() const
+        {
+            PositionType result;
+            for (int d = 0; d < dimension; d++)
+                result[d] = geometry->join(*cell[d], *offset[d], d);
+            return result;
+        }
+
+        CellPositionProxy& operator=(const PositionType& position)
+        {
+            for (int d = 0; d < dimension; d++)
+                geometry->split(position[d], d, *cell[d], *offset[d]);
+            return *this;
+        }
+
+        // the components beyond the dimension are zero
+        CellPosition getCellPosition() const
+        {
+            CellPosition result(Int3(0, 0, 0), FP3(0, 0, 0));
+            for (int d = 0; d < dimension; d++) {
+                result.cell[d] = *cell[d];
+                result.offset[d] = *offset[d];
+            }
+            return result;
+        }
+
+        // the offset is brought to [0, 1) moving to the neighbouring cells if needed
+        void setCellPosition(const CellPosition& position)
+        {
+            for (int d = 0; d < dimension; d++) {
+                const FP floorOffset = std::floor(position.offset[d]);
+                *cell[d] = position.cell[d] + static_cast<int>(floorOffset);
+                *offset[d] = static_cast<TOffset>(position.offset[d] - floorOffset);
+                if (*offset[d] >= static_cast<TOffset>(1)) {
+                    *offset[d] = static_cast<TOffset>(0);
+                    ++*cell[d];
+                }
+            }
+        }
+
+    private:
+
+        int* cell[dimension];
+        TOffset* offset[dimension];
+        const CellGeometry* geometry;
+    };
+
+} // namespace pfc
@@ -33,6 +33,15 @@ namespace pfc {
             return static_cast<int>(size); 
         }
 
+        // bytes of the allocated storage of all particle arrays
+        inline size_t getMemoryUsage() const
+        {
+            size_t result = 0;
+            for (auto it = pArrays.begin(); it != pArrays.end(); it++)
+                result += it->second.getMemoryUsage();
+            return result;
+        }
+
         Ensemble()
         {
             for (int t = 0; t < sizeParticleTypes; t++)
@@ -1,9 +1,11 @@
 #pragma once
 #include <omp.h>
 #include "ScalarField.h"
+#include "ScalarFieldView.h"
 #include "Grid.h"
 #include "SpectralGrid.h"
 #include "Enums.h"
+#include "MemoryAccounting.h"
 
 #include "macros.h"
 
@@ -30,6 +32,8 @@ namespace pfc
 #ifdef __USE_FFT__
         Int3 size, memSizeRealData;
         fftw_plan plans[2];  // RtoC/CtoR
+        size_t planBytes = 0;  // heap memory of the plans, accounted to MemoryCategory::FourierTransform
+        bool isPlanned = false;
         FP* realData;
         complexFP* complexData;
 #endif
@@ -50,6 +54,8 @@ namespace pfc
             memSizeRealData = _memSizeRealData;
             realData = _realData;
             complexData = _complexData;
+            if (isPlanned)
+                destroyPlans();
             createPlans();
         }
 
@@ -57,14 +63,28 @@ namespace pfc
             destroyPlans();
         }
 
+        // rebinds the transform to other arrays of the same size and layout, the plans are kept
+        void setData(FP* _realData, complexFP* _complexData)
+        {
+            realData = _realData;
+            complexData = _complexData;
+        }
+
+        void release()
+        {
+            destroyPlans();
+        }
+
         void doDirectFourierTransform()
         {
-            fftw_execute(plans[fourier_transform::Direction::RtoC]);
+            fftw_execute_dft_r2c(plans[fourier_transform::Direction::RtoC],
+                realData, (fftw_complex*)complexData);
         }
 
         void doInverseFourierTransform()
         {
-            fftw_execute(plans[fourier_transform::Direction::CtoR]);
+            fftw_execute_dft_c2r(plans[fourier_transform::Direction::CtoR],
+                (fftw_complex*)complexData, realData);
             FP normCoeff = (FP)size.volume();
             int nx = memSizeRealData.x, ny = memSizeRealData.y, nz = memSizeRealData.z;
             OMP_FOR_COLLAPSE()
@@ -80,6 +100,9 @@ namespace pfc
         void initialize(FP* _realData, complexFP* _complexData,
             Int3 _size, Int3 _memSizeRealData) {}
 
+        void setData(FP* _realData, complexFP* _complexData) {}
+        void release() {}
+
         void doDirectFourierTransform() {}
         void doInverseFourierTransform() {}
 
@@ -119,6 +142,9 @@ namespace pfc
         void createPlans()
         {
             int Nx = size.x, Ny = size.y, Nz = size.z;
+            // FFTW does not report the memory of plans, it is estimated by the heap growth,
+            // which includes allocations of other threads made during planning
+            const size_t heapBytes = getHeapAllocatedBytes();
 
 #ifdef __USE_OMP__
             fftw_plan_with_nthreads(omp_get_max_threads());
@@ -130,6 +156,144 @@ namespace pfc
 #endif
             plans[fourier_transform::Direction::CtoR] = fftw_plan_dft_c2r_3d(Nx, Ny, Nz,
                 (fftw_complex*)&(complexData[0]), &(realData[0]), FFTW_ESTIMATE);
+            const size_t newHeapBytes = getHeapAllocatedBytes();
+            planBytes = newHeapBytes > heapBytes ? newHeapBytes - heapBytes : 0;
+            MemoryRegistry::instance().registerAllocation(MemoryCategory::FourierTransform, planBytes);
+            isPlanned = true;
+        }
+
+        void destroyPlans()
+        {
+            if (plans[fourier_transform::Direction::RtoC] != 0)
+                fftw_destroy_plan(plans[fourier_transform::Direction::RtoC]);
+            if (plans[fourier_transform::Direction::CtoR] != 0)
+                fftw_destroy_plan(plans[fourier_transform::Direction::CtoR]);
+            if (isPlanned)
+                MemoryRegistry::instance().registerDeallocation(MemoryCategory::FourierTransform, planBytes);
+            plans[fourier_transform::Direction::RtoC] = 0;
+            plans[fourier_transform::Direction::CtoR] = 0;
+            planBytes = 0;
+            isPlanned = false;
+        }
+#endif
+    };
+
+
+    /* 2d transforms of a batch of yz-planes stored one after another in place,
+    size.x is the number of planes, the planes have the layout of the planes of a 3d field */
+    class PlaneFourierTransform {
+#ifdef __USE_FFT__
+        Int3 size, memSizeRealData;
+        fftw_plan plans[2];  // RtoC/CtoR
+        size_t planBytes = 0;  // heap memory of the plans, accounted to MemoryCategory::FourierTransform
+        bool isPlanned = false;
+        FP* realData;
+        complexFP* complexData;
+#endif
+
+    public:
+
+#ifdef __USE_FFT__
+        PlaneFourierTransform()
+        {
+            plans[fourier_transform::Direction::RtoC] = 0;
+            plans[fourier_transform::Direction::CtoR] = 0;
+        }
+
+        void initialize(FP* _realData, complexFP* _complexData,
+            Int3 _size, Int3 _memSizeRealData)
+        {
+            size = _size;
+            memSizeRealData = _memSizeRealData;
+            realData = _realData;
+            complexData = _complexData;
+            if (isPlanned)
+                destroyPlans();
+            createPlans();
+        }
+
+        ~PlaneFourierTransform() {
+            destroyPlans();
+        }
+
+        void release()
+        {
+            destroyPlans();
+        }
+
+        void doDirectFourierTransform()
+        {
+            fftw_execute(plans[fourier_transform::Direction::RtoC]);
+        }
+
+        void doInverseFourierTransform()
+        {
+            fftw_execute(plans[fourier_transform::Direction::CtoR]);
+            FP normCoeff = (FP)(size.y * size.z);
+            int ny = memSizeRealData.y, nz = memSizeRealData.z;
+            OMP_FOR_COLLAPSE()
+            for (int i = 0; i < size.x; i++)
+                for (int j = 0; j < size.y; j++)
+                    for (int k = 0; k < size.z; k++)
+                        realData[k + (j + i * ny) * nz] /= normCoeff;
+        }
+
+#else
+        PlaneFourierTransform() {}
+
+        void initialize(FP* _realData, complexFP* _complexData,
+            Int3 _size, Int3 _memSizeRealData) {}
+
+        void release() {}
+
+        void doDirectFourierTransform() {}
+        void doInverseFourierTransform() {}
+#endif
+
+        void doFourierTransform(fourier_transform::Direction direction)
+        {
+            switch (direction) {
+            case fourier_transform::Direction::RtoC:
+                doDirectFourierTransform();
+                break;
+            case fourier_transform::Direction::CtoR:
+                doInverseFourierTransform();
+                break;
+            default:
+                break;
+            }
+        }
+
+    private:
+
+#ifdef __USE_FFT__
+        void createPlans()
+        {
+            int n[2] = { size.y, size.z };
+            int realEmbed[2] = { memSizeRealData.y, memSizeRealData.z };
+            // the transforms are in place, a complex plane occupies the storage of a real one
+            int complexEmbed[2] = { memSizeRealData.y, memSizeRealData.z / 2 };
+            int realDist = memSizeRealData.y * memSizeRealData.z;
+            int complexDist = realDist / 2;
+            // the memory of plans is estimated by the heap growth, as in ArrayFourierTransform3d
+            const size_t heapBytes = getHeapAllocatedBytes();
+
+#ifdef __USE_OMP__
+            fftw_plan_with_nthreads(omp_get_max_threads());
+#endif
+            plans[fourier_transform::Direction::RtoC] = fftw_plan_many_dft_r2c(2, n, size.x,
+                realData, realEmbed, 1, realDist,
+                (fftw_complex*)complexData, complexEmbed, 1, complexDist, FFTW_ESTIMATE);
+#ifdef __USE_OMP__
+            fftw_plan_with_nthreads(omp_get_max_threads());
+#endif
+            plans[fourier_transform::Direction::CtoR] = fftw_plan_many_dft_c2r(2, n, size.x,
+                (fftw_complex*)complexData, complexEmbed, 1, complexDist,
+                realData, realEmbed, 1, realDist, FFTW_ESTIMATE);
+            const size_t newHeapBytes = getHeapAllocatedBytes();
+            planBytes = newHeapBytes > heapBytes ? newHeapBytes - heapBytes : 0;
+            MemoryRegistry::instance().registerAllocation(MemoryCategory::FourierTransform, planBytes);
+            isPlanned = true;
         }
 
         void destroyPlans()
@@ -138,7 +302,74 @@ namespace pfc
                 fftw_destroy_plan(plans[fourier_transform::Direction::RtoC]);
             if (plans[fourier_transform::Direction::CtoR] != 0)
                 fftw_destroy_plan(plans[fourier_transform::Direction::CtoR]);
+            if (isPlanned)
+                MemoryRegistry::instance().registerDeallocation(MemoryCategory::FourierTransform, planBytes);
+            plans[fourier_transform::Direction::RtoC] = 0;
+            plans[fourier_transform::Direction::CtoR] = 0;
+            planBytes = 0;
+            isPlanned = false;
+        }
+#endif
+    };
+
+
+    /* Inverse complex 1d transforms along the first index of an array of n * numLines complex
+    numbers, in place and not normalized. The plan is executed on the array passed to
+    doInverseFourierTransform, so threads can transform their own arrays with one plan */
+    class LineFourierTransform {
+#ifdef __USE_FFT__
+        fftw_plan plan = 0;
+        size_t planBytes = 0;  // heap memory of the plan, accounted to MemoryCategory::FourierTransform
+#endif
+
+    public:
+
+#ifdef __USE_FFT__
+        LineFourierTransform() {}
+
+        ~LineFourierTransform() {
+            release();
+        }
+
+        void initialize(int n, int numLines)
+        {
+            release();
+            std::vector<complexFP> data((size_t)n * numLines);
+            // the memory of the plan is estimated by the heap growth, as in ArrayFourierTransform3d
+            const size_t heapBytes = getHeapAllocatedBytes();
+            // the plan is executed by the threads of a parallel loop
+            fftw_plan_with_nthreads(1);
+            plan = fftw_plan_many_dft(1, &n, numLines,
+                (fftw_complex*)data.data(), 0, numLines, 1,
+                (fftw_complex*)data.data(), 0, numLines, 1,
+                FFTW_BACKWARD, FFTW_ESTIMATE | FFTW_UNALIGNED);
+            const size_t newHeapBytes = getHeapAllocatedBytes();
+            planBytes = newHeapBytes > heapBytes ? newHeapBytes - heapBytes : 0;
+            MemoryRegistry::instance().registerAllocation(MemoryCategory::FourierTransform, planBytes);
+        }
+
+        void release()
+        {
+            if (plan != 0) {
+                fftw_destroy_plan(plan);
+                MemoryRegistry::instance().registerDeallocation(MemoryCategory::FourierTransform, planBytes);
+            }
+            plan = 0;
+            planBytes = 0;
         }
+
+        void doInverseFourierTransform(complexFP* data) const
+        {
+            fftw_execute_dft(plan, (fftw_complex*)data, (fftw_complex*)data);
+        }
+
+#else
+        LineFourierTransform() {}
+
+        void initialize(int n, int numLines) {}
+        void release() {}
+
+        void doInverseFourierTransform(complexFP* data) const {}
 #endif
     };
 
@@ -155,8 +386,18 @@ namespace pfc
 
         void initialize(ScalarField<FP>* _realData,
             SpectralScalarField<FP, complexFP>* _complexData, Int3 _size) {
-            ArrayFourierTransform3d::initialize(_realData->getData(),
-                _complexData->getData(), _size, _realData->getMemSize());
+            this->initialize(ScalarFieldView<FP>(*_realData), _complexData, _size);
+        }
+
+        // the view has to cover the whole storage of a field, as the transform is done in place
+        void initialize(const ScalarFieldView<FP>& _realData,
+            SpectralScalarField<FP, complexFP>* _complexData, Int3 _size) {
+            ArrayFourierTransform3d::initialize(_realData.getData(),
+                _complexData->getData(), _size, _realData.getMemSize());
+        }
+
+        void setData(ScalarField<FP>* _realData, SpectralScalarField<FP, complexFP>* _complexData) {
+            ArrayFourierTransform3d::setData(_realData->getData(), _complexData->getData());
         }
     };
 
@@ -184,6 +425,22 @@ namespace pfc
             transform[(int)FieldEnum::J][(int)CoordinateEnum::z].initialize(&gridInTime->Jz, &gridInSpectral->Jz, gridInTime->numCells);
         }
 
+        // rebinds the transforms after the storage of the fields was swapped or moved
+        template<class TGrid>
+        void setData(TGrid* gridInTime, SpectralGrid<FP, complexFP>* gridInSpectral) {
+            transform[(int)FieldEnum::E][(int)CoordinateEnum::x].setData(&gridInTime->Ex, &gridInSpectral->Ex);
+            transform[(int)FieldEnum::E][(int)CoordinateEnum::y].setData(&gridInTime->Ey, &gridInSpectral->Ey);
+            transform[(int)FieldEnum::E][(int)CoordinateEnum::z].setData(&gridInTime->Ez, &gridInSpectral->Ez);
+
+            transform[(int)FieldEnum::B][(int)CoordinateEnum::x].setData(&gridInTime->Bx, &gridInSpectral->Bx);
+            transform[(int)FieldEnum::B][(int)CoordinateEnum::y].setData(&gridInTime->By, &gridInSpectral->By);
+            transform[(int)FieldEnum::B][(int)CoordinateEnum::z].setData(&gridInTime->Bz, &gridInSpectral->Bz);
+
+            transform[(int)FieldEnum::J][(int)CoordinateEnum::x].setData(&gridInTime->Jx, &gridInSpectral->Jx);
+            transform[(int)FieldEnum::J][(int)CoordinateEnum::y].setData(&gridInTime->Jy, &gridInSpectral->Jy);
+            transform[(int)FieldEnum::J][(int)CoordinateEnum::z].setData(&gridInTime->Jz, &gridInSpectral->Jz);
+        }
+
         void doDirectFourierTransform(FieldEnum field, CoordinateEnum coord) {
             transform[(int)field][(int)coord].doDirectFourierTransform();
         }
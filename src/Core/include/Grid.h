@@ -2,6 +2,7 @@
 
 #include "macros.h"
 
+#include "CellPosition.h"
 #include "GridTypes.h"
 #include "ScalarField.h"
 #include "Vectors.h"
@@ -9,7 +10,9 @@
 
 #include "GridMacros.h"
 
+#include <atomic>
 #include <exception>
+#include <mutex>
 
 
 namespace pfc {
@@ -19,6 +22,25 @@ namespace pfc {
         Interpolation_SecondOrder, Interpolation_FourthOrder
     };
 
+    // E and B of a grid node, a record of the interleaved storage of the grid
+    struct FieldRecordEB {
+        FP values[6];  // Ex, Ey, Ez, Bx, By, Bz
+    };
+
+    // flag of changed E or B of a grid with the lock of the refresh of the interleaved records,
+    // a copy of a grid gets its own lock
+    struct InterleavedFieldsState {
+        InterleavedFieldsState() : changed(false) {}
+        InterleavedFieldsState(const InterleavedFieldsState& state) : changed(state.changed.load()) {}
+        InterleavedFieldsState& operator=(const InterleavedFieldsState& state) {
+            changed = state.changed.load();
+            return *this;
+        }
+
+        std::atomic<bool> changed;
+        std::mutex mutex;
+    };
+
     template<typename Data, GridTypes gridType_>
     class Grid :
         // next labels define some properties of grid
@@ -37,6 +59,10 @@ namespace pfc {
             const FP3& minCoords, const FP3& _steps,
             const Int3& globalGridDims) {}
         Grid(const Grid<Data, gridType_>& grid);
+        // moves take over the storage of the fields without copying
+        Grid(Grid<Data, gridType_>&& grid) = default;
+        Grid& operator=(const Grid<Data, gridType_>& grid) = default;
+        Grid& operator=(Grid<Data, gridType_>&& grid) = default;
 
         /* copy values from *this to *grid */
         template <class TGrid>
@@ -187,40 +213,120 @@ namespace pfc {
         // the next methods interpolate and return field values, using default interpolation
         // this interpolation is written in the 'interpolationType' variable and can be changed
         // the start default interpolation method is CIC
+        // each method also has a template version with the interpolation as a compile-time
+        // policy, e.g. getFields<InterpolationType::Interpolation_TSC>(coords, e, b),
+        // hot loops instantiated per interpolation avoid the dispatch at each call
+        // getE, getB, getJ and getFields also accept a CellPosition with cells of this grid,
+        // then the grid index and the internal coords are found without division by steps
 
         void setInterpolationType(InterpolationType type);
         InterpolationType getInterpolationType() const;
 
         /* returns interpolated field value in arbitrary coords */
-        /* signature: 'forceinline FP funcname(const FP3& coords) const' */
-        GRID_GET_FIELD_IMPL(getBx, interpolationBx);
-        GRID_GET_FIELD_IMPL(getBy, interpolationBy);
-        GRID_GET_FIELD_IMPL(getBz, interpolationBz);
-        GRID_GET_FIELD_IMPL(getEx, interpolationEx);
-        GRID_GET_FIELD_IMPL(getEy, interpolationEy);
-        GRID_GET_FIELD_IMPL(getEz, interpolationEz);
-        GRID_GET_FIELD_IMPL(getJx, interpolationJx);
-        GRID_GET_FIELD_IMPL(getJy, interpolationJy);
-        GRID_GET_FIELD_IMPL(getJz, interpolationJz);
+        /* signatures: 'template <InterpolationType type> forceinline FP funcname(const FP3& coords) const'
+        and 'forceinline FP funcname(const FP3& coords) const' */
+        GRID_GET_FIELD_IMPL(getBx, Bx, shiftBx);
+        GRID_GET_FIELD_IMPL(getBy, By, shiftBy);
+        GRID_GET_FIELD_IMPL(getBz, Bz, shiftBz);
+        GRID_GET_FIELD_IMPL(getEx, Ex, shiftEJx);
+        GRID_GET_FIELD_IMPL(getEy, Ey, shiftEJy);
+        GRID_GET_FIELD_IMPL(getEz, Ez, shiftEJz);
+        GRID_GET_FIELD_IMPL(getJx, Jx, shiftEJx);
+        GRID_GET_FIELD_IMPL(getJy, Jy, shiftEJy);
+        GRID_GET_FIELD_IMPL(getJz, Jz, shiftEJz);
+
+        template <InterpolationType type, class TPosition>
+        FP3 getB(const TPosition& coords) const {
+            return getVectorField<type>(coords, Bx, By, Bz, positionShift(coords, shiftBx, normalizedShiftBx),
+                positionShift(coords, shiftBy, normalizedShiftBy), positionShift(coords, shiftBz, normalizedShiftBz));
+        }
+        template <InterpolationType type, class TPosition>
+        FP3 getE(const TPosition& coords) const {
+            return getVectorField<type>(coords, Ex, Ey, Ez, positionShift(coords, shiftEJx, normalizedShiftEJx),
+                positionShift(coords, shiftEJy, normalizedShiftEJy), positionShift(coords, shiftEJz, normalizedShiftEJz));
+        }
+        template <InterpolationType type, class TPosition>
+        FP3 getJ(const TPosition& coords) const {
+            return getVectorField<type>(coords, Jx, Jy, Jz, positionShift(coords, shiftEJx, normalizedShiftEJx),
+                positionShift(coords, shiftEJy, normalizedShiftEJy), positionShift(coords, shiftEJz, normalizedShiftEJz));
+        }
 
         FP3 getB(const FP3& coords) const {
-            return FP3(getBx(coords), getBy(coords), getBz(coords));
+            GRID_DISPATCH_INTERPOLATION(getB, coords);
         }
         FP3 getE(const FP3& coords) const {
-            return FP3(getEx(coords), getEy(coords), getEz(coords));
+            GRID_DISPATCH_INTERPOLATION(getE, coords);
         }
         FP3 getJ(const FP3& coords) const {
-            return FP3(getJx(coords), getJy(coords), getJz(coords));
+            GRID_DISPATCH_INTERPOLATION(getJ, coords);
+        }
+        FP3 getB(const CellPosition& position) const {
+            GRID_DISPATCH_INTERPOLATION(getB, position);
+        }
+        FP3 getE(const CellPosition& position) const {
+            GRID_DISPATCH_INTERPOLATION(getE, position);
+        }
+        FP3 getJ(const CellPosition& position) const {
+            GRID_DISPATCH_INTERPOLATION(getJ, position);
         }
 
-        void getFields(const FP3& coords, FP3& e, FP3& b) const
+        template <InterpolationType type, class TPosition>
+        void getFields(const TPosition& coords, FP3& e, FP3& b) const
         {
-            (this->*interpolationFields)(coords, e, b);
+            if (type == InterpolationType::Interpolation_CIC && isInterleavedFields())
+                getFieldsCICInterleaved(coords, e, b);
+            else if (!this->ifFieldsSpatialStaggered) {
+                // all six components share one stencil
+                const ScalarField<Data>* fields[6] = { &Ex, &Ey, &Ez, &Bx, &By, &Bz };
+                FP values[6];
+                interpolateCollocated<type, 6>(coords, fields, values);
+                e = FP3(values[0], values[1], values[2]);
+                b = FP3(values[3], values[4], values[5]);
+            }
+            else {
+                e = getE<type>(coords);
+                b = getB<type>(coords);
+            }
         }
+
+        void getFields(const FP3& coords, FP3& e, FP3& b) const;
         void getFields(FP x, FP y, FP z, FP3& e, FP3& b) const
         {
             getFields(FP3(x, y, z), e, b);
         }
+        void getFields(const CellPosition& position, FP3& e, FP3& b) const
+        {
+            GRID_DISPATCH_INTERPOLATION(getFields, position, e, b);
+        }
+
+        /* gathers the fields at all particles of an array with cell-relative positions,
+        e and b should have particles.size() elements. The cell geometry of the array
+        should be the cell geometry of the grid, otherwise std::logic_error is thrown */
+        template <InterpolationType type, class TParticleArray>
+        void gatherFields(const TParticleArray& particles, FP3* e, FP3* b) const;
+        template <class TParticleArray>
+        void gatherFields(const TParticleArray& particles, FP3* e, FP3* b) const
+        {
+            GRID_DISPATCH_INTERPOLATION(gatherFields, particles, e, b);
+        }
+
+        // cells of the grid for the cell-relative positions of particles
+        CellGeometry getCellGeometry() const { return CellGeometry(origin, steps); }
+
+        /* Interleaved storage of E and B for gather-heavy workloads: the six components
+        of each node are also packed into one record, so a CIC gather reads neighbouring
+        records instead of six separate arrays. The records are a copy, so the option
+        doubles the memory of E and B; the arrays Ex..Bz remain the storage of the field
+        solvers and of all the setters. When enabled, getFields with CIC interpolation
+        reads the records. The field solvers refresh them at the end of updateFields.
+        Any other code that writes E or B (setters, array views, copyValues) must call
+        markFieldsChanged(), then the records are refreshed by the next gather. */
+        void setInterleavedFields(bool enable);
+        bool isInterleavedFields() const { return !interleavedFields.empty(); }
+        void updateInterleavedFields();
+        void markFieldsChanged() { interleavedFieldsState.changed = true; }
+        template <class TPosition>
+        void getFieldsCICInterleaved(const TPosition& coords, FP3& e, FP3& b) const;
 
         /* Make all current density values zero. */
         void zeroizeJ();
@@ -272,6 +378,18 @@ namespace pfc {
             internalCoords = (coords - baseCoords(idx.x, idx.y, idx.z) - shift) / steps;
         }
 
+        /* for CellPosition the shift is normalized by the steps, see positionShift */
+        void getGridCoords(const CellPosition& position, const FP3& shift, Int3& idx,
+            FP3& internalCoords) const
+        {
+            // the offset is in [0, 1) and the shift is not larger than 1, so coords > -1
+            // and the floor is computed by truncation
+            const FP3 coords = position.offset - shift;
+            const Int3 cellShift = Int3(coords + FP3(1, 1, 1)) - Int3(1, 1, 1);
+            idx = position.cell + cellShift;
+            internalCoords = coords - (FP3)cellShift;
+        }
+
         void getClosestGridCoords(const FP3& coords, const FP3& shift, Int3& idx,
             FP3& internalCoords) const
         {
@@ -281,6 +399,36 @@ namespace pfc {
             internalCoords = (coords - baseCoords(idx.x, idx.y, idx.z) - shift) / steps;
         }
 
+        void getClosestGridCoords(const CellPosition& position, const FP3& shift, Int3& idx,
+            FP3& internalCoords) const
+        {
+            const FP3 coords = position.offset - shift;
+            const Int3 cellShift = Int3(coords + FP3(1.5, 1.5, 1.5)) - Int3(1, 1, 1);
+            idx = position.cell + cellShift;
+            internalCoords = coords - (FP3)cellShift;
+        }
+
+        // the shift of a field component in the units of the position:
+        // in coords for FP3 and normalized by the steps for CellPosition
+        forceinline const FP3& positionShift(const FP3&, const FP3& shift, const FP3&) const
+        {
+            return shift;
+        }
+        forceinline const FP3& positionShift(const CellPosition&, const FP3&, const FP3& normalizedShift) const
+        {
+            return normalizedShift;
+        }
+
+        void updateNormalizedShifts()
+        {
+            normalizedShiftBx = shiftBx / steps;
+            normalizedShiftBy = shiftBy / steps;
+            normalizedShiftBz = shiftBz / steps;
+            normalizedShiftEJx = shiftEJx / steps;
+            normalizedShiftEJy = shiftEJy / steps;
+            normalizedShiftEJz = shiftEJz / steps;
+        }
+
         /* returns base coords of element (i, j, k) so that its real coords are
         base coords + corresponding shift. */
         forceinline const FP3 baseCoords(int i, int j, int k) const
@@ -296,6 +444,16 @@ namespace pfc {
             return coords >= minCoords && coords < maxCoords;
         }
 
+        /* storage size of the real-space grids, with __USE_PADDING__ the rows
+        are padded for aligned vectorized loops along z */
+        static Int3 getRealStorageSize(const Int3& numCells) {
+#ifdef __USE_PADDING__
+            return ScalarField<Data>::getPaddedStorageSize(numCells);
+#else
+            return numCells;
+#endif
+        }
+
         void checkGridSizeAndOverlaps() {
             if (this->numInternalCells < this->getNumExternalLeftCells() + this->getNumExternalRightCells()) {
                 std::string exc = "ERROR: grid size should be larger than both overlaps";
@@ -304,23 +462,72 @@ namespace pfc {
             }
         }
 
-        FP getFieldCIC(const FP3& coords, const ScalarField<Data>& field, const FP3& shift) const;
-        FP getFieldTSC(const FP3& coords, const ScalarField<Data>& field, const FP3& shift) const;
-        FP getFieldPCS(const FP3& coords, const ScalarField<Data>& field, const FP3& shift) const;
-        FP getFieldSecondOrder(const FP3& coords, const ScalarField<Data>& field, const FP3& shift) const;
-        FP getFieldFourthOrder(const FP3& coords, const ScalarField<Data>& field, const FP3& shift) const;
+        // indices of the interleaved records and the weights of the CIC interpolation
+        // the positions are given by FP3 coords or by CellPosition, with the shift from positionShift
+        template <class TPosition>
+        void getCICNodes(const TPosition& coords, const FP3& shift, int index[8], FP weight[8]) const;
+
+        template <class TPosition>
+        FP getFieldCIC(const TPosition& coords, const ScalarField<Data>& field, const FP3& shift) const;
+        template <class TPosition>
+        FP getFieldTSC(const TPosition& coords, const ScalarField<Data>& field, const FP3& shift) const;
+        template <class TPosition>
+        FP getFieldPCS(const TPosition& coords, const ScalarField<Data>& field, const FP3& shift) const;
+        template <class TPosition>
+        FP getFieldSecondOrder(const TPosition& coords, const ScalarField<Data>& field, const FP3& shift) const;
+        template <class TPosition>
+        FP getFieldFourthOrder(const TPosition& coords, const ScalarField<Data>& field, const FP3& shift) const;
+
+        template <InterpolationType type, class TPosition>
+        forceinline FP getField(const TPosition& coords, const ScalarField<Data>& field, const FP3& shift) const
+        {
+            // the switch is resolved at compile time
+            switch (type) {
+            case InterpolationType::Interpolation_TSC: return getFieldTSC(coords, field, shift);
+            case InterpolationType::Interpolation_PCS: return getFieldPCS(coords, field, shift);
+            case InterpolationType::Interpolation_SecondOrder: return getFieldSecondOrder(coords, field, shift);
+            case InterpolationType::Interpolation_FourthOrder: return getFieldFourthOrder(coords, field, shift);
+            default: return getFieldCIC(coords, field, shift);
+            }
+        }
+
+        // the current interpolation
+        FP getField(const FP3& coords, const ScalarField<Data>& field, const FP3& shift) const;
+
+        template <InterpolationType type, class TPosition>
+        FP3 getVectorField(const TPosition& coords, const ScalarField<Data>& fx, const ScalarField<Data>& fy,
+            const ScalarField<Data>& fz, const FP3& sx, const FP3& sy, const FP3& sz) const
+        {
+            if (this->ifFieldsSpatialStaggered)
+                return FP3(getField<type>(coords, fx, sx), getField<type>(coords, fy, sy),
+                    getField<type>(coords, fz, sz));
+            const ScalarField<Data>* fields[3] = { &fx, &fy, &fz };
+            FP values[3];
+            interpolateCollocated<type, 3>(coords, fields, values);
+            return FP3(values[0], values[1], values[2]);
+        }
+
+        /* interpolates co-located fields (zero shifts) with one stencil, the border rules
+        are the ones of getField: the CIC nodes wrap around the grid, the other stencils
+        do not wrap and the fourth order falls back to TSC near the borders */
+        template <InterpolationType type, int numFields, class TPosition>
+        void interpolateCollocated(const TPosition& coords, const ScalarField<Data>* const fields[],
+            FP result[]) const;
+
+        // refreshes the records if E or B were changed, safe to be called by concurrent gathers
+        void refreshInterleavedFields() const;
+
+        // a cache of Ex..Bz, refreshed on gathers
+        std::vector<FieldRecordEB, NUMA_Allocator<FieldRecordEB>> interleavedFields;
+        mutable InterleavedFieldsState interleavedFieldsState;
 
         InterpolationType interpolationType;
-        void (Grid::* interpolationFields)(const FP3&, FP3&, FP3&) const;
-        FP (Grid::* interpolationBx)(const FP3&) const;
-        FP (Grid::* interpolationBy)(const FP3&) const;
-        FP (Grid::* interpolationBz)(const FP3&) const;
-        FP (Grid::* interpolationEx)(const FP3&) const;
-        FP (Grid::* interpolationEy)(const FP3&) const;
-        FP (Grid::* interpolationEz)(const FP3&) const;
-        FP (Grid::* interpolationJx)(const FP3&) const;
-        FP (Grid::* interpolationJy)(const FP3&) const;
-        FP (Grid::* interpolationJz)(const FP3&) const;
+
+        // the shifts divided by the steps for the gathers at CellPosition,
+        // initialized after the shifts, load() updates them
+        FP3 normalizedShiftBx = shiftBx / steps, normalizedShiftBy = shiftBy / steps,
+            normalizedShiftBz = shiftBz / steps, normalizedShiftEJx = shiftEJx / steps,
+            normalizedShiftEJy = shiftEJy / steps, normalizedShiftEJz = shiftEJz / steps;
     };
 
     typedef Grid<FP, GridTypes::YeeGridType> YeeGrid;
@@ -342,7 +549,9 @@ namespace pfc {
         dimensionality(grid.dimensionality),
         Bx(grid.Bx), By(grid.By), Bz(grid.Bz),
         Ex(grid.Ex), Ey(grid.Ey), Ez(grid.Ez),
-        Jx(grid.Jx), Jy(grid.Jy), Jz(grid.Jz)
+        Jx(grid.Jx), Jy(grid.Jy), Jz(grid.Jz),
+        interleavedFields(grid.interleavedFields),
+        interleavedFieldsState(grid.interleavedFieldsState)
     {
         checkGridSizeAndOverlaps();
         setInterpolationType(grid.interpolationType);
@@ -355,7 +564,7 @@ namespace pfc {
         steps(_steps),
         numInternalCells(_numCells),
         numCells(numInternalCells + getNumExternalLeftCells() + getNumExternalRightCells()),
-        sizeStorage(numCells),
+        sizeStorage(getRealStorageSize(numCells)),
         Ex(numCells, sizeStorage), Ey(numCells, sizeStorage), Ez(numCells, sizeStorage),
         Bx(numCells, sizeStorage), By(numCells, sizeStorage), Bz(numCells, sizeStorage),
         Jx(numCells, sizeStorage), Jy(numCells, sizeStorage), Jz(numCells, sizeStorage),
@@ -381,7 +590,7 @@ namespace pfc {
         steps(_steps),
         numInternalCells(_numInternalCells),
         numCells(numInternalCells + getNumExternalLeftCells() + getNumExternalRightCells()),
-        sizeStorage(numCells),
+        sizeStorage(getRealStorageSize(numCells)),
         Bx(numCells, sizeStorage), By(numCells, sizeStorage), Bz(numCells, sizeStorage),
         Ex(numCells, sizeStorage), Ey(numCells, sizeStorage), Ez(numCells, sizeStorage),
         Jx(numCells, sizeStorage), Jy(numCells, sizeStorage), Jz(numCells, sizeStorage),
@@ -495,10 +704,12 @@ namespace pfc {
                     grid->Jy(i, j, k) = this->getJy(grid->JyPosition(i, j, k));
                     grid->Jz(i, j, k) = this->getJz(grid->JzPosition(i, j, k));
                 }
+        grid->markFieldsChanged();
     }
 
     template< typename Data, GridTypes gT>
-    inline FP Grid<Data, gT>::getFieldCIC(const FP3& coords, const ScalarField<Data>& field, const FP3& shift) const
+    template <class TPosition>
+    inline FP Grid<Data, gT>::getFieldCIC(const TPosition& coords, const ScalarField<Data>& field, const FP3& shift) const
     {
         Int3 idx;
         FP3 internalCoords;
@@ -507,7 +718,8 @@ namespace pfc {
     }
 
     template< typename Data, GridTypes gT>
-    inline FP Grid<Data, gT>::getFieldTSC(const FP3& coords, const ScalarField<Data>& field, const FP3& shift) const
+    template <class TPosition>
+    inline FP Grid<Data, gT>::getFieldTSC(const TPosition& coords, const ScalarField<Data>& field, const FP3& shift) const
     {
         Int3 idx;
         FP3 internalCoords;
@@ -516,7 +728,8 @@ namespace pfc {
     }
 
     template< typename Data, GridTypes gT>
-    inline FP Grid<Data, gT>::getFieldSecondOrder(const FP3& coords, const ScalarField<Data>& field, const FP3& shift) const
+    template <class TPosition>
+    inline FP Grid<Data, gT>::getFieldSecondOrder(const TPosition& coords, const ScalarField<Data>& field, const FP3& shift) const
     {
         Int3 idx;
         FP3 internalCoords;
@@ -525,7 +738,8 @@ namespace pfc {
     }
 
     template< typename Data, GridTypes gT>
-    inline FP Grid<Data, gT>::getFieldFourthOrder(const FP3& coords, const ScalarField<Data>& field, const FP3& shift) const
+    template <class TPosition>
+    inline FP Grid<Data, gT>::getFieldFourthOrder(const TPosition& coords, const ScalarField<Data>& field, const FP3& shift) const
     {
         Int3 idx;
         FP3 internalCoords;
@@ -534,7 +748,8 @@ namespace pfc {
     }
 
     template< typename Data, GridTypes gT>
-    inline FP Grid<Data, gT>::getFieldPCS(const FP3& coords, const ScalarField<Data>& field, const FP3& shift) const
+    template <class TPosition>
+    inline FP Grid<Data, gT>::getFieldPCS(const TPosition& coords, const ScalarField<Data>& field, const FP3& shift) const
     {
         Int3 idx;
         FP3 internalCoords;
@@ -550,67 +765,191 @@ namespace pfc {
         Jz.zeroize();
     }
 
+    template<typename Data, GridTypes gT>
+    inline void Grid<Data, gT>::setInterleavedFields(bool enable)
+    {
+        if (enable) {
+            interleavedFields.resize(numCells.volume());
+            updateInterleavedFields();
+        }
+        else
+            std::vector<FieldRecordEB, NUMA_Allocator<FieldRecordEB>>().swap(interleavedFields);
+    }
+
+    template<typename Data, GridTypes gT>
+    inline void Grid<Data, gT>::updateInterleavedFields()
+    {
+        if (!isInterleavedFields()) {
+            interleavedFieldsState.changed = false;
+            return;
+        }
+        const int nx = numCells.x, ny = numCells.y, nz = numCells.z;
+        FieldRecordEB* records = interleavedFields.data();
+        OMP_FOR_COLLAPSE()
+        for (int i = 0; i < nx; i++)
+            for (int j = 0; j < ny; j++)
+                for (int k = 0; k < nz; k++) {
+                    FP* record = records[(i * ny + j) * nz + k].values;
+                    record[0] = Ex(i, j, k);
+                    record[1] = Ey(i, j, k);
+                    record[2] = Ez(i, j, k);
+                    record[3] = Bx(i, j, k);
+                    record[4] = By(i, j, k);
+                    record[5] = Bz(i, j, k);
+                }
+        // concurrent gathers see the flag cleared only after the records are written
+        interleavedFieldsState.changed.store(false, std::memory_order_release);
+    }
+
+    template<typename Data, GridTypes gT>
+    inline void Grid<Data, gT>::refreshInterleavedFields() const
+    {
+        if (!interleavedFieldsState.changed.load(std::memory_order_acquire))
+            return;
+        std::lock_guard<std::mutex> lock(interleavedFieldsState.mutex);
+        if (interleavedFieldsState.changed.load(std::memory_order_relaxed))
+            const_cast<Grid<Data, gT>*>(this)->updateInterleavedFields();
+    }
+
+    template<typename Data, GridTypes gT>
+    template <class TPosition>
+    inline void Grid<Data, gT>::getFieldsCICInterleaved(const TPosition& coords, FP3& e, FP3& b) const
+    {
+        refreshInterleavedFields();
+        const FieldRecordEB* records = interleavedFields.data();
+        FP values[6] = { 0, 0, 0, 0, 0, 0 };
+        int index[8];
+        FP weight[8];
+        if (!this->ifFieldsSpatialStaggered) {
+            // the components share the nodes and the weights
+            getCICNodes(coords, positionShift(coords, shiftEJx, normalizedShiftEJx), index, weight);
+            for (int n = 0; n < 8; n++) {
+                const FP* record = records[index[n]].values;
+                for (int c = 0; c < 6; c++)
+                    values[c] += weight[n] * record[c];
+            }
+        }
+        else {
+            const FP3* shifts[6] = {
+                &positionShift(coords, shiftEJx, normalizedShiftEJx),
+                &positionShift(coords, shiftEJy, normalizedShiftEJy),
+                &positionShift(coords, shiftEJz, normalizedShiftEJz),
+                &positionShift(coords, shiftBx, normalizedShiftBx),
+                &positionShift(coords, shiftBy, normalizedShiftBy),
+                &positionShift(coords, shiftBz, normalizedShiftBz) };
+            for (int c = 0; c < 6; c++) {
+                getCICNodes(coords, *shifts[c], index, weight);
+                for (int n = 0; n < 8; n++)
+                    values[c] += weight[n] * records[index[n]].values[c];
+            }
+        }
+        e = FP3(values[0], values[1], values[2]);
+        b = FP3(values[3], values[4], values[5]);
+    }
+
+    template<typename Data, GridTypes gT>
+    template <InterpolationType type, class TParticleArray>
+    inline void Grid<Data, gT>::gatherFields(const TParticleArray& particles, FP3* e, FP3* b) const
+    {
+        if (!(particles.getCellGeometry() == getCellGeometry())) {
+            std::string exc = "ERROR: cell geometry of the particles differs from the cells of the grid";
+            std::cout << exc << std::endl;
+            throw std::logic_error(exc);
+        }
+        const int size = particles.size();
+        OMP_FOR()
+        for (int i = 0; i < size; i++)
+            getFields<type>(particles.getCellPosition(i), e[i], b[i]);
+    }
+
+    template<typename Data, GridTypes gT>
+    template <class TPosition>
+    inline void Grid<Data, gT>::getCICNodes(const TPosition& coords, const FP3& shift,
+        int index[8], FP weight[8]) const
+    {
+        const Int3 dimensionCoeffInt(numCells.x > 1, numCells.y > 1, numCells.z > 1);
+        Int3 idx;
+        FP3 internalCoords;
+        getGridCoords(coords, shift, idx, internalCoords);
+        const FP3 w = internalCoords * (FP3)dimensionCoeffInt;
+        const FP3 invW = FP3(1, 1, 1) - w;
+        const Int3 base = (idx * dimensionCoeffInt) % numCells;  // % numCells for spectral grids
+        const Int3 next = (base + dimensionCoeffInt) % numCells;
+        const int x[2] = { base.x, next.x }, y[2] = { base.y, next.y }, z[2] = { base.z, next.z };
+        const FP wx[2] = { invW.x, w.x }, wy[2] = { invW.y, w.y }, wz[2] = { invW.z, w.z };
+        for (int ii = 0; ii < 2; ii++)
+            for (int jj = 0; jj < 2; jj++)
+                for (int kk = 0; kk < 2; kk++) {
+                    index[4 * ii + 2 * jj + kk] = (x[ii] * numCells.y + y[jj]) * numCells.z + z[kk];
+                    weight[4 * ii + 2 * jj + kk] = wx[ii] * wy[jj] * wz[kk];
+                }
+    }
+
     template< typename Data, GridTypes gT>
     inline void Grid<Data, gT>::setInterpolationType(InterpolationType type)
     {
         interpolationType = type;
-        switch (interpolationType)
-        {
-        case InterpolationType::Interpolation_CIC:
-            interpolationFields = &Grid<Data, gT>::getFieldsCIC;
-            interpolationEx = &Grid<Data, gT>::getExCIC;
-            interpolationEy = &Grid<Data, gT>::getEyCIC;
-            interpolationEz = &Grid<Data, gT>::getEzCIC;
-            interpolationBx = &Grid<Data, gT>::getBxCIC;
-            interpolationBy = &Grid<Data, gT>::getByCIC;
-            interpolationBz = &Grid<Data, gT>::getBzCIC;
-            interpolationJx = &Grid<Data, gT>::getJxCIC;
-            interpolationJy = &Grid<Data, gT>::getJyCIC;
-            interpolationJz = &Grid<Data, gT>::getJzCIC; break;
-        case InterpolationType::Interpolation_TSC:
-            interpolationFields = &Grid<Data, gT>::getFieldsTSC;
-            interpolationEx = &Grid<Data, gT>::getExTSC;
-            interpolationEy = &Grid<Data, gT>::getEyTSC;
-            interpolationEz = &Grid<Data, gT>::getEzTSC;
-            interpolationBx = &Grid<Data, gT>::getBxTSC;
-            interpolationBy = &Grid<Data, gT>::getByTSC;
-            interpolationBz = &Grid<Data, gT>::getBzTSC;
-            interpolationJx = &Grid<Data, gT>::getJxTSC;
-            interpolationJy = &Grid<Data, gT>::getJyTSC;
-            interpolationJz = &Grid<Data, gT>::getJzTSC; break;
-        case InterpolationType::Interpolation_PCS:
-            interpolationFields = &Grid<Data, gT>::getFieldsPCS;
-            interpolationEx = &Grid<Data, gT>::getExPCS;
-            interpolationEy = &Grid<Data, gT>::getEyPCS;
-            interpolationEz = &Grid<Data, gT>::getEzPCS;
-            interpolationBx = &Grid<Data, gT>::getBxPCS;
-            interpolationBy = &Grid<Data, gT>::getByPCS;
-            interpolationBz = &Grid<Data, gT>::getBzPCS;
-            interpolationJx = &Grid<Data, gT>::getJxPCS;
-            interpolationJy = &Grid<Data, gT>::getJyPCS;
-            interpolationJz = &Grid<Data, gT>::getJzPCS; break;
-        case InterpolationType::Interpolation_SecondOrder:
-            interpolationFields = &Grid<Data, gT>::getFieldsSecondOrder;
-            interpolationEx = &Grid<Data, gT>::getExSecondOrder;
-            interpolationEy = &Grid<Data, gT>::getEySecondOrder;
-            interpolationEz = &Grid<Data, gT>::getEzSecondOrder;
-            interpolationBx = &Grid<Data, gT>::getBxSecondOrder;
-            interpolationBy = &Grid<Data, gT>::getBySecondOrder;
-            interpolationBz = &Grid<Data, gT>::getBzSecondOrder;
-            interpolationJx = &Grid<Data, gT>::getJxSecondOrder;
-            interpolationJy = &Grid<Data, gT>::getJySecondOrder;
-            interpolationJz = &Grid<Data, gT>::getJzSecondOrder; break;
-        case InterpolationType::Interpolation_FourthOrder:
-            interpolationFields = &Grid<Data, gT>::getFieldsFourthOrder;
-            interpolationEx = &Grid<Data, gT>::getExFourthOrder;
-            interpolationEy = &Grid<Data, gT>::getEyFourthOrder;
-            interpolationEz = &Grid<Data, gT>::getEzFourthOrder;
-            interpolationBx = &Grid<Data, gT>::getBxFourthOrder;
-            interpolationBy = &Grid<Data, gT>::getByFourthOrder;
-            interpolationBz = &Grid<Data, gT>::getBzFourthOrder;
-            interpolationJx = &Grid<Data, gT>::getJxFourthOrder;
-            interpolationJy = &Grid<Data, gT>::getJyFourthOrder;
-            interpolationJz = &Grid<Data, gT>::getJzFourthOrder; break;
+    }
+
+    template< typename Data, GridTypes gT>
+    inline FP Grid<Data, gT>::getField(const FP3& coords, const ScalarField<Data>& field,
+        const FP3& shift) const
+    {
+        GRID_DISPATCH_INTERPOLATION(getField, coords, field, shift);
+    }
+
+    template< typename Data, GridTypes gT>
+    inline void Grid<Data, gT>::getFields(const FP3& coords, FP3& e, FP3& b) const
+    {
+        GRID_DISPATCH_INTERPOLATION(getFields, coords, e, b);
+    }
+
+    template< typename Data, GridTypes gT>
+    template <InterpolationType type, int numFields, class TPosition>
+    inline void Grid<Data, gT>::interpolateCollocated(const TPosition& coords,
+        const ScalarField<Data>* const fields[], FP result[]) const
+    {
+        // ScalarField<FP>::interpolateCIC takes the nodes modulo the field size
+        const bool isCICWrapped = !isComplex;
+        const ScalarField<Data>& field = *fields[0];
+        Int3 idx;
+        FP3 internalCoords;
+        // the switch is resolved at compile time
+        switch (type) {
+        case InterpolationType::Interpolation_TSC: {
+            getClosestGridCoords(coords, ZERO_SHIFT, idx, internalCoords);
+            InterpolationStencil<3> stencil;
+            field.getStencilTSC(idx, internalCoords, false, stencil);
+            ScalarField<Data>::template interpolate<numFields>(fields, stencil, result);
+            break;
+        }
+        case InterpolationType::Interpolation_PCS: {
+            getGridCoords(coords, ZERO_SHIFT, idx, internalCoords);
+            InterpolationStencil<4> stencil;
+            field.getStencilPCS(idx, internalCoords, false, stencil);
+            ScalarField<Data>::template interpolate<numFields>(fields, stencil, result);
+            break;
+        }
+        case InterpolationType::Interpolation_SecondOrder: {
+            getClosestGridCoords(coords, ZERO_SHIFT, idx, internalCoords);
+            InterpolationStencil<3> stencil;
+            field.getStencilSecondOrder(idx, internalCoords, false, stencil);
+            ScalarField<Data>::template interpolate<numFields>(fields, stencil, result);
+            break;
+        }
+        case InterpolationType::Interpolation_FourthOrder: {
+            getClosestGridCoords(coords, ZERO_SHIFT, idx, internalCoords);
+            InterpolationStencil<5> stencil;
+            field.getStencilFourthOrder(idx, internalCoords, false, stencil);
+            ScalarField<Data>::template interpolate<numFields>(fields, stencil, result);
+            break;
+        }
+        default: {
+            getGridCoords(coords, ZERO_SHIFT, idx, internalCoords);
+            InterpolationStencil<2> stencil;
+            field.getStencilCIC(idx, internalCoords, isCICWrapped, stencil);
+            ScalarField<Data>::template interpolate<numFields>(fields, stencil, result);
+        }
         }
     }
 
@@ -674,6 +1013,7 @@ namespace pfc {
         istr.read((char*)&shiftEJx, sizeof(shiftEJx));
         istr.read((char*)&shiftEJy, sizeof(shiftEJy));
         istr.read((char*)&shiftEJz, sizeof(shiftEJz));
+        updateNormalizedShifts();
 
         Bx.load(istr);
         By.load(istr);
@@ -684,5 +1024,7 @@ namespace pfc {
         Jx.load(istr);
         Jy.load(istr);
         Jz.load(istr);
+
+        if (isInterleavedFields()) setInterleavedFields(true);
     }
 }
@@ -33,11 +33,33 @@ forceinline bool funcname(const FP3& coords) const {               \
     return isInside(coords, shift);                                \
 }
 
-// method to return interpolated field value in arbitrary coords
-#define GRID_GET_FIELD_IMPL(funcname, interpolation)               \
+// methods to return interpolated field value in arbitrary coords:
+// with the interpolation given as a template argument and with the current one
+#define GRID_GET_FIELD_IMPL(funcname, field, shift)                \
+template <InterpolationType type>                                  \
 forceinline FP funcname(const FP3& coords) const                   \
 {                                                                  \
-    return (this->*interpolation)(coords);                         \
+    return getField<type>(coords, field, shift);                   \
+}                                                                  \
+forceinline FP funcname(const FP3& coords) const                   \
+{                                                                  \
+    return getField(coords, field, shift);                         \
+}
+
+// body of a method calling funcname with the current interpolation as the template argument
+#define GRID_DISPATCH_INTERPOLATION(funcname, ...)                           \
+switch (interpolationType)                                                   \
+{                                                                            \
+case InterpolationType::Interpolation_TSC:                                   \
+    return funcname<InterpolationType::Interpolation_TSC>(__VA_ARGS__);      \
+case InterpolationType::Interpolation_PCS:                                   \
+    return funcname<InterpolationType::Interpolation_PCS>(__VA_ARGS__);      \
+case InterpolationType::Interpolation_SecondOrder:                           \
+    return funcname<InterpolationType::Interpolation_SecondOrder>(__VA_ARGS__); \
+case InterpolationType::Interpolation_FourthOrder:                           \
+    return funcname<InterpolationType::Interpolation_FourthOrder>(__VA_ARGS__); \
+default:                                                                     \
+    return funcname<InterpolationType::Interpolation_CIC>(__VA_ARGS__);      \
 }
 
 // method to return CIC-interpolated field value in arbitrary coords
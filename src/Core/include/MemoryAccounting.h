@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define __USE_MALLINFO2__
+#endif
+
+namespace pfc {
+
+    /* Components the memory is accounted to:
+    Fields - storage of scalar fields (grids, interleaved records, user fields);
+    FieldSolver - temporary fields of the field solvers;
+    Pml - split fields, coefficients and temporary fields of PML;
+    FourierTransform - FFT plans (estimated by the heap growth, see getHeapAllocatedBytes);
+    Particles - particle arrays and ensembles. */
+    enum class MemoryCategory { Fields, FieldSolver, Pml, FourierTransform, Particles };
+    const int numMemoryCategories = 5;
+
+    inline const char* getMemoryCategoryName(MemoryCategory category)
+    {
+        static const char* names[numMemoryCategories] = {
+            "fields", "field_solver", "pml", "fourier_transform", "particles" };
+        return names[(int)category];
+    }
+
+    struct MemoryStats {
+        size_t numAllocations = 0;
+        size_t allocatedBytes = 0;
+        size_t peakAllocatedBytes = 0;  // high-water mark since the start or the last resetPeaks
+    };
+
+    // live memory of each component and of all of them, updated by the components
+    class MemoryRegistry {
+    public:
+
+        static MemoryRegistry& instance() {
+            static MemoryRegistry registry;
+            return registry;
+        }
+
+        void registerAllocation(MemoryCategory category, size_t bytes) {
+            add(counters[(int)category], bytes);
+            add(total, bytes);
+        }
+
+        void registerDeallocation(MemoryCategory category, size_t bytes) {
+            subtract(counters[(int)category], bytes);
+            subtract(total, bytes);
+        }
+
+        MemoryStats getStats(MemoryCategory category) const {
+            return getStats(counters[(int)category]);
+        }
+
+        MemoryStats getTotalStats() const {
+            return getStats(total);
+        }
+
+        // the high-water marks are set to the current values
+        void resetPeaks() {
+            for (int c = 0; c < numMemoryCategories; c++)
+                counters[c].peakAllocatedBytes = counters[c].allocatedBytes.load();
+            total.peakAllocatedBytes = total.allocatedBytes.load();
+        }
+
+    private:
+
+        struct Counters {
+            std::atomic<size_t> numAllocations, allocatedBytes, peakAllocatedBytes;
+            Counters() : numAllocations(0), allocatedBytes(0), peakAllocatedBytes(0) {}
+        };
+
+        MemoryRegistry() {}
+
+        static void add(Counters& counters, size_t bytes) {
+            counters.numAllocations++;
+            const size_t current = counters.allocatedBytes += bytes;
+            size_t peak = counters.peakAllocatedBytes.load();
+            while (current > peak && !counters.peakAllocatedBytes.compare_exchange_weak(peak, current));
+        }
+
+        static void subtract(Counters& counters, size_t bytes) {
+            counters.numAllocations--;
+            counters.allocatedBytes -= bytes;
+        }
+
+        static MemoryStats getStats(const Counters& counters) {
+            MemoryStats stats;
+            stats.numAllocations = counters.numAllocations.load();
+            stats.allocatedBytes = counters.allocatedBytes.load();
+            stats.peakAllocatedBytes = counters.peakAllocatedBytes.load();
+            return stats;
+        }
+
+        Counters counters[numMemoryCategories];
+        Counters total;
+    };
+
+    /* Returns the number of bytes in use on the heap of malloc, including the chunks
+    mapped with mmap, 0 if it is unknown (not glibc 2.33+). Used to estimate memory
+    allocated by third-party libraries, e.g. by FFTW for plans, as the growth of the heap.
+    It is an estimate only: allocations and deallocations of other threads made
+    in the meantime are counted too. */
+    inline size_t getHeapAllocatedBytes()
+    {
+#ifdef __USE_MALLINFO2__
+        const struct mallinfo2 info = mallinfo2();
+        return info.uordblks + info.hblkhd;
+#else
+        return 0;
+#endif
+    }
+
+    // allocator of std containers reporting to MemoryRegistry
+    template <class T, MemoryCategory category>
+    class TrackingAllocator {
+    public:
+
+        using value_type = T;
+        using propagate_on_container_move_assignment = std::true_type;
+        using is_always_equal = std::true_type;
+
+        template <class U>
+        struct rebind {
+            typedef TrackingAllocator<U, category> other;
+        };
+
+        TrackingAllocator() noexcept {}
+        template <class U>
+        TrackingAllocator(const TrackingAllocator<U, category>&) noexcept {}
+
+        T* allocate(size_t num)
+        {
+            T* p = static_cast<T*>(::operator new(num * sizeof(T)));
+            MemoryRegistry::instance().registerAllocation(category, num * sizeof(T));
+            return p;
+        }
+
+        void deallocate(T* p, size_t num)
+        {
+            MemoryRegistry::instance().registerDeallocation(category, num * sizeof(T));
+            ::operator delete(p);
+        }
+
+        friend bool operator==(const TrackingAllocator&, const TrackingAllocator&) {
+            return true;
+        }
+
+        friend bool operator!=(const TrackingAllocator&, const TrackingAllocator&) {
+            return false;
+        }
+    };
+
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "CellPosition.h"
 #include "Constants.h"
 #include "FP.h"
 #include "ParticleTypes.h"
@@ -32,10 +33,14 @@ namespace pfc {
         extern short numTypes;
     };
 
-    template<Dimension dimension>
+    // The position proxy can be a proxy of a vector (by default) or of a cell-relative position
+    template<Dimension dimension, typename TStorage = Real,
+        class TPositionProxy = typename ProxyVectorTypeHelper<dimension, TStorage>::Type>
     class ParticleProxy;
 
-    template<Dimension dimension>
+    // Particle data is stored with precision TStorage, e.g. float to halve the memory of particles.
+    // The interface uses Real, so that pushers compute with the precision of fields
+    template<Dimension dimension, typename TStorage = Real>
     class Particle {
     public:
         
@@ -45,12 +50,17 @@ namespace pfc {
         typedef Real GammaType;
         typedef Real WeightType;
         typedef ParticleTypes TypeIndexType;
-        typedef typename ProxyVectorTypeHelper<dimension, Real>::Type PositionTypeProxy;
-        typedef typename ProxyVectorTypeHelper<Three, Real>::Type MomentumTypeProxy;
-        typedef reference_wrapper<Real> GammaTypeProxy;
-        typedef reference_wrapper<Real> WeightTypeProxy;
+        typedef typename ProxyVectorTypeHelper<dimension, TStorage>::Type PositionTypeProxy;
+        typedef typename ProxyVectorTypeHelper<Three, TStorage>::Type MomentumTypeProxy;
+        typedef reference_wrapper<TStorage> GammaTypeProxy;
+        typedef reference_wrapper<TStorage> WeightTypeProxy;
         typedef reference_wrapper<ParticleTypes> TypeIndexTypeProxy;
 
+        // Types of the stored data
+        typedef TStorage StorageType;
+        typedef typename VectorTypeHelper<dimension, TStorage>::Type StoredPositionType;
+        typedef typename VectorTypeHelper<Three, TStorage>::Type StoredMomentumType;
+
         Particle() :
             weight(1),
             gamma(1.0),
@@ -59,12 +69,12 @@ namespace pfc {
 
         Particle(const PositionType& position, const MomentumType& momentum,
             WeightType weight = 1, TypeIndexType typeIndex = ParticleTypes::Electron) :
-            position(position), weight(weight), typeIndex(typeIndex)
+            position(position), weight(static_cast<TStorage>(weight)), typeIndex(typeIndex)
         {
             setMomentum(momentum);
         }
 
-        Particle(ParticleProxy<dimension>& particleProxy)
+        Particle(ParticleProxy<dimension, TStorage>& particleProxy)
         {
             this->setPosition(particleProxy.getPosition());
             this->setP(particleProxy.getP());
@@ -72,7 +82,16 @@ namespace pfc {
             this->setType(particleProxy.getType());
         }
 
-        Particle(ParticleProxy<dimension> particleProxy)
+        Particle(ParticleProxy<dimension, TStorage> particleProxy)
+        {
+            this->setPosition(particleProxy.getPosition());
+            this->setP(particleProxy.getP());
+            this->setWeight(particleProxy.getWeight());
+            this->setType(particleProxy.getType());
+        }
+
+        template<class TPositionProxy>
+        Particle(const ParticleProxy<dimension, TStorage, TPositionProxy>& particleProxy)
         {
             this->setPosition(particleProxy.getPosition());
             this->setP(particleProxy.getP());
@@ -86,32 +105,30 @@ namespace pfc {
 
         MomentumType getMomentum() const
         {
-            return p * Constants<MassType>::c() * getMass();
+            return getP() * Constants<MassType>::c() * getMass();
         }
 
         void setMomentum(const MomentumType& newMomentum)
         {
-            p = newMomentum / (Constants<GammaType>::c() * getMass());
-            gamma = sqrt(static_cast<GammaType>(1.0) + p.norm2());
+            setP(newMomentum / (Constants<GammaType>::c() * getMass()));
         }
 
         void setP(const  MomentumType& newP)
         {
             p = newP;
-            gamma = sqrt(static_cast<GammaType>(1.0) + p.norm2());
+            gamma = static_cast<TStorage>(sqrt(static_cast<GammaType>(1.0) + newP.norm2()));
         }
         MomentumTypeProxy getProxyP() { return MomentumTypeProxy(p); } //only advanced users
         MomentumType getP() const { return p; }
 
         MomentumType getVelocity() const
         {
-            return p * (Constants<GammaType>::c() / gamma);
+            return getP() * (Constants<GammaType>::c() / getGamma());
         }
 
         void setVelocity(const MomentumType& newVelocity)
         {
-            p = newVelocity / sqrt(constants::c * constants::c - newVelocity.norm2());
-            gamma = sqrt((FP)1 + p.norm2());
+            setP(newVelocity / sqrt(constants::c * constants::c - newVelocity.norm2()));
         }
 
         GammaTypeProxy getProxyGamma() { return GammaTypeProxy(gamma); } //only advanced users
@@ -123,28 +140,28 @@ namespace pfc {
 
         WeightTypeProxy getProxyWeight() { return WeightTypeProxy(weight); } //only advanced users
         WeightType getWeight() const { return weight; }
-        void setWeight(WeightType newWeight) { weight = newWeight; }
+        void setWeight(WeightType newWeight) { weight = static_cast<TStorage>(newWeight); }
 
         TypeIndexType getType() const { return typeIndex; }
         void setType(TypeIndexType newType) { typeIndex = newType; }
 
         void save(std::ostream& os)
         {
-            os.write((char*)this, sizeof(Particle<dimension>));
+            os.write((char*)this, sizeof(Particle<dimension, TStorage>));
         }
         void load(std::istream& is)
         {
-            is.read((char*)this, sizeof(Particle<dimension>));
+            is.read((char*)this, sizeof(Particle<dimension, TStorage>));
         }
     private:
 
-        PositionType position;
-        MomentumType p;
-        WeightType weight;
-        GammaType gamma;
+        StoredPositionType position;
+        StoredMomentumType p;
+        TStorage weight;
+        TStorage gamma;
         TypeIndexType typeIndex;
 
-        template<Dimension dim>
+        template<Dimension, typename, class>
         friend class ParticleProxy;
     };
 
@@ -153,7 +170,7 @@ namespace pfc {
     typedef Particle<Three> Particle3d;
 
 
-    template<Dimension dimension>
+    template<Dimension dimension, typename TStorage, class TPositionProxy>
     class ParticleProxy {
     public:
 
@@ -163,25 +180,30 @@ namespace pfc {
         typedef Real GammaType;
         typedef Real WeightType;
         typedef ParticleTypes TypeIndexType;
-        typedef typename ProxyVectorTypeHelper<dimension, Real>::Type PositionTypeProxy;
-        typedef typename ProxyVectorTypeHelper<Three, Real>::Type MomentumTypeProxy;
-        typedef reference_wrapper<GammaType> GammaTypeProxy;
-        typedef reference_wrapper<WeightType> WeightTypeProxy;
+        typedef TPositionProxy PositionTypeProxy;
+        typedef typename ProxyVectorTypeHelper<Three, TStorage>::Type MomentumTypeProxy;
+        typedef reference_wrapper<TStorage> GammaTypeProxy;
+        typedef reference_wrapper<TStorage> WeightTypeProxy;
         typedef reference_wrapper<TypeIndexType> TypeIndexTypeProxy;
 
+        // Types of the stored data
+        typedef TStorage StorageType;
+        typedef typename VectorTypeHelper<dimension, TStorage>::Type StoredPositionType;
+        typedef typename VectorTypeHelper<Three, TStorage>::Type StoredMomentumType;
+
         ParticleProxy(PositionTypeProxy& position, MomentumTypeProxy& p,
             WeightTypeProxy& weight, TypeIndexTypeProxy& typeIndex, GammaTypeProxy& gamma) :
             position(position), weight(weight), typeIndex(typeIndex),
             p(p), gamma(gamma)
         {}
 
-        ParticleProxy(PositionType& position, MomentumType& p,
-            WeightType& weight, TypeIndexType& typeIndex, GammaType& gamma) :
+        ParticleProxy(StoredPositionType& position, StoredMomentumType& p,
+            TStorage& weight, TypeIndexType& typeIndex, TStorage& gamma) :
             position(position), weight(weight), typeIndex(typeIndex),
             p(p), gamma(gamma)
         {}
 
-        ParticleProxy(Particle<dimension>& particle) :
+        ParticleProxy(Particle<dimension, TStorage>& particle) :
             position(particle.position), weight(particle.weight), typeIndex(particle.typeIndex),
             p(particle.p), gamma(particle.gamma)
         {}
@@ -192,35 +214,37 @@ namespace pfc {
         //{}
 
         PositionTypeProxy& getProxyPosition() { return position; } //only advanced users
-        PositionType getPosition() { return position.toVector(); }
+        PositionType getPosition() const { return position.toVector(); }
         void setPosition(const PositionType& newPosition) { position = newPosition; }
 
+        // conversions for cell-relative positions, the components beyond the dimension are zero
+        CellPosition getCellPosition() const { return position.getCellPosition(); }
+        void setCellPosition(const CellPosition& newPosition) { position.setCellPosition(newPosition); }
+
         MomentumType getMomentum() const
         {
-            return p * (Constants<MassType>::c() * getMass());
+            return getP() * (Constants<MassType>::c() * getMass());
         }
         void setMomentum(const MomentumType& newMomentum)
         {
-            p = newMomentum / (Constants<GammaType>::c() * getMass());
-            gamma.get() = sqrt(static_cast<GammaType>(1.0) + p.norm2());
+            setP(newMomentum / (Constants<GammaType>::c() * getMass()));
         }
 
         MomentumTypeProxy getProxyP() const { return p; } //only advanced users
-        MomentumType getP() { return p.toVector(); }
+        MomentumType getP() const { return p.toVector(); }
         void setP(const  MomentumType& newP)
         {
-            p = newP;
-            gamma.get() = sqrt(static_cast<GammaType>(1.0) + p.norm2());
+            p = StoredMomentumType(newP);
+            gamma.get() = static_cast<TStorage>(sqrt(static_cast<GammaType>(1.0) + newP.norm2()));
         }
 
         MomentumType getVelocity() const
         {
-            return p * (Constants<GammaType>::c() / gamma.get());
+            return getP() * (Constants<GammaType>::c() / getGamma());
         }
         void setVelocity(const MomentumType& newVelocity)
         {
-            p = newVelocity / sqrt(constants::c * constants::c - newVelocity.norm2());
-            gamma.get() = sqrt((FP)1 + p.norm2());
+            setP(newVelocity / sqrt(constants::c * constants::c - newVelocity.norm2()));
         }
 
         GammaType getGamma() const { return gamma.get(); }
@@ -232,7 +256,7 @@ namespace pfc {
 
         WeightTypeProxy getProxyWeight() const { return weight; } //only advanced users
         WeightType getWeight() const { return weight.get(); }
-        void setWeight(WeightType newWeight) { weight.get() = newWeight; }
+        void setWeight(WeightType newWeight) { weight.get() = static_cast<TStorage>(newWeight); }
 
         TypeIndexType getType() const { return typeIndex.get(); }
         void setType(TypeIndexType newType) { typeIndex.get() = newType; }
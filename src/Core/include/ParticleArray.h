@@ -1,6 +1,8 @@
 #pragma once
 
+#include "CellPosition.h"
 #include "Dimension.h"
+#include "MemoryAccounting.h"
 #include "Particle.h"
 #include "ParticleTypes.h"
 #include "ParticleTraits.h"
@@ -14,6 +16,10 @@
 
 namespace pfc {
 
+    // storage of particles, accounted to MemoryCategory::Particles
+    template <class T>
+    using ParticleVector = std::vector<T, TrackingAllocator<T, MemoryCategory::Particles>>;
+
     template<typename pArray_t, typename ParticleType>
     class iteratorPArray : public std::iterator<std::random_access_iterator_tag, ParticleType, size_t>
     {
@@ -87,34 +93,74 @@ namespace pfc {
     };
 
 
-    enum ParticleRepresentation { ParticleRepresentation_AoS, ParticleRepresentation_SoA };
+    enum ParticleRepresentation { ParticleRepresentation_AoS, ParticleRepresentation_SoA,
+        ParticleRepresentation_CellSoA };
 
 
-    // Collection of particles with array-like semantics,
-    // representation as array of structures
+    // Proxy vector to the idx-th elements of the component arrays
     template<Dimension dimension>
+    struct ComponentProxyHelper {
+    };
+
+    template<>
+    struct ComponentProxyHelper<One> {
+        template<class TArray>
+        static Vector1Proxy<typename TArray::value_type> get(TArray* components, int idx)
+        {
+            return Vector1Proxy<typename TArray::value_type>(components[0][idx]);
+        }
+    };
+
+    template<>
+    struct ComponentProxyHelper<Two> {
+        template<class TArray>
+        static Vector2Proxy<typename TArray::value_type> get(TArray* components, int idx)
+        {
+            return Vector2Proxy<typename TArray::value_type>(components[0][idx], components[1][idx]);
+        }
+    };
+
+    template<>
+    struct ComponentProxyHelper<Three> {
+        template<class TArray>
+        static Vector3Proxy<typename TArray::value_type> get(TArray* components, int idx)
+        {
+            return Vector3Proxy<typename TArray::value_type>(components[0][idx], components[1][idx],
+                components[2][idx]);
+        }
+    };
+
+
+    // Collection of particles with array-like semantics,
+    // representation as array of structures,
+    // particle data is stored with precision TStorage
+    template<Dimension dimension, typename TStorage = Real>
     class ParticleArrayAoS {
     public:
 
         static const ParticleRepresentation particleRepresentationType = ParticleRepresentation::ParticleRepresentation_AoS;
 
-        typedef typename ParticleTraits<Particle<dimension>>::PositionType PositionType;
-        typedef typename ParticleTraits<Particle<dimension>>::MomentumType MomentumType;
-        typedef typename ParticleTraits<Particle<dimension>>::GammaType GammaType;
-        typedef typename ParticleTraits<Particle<dimension>>::WeightType WeightType;
-        typedef typename ParticleTraits<Particle<dimension>>::TypeIndexType TypeIndexType;
-        typedef Particle<dimension> ParticleType; 
-        typedef Particle<dimension>& ParticleRef;
-        typedef const Particle<dimension>& ConstParticleRef;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::PositionType PositionType;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::MomentumType MomentumType;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::GammaType GammaType;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::WeightType WeightType;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::TypeIndexType TypeIndexType;
+        typedef Particle<dimension, TStorage> ParticleType; 
+        typedef Particle<dimension, TStorage>& ParticleRef;
+        typedef const Particle<dimension, TStorage>& ConstParticleRef;
         static const int momentumDimension = VectorDimensionHelper<MomentumType>::dimension;
-        typedef ParticleProxy<dimension> ParticleProxyType;
+        typedef ParticleProxy<dimension, TStorage> ParticleProxyType;
+        typedef TStorage StorageType;
 
 
-        typedef ParticleArrayAoS<dimension> typeArray;
+        typedef ParticleArrayAoS<dimension, TStorage> typeArray;
         typedef iteratorPArray<typeArray, ParticleProxyType> iterator;
 
         inline size_t size() const { return static_cast<size_t>(particles.size()); }
 
+        // bytes of the allocated storage
+        inline size_t getMemoryUsage() const { return particles.capacity() * sizeof(ParticleType); }
+
         ParticleArrayAoS(ParticleTypes type = Electron)
         {
             setType(type);
@@ -143,6 +189,11 @@ namespace pfc {
             if(particle.getType() == typeIndex)
                 particles.push_back(particle); 
         }
+
+        // Unlike pushBack, the particle is stored with its own type, the types of particles
+        // of an AoS array can differ after setType
+        inline void pushBackKeepingType(ConstParticleRef particle) { particles.push_back(particle); }
+
         inline void popBack() { particles.pop_back(); }
 
         inline void deleteParticle(iterator& idx)
@@ -165,6 +216,23 @@ namespace pfc {
             particles.clear();
         }
 
+        // New particles are default ones of the array type, storage is reallocated at most once
+        inline void resize(int newSize)
+        {
+            ParticleType particle;
+            particle.setType(typeIndex);
+            particles.resize(newSize, particle);
+        }
+
+        // Keep only particles with given indices (in ascending order), one pass
+        inline void compact(const std::vector<int>& indices)
+        {
+            const int newSize = static_cast<int>(indices.size());
+            for (int i = 0; i < newSize; i++)
+                particles[i] = particles[indices[i]];
+            particles.erase(particles.begin() + newSize, particles.end());
+        }
+
         inline iterator begin() { return iterator(this, 0); }
         inline iterator end() { return iterator(this, size()); }
         inline const iterator cbegin() { return begin(); }
@@ -179,7 +247,7 @@ namespace pfc {
             size_t tmp = size();
             os.write((char*)&tmp, sizeof(tmp));
             os.write((char*)&typeIndex, sizeof(typeIndex));
-            os.write((char*)particles.data(), sizeof(Particle<dimension>)*tmp);
+            os.write((char*)particles.data(), sizeof(ParticleType)*tmp);
         }
         inline void load(std::istream& is)
         {
@@ -196,41 +264,43 @@ namespace pfc {
             is.read((char*)&tmp, sizeof(tmp));
             is.read((char*)&typeIndex, sizeof(typeIndex));
             particles.resize(tmp);
-            is.read((char*)particles.data(), sizeof(Particle<dimension>) * size());
+            is.read((char*)particles.data(), sizeof(ParticleType) * size());
         }
 
     private:
         ParticleTypes typeIndex;
-        std::vector<ParticleType> particles;
+        ParticleVector<ParticleType> particles;
     };
 
     // Collection of particles with array-like semantics,
-    // representation as structure of arrays
-    template<Dimension dimension>
+    // representation as structure of arrays,
+    // particle data is stored with precision TStorage
+    template<Dimension dimension, typename TStorage = Real>
     class ParticleArraySoA {
     public:
 
         static const ParticleRepresentation particleRepresentationType = ParticleRepresentation::ParticleRepresentation_SoA;
 
-        typedef typename ParticleTraits<Particle<dimension>>::PositionType PositionType;
-        typedef typename ParticleTraits<Particle<dimension>>::MomentumType MomentumType;
-        typedef typename ParticleTraits<Particle<dimension>>::GammaType GammaType;
-        typedef typename ParticleTraits<Particle<dimension>>::WeightType WeightType;
-        typedef typename ParticleTraits<Particle<dimension>>::TypeIndexType TypeIndexType;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::PositionType PositionType;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::MomentumType MomentumType;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::GammaType GammaType;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::WeightType WeightType;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::TypeIndexType TypeIndexType;
 
-        typedef typename ParticleTraits<Particle<dimension>>::PositionTypeProxy PositionTypeProxy;
-        typedef typename ParticleTraits<Particle<dimension>>::MomentumTypeProxy MomentumTypeProxy;
-        typedef typename ParticleTraits<Particle<dimension>>::GammaTypeProxy GammaTypeProxy;
-        typedef typename ParticleTraits<Particle<dimension>>::WeightTypeProxy WeightTypeProxy;
-        typedef typename ParticleTraits<Particle<dimension>>::TypeIndexTypeProxy TypeIndexTypeProxy;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::PositionTypeProxy PositionTypeProxy;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::MomentumTypeProxy MomentumTypeProxy;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::GammaTypeProxy GammaTypeProxy;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::WeightTypeProxy WeightTypeProxy;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::TypeIndexTypeProxy TypeIndexTypeProxy;
 
-        typedef Particle<dimension> ParticleType;
-        typedef Particle<dimension>& ParticleRef;
-        typedef const Particle<dimension>& ConstParticleRef;
-        typedef ParticleProxy<dimension> ParticleProxyType;
+        typedef Particle<dimension, TStorage> ParticleType;
+        typedef Particle<dimension, TStorage>& ParticleRef;
+        typedef const Particle<dimension, TStorage>& ConstParticleRef;
+        typedef ParticleProxy<dimension, TStorage> ParticleProxyType;
+        typedef TStorage StorageType;
 
 
-        typedef ParticleArraySoA<dimension> typeArray;
+        typedef ParticleArraySoA<dimension, TStorage> typeArray;
         typedef iteratorPArray<typeArray, ParticleProxyType> iterator;
 
         static const int positionDimension = VectorDimensionHelper<PositionType>::dimension;
@@ -238,6 +308,17 @@ namespace pfc {
 
         inline int size() const { return static_cast<int>(weights.size()); }
 
+        // bytes of the allocated storage
+        inline size_t getMemoryUsage() const
+        {
+            size_t result = weights.capacity() * sizeof(TStorage) + gammas.capacity() * sizeof(TStorage);
+            for (int i = 0; i < positionDimension; i++)
+                result += positions[i].capacity() * sizeof(TStorage);
+            for (int i = 0; i < momentumDimension; i++)
+                result += ps[i].capacity() * sizeof(TStorage);
+            return result;
+        }
+
         ParticleArraySoA(ParticleTypes type = Electron)
         {
             setType(type);
@@ -260,21 +341,32 @@ namespace pfc {
             return operator[](this->size() - 1);
         }
 
+        // Raw pointers to the component storage, p is stored normalized by mc.
+        // Pointers are invalidated when the array grows
+        inline TStorage* getPositionData(int d) { return positions[d].data(); }
+        inline TStorage* getPData(int d) { return ps[d].data(); }
+        inline TStorage* getWeightData() { return weights.data(); }
+        inline TStorage* getGammaData() { return gammas.data(); }
+
         inline void pushBack(ConstParticleRef particle)
         {
             if (particle.getType() == typeIndex)
             {
                 const PositionType position = particle.getPosition();
                 for (int d = 0; d < positionDimension; d++)
-                    positions[d].push_back(position[d]);
+                    positions[d].push_back(static_cast<TStorage>(position[d]));
                 const MomentumType p = particle.getP();
                 for (int d = 0; d < momentumDimension; d++)
-                    ps[d].push_back(p[d]);
-                weights.push_back(particle.getWeight());
-                gammas.push_back(particle.getGamma());
+                    ps[d].push_back(static_cast<TStorage>(p[d]));
+                weights.push_back(static_cast<TStorage>(particle.getWeight()));
+                gammas.push_back(static_cast<TStorage>(particle.getGamma()));
             }
             
         }
+
+        // All particles of the array have the type of the array, particles of other types are skipped as by pushBack
+        inline void pushBackKeepingType(ConstParticleRef particle) { pushBack(particle); }
+
         inline void popBack()
         {
             for (int d = 0; d < positionDimension; d++)
@@ -324,6 +416,43 @@ namespace pfc {
             gammas.clear();
         }
 
+        // New particles are default ones (at rest in the origin, unit weight),
+        // storage is reallocated at most once, so it can be filled in parallel via the raw pointers
+        inline void resize(int newSize)
+        {
+            for (int d = 0; d < positionDimension; d++)
+                positions[d].resize(newSize);
+            for (int d = 0; d < momentumDimension; d++)
+                ps[d].resize(newSize);
+            weights.resize(newSize, static_cast<TStorage>(1.0));
+            gammas.resize(newSize, static_cast<TStorage>(1.0));
+        }
+
+        // Keep only particles with given indices (in ascending order), one pass
+        inline void compact(const std::vector<int>& indices)
+        {
+            const int newSize = static_cast<int>(indices.size());
+            for (int d = 0; d < positionDimension; d++)
+            {
+                for (int i = 0; i < newSize; i++)
+                    positions[d][i] = positions[d][indices[i]];
+                positions[d].resize(newSize);
+            }
+            for (int d = 0; d < momentumDimension; d++)
+            {
+                for (int i = 0; i < newSize; i++)
+                    ps[d][i] = ps[d][indices[i]];
+                ps[d].resize(newSize);
+            }
+            for (int i = 0; i < newSize; i++)
+            {
+                weights[i] = weights[indices[i]];
+                gammas[i] = gammas[indices[i]];
+            }
+            weights.resize(newSize);
+            gammas.resize(newSize);
+        }
+
         inline iterator begin() { return iterator(this, 0); }
         inline iterator end() { return iterator(this, size()); }
         inline const iterator cbegin() { return begin(); }
@@ -339,11 +468,11 @@ namespace pfc {
             size_t tmp = size();
             os.write((char*)&tmp, sizeof(tmp));
             for (int i = 0; i < positionDimension; i++)
-                os.write((char*)positions[i].data(), sizeof(typename ScalarType<PositionType>::Type) * tmp);
+                os.write((char*)positions[i].data(), sizeof(TStorage) * tmp);
             for (int i = 0; i < momentumDimension; i++)
-                os.write((char*)ps[i].data(), sizeof(typename ScalarType<MomentumType>::Type) * tmp);
-            os.write((char*)weights.data(), sizeof(WeightType) * tmp);
-            os.write((char*)gammas.data(), sizeof(GammaType) * tmp);
+                os.write((char*)ps[i].data(), sizeof(TStorage) * tmp);
+            os.write((char*)weights.data(), sizeof(TStorage) * tmp);
+            os.write((char*)gammas.data(), sizeof(TStorage) * tmp);
             os.write((char*)&typeIndex, sizeof(typeIndex));
         }
         inline void load(std::istream& is)
@@ -362,32 +491,33 @@ namespace pfc {
             for (int i = 0; i < positionDimension; i++)
             {
                 positions[i].resize(tmp);
-                is.read((char*)positions[i].data(), sizeof(typename ScalarType<PositionType>::Type) * tmp);
+                is.read((char*)positions[i].data(), sizeof(TStorage) * tmp);
             }
             for (int i = 0; i < momentumDimension; i++)
             {
                 ps[i].resize(tmp);
-                is.read((char*)ps[i].data(), sizeof(typename ScalarType<MomentumType>::Type) * tmp);
+                is.read((char*)ps[i].data(), sizeof(TStorage) * tmp);
             }
             weights.resize(tmp);
-            is.read((char*)weights.data(), sizeof(WeightType) * tmp);
+            is.read((char*)weights.data(), sizeof(TStorage) * tmp);
             gammas.resize(tmp);
-            is.read((char*)gammas.data(), sizeof(GammaType) * tmp);
+            is.read((char*)gammas.data(), sizeof(TStorage) * tmp);
             is.read((char*)&typeIndex, sizeof(typeIndex));
         }
 
     private:
-        std::vector<typename ScalarType<PositionType>::Type> positions[positionDimension];
-        std::vector<typename ScalarType<MomentumType>::Type> ps[momentumDimension];
-        std::vector<WeightType> weights;
-        std::vector<GammaType> gammas;
+        ParticleVector<TStorage> positions[positionDimension];
+        ParticleVector<TStorage> ps[momentumDimension];
+        ParticleVector<TStorage> weights;
+        ParticleVector<TStorage> gammas;
         ParticleTypes typeIndex;
     };
 
-    template<>
-    inline ParticleArraySoA<One>::ParticleProxyType ParticleArraySoA<One>::operator[](int idx)
+    template<Dimension dimension, typename TStorage>
+    inline typename ParticleArraySoA<dimension, TStorage>::ParticleProxyType
+        ParticleArraySoA<dimension, TStorage>::operator[](int idx)
     {
-        PositionTypeProxy posProxy(positions[0][idx]);
+        PositionTypeProxy posProxy = ComponentProxyHelper<dimension>::get(positions, idx);
         MomentumTypeProxy momProxy(ps[0][idx], ps[1][idx], ps[2][idx]);
         WeightTypeProxy weightRef = ref(weights[idx]);
         TypeIndexTypeProxy typeRef = ref(typeIndex);
@@ -395,30 +525,328 @@ namespace pfc {
 
         return ParticleProxyType(posProxy, momProxy, weightRef, typeRef, gammaRef);
     }
-    
-    template<>
-    inline ParticleArraySoA<Two>::ParticleProxyType ParticleArraySoA<Two>::operator[](int idx)
-    {
-        PositionTypeProxy posProxy(positions[0][idx], positions[1][idx]);
-        MomentumTypeProxy momProxy(ps[0][idx], ps[1][idx], ps[2][idx]);
-        WeightTypeProxy weightRef = ref(weights[idx]);
-        TypeIndexTypeProxy typeRef = ref(typeIndex);
-        GammaTypeProxy gammaRef = ref(gammas[idx]);
 
-        return ParticleProxyType(posProxy, momProxy, weightRef, typeRef, gammaRef);
-    }
 
-    template<>
-    inline ParticleArraySoA<Three>::ParticleProxyType ParticleArraySoA<Three>::operator[](int idx)
-    {
-        PositionTypeProxy posProxy(positions[0][idx], positions[1][idx], positions[2][idx]);
-        MomentumTypeProxy momProxy(ps[0][idx], ps[1][idx], ps[2][idx]);
-        WeightTypeProxy weightRef = ref(weights[idx]);
-        TypeIndexTypeProxy typeRef = ref(typeIndex);
-        GammaTypeProxy gammaRef = ref(gammas[idx]);
+    // Collection of particles with array-like semantics,
+    // representation as structure of arrays with cell-relative positions:
+    // the index of a cell and the offset in the cell normalized by the cell size are stored,
+    // so the precision of positions is the same in the whole domain and
+    // fields are gathered without conversion of coords to cells, see Grid::gatherFields.
+    // The interface of particles and proxies uses the positions in coords
+    template<Dimension dimension, typename TStorage = Real>
+    class ParticleArrayCellSoA {
+    public:
 
-        return ParticleProxyType(posProxy, momProxy, weightRef, typeRef, gammaRef);
-    }
+        static const ParticleRepresentation particleRepresentationType = ParticleRepresentation::ParticleRepresentation_CellSoA;
+
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::PositionType PositionType;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::MomentumType MomentumType;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::GammaType GammaType;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::WeightType WeightType;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::TypeIndexType TypeIndexType;
+
+        typedef CellPositionProxy<dimension, TStorage> PositionTypeProxy;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::MomentumTypeProxy MomentumTypeProxy;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::GammaTypeProxy GammaTypeProxy;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::WeightTypeProxy WeightTypeProxy;
+        typedef typename ParticleTraits<Particle<dimension, TStorage>>::TypeIndexTypeProxy TypeIndexTypeProxy;
+
+        typedef Particle<dimension, TStorage> ParticleType;
+        typedef Particle<dimension, TStorage>& ParticleRef;
+        typedef const Particle<dimension, TStorage>& ConstParticleRef;
+        typedef ParticleProxy<dimension, TStorage, PositionTypeProxy> ParticleProxyType;
+        typedef TStorage StorageType;
+
+
+        typedef ParticleArrayCellSoA<dimension, TStorage> typeArray;
+        typedef iteratorPArray<typeArray, ParticleProxyType> iterator;
+
+        static const int positionDimension = VectorDimensionHelper<PositionType>::dimension;
+        static const int momentumDimension = VectorDimensionHelper<MomentumType>::dimension;
+
+        inline int size() const { return static_cast<int>(weights.size()); }
+
+        // bytes of the allocated storage
+        inline size_t getMemoryUsage() const
+        {
+            size_t result = weights.capacity() * sizeof(TStorage) + gammas.capacity() * sizeof(TStorage);
+            for (int i = 0; i < positionDimension; i++)
+                result += cells[i].capacity() * sizeof(int) + offsets[i].capacity() * sizeof(TStorage);
+            for (int i = 0; i < momentumDimension; i++)
+                result += ps[i].capacity() * sizeof(TStorage);
+            return result;
+        }
+
+        ParticleArrayCellSoA(ParticleTypes type = Electron, const CellGeometry& geometry = CellGeometry()) :
+            geometry(geometry)
+        {
+            setType(type);
+        }
+
+        inline void setType(ParticleTypes type)
+        {
+            typeIndex = type;
+        }
+
+        inline ParticleTypes getType()
+        {
+            return static_cast<ParticleTypes>(typeIndex);
+        }
+
+        inline const CellGeometry& getCellGeometry() const { return geometry; }
+
+        // Positions of the stored particles are converted to the new cells,
+        // for gathering of fields the cells should be the cells of the grid, e.g. grid.getCellGeometry()
+        inline void setCellGeometry(const CellGeometry& newGeometry)
+        {
+            const int size = this->size();
+            for (int d = 0; d < positionDimension; d++)
+                for (int i = 0; i < size; i++)
+                    newGeometry.split(geometry.join(cells[d][i], offsets[d][i], d), d,
+                        cells[d][i], offsets[d][i]);
+            geometry = newGeometry;
+        }
+
+        inline ParticleProxyType operator[](int idx)
+        {
+            int* cellRefs[positionDimension];
+            TStorage* offsetRefs[positionDimension];
+            for (int d = 0; d < positionDimension; d++)
+            {
+                cellRefs[d] = &cells[d][idx];
+                offsetRefs[d] = &offsets[d][idx];
+            }
+            PositionTypeProxy posProxy(cellRefs, offsetRefs, &geometry);
+            MomentumTypeProxy momProxy(ps[0][idx], ps[1][idx], ps[2][idx]);
+            WeightTypeProxy weightRef = ref(weights[idx]);
+            TypeIndexTypeProxy typeRef = ref(typeIndex);
+            GammaTypeProxy gammaRef = ref(gammas[idx]);
+
+            return ParticleProxyType(posProxy, momProxy, weightRef, typeRef, gammaRef);
+        }
+
+        inline ParticleProxyType back()
+        {
+            return operator[](this->size() - 1);
+        }
+
+        // the cell-relative position of a particle, the components beyond the dimension are zero
+        inline CellPosition getCellPosition(int idx) const
+        {
+            CellPosition result(Int3(0, 0, 0), FP3(0, 0, 0));
+            for (int d = 0; d < positionDimension; d++)
+            {
+                result.cell[d] = cells[d][idx];
+                result.offset[d] = offsets[d][idx];
+            }
+            return result;
+        }
+
+        // Raw pointers to the component storage, p is stored normalized by mc.
+        // Pointers are invalidated when the array grows
+        inline int* getCellData(int d) { return cells[d].data(); }
+        inline TStorage* getOffsetData(int d) { return offsets[d].data(); }
+        inline TStorage* getPData(int d) { return ps[d].data(); }
+        inline TStorage* getWeightData() { return weights.data(); }
+        inline TStorage* getGammaData() { return gammas.data(); }
+
+        inline void pushBack(ConstParticleRef particle)
+        {
+            if (particle.getType() == typeIndex)
+            {
+                const PositionType position = particle.getPosition();
+                for (int d = 0; d < positionDimension; d++)
+                {
+                    int cell = 0;
+                    TStorage offset = 0;
+                    geometry.split(position[d], d, cell, offset);
+                    cells[d].push_back(cell);
+                    offsets[d].push_back(offset);
+                }
+                const MomentumType p = particle.getP();
+                for (int d = 0; d < momentumDimension; d++)
+                    ps[d].push_back(static_cast<TStorage>(p[d]));
+                weights.push_back(static_cast<TStorage>(particle.getWeight()));
+                gammas.push_back(static_cast<TStorage>(particle.getGamma()));
+            }
+        }
+
+        // All particles of the array have the type of the array, particles of other types are skipped as by pushBack
+        inline void pushBackKeepingType(ConstParticleRef particle) { pushBack(particle); }
+
+        inline void popBack()
+        {
+            for (int d = 0; d < positionDimension; d++)
+            {
+                cells[d].pop_back();
+                offsets[d].pop_back();
+            }
+            for (int d = 0; d < momentumDimension; d++)
+                ps[d].pop_back();
+            weights.pop_back();
+            gammas.pop_back();
+        }
+
+        inline void deleteParticle(iterator& idx)
+        {
+            deleteParticle(idx.getIdx());
+            idx--;
+        }
+
+        inline void deleteParticle(int idx)
+        {
+            if (idx < this->size())
+            {
+                int size = this->size();
+                for (int d = 0; d < positionDimension; d++)
+                {
+                    std::swap(cells[d][idx], cells[d][size - 1]);
+                    cells[d].pop_back();
+                    std::swap(offsets[d][idx], offsets[d][size - 1]);
+                    offsets[d].pop_back();
+                }
+                for (int d = 0; d < momentumDimension; d++)
+                {
+                    std::swap(ps[d][idx], ps[d][size - 1]);
+                    ps[d].pop_back();
+                }
+
+                std::swap(weights[idx], weights[size - 1]);
+                weights.pop_back();
+                std::swap(gammas[idx], gammas[size - 1]);
+                gammas.pop_back();
+            }
+        }
+
+        inline void clear()
+        {
+            for (int d = 0; d < positionDimension; d++)
+            {
+                cells[d].clear();
+                offsets[d].clear();
+            }
+            for (int d = 0; d < momentumDimension; d++)
+                ps[d].clear();
+            weights.clear();
+            gammas.clear();
+        }
+
+        // New particles are default ones (at rest in the origin of the cells, unit weight),
+        // storage is reallocated at most once, so it can be filled in parallel via the raw pointers
+        inline void resize(int newSize)
+        {
+            for (int d = 0; d < positionDimension; d++)
+            {
+                cells[d].resize(newSize);
+                offsets[d].resize(newSize);
+            }
+            for (int d = 0; d < momentumDimension; d++)
+                ps[d].resize(newSize);
+            weights.resize(newSize, static_cast<TStorage>(1.0));
+            gammas.resize(newSize, static_cast<TStorage>(1.0));
+        }
+
+        // Keep only particles with given indices (in ascending order), one pass
+        inline void compact(const std::vector<int>& indices)
+        {
+            const int newSize = static_cast<int>(indices.size());
+            for (int d = 0; d < positionDimension; d++)
+            {
+                for (int i = 0; i < newSize; i++)
+                {
+                    cells[d][i] = cells[d][indices[i]];
+                    offsets[d][i] = offsets[d][indices[i]];
+                }
+                cells[d].resize(newSize);
+                offsets[d].resize(newSize);
+            }
+            for (int d = 0; d < momentumDimension; d++)
+            {
+                for (int i = 0; i < newSize; i++)
+                    ps[d][i] = ps[d][indices[i]];
+                ps[d].resize(newSize);
+            }
+            for (int i = 0; i < newSize; i++)
+            {
+                weights[i] = weights[indices[i]];
+                gammas[i] = gammas[indices[i]];
+            }
+            weights.resize(newSize);
+            gammas.resize(newSize);
+        }
+
+        inline iterator begin() { return iterator(this, 0); }
+        inline iterator end() { return iterator(this, size()); }
+        inline const iterator cbegin() { return begin(); }
+        inline const iterator cend() { return end(); }
+
+        inline void save(std::ostream& os)
+        {
+            Dimension tmp_dim = dimension;
+            os.write((char*)&tmp_dim, sizeof(tmp_dim));
+            ParticleRepresentation tmp_repr = particleRepresentationType;
+            os.write((char*)&tmp_repr, sizeof(tmp_repr));
+            os.write((char*)&geometry.origin, sizeof(geometry.origin));
+            os.write((char*)&geometry.steps, sizeof(geometry.steps));
+
+            size_t tmp = size();
+            os.write((char*)&tmp, sizeof(tmp));
+            for (int i = 0; i < positionDimension; i++)
+            {
+                os.write((char*)cells[i].data(), sizeof(int) * tmp);
+                os.write((char*)offsets[i].data(), sizeof(TStorage) * tmp);
+            }
+            for (int i = 0; i < momentumDimension; i++)
+                os.write((char*)ps[i].data(), sizeof(TStorage) * tmp);
+            os.write((char*)weights.data(), sizeof(TStorage) * tmp);
+            os.write((char*)gammas.data(), sizeof(TStorage) * tmp);
+            os.write((char*)&typeIndex, sizeof(typeIndex));
+        }
+        inline void load(std::istream& is)
+        {
+            Dimension tmp_dim = Dimension::One;
+            is.read((char*)&tmp_dim, sizeof(tmp_dim));
+            if (dimension != tmp_dim)
+                throw "ERROR: dimension of loaded ParticleArrays do not match";
+            ParticleRepresentation tmp_repr = particleRepresentationType;
+            is.read((char*)&tmp_repr, sizeof(tmp_repr));
+            if (particleRepresentationType != tmp_repr)
+                throw "ERROR: representation types of loaded ParticleArrays do not match";
+            FP3 origin, steps;
+            is.read((char*)&origin, sizeof(origin));
+            is.read((char*)&steps, sizeof(steps));
+            geometry = CellGeometry(origin, steps);
+
+            size_t tmp = 0;
+            is.read((char*)&tmp, sizeof(tmp));
+            for (int i = 0; i < positionDimension; i++)
+            {
+                cells[i].resize(tmp);
+                is.read((char*)cells[i].data(), sizeof(int) * tmp);
+                offsets[i].resize(tmp);
+                is.read((char*)offsets[i].data(), sizeof(TStorage) * tmp);
+            }
+            for (int i = 0; i < momentumDimension; i++)
+            {
+                ps[i].resize(tmp);
+                is.read((char*)ps[i].data(), sizeof(TStorage) * tmp);
+            }
+            weights.resize(tmp);
+            is.read((char*)weights.data(), sizeof(TStorage) * tmp);
+            gammas.resize(tmp);
+            is.read((char*)gammas.data(), sizeof(TStorage) * tmp);
+            is.read((char*)&typeIndex, sizeof(typeIndex));
+        }
+
+    private:
+        CellGeometry geometry;
+        ParticleVector<int> cells[positionDimension];
+        ParticleVector<TStorage> offsets[positionDimension];
+        ParticleVector<TStorage> ps[momentumDimension];
+        ParticleVector<TStorage> weights;
+        ParticleVector<TStorage> gammas;
+        ParticleTypes typeIndex;
+    };
 
 
     inline std::string toString(ParticleRepresentation particleRepresentation)
@@ -426,28 +854,36 @@ namespace pfc {
         std::map<ParticleRepresentation, std::string> names;
         names[ParticleRepresentation_AoS] = "AoS";
         names[ParticleRepresentation_SoA] = "SoA";
+        names[ParticleRepresentation_CellSoA] = "CellSoA";
         return names[particleRepresentation];
     }
 
 
     // Traits class to provide a Type corresponding to array of particles
-    // according to the given representation
-    template<Dimension dimension, ParticleRepresentation storage>
+    // according to the given representation and precision of storage
+    template<Dimension dimension, ParticleRepresentation storage, typename TStorage = Real>
     struct ParticleArray {
     };
 
-    template<Dimension dimension>
-    struct ParticleArray<dimension, ParticleRepresentation_AoS> {
-        typedef ParticleArrayAoS<dimension> Type;
+    template<Dimension dimension, typename TStorage>
+    struct ParticleArray<dimension, ParticleRepresentation_AoS, TStorage> {
+        typedef ParticleArrayAoS<dimension, TStorage> Type;
     };
 
-    template<Dimension dimension>
-    struct ParticleArray<dimension, ParticleRepresentation_SoA> {
-        typedef ParticleArraySoA<dimension> Type;
+    template<Dimension dimension, typename TStorage>
+    struct ParticleArray<dimension, ParticleRepresentation_SoA, TStorage> {
+        typedef ParticleArraySoA<dimension, TStorage> Type;
+    };
+
+    template<Dimension dimension, typename TStorage>
+    struct ParticleArray<dimension, ParticleRepresentation_CellSoA, TStorage> {
+        typedef ParticleArrayCellSoA<dimension, TStorage> Type;
     };
 
 
     typedef typename ParticleArray<Three, ParticleRepresentation_SoA>::Type ParticleArray3d;
     typedef typename ParticleArray<Three, ParticleRepresentation_AoS>::Type ParticleArrayAoS3d;
+    typedef typename ParticleArray<Three, ParticleRepresentation_CellSoA>::Type ParticleArrayCellSoA3d;
+    typedef typename ParticleArrayCellSoA3d::ParticleProxyType CellParticleProxy3d;
 
 } // namespace pfc
\ No newline at end of file
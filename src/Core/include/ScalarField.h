@@ -1,4 +1,7 @@
 #pragma once
+#include <algorithm>
+#include <cstring>
+#include <utility>
 #include <vector>
 
 #include "FormFactor.h"
@@ -9,18 +12,32 @@
 
 namespace pfc {
 
+    /* Nodes and weights of the interpolation of a point along each axis,
+    computed once and applied to several co-located fields of the same size.
+    Fake dimensions have a single node with index 0 and weight 1. */
+    template <int numNodes>
+    struct InterpolationStencil {
+        static const int size = numNodes;
+        int index[3][numNodes];
+        FP weight[3][numNodes];
+    };
+
     /* Class for storing 3d scalar field on a regular grid.
-    Provides index-wise access, interpolation and deposition.*/
+    Provides index-wise access, interpolation and deposition.
+    The storage starts at a fieldAlignment boundary, the storage size can be
+    larger than the logical size, e.g. to pad rows (see getPaddedStorageSize).*/
     template <typename Data>
     class ScalarField
     {
     public:
 
-        ScalarField() {};
+        ScalarField() : raw(0) {};
         ScalarField(const Int3& size);
         ScalarField(const Int3& size, const Int3& storageSize);
         ScalarField(const ScalarField<Data>& field);
+        ScalarField(ScalarField<Data>&& field) noexcept;
         ScalarField& operator =(const ScalarField& field);
+        ScalarField& operator =(ScalarField&& field) noexcept;
 
         std::vector<Data, NUMA_Allocator<Data>>& toVector()
         {
@@ -32,6 +49,11 @@ namespace pfc {
             return raw;
         }
 
+        const Data* getData() const
+        {
+            return raw;
+        }
+
         Int3 getSize() const
         {
             return size;
@@ -42,6 +64,18 @@ namespace pfc {
             return sizeStorage;
         }
 
+        /* Storage size with the innermost dimension rounded up to a multiple of
+        fieldAlignment, so that every row starts at an aligned address.
+        Fake (size 1) innermost dimensions are not padded. */
+        static Int3 getPaddedStorageSize(const Int3& size)
+        {
+            const int rowAlignment = (int)(fieldAlignment / sizeof(Data));
+            Int3 result = size;
+            if (rowAlignment > 1 && size.z > 1)
+                result.z = (size.z + rowAlignment - 1) / rowAlignment * rowAlignment;
+            return result;
+        }
+
         /* Read-only access by scalar indexes */
         Data operator()(int i, int j, int k) const
         {
@@ -73,6 +107,31 @@ namespace pfc {
         FP interpolateFourthOrder(const Int3& baseIdx, const FP3& coeffs) const;
         FP interpolatePCS(const Int3& baseIdx, const FP3& coeffs) const;
 
+        /* Shared-weight interpolation: stencils with given base index and coefficients
+        (as in the methods above) for fields of the size of this field. With isPeriodic
+        the node indices wrap around the field size (spectral grids), otherwise the nodes
+        have to be inside the field. Fourth order stencils near the borders of
+        non-periodic fields fall back to TSC as interpolateFourthOrder does. */
+        void getStencilCIC(const Int3& baseIdx, const FP3& coeffs, bool isPeriodic,
+            InterpolationStencil<2>& stencil) const;
+        void getStencilTSC(const Int3& baseIdx, const FP3& coeffs, bool isPeriodic,
+            InterpolationStencil<3>& stencil) const;
+        void getStencilSecondOrder(const Int3& baseIdx, const FP3& coeffs, bool isPeriodic,
+            InterpolationStencil<3>& stencil) const;
+        void getStencilFourthOrder(const Int3& baseIdx, const FP3& coeffs, bool isPeriodic,
+            InterpolationStencil<5>& stencil) const;
+        void getStencilPCS(const Int3& baseIdx, const FP3& coeffs, bool isPeriodic,
+            InterpolationStencil<4>& stencil) const;
+
+        /* Interpolates numFields fields of the same size and storage size with one stencil,
+        the loops are specialized for the fake dimensions of the fields (1D, 2D and 3D) */
+        template <int numFields, class Stencil>
+        static void interpolate(const ScalarField* const fields[], const Stencil& stencil,
+            FP result[]);
+
+        // sets the whole storage to zero
+        void zeroize();
+
         void save(std::ostream& ostr) {
             ostr.write((char*)&size, sizeof(size));
             ostr.write((char*)&sizeStorage, sizeof(sizeStorage));
@@ -86,21 +145,57 @@ namespace pfc {
             istr.read((char*)&sizeStorage, sizeof(sizeStorage));
             istr.read((char*)&dimensionCoeffInt, sizeof(dimensionCoeffInt));
             istr.read((char*)&dimensionCoeffFP, sizeof(dimensionCoeffFP));
-            elements.resize(sizeStorage.volume());
+            allocateStorage();
             istr.read((char*)elements.data(), sizeof(Data) * sizeStorage.volume());
-            raw = elements.data();
+        }
+
+        /* The storage is accounted to MemoryCategory::Fields by default,
+        fields of other components (e.g. temporary fields of solvers) move it to their category */
+        void setMemoryCategory(MemoryCategory category)
+        {
+            memoryCategory = category;
+            FieldAllocationRegistry::instance().setCategory(raw, category);
+        }
+
+        MemoryCategory getMemoryCategory() const
+        {
+            return memoryCategory;
+        }
+
+        /* number of pages of the storage at each NUMA node, see getNumaPlacement */
+        std::vector<size_t> getNumaPlacement() const
+        {
+            return pfc::getNumaPlacement(raw, sizeof(Data) * elements.size());
         }
 
     private:
 
         FP interpolateThreePoints(const Int3& baseIdx, FP c[3][3]) const;
 
+        // sets the nodes of the stencil along axis d, the first node is first
+        template <class Stencil>
+        void setStencilAxis(int d, int first, const FP* weight, bool isPeriodic,
+            Stencil& stencil) const;
+
+        template <int numFields, int nx, int ny, int nz, class Stencil>
+        static void interpolate(const ScalarField* const fields[], const Stencil& stencil,
+            FP result[]);
+
+        static FP realPart(const FP& value) { return value; }
+        static FP realPart(const complex& value) { return value.real; }
+
+        /* Allocates the storage and zeroes it (or copies source of the same storage size).
+        The (i, j) rows are distributed among threads with OMP_FOR_COLLAPSE as in the
+        solvers, so the pages are first touched by the threads that will process them. */
+        void allocateStorage(const Data* source = 0);
+
         std::vector<Data, NUMA_Allocator<Data>> elements; // storage
         Data* raw; // raw pointer to elements vector
         Int3 size; // logical size of each dimension, necessary for interpolation
         Int3 sizeStorage; // physical memory size, size <= sizeStorage
         Int3 dimensionCoeffInt; // 0 for fake dimensions, 1 otherwise
         FP3 dimensionCoeffFP; // 0 for fake dimensions, 1 otherwise
+        MemoryCategory memoryCategory = MemoryCategory::Fields;
     };
 
     template <class Data>
@@ -113,8 +208,7 @@ namespace pfc {
     {
         size = _size;
         sizeStorage = _storageSize;
-        elements.resize(sizeStorage.volume());
-        raw = elements.data();
+        allocateStorage();
         for (int d = 0; d < 3; d++) {
             dimensionCoeffInt[d] = (size[d] > 1) ? 1 : 0;
             dimensionCoeffFP[d] = (FP)dimensionCoeffInt[d];
@@ -124,26 +218,96 @@ namespace pfc {
     template <class Data>
     inline ScalarField<Data>::ScalarField(const ScalarField& field)
     {
+        memoryCategory = field.memoryCategory;
         size = field.size;
         sizeStorage = field.sizeStorage;
-        elements = field.elements;
-        raw = elements.data();
+        allocateStorage(field.raw);
         dimensionCoeffInt = field.dimensionCoeffInt;
         dimensionCoeffFP = field.dimensionCoeffFP;
     }
 
+    template <class Data>
+    inline ScalarField<Data>::ScalarField(ScalarField&& field) noexcept :
+        elements(std::move(field.elements)), raw(elements.data()),
+        size(field.size), sizeStorage(field.sizeStorage),
+        dimensionCoeffInt(field.dimensionCoeffInt), dimensionCoeffFP(field.dimensionCoeffFP),
+        memoryCategory(field.memoryCategory)
+    {
+        field.raw = field.elements.data();
+        field.size = Int3(0, 0, 0);
+        field.sizeStorage = Int3(0, 0, 0);
+    }
+
     template <class Data>
     inline ScalarField<Data>& ScalarField<Data>::operator=(const ScalarField<Data>& field)
     {
+        if (this == &field)
+            return *this;
         size = field.size;
         sizeStorage = field.sizeStorage;
-        elements = field.elements;
+        allocateStorage(field.raw);
+        dimensionCoeffInt = field.dimensionCoeffInt;
+        dimensionCoeffFP = field.dimensionCoeffFP;
+        return *this;
+    }
+
+    template <class Data>
+    inline ScalarField<Data>& ScalarField<Data>::operator=(ScalarField<Data>&& field) noexcept
+    {
+        if (this == &field)
+            return *this;
+        elements = std::move(field.elements);
         raw = elements.data();
+        size = field.size;
+        sizeStorage = field.sizeStorage;
         dimensionCoeffInt = field.dimensionCoeffInt;
         dimensionCoeffFP = field.dimensionCoeffFP;
+        // the storage is accounted to the category of this field
+        FieldAllocationRegistry::instance().setCategory(raw, memoryCategory);
+        std::vector<Data, NUMA_Allocator<Data>>().swap(field.elements);
+        field.raw = field.elements.data();
+        field.size = Int3(0, 0, 0);
+        field.sizeStorage = Int3(0, 0, 0);
         return *this;
     }
 
+    template <class Data>
+    inline void ScalarField<Data>::allocateStorage(const Data* source)
+    {
+        if (elements.size() != (size_t)sizeStorage.volume()) {
+            std::vector<Data, NUMA_Allocator<Data>>().swap(elements);
+            elements.resize(sizeStorage.volume());
+            if (memoryCategory != MemoryCategory::Fields)
+                FieldAllocationRegistry::instance().setCategory(elements.data(), memoryCategory);
+        }
+        raw = elements.data();
+        const int nx = sizeStorage.x, ny = sizeStorage.y;
+        const size_t rowSize = sizeStorage.z;
+        OMP_FOR_COLLAPSE()
+        for (int i = 0; i < nx; i++)
+            for (int j = 0; j < ny; j++) {
+                const size_t offset = ((size_t)i * ny + j) * rowSize;
+                if (source)
+                    std::memcpy(raw + offset, source + offset, sizeof(Data) * rowSize);
+                else
+                    std::fill(raw + offset, raw + offset + rowSize, Data());
+            }
+    }
+
+    template <class Data>
+    inline void ScalarField<Data>::zeroize()
+    {
+        const int nx = sizeStorage.x, ny = sizeStorage.y;
+        const size_t rowSize = sizeStorage.z;
+        OMP_FOR_COLLAPSE()
+        for (int i = 0; i < nx; i++)
+            for (int j = 0; j < ny; j++)
+            {
+                Data* row = raw + ((size_t)i * ny + j) * rowSize;
+                std::fill(row, row + rowSize, Data());
+            }
+    }
+
     template <>
     inline FP ScalarField<FP>::interpolateCIC(const Int3& baseIdx, const FP3& coeffs) const
     {
@@ -212,7 +376,7 @@ namespace pfc {
         Int3 base = baseIdx * dimensionCoeffInt;
         const Int3 minAllowedIdx = Int3(2, 2, 2) * dimensionCoeffInt;
         const Int3 maxAllowedIdx = (size - Int3(4, 4, 4)) * dimensionCoeffInt;
-        if ((base >= minAllowedIdx) && (base <= maxAllowedIdx) == false)
+        if (!((base >= minAllowedIdx) && (base <= maxAllowedIdx)))
             return interpolateTSC(baseIdx, coeffs);
         FP c[3][5];
         formfactorFourthOrder(coeffs.x, c[0]);
@@ -303,7 +467,7 @@ namespace pfc {
         Int3 base = baseIdx * dimensionCoeffInt;
         const Int3 minAllowedIdx = Int3(2, 2, 2) * dimensionCoeffInt;
         const Int3 maxAllowedIdx = (size - Int3(4, 4, 4)) * dimensionCoeffInt;
-        if ((base >= minAllowedIdx) && (base <= maxAllowedIdx) == false)
+        if (!((base >= minAllowedIdx) && (base <= maxAllowedIdx)))
             return interpolateTSC(baseIdx, coeffs);
         FP c[3][5];
         formfactorFourthOrder(coeffs.x, c[0]);
@@ -354,4 +518,140 @@ namespace pfc {
                     result += c[0][ii] * c[1][jj] * c[2][kk] * (*this)(base.x + ii, base.y + jj, base.z + kk).real;
         return result;
     }
+
+    template <class Data>
+    template <class Stencil>
+    inline void ScalarField<Data>::setStencilAxis(int d, int first, const FP* weight,
+        bool isPeriodic, Stencil& stencil) const
+    {
+        if (!dimensionCoeffInt[d]) {
+            stencil.index[d][0] = 0;
+            stencil.weight[d][0] = (FP)1;
+            return;
+        }
+        for (int i = 0; i < Stencil::size; i++) {
+            int index = first + i;
+            if (isPeriodic)
+                index = (index % size[d] + size[d]) % size[d];
+            stencil.index[d][i] = index;
+            stencil.weight[d][i] = weight[i];
+        }
+    }
+
+    template <class Data>
+    inline void ScalarField<Data>::getStencilCIC(const Int3& baseIdx, const FP3& coeffs,
+        bool isPeriodic, InterpolationStencil<2>& stencil) const
+    {
+        for (int d = 0; d < 3; d++) {
+            const FP weight[2] = { (FP)1 - coeffs[d], coeffs[d] };
+            setStencilAxis(d, baseIdx[d], weight, isPeriodic, stencil);
+        }
+    }
+
+    template <class Data>
+    inline void ScalarField<Data>::getStencilTSC(const Int3& baseIdx, const FP3& coeffs,
+        bool isPeriodic, InterpolationStencil<3>& stencil) const
+    {
+        for (int d = 0; d < 3; d++) {
+            FP weight[3];
+            for (int i = 0; i < 3; i++)
+                weight[i] = formfactorTSC(FP(i - 1) - coeffs[d]);
+            setStencilAxis(d, baseIdx[d] - 1, weight, isPeriodic, stencil);
+        }
+    }
+
+    template <class Data>
+    inline void ScalarField<Data>::getStencilSecondOrder(const Int3& baseIdx, const FP3& coeffs,
+        bool isPeriodic, InterpolationStencil<3>& stencil) const
+    {
+        for (int d = 0; d < 3; d++) {
+            const FP c = coeffs[d];
+            const FP weight[3] = { (FP)0.5 * (c * (c - (FP)1)), (FP)1 - c * c,
+                (FP)0.5 * (c * (c + (FP)1)) };
+            setStencilAxis(d, baseIdx[d] - 1, weight, isPeriodic, stencil);
+        }
+    }
+
+    template <class Data>
+    inline void ScalarField<Data>::getStencilFourthOrder(const Int3& baseIdx, const FP3& coeffs,
+        bool isPeriodic, InterpolationStencil<5>& stencil) const
+    {
+        bool isInside = true;
+        for (int d = 0; d < 3; d++)
+            if (dimensionCoeffInt[d] && (baseIdx[d] < 2 || baseIdx[d] > size[d] - 4))
+                isInside = false;
+        for (int d = 0; d < 3; d++) {
+            FP weight[5];
+            if (isInside || isPeriodic) {
+                formfactorFourthOrder(coeffs[d], weight);
+                setStencilAxis(d, baseIdx[d] - 2, weight, isPeriodic, stencil);
+            }
+            else {
+                // TSC weights at the three central nodes, the outer nodes have zero weights
+                // and are moved to the center not to be read outside the field
+                weight[0] = weight[4] = 0;
+                for (int i = 0; i < 3; i++)
+                    weight[i + 1] = formfactorTSC(FP(i - 1) - coeffs[d]);
+                setStencilAxis(d, baseIdx[d] - 2, weight, isPeriodic, stencil);
+                if (dimensionCoeffInt[d])
+                    stencil.index[d][0] = stencil.index[d][4] = baseIdx[d];
+            }
+        }
+    }
+
+    template <class Data>
+    inline void ScalarField<Data>::getStencilPCS(const Int3& baseIdx, const FP3& coeffs,
+        bool isPeriodic, InterpolationStencil<4>& stencil) const
+    {
+        for (int d = 0; d < 3; d++) {
+            FP weight[4];
+            for (int i = 0; i < 4; i++)
+                weight[i] = formfactorPCS(FP(i - 1) - coeffs[d]);
+            setStencilAxis(d, baseIdx[d] - 1, weight, isPeriodic, stencil);
+        }
+    }
+
+    template <class Data>
+    template <int numFields, class Stencil>
+    inline void ScalarField<Data>::interpolate(const ScalarField* const fields[],
+        const Stencil& stencil, FP result[])
+    {
+        const Int3& dims = fields[0]->dimensionCoeffInt;
+        const int n = Stencil::size;
+        switch (dims.x * 4 + dims.y * 2 + dims.z) {
+        case 0: interpolate<numFields, 1, 1, 1>(fields, stencil, result); break;
+        case 1: interpolate<numFields, 1, 1, n>(fields, stencil, result); break;
+        case 2: interpolate<numFields, 1, n, 1>(fields, stencil, result); break;
+        case 3: interpolate<numFields, 1, n, n>(fields, stencil, result); break;
+        case 4: interpolate<numFields, n, 1, 1>(fields, stencil, result); break;
+        case 5: interpolate<numFields, n, 1, n>(fields, stencil, result); break;
+        case 6: interpolate<numFields, n, n, 1>(fields, stencil, result); break;
+        default: interpolate<numFields, n, n, n>(fields, stencil, result);
+        }
+    }
+
+    template <class Data>
+    template <int numFields, int nx, int ny, int nz, class Stencil>
+    inline void ScalarField<Data>::interpolate(const ScalarField* const fields[],
+        const Stencil& stencil, FP result[])
+    {
+        const Data* raw[numFields];
+        for (int f = 0; f < numFields; f++) {
+            raw[f] = fields[f]->raw;
+            result[f] = 0;
+        }
+        const Int3& sizeStorage = fields[0]->sizeStorage;
+        for (int i = 0; i < nx; i++)
+            for (int j = 0; j < ny; j++) {
+                const FP weightXY = stencil.weight[0][i] * stencil.weight[1][j];
+                const size_t row = ((size_t)stencil.index[0][i] * sizeStorage.y +
+                    stencil.index[1][j]) * sizeStorage.z;
+                for (int k = 0; k < nz; k++) {
+                    const FP weight = weightXY * stencil.weight[2][k];
+                    const size_t offset = row + stencil.index[2][k];
+                    for (int f = 0; f < numFields; f++)
+                        result[f] += weight * realPart(raw[f][offset]);
+                }
+            }
+    }
 }
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "ScalarField.h"
+#include "Vectors.h"
+
+#include <type_traits>
+
+namespace pfc {
+
+    /* Non-owning view of a box of a scalar field: pointer to the first element,
+    logical size of the box and storage size of the viewed field as the strides.
+    Views are cheap to copy and can be passed instead of the fields,
+    the viewed storage must outlive them. */
+    template <typename Data>
+    class ScalarFieldView
+    {
+    public:
+
+        typedef typename std::remove_const<Data>::type FieldData;
+
+        ScalarFieldView() : raw(0) {}
+
+        ScalarFieldView(Data* data, const Int3& size, const Int3& sizeStorage) :
+            raw(data), size(size), sizeStorage(sizeStorage)
+        {}
+
+        ScalarFieldView(ScalarField<FieldData>& field) :
+            raw(field.getData()), size(field.getSize()), sizeStorage(field.getMemSize())
+        {}
+
+        // view of a const field is read-only
+        template <class T = Data, class = typename std::enable_if<std::is_const<T>::value>::type>
+        ScalarFieldView(const ScalarField<FieldData>& field) :
+            raw(field.getData()), size(field.getSize()), sizeStorage(field.getMemSize())
+        {}
+
+        // read-only view of a view
+        template <class T = Data, class = typename std::enable_if<std::is_const<T>::value>::type>
+        ScalarFieldView(const ScalarFieldView<FieldData>& view) :
+            raw(view.getData()), size(view.getSize()), sizeStorage(view.getMemSize())
+        {}
+
+        Data* getData() const
+        {
+            return raw;
+        }
+
+        Int3 getSize() const
+        {
+            return size;
+        }
+
+        Int3 getMemSize() const
+        {
+            return sizeStorage;
+        }
+
+        /* true if the elements of the view are stored without gaps */
+        bool isContiguous() const
+        {
+            return (size.z == sizeStorage.z || size.x * size.y <= 1) &&
+                (size.y == sizeStorage.y || size.x <= 1);
+        }
+
+        /* View of the box [begin, begin + subSize) of this view */
+        ScalarFieldView subView(const Int3& begin, const Int3& subSize) const
+        {
+            return ScalarFieldView(&(*this)(begin), subSize, sizeStorage);
+        }
+
+        /* Access by scalar indexes relative to the beginning of the box */
+        Data& operator()(int i, int j, int k) const
+        {
+            return raw[k + (j + i * sizeStorage.y) * sizeStorage.z];
+        }
+
+        /* Access by vector index relative to the beginning of the box */
+        Data& operator()(const Int3& index) const
+        {
+            return (*this)(index.x, index.y, index.z);
+        }
+
+    private:
+
+        Data* raw;
+        Int3 size;  // logical size of the box
+        Int3 sizeStorage;  // storage size of the viewed field, defines the strides
+    };
+}
@@ -31,6 +31,12 @@ namespace pfc {
             return raw;
         }
 
+        // has to be called after the storage of the wrapped field was swapped or reallocated
+        void updateData()
+        {
+            this->raw = reinterpret_cast<SpectralData*>(scalarField->getData());
+        }
+
         Int3 getSize() const
         {
             return size;
@@ -86,6 +92,13 @@ namespace pfc {
         Int3 sizeStorage;  // in real type memory cells
 
         SpectralScalarField<RealData, SpectralData> Ex, Ey, Ez, Bx, By, Bz, Jx, Jy, Jz;
+
+        void updateData()
+        {
+            Ex.updateData(); Ey.updateData(); Ez.updateData();
+            Bx.updateData(); By.updateData(); Bz.updateData();
+            Jx.updateData(); Jy.updateData(); Jz.updateData();
+        }
     };
 
     template<>
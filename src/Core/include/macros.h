@@ -29,14 +29,16 @@
 #endif
 
 
+// OMP_FOR_COLLAPSE has an explicit static schedule: ScalarField first touches
+// its storage with the same distribution of (i, j) rows as the solvers
 #if _OPENMP >= 201307
     #define OMP_FOR()  PRAGMA(omp parallel for)
-    #define OMP_FOR_COLLAPSE()  PRAGMA(omp parallel for collapse(2))
+    #define OMP_FOR_COLLAPSE()  PRAGMA(omp parallel for collapse(2) schedule(static))
     #define OMP_FOR_SIMD()  PRAGMA(omp parallel for simd)
     #define OMP_SIMD()  PRAGMA(omp simd)
 #else
     #define OMP_FOR()  PRAGMA(omp parallel for)
-    #define OMP_FOR_COLLAPSE()  PRAGMA(omp parallel for)
+    #define OMP_FOR_COLLAPSE()  PRAGMA(omp parallel for schedule(static))
     #define OMP_FOR_SIMD()  PRAGMA(omp parallel for)
     #define OMP_SIMD()  PRAGMA(ivdep)
 #endif
@@ -0,0 +1,117 @@
+#pragma once
+#include "Mapping.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace pfc {
+
+    // Chain of mappings flattened into a contiguous program.
+    // Mappings are applied in the order they were appended (for both direct and inverse coords),
+    // consecutive affine mappings are fused into one transform, other mappings are kept as stages.
+    class CompiledMapping {
+
+    public:
+
+        void append(const std::shared_ptr<Mapping>& mapping) {
+            AffineTransform direct, inverse;
+            if (!mapping->getAffineTransforms(direct, inverse)) {
+                stages.push_back(Stage(mapping));
+                return;
+            }
+            if (stages.empty() || stages.back().mapping)
+                stages.push_back(Stage(direct, inverse));
+            else {
+                stages.back().direct = stages.back().direct.then(direct);
+                stages.back().inverse = stages.back().inverse.then(inverse);
+            }
+        }
+
+        FP3 getDirectCoords(const FP3& coords, FP time = 0.0, bool* status = 0) const {
+            FP3 result = coords;
+            bool isOk = true;
+            for (int i = 0; i < (int)stages.size(); i++) {
+                if (!stages[i].mapping) {
+                    result = stages[i].direct.apply(result);
+                    continue;
+                }
+                bool stageStatus = true;
+                result = stages[i].mapping->getDirectCoords(result, time, &stageStatus);
+                isOk = isOk && stageStatus;
+            }
+            if (status) *status = isOk;
+            return result;
+        }
+
+        FP3 getInverseCoords(const FP3& coords, FP time = 0.0, bool* status = 0) const {
+            FP3 result = coords;
+            bool isOk = true;
+            for (int i = 0; i < (int)stages.size(); i++) {
+                if (!stages[i].mapping) {
+                    result = stages[i].inverse.apply(result);
+                    continue;
+                }
+                bool stageStatus = true;
+                result = stages[i].mapping->getInverseCoords(result, time, &stageStatus);
+                isOk = isOk && stageStatus;
+            }
+            if (status) *status = isOk;
+            return result;
+        }
+
+        // Batch versions with the status mask semantics of Mapping::getDirectCoordsBatch,
+        // result may coincide with coords
+        void getDirectCoordsBatch(const FP3* coords, FP3* result, int size,
+            FP time = 0.0, bool* status = 0) const {
+            const FP3* input = coords;
+            for (int s = 0; s < (int)stages.size(); s++) {
+                if (stages[s].mapping)
+                    stages[s].mapping->getDirectCoordsBatch(input, result, size, time, status);
+                else
+                    applyBatch(stages[s].direct, input, result, size);
+                input = result;
+            }
+            if (stages.empty()) std::copy(coords, coords + size, result);
+        }
+
+        void getInverseCoordsBatch(const FP3* coords, FP3* result, int size,
+            FP time = 0.0, bool* status = 0) const {
+            const FP3* input = coords;
+            for (int s = 0; s < (int)stages.size(); s++) {
+                if (stages[s].mapping)
+                    stages[s].mapping->getInverseCoordsBatch(input, result, size, time, status);
+                else
+                    applyBatch(stages[s].inverse, input, result, size);
+                input = result;
+            }
+            if (stages.empty()) std::copy(coords, coords + size, result);
+        }
+
+        int getNumStages() const {
+            return (int)stages.size();
+        }
+
+    private:
+
+        // fused affine stage if mapping is null
+        struct Stage {
+            Stage(const AffineTransform& direct, const AffineTransform& inverse) :
+                direct(direct), inverse(inverse) {}
+            Stage(const std::shared_ptr<Mapping>& mapping) : mapping(mapping) {}
+
+            AffineTransform direct, inverse;
+            std::shared_ptr<Mapping> mapping;
+        };
+
+        std::vector<Stage> stages;
+
+        static void applyBatch(const AffineTransform& transform, const FP3* coords, FP3* result, int size) {
+            OMP_SIMD()
+            for (int i = 0; i < size; i++)
+                result[i] = transform.apply(coords[i]);
+        }
+
+    };
+
+}
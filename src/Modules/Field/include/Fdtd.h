@@ -200,6 +200,7 @@ namespace pfc {
         updateHalfB();
         applyBoundaryConditionsB(globalTime + dt);
 
+        grid->updateInterleavedFields();
         globalTime += dt;
     }
 
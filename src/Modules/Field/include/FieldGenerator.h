@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <array>
 #include <functional>
 
@@ -21,6 +22,8 @@ namespace pfc
     public:
 
         using FunctionType = std::function<FP(FP, FP, FP, FP)>;  // f(x, y, z, t)
+        // f(x[], y[], z[], t, result[], size), computes a field component in an array of points
+        using BatchFunctionType = std::function<void(const FP*, const FP*, const FP*, FP, FP*, int)>;
 
         FieldGenerator(TGrid* grid, FP dt,
             const Int3& domainIndexBegin, const Int3& domainIndexEnd,
@@ -74,6 +77,16 @@ namespace pfc
         void setFunction(FieldEnum field, CoordinateEnum fieldComponent,
             CoordinateEnum edge, SideEnum side, FunctionType func);
 
+        // batch functions replace the functions set before for the same borders
+        void setBatchFunction(FieldEnum field, CoordinateEnum fieldComponent, BatchFunctionType func);
+        void setBatchFunction(FieldEnum field, CoordinateEnum fieldComponent,
+            CoordinateEnum edge, SideEnum side, BatchFunctionType func);
+
+        // computes the generated field component in an array of points,
+        // the batch function of the border is used if it is set
+        void getFunctionValues(FieldEnum field, int side, int edge, int fieldComponent,
+            const FP* x, const FP* y, const FP* z, FP time, FP* result, int size) const;
+
         void save(std::ostream& ostr);
         void load(std::istream& istr);
 
@@ -90,6 +103,7 @@ namespace pfc
         // second index is index of edge
         // third index is index of field component
         std::array<std::array<std::array<FunctionType, 3>, 3>, 2> eFunc, bFunc;
+        std::array<std::array<std::array<BatchFunctionType, 3>, 3>, 2> eBatchFunc, bBatchFunc;
     };
 
     template<class TGrid>
@@ -158,7 +172,10 @@ namespace pfc
             gen.leftGeneratorIndex, gen.rightGeneratorIndex,
             gen.bFunc, gen.eFunc,
             gen.isLeftBorderEnabled, gen.isRightBorderEnabled)
-    {}
+    {
+        this->bBatchFunc = gen.bBatchFunc;
+        this->eBatchFunc = gen.eBatchFunc;
+    }
 
     template<class TGrid>
     inline FieldGenerator<TGrid>::FieldGenerator(TGrid* grid, FP dt,
@@ -186,15 +203,70 @@ namespace pfc
         switch (field) {
         case FieldEnum::B:
             bFunc[(int)side][(int)edge][(int)fieldComponent] = func;
+            bBatchFunc[(int)side][(int)edge][(int)fieldComponent] = nullptr;
             break;
         case FieldEnum::E:
             eFunc[(int)side][(int)edge][(int)fieldComponent] = func;
+            eBatchFunc[(int)side][(int)edge][(int)fieldComponent] = nullptr;
+            break;
+        default:
+            break;
+        }
+    }
+
+    template<class TGrid>
+    inline void FieldGenerator<TGrid>::setBatchFunction(
+        FieldEnum field, CoordinateEnum fieldComponent,
+        FieldGenerator<TGrid>::BatchFunctionType func)
+    {
+        for (int side = 0; side < 2; side++)
+            for (int edge = 0; edge < 3; edge++)
+                setBatchFunction(field, fieldComponent,
+                    (CoordinateEnum)edge, (SideEnum)side, func);
+    }
+
+    template<class TGrid>
+    inline void FieldGenerator<TGrid>::setBatchFunction(
+        FieldEnum field, CoordinateEnum fieldComponent,
+        CoordinateEnum edge, SideEnum side, FieldGenerator<TGrid>::BatchFunctionType func)
+    {
+        switch (field) {
+        case FieldEnum::B:
+            bBatchFunc[(int)side][(int)edge][(int)fieldComponent] = func;
+            break;
+        case FieldEnum::E:
+            eBatchFunc[(int)side][(int)edge][(int)fieldComponent] = func;
             break;
         default:
             break;
         }
     }
 
+    template<class TGrid>
+    inline void FieldGenerator<TGrid>::getFunctionValues(FieldEnum field,
+        int side, int edge, int fieldComponent,
+        const FP* x, const FP* y, const FP* z, FP time, FP* result, int size) const
+    {
+        const FunctionType& func = field == FieldEnum::B ?
+            bFunc[side][edge][fieldComponent] : eFunc[side][edge][fieldComponent];
+        const BatchFunctionType& batchFunc = field == FieldEnum::B ?
+            bBatchFunc[side][edge][fieldComponent] : eBatchFunc[side][edge][fieldComponent];
+
+        // chunks are processed in parallel, a batch function is called once per chunk
+        const int chunkSize = 256;
+        const int numChunks = (size + chunkSize - 1) / chunkSize;
+        OMP_FOR()
+        for (int chunk = 0; chunk < numChunks; chunk++) {
+            const int begin = chunk * chunkSize;
+            const int length = std::min(chunkSize, size - begin);
+            if (batchFunc)
+                batchFunc(x + begin, y + begin, z + begin, time, result + begin, length);
+            else
+                for (int i = begin; i < begin + length; i++)
+                    result[i] = func(x[i], y[i], z[i], time);
+        }
+    }
+
     template<class TGrid>
     inline void FieldGenerator<TGrid>::save(std::ostream& ostr)
     {
@@ -219,6 +291,8 @@ namespace pfc
                 for (int fieldComponent = 0; fieldComponent < 3; fieldComponent++) {
                     bFunc[(int)side][(int)edge][(int)fieldComponent] = field_generator::defaultFieldFunction;
                     eFunc[(int)side][(int)edge][(int)fieldComponent] = field_generator::defaultFieldFunction;
+                    bBatchFunc[(int)side][(int)edge][(int)fieldComponent] = nullptr;
+                    eBatchFunc[(int)side][(int)edge][(int)fieldComponent] = nullptr;
                 }
     }
 }
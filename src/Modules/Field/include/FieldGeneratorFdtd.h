@@ -55,10 +55,13 @@ namespace pfc
 
     protected:
 
-        FP3 getBCurrents(int side, int dim0,
-            const FP3& exCoords, const FP3& eyCoords, const FP3& ezCoords, FP time) const;
-        FP3 getECurrents(int side, int dim0,
-            const FP3& bxCoords, const FP3& byCoords, const FP3& bzCoords, FP time) const;
+        using FieldGenerator<YeeGrid>::getFunctionValues;
+
+        // values of the generated field components in the border nodes (j, k) in C order,
+        // E values are used to generate B and vice versa
+        void getFunctionValues(FieldEnum field, int side, int dim0, int genIndex,
+            int begin1, int end1, int begin2, int end2, int dim1, int dim2,
+            FP time, std::vector<FP>(&values)[3]) const;
 
         std::vector<Int3> getBGridIndices(int i, int j, int k,
             int dim0, int dim1, int dim2) const;
@@ -149,22 +152,26 @@ namespace pfc
                 rightGeneratorIndex[dim2] : this->domainIndexEnd[dim2];
 
             Int3 isBorderEnabled[2] = { isLeftBorderEnabled, isRightBorderEnabled };
+            std::vector<FP> values[3];
 
             for (int side = 0; side < 2; side++) {
                 if (!isBorderEnabled[side][dim0]) continue;
 
+                // the generator functions are evaluated for the whole border at once
+                getFunctionValues(FieldEnum::E, side, dim0, genIndexDim0[side],
+                    begin1, end1, begin2, end2, dim1, dim2, time, values);
+
+                FP3 normal;
+                normal[dim0] = (side == 0) ? 1.0 : -1.0;
+
                 OMP_FOR_COLLAPSE()
                 for (int j = begin1; j < end1; j++)
                     for (int k = begin2; k < end2; k++)
                     {
-                        std::vector<Int3> eIndices = getEGridIndices(genIndexDim0[side], j, k, dim0, dim1, dim2);
                         std::vector<Int3> bIndices = getBGridIndices(genIndexDim0[side], j, k, dim0, dim1, dim2);
 
-                        FP3 exCoords = this->grid->ExPosition(eIndices[0].x, eIndices[0].y, eIndices[0].z);
-                        FP3 eyCoords = this->grid->EyPosition(eIndices[1].x, eIndices[1].y, eIndices[1].z);
-                        FP3 ezCoords = this->grid->EzPosition(eIndices[2].x, eIndices[2].y, eIndices[2].z);
-
-                        FP3 current = getBCurrents(side, dim0, exCoords, eyCoords, ezCoords, time);
+                        const int idx = (j - begin1) * (end2 - begin2) + (k - begin2);
+                        FP3 current = cross(normal, FP3(values[0][idx], values[1][idx], values[2][idx]));
 
                         this->grid->Bx(bIndices[0]) += norm_coeffs[dim0] * current.x;
                         this->grid->By(bIndices[1]) += norm_coeffs[dim0] * current.y;
@@ -200,22 +207,26 @@ namespace pfc
                 rightGeneratorIndex[dim2] : this->domainIndexEnd[dim2];
 
             Int3 isBorderEnabled[2] = { isLeftBorderEnabled, isRightBorderEnabled };
+            std::vector<FP> values[3];
 
             for (int side = 0; side < 2; side++) {
                 if (!isBorderEnabled[side][dim0]) continue;
 
+                // the generator functions are evaluated for the whole border at once
+                getFunctionValues(FieldEnum::B, side, dim0, genIndexDim0[side],
+                    begin1, end1, begin2, end2, dim1, dim2, time, values);
+
+                FP3 normal;
+                normal[dim0] = (side == 0) ? 1.0 : -1.0;
+
                 OMP_FOR_COLLAPSE()
                 for (int j = begin1; j < end1; j++)
                     for (int k = begin2; k < end2; k++)
                     {
                         std::vector<Int3> eIndices = getEGridIndices(genIndexDim0[side], j, k, dim0, dim1, dim2);
-                        std::vector<Int3> bIndices = getBGridIndices(genIndexDim0[side], j, k, dim0, dim1, dim2);
-
-                        FP3 bxCoords = this->grid->BxPosition(bIndices[0].x, bIndices[0].y, bIndices[0].z);
-                        FP3 byCoords = this->grid->ByPosition(bIndices[1].x, bIndices[1].y, bIndices[1].z);
-                        FP3 bzCoords = this->grid->BzPosition(bIndices[2].x, bIndices[2].y, bIndices[2].z);
 
-                        FP3 current = getECurrents(side, dim0, bxCoords, byCoords, bzCoords, time);
+                        const int idx = (j - begin1) * (end2 - begin2) + (k - begin2);
+                        FP3 current = cross(normal, FP3(values[0][idx], values[1][idx], values[2][idx])) * (-1.0);
 
                         this->grid->Ex(eIndices[0]) += norm_coeffs[dim0] * current.x;
                         this->grid->Ey(eIndices[1]) += norm_coeffs[dim0] * current.y;
@@ -225,32 +236,46 @@ namespace pfc
         }
     }
 
-    inline FP3 FieldGeneratorFdtd::getBCurrents(int side, int dim0,
-        const FP3& exCoords, const FP3& eyCoords, const FP3& ezCoords, FP time) const
+    inline void FieldGeneratorFdtd::getFunctionValues(FieldEnum field, int side, int dim0, int genIndex,
+        int begin1, int end1, int begin2, int end2, int dim1, int dim2,
+        FP time, std::vector<FP>(&values)[3]) const
     {
-        FP3 current, normal, genField;
-        normal[dim0] = (side == 0) ? 1.0 : -1.0;
-        genField = FP3(
-            eFunc[side][dim0][0](exCoords.x, exCoords.y, exCoords.z, time),
-            eFunc[side][dim0][1](eyCoords.x, eyCoords.y, eyCoords.z, time),
-            eFunc[side][dim0][2](ezCoords.x, ezCoords.y, ezCoords.z, time)
-        );
-        current = cross(normal, genField);
-        return current;
-    }
+        const int size1 = std::max(end1 - begin1, 0), size2 = std::max(end2 - begin2, 0);
+        const int size = size1 * size2;
+        std::vector<FP> x[3], y[3], z[3];
+        for (int c = 0; c < 3; c++) {
+            x[c].resize(size);
+            y[c].resize(size);
+            z[c].resize(size);
+            values[c].resize(size);
+        }
 
-    inline FP3 FieldGeneratorFdtd::getECurrents(int side, int dim0,
-        const FP3& bxCoords, const FP3& byCoords, const FP3& bzCoords, FP time) const
-    {
-        FP3 current, normal, genField;
-        normal[dim0] = (side == 0) ? 1.0 : -1.0;
-        genField = FP3(
-            bFunc[side][dim0][0](bxCoords.x, bxCoords.y, bxCoords.z, time),
-            bFunc[side][dim0][1](byCoords.x, byCoords.y, byCoords.z, time),
-            bFunc[side][dim0][2](bzCoords.x, bzCoords.y, bzCoords.z, time)
-        );
-        current = cross(normal, genField) * (-1.0);
-        return current;
+        const FP3(YeeGrid::* position[2][3])(int, int, int) const = {
+            { &YeeGrid::BxPosition, &YeeGrid::ByPosition, &YeeGrid::BzPosition },
+            { &YeeGrid::ExPosition, &YeeGrid::EyPosition, &YeeGrid::EzPosition }
+        };
+        const int positionIndex = field == FieldEnum::B ? 0 : 1;
+
+        OMP_FOR_COLLAPSE()
+        for (int j = begin1; j < end1; j++)
+            for (int k = begin2; k < end2; k++)
+            {
+                std::vector<Int3> indices = field == FieldEnum::B ?
+                    getBGridIndices(genIndex, j, k, dim0, dim1, dim2) :
+                    getEGridIndices(genIndex, j, k, dim0, dim1, dim2);
+                const int idx = (j - begin1) * size2 + (k - begin2);
+                for (int c = 0; c < 3; c++) {
+                    FP3 coords = (this->grid->*position[positionIndex][c])(
+                        indices[c].x, indices[c].y, indices[c].z);
+                    x[c][idx] = coords.x;
+                    y[c][idx] = coords.y;
+                    z[c][idx] = coords.z;
+                }
+            }
+
+        for (int c = 0; c < 3; c++)
+            getFunctionValues(field, side, dim0, c, x[c].data(), y[c].data(), z[c].data(),
+                time, values[c].data(), size);
     }
 
     inline std::vector<Int3> FieldGeneratorFdtd::getBGridIndices(int i, int j, int k,
@@ -6,6 +6,41 @@
 
 namespace pfc {
 
+    // Affine transform: coords -> matrix * coords + shift
+    struct AffineTransform {
+
+        AffineTransform() : shift(0.0, 0.0, 0.0) {
+            for (int i = 0; i < 3; i++)
+                for (int j = 0; j < 3; j++)
+                    matrix[i][j] = (i == j) ? 1.0 : 0.0;
+        }
+
+        FP3 apply(const FP3& coords) const {
+            return FP3(
+                matrix[0][0] * coords.x + matrix[0][1] * coords.y + matrix[0][2] * coords.z + shift.x,
+                matrix[1][0] * coords.x + matrix[1][1] * coords.y + matrix[1][2] * coords.z + shift.y,
+                matrix[2][0] * coords.x + matrix[2][1] * coords.y + matrix[2][2] * coords.z + shift.z);
+        }
+
+        // transform equal to applying this one and then the other one
+        AffineTransform then(const AffineTransform& other) const {
+            AffineTransform result;
+            for (int i = 0; i < 3; i++)
+                for (int j = 0; j < 3; j++) {
+                    result.matrix[i][j] = 0.0;
+                    for (int k = 0; k < 3; k++)
+                        result.matrix[i][j] += other.matrix[i][k] * matrix[k][j];
+                }
+            result.shift = other.apply(shift);
+            return result;
+        }
+
+        FP matrix[3][3];
+        FP3 shift;
+
+    };
+
+
     class Mapping {
 
     public:
@@ -20,8 +55,35 @@ namespace pfc {
             return coords;
         }
 
+        // Batch versions: coords of size points are mapped to result (may coincide with coords),
+        // entries of the status mask (if given) are cleared for points where the mapping fails
+        // and are left unchanged otherwise
+        virtual void getDirectCoordsBatch(const FP3* coords, FP3* result, int size,
+            FP time = 0.0, bool* status = 0) {
+            for (int i = 0; i < size; i++) {
+                bool pointStatus = true;
+                result[i] = getDirectCoords(coords[i], time, &pointStatus);
+                if (status) status[i] = status[i] && pointStatus;
+            }
+        }
+
+        virtual void getInverseCoordsBatch(const FP3* coords, FP3* result, int size,
+            FP time = 0.0, bool* status = 0) {
+            for (int i = 0; i < size; i++) {
+                bool pointStatus = true;
+                result[i] = getInverseCoords(coords[i], time, &pointStatus);
+                if (status) status[i] = status[i] && pointStatus;
+            }
+        }
+
         virtual Mapping* createInstance() = 0;
 
+        // returns true if the mapping is a time-independent affine transform which never fails,
+        // such mappings can be fused together (see CompiledMapping)
+        virtual bool getAffineTransforms(AffineTransform& direct, AffineTransform& inverse) const {
+            return false;
+        }
+
     protected:
 
         void setFailStatus(bool* status) {
@@ -52,12 +114,33 @@ namespace pfc {
             return coords;
         }
 
+        void getDirectCoordsBatch(const FP3* coords, FP3* result, int size,
+            FP time = 0.0, bool* status = 0) override {
+            getCoordsBatch(coords, result, size, status);
+        }
+
+        void getInverseCoordsBatch(const FP3* coords, FP3* result, int size,
+            FP time = 0.0, bool* status = 0) override {
+            getCoordsBatch(coords, result, size, status);
+        }
+
         Mapping* createInstance() override {
             return new IdentityMapping(*this);
         }
 
         FP3 a, b;
 
+    private:
+
+        void getCoordsBatch(const FP3* coords, FP3* result, int size, bool* status) {
+            OMP_SIMD()
+            for (int i = 0; i < size; i++) {
+                const FP3 c = coords[i];
+                if (status) status[i] = status[i] && (c >= a && c < b);
+                result[i] = c;
+            }
+        }
+
     };
 
 
@@ -83,6 +166,29 @@ namespace pfc {
             return inverseCoords;
         }
 
+        void getDirectCoordsBatch(const FP3* coords, FP3* result, int size,
+            FP time = 0.0, bool* status = 0) override {
+            const int a = (int)axis;
+            OMP_SIMD()
+            for (int i = 0; i < size; i++) {
+                const FP3 c = coords[i];
+                if (status) status[i] = status[i] && (c[a] >= cMin && c[a] < cMax);
+                result[i] = c;
+            }
+        }
+
+        void getInverseCoordsBatch(const FP3* coords, FP3* result, int size,
+            FP time = 0.0, bool* status = 0) override {
+            const int a = (int)axis;
+            OMP_SIMD()
+            for (int i = 0; i < size; i++) {
+                FP3 c = coords[i];
+                const FP t = (c[a] - cMin) / D;
+                c[a] = cMin + (t - std::floor(t)) * D;
+                result[i] = c;
+            }
+        }
+
         Mapping* createInstance() override {
             return new PeriodicalMapping(*this);
         }
@@ -144,10 +250,47 @@ namespace pfc {
             return inverseCoords;
         }
 
+        void getDirectCoordsBatch(const FP3* coords, FP3* result, int size,
+            FP time = 0.0, bool* status = 0) override {
+            const FP(&m)[3][3] = rotationMatrix;
+            OMP_SIMD()
+            for (int i = 0; i < size; i++) {
+                const FP3 c = coords[i];
+                result[i] = FP3(
+                    m[0][0] * c.x + m[0][1] * c.y + m[0][2] * c.z,
+                    m[1][0] * c.x + m[1][1] * c.y + m[1][2] * c.z,
+                    m[2][0] * c.x + m[2][1] * c.y + m[2][2] * c.z);
+            }
+        }
+
+        void getInverseCoordsBatch(const FP3* coords, FP3* result, int size,
+            FP time = 0.0, bool* status = 0) override {
+            const FP(&m)[3][3] = rotationMatrix;
+            OMP_SIMD()
+            for (int i = 0; i < size; i++) {
+                const FP3 c = coords[i];
+                result[i] = FP3(
+                    m[0][0] * c.x + m[1][0] * c.y + m[2][0] * c.z,
+                    m[0][1] * c.x + m[1][1] * c.y + m[2][1] * c.z,
+                    m[0][2] * c.x + m[1][2] * c.y + m[2][2] * c.z);
+            }
+        }
+
         Mapping* createInstance() override {
             return new RotationMapping(*this);
         }
 
+        bool getAffineTransforms(AffineTransform& direct, AffineTransform& inverse) const override {
+            direct = AffineTransform();
+            inverse = AffineTransform();
+            for (int i = 0; i < 3; i++)
+                for (int j = 0; j < 3; j++) {
+                    direct.matrix[i][j] = rotationMatrix[i][j];
+                    inverse.matrix[i][j] = rotationMatrix[j][i];
+                }
+            return true;
+        }
+
         CoordinateEnum axis;
         FP angle;  // in radians
         // mapping from inverse to direct coords
@@ -172,10 +315,32 @@ namespace pfc {
             return coords - shift;
         }
 
+        void getDirectCoordsBatch(const FP3* coords, FP3* result, int size,
+            FP time = 0.0, bool* status = 0) override {
+            OMP_SIMD()
+            for (int i = 0; i < size; i++)
+                result[i] = coords[i] + shift;
+        }
+
+        void getInverseCoordsBatch(const FP3* coords, FP3* result, int size,
+            FP time = 0.0, bool* status = 0) override {
+            OMP_SIMD()
+            for (int i = 0; i < size; i++)
+                result[i] = coords[i] - shift;
+        }
+
         Mapping* createInstance() override {
             return new ShiftMapping(*this);
         }
 
+        bool getAffineTransforms(AffineTransform& direct, AffineTransform& inverse) const override {
+            direct = AffineTransform();
+            direct.shift = shift;
+            inverse = AffineTransform();
+            inverse.shift = -shift;
+            return true;
+        }
+
         FP3 shift;
 
     };
@@ -201,10 +366,40 @@ namespace pfc {
             return inverseCoords;
         }
 
+        void getDirectCoordsBatch(const FP3* coords, FP3* result, int size,
+            FP time = 0.0, bool* status = 0) override {
+            const int a = (int)axis;
+            OMP_SIMD()
+            for (int i = 0; i < size; i++) {
+                FP3 c = coords[i];
+                c[a] *= coef;
+                result[i] = c;
+            }
+        }
+
+        void getInverseCoordsBatch(const FP3* coords, FP3* result, int size,
+            FP time = 0.0, bool* status = 0) override {
+            const int a = (int)axis;
+            OMP_SIMD()
+            for (int i = 0; i < size; i++) {
+                FP3 c = coords[i];
+                c[a] /= coef;
+                result[i] = c;
+            }
+        }
+
         Mapping* createInstance() override {
             return new ScaleMapping(*this);
         }
 
+        bool getAffineTransforms(AffineTransform& direct, AffineTransform& inverse) const override {
+            direct = AffineTransform();
+            direct.matrix[(int)axis][(int)axis] = coef;
+            inverse = AffineTransform();
+            inverse.matrix[(int)axis][(int)axis] = 1.0 / coef;
+            return true;
+        }
+
         FP coef;
         CoordinateEnum axis;
 
@@ -277,6 +472,54 @@ namespace pfc {
 
         }
 
+        // the search parameters depend only on time and are computed once for the batch
+        void getDirectCoordsBatch(const FP3* coords, FP3* result, int size,
+            FP time = 0.0, bool* status = 0) override {
+            const FP ct = constants::c*time;
+            const int a = (int)periodicalMapping.axis;
+            const FP cMin = periodicalMapping.cMin + ct, cMax = periodicalMapping.cMax + ct;
+
+            int nPeriods = 1;
+            FP shift = 0;
+            if (cMax < 0) {
+                nPeriods = int(-cMin / periodicalMapping.D) + 1;
+                shift = periodicalMapping.D;
+            }
+            else if (cMin > 0) {
+                nPeriods = int(cMax / periodicalMapping.D) + 1;
+                shift = -periodicalMapping.D;
+            }
+
+            for (int i = 0; i < size; i++) {
+                const FP3 c = coords[i];
+                bool isOk = !ifCut;
+                FP3 directCoords = c;
+                if (c[a] >= cMin && c[a] < cMax) {
+                    FP3 coordsShift = c;
+                    for (int period = 0; period < nPeriods; period++) {
+                        coordsShift[a] += shift;
+                        if (ifInArea(coordsShift, time)) {
+                            directCoords = coordsShift;
+                            isOk = true;
+                            break;
+                        }
+                    }
+                }
+                if (status) status[i] = status[i] && isOk;
+                result[i] = directCoords;
+            }
+        }
+
+        void getInverseCoordsBatch(const FP3* coords, FP3* result, int size,
+            FP time = 0.0, bool* status = 0) override {
+            if (ifCut && status) {
+                OMP_SIMD()
+                for (int i = 0; i < size; i++)
+                    status[i] = status[i] && ifInArea(coords[i], time);
+            }
+            periodicalMapping.getInverseCoordsBatch(coords, result, size);
+        }
+
         FP getMinCoord() const { return periodicalMapping.cMin; }
         FP getMaxCoord() const { return periodicalMapping.cMax; }
 
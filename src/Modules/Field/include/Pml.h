@@ -203,19 +203,41 @@ namespace pfc {
         // coefficient pre-computing
         void computeCoeffs();
 
+        /* Each coefficient depends on the coordinate along one axis only, so
+        the per-node arrays can be replaced with one table per axis. */
+        void setCompactCoeffs(bool enabled);
+        bool hasCompactCoeffs() const { return compactCoeffs; }
+
         SpectralGrid<FP, complexFP>* complexGrid = nullptr;
         Int3 complexDomainIndexBegin, complexDomainIndexEnd;
 
-        std::vector<FP> bCoeffX, bCoeffY, bCoeffZ, eCoeffX, eCoeffY, eCoeffZ;
+        PmlArray bCoeffX, bCoeffY, bCoeffZ, eCoeffX, eCoeffY, eCoeffZ;
+
+    protected:
+
+        bool compactCoeffs = false;
+        // tables indexed by the node index along the axis relative to the domain
+        PmlArray bAxisCoeffs[3], eAxisCoeffs[3];
 
     private:
 
         void computeCoeffs(
-            std::vector<FP>& coeffX, std::vector<FP>& coeffY, std::vector<FP>& coeffZ,
+            PmlArray& coeffX, PmlArray& coeffY, PmlArray& coeffZ,
+            const FP3(TGrid::* positionFX)(int, int, int) const,
+            const FP3(TGrid::* positionFY)(int, int, int) const,
+            const FP3(TGrid::* positionFZ)(int, int, int) const);
+
+        void computeAxisCoeffs(PmlArray axisCoeffs[3],
             const FP3(TGrid::* positionFX)(int, int, int) const,
             const FP3(TGrid::* positionFY)(int, int, int) const,
             const FP3(TGrid::* positionFZ)(int, int, int) const);
 
+        forceinline FP3 getCoeffs(const PmlArray& coeffX, const PmlArray& coeffY, const PmlArray& coeffZ,
+            const PmlArray axisCoeffs[3], int idx, const Int3& index) const;
+
+        void writeCoeffs(std::ostream& ostr, const PmlArray& coeffX,
+            const PmlArray& coeffY, const PmlArray& coeffZ) const;
+
     };
 
     template<class TGrid>
@@ -253,6 +275,45 @@ namespace pfc {
             &TGrid::ExPosition, &TGrid::EyPosition, &TGrid::EzPosition);
     }
 
+    template<class TGrid>
+    inline void PmlSpectral<TGrid>::setCompactCoeffs(bool enabled)
+    {
+        if (enabled == compactCoeffs)
+            return;
+
+        if (enabled) {
+            this->computeAxisCoeffs(bAxisCoeffs,
+                &TGrid::BxPosition, &TGrid::ByPosition, &TGrid::BzPosition);
+            this->computeAxisCoeffs(eAxisCoeffs,
+                &TGrid::ExPosition, &TGrid::EyPosition, &TGrid::EzPosition);
+            PmlArray().swap(bCoeffX);
+            PmlArray().swap(bCoeffY);
+            PmlArray().swap(bCoeffZ);
+            PmlArray().swap(eCoeffX);
+            PmlArray().swap(eCoeffY);
+            PmlArray().swap(eCoeffZ);
+        }
+        else {
+            for (int d = 0; d < 3; d++) {
+                PmlArray().swap(bAxisCoeffs[d]);
+                PmlArray().swap(eAxisCoeffs[d]);
+            }
+            this->computeCoeffs();
+        }
+        compactCoeffs = enabled;
+    }
+
+    template<class TGrid>
+    inline FP3 PmlSpectral<TGrid>::getCoeffs(const PmlArray& coeffX, const PmlArray& coeffY,
+        const PmlArray& coeffZ, const PmlArray axisCoeffs[3], int idx, const Int3& index) const
+    {
+        if (compactCoeffs) {
+            const Int3 ind = index - this->domainIndexBegin;
+            return FP3(axisCoeffs[0][ind.x], axisCoeffs[1][ind.y], axisCoeffs[2][ind.z]);
+        }
+        return FP3(coeffX[idx], coeffY[idx], coeffZ[idx]);
+    }
+
     template<class TGrid>
     inline void PmlSpectral<TGrid>::updateB()
     {
@@ -263,12 +324,14 @@ namespace pfc {
         {
             Int3 index = this->splitGrid->getIndex3d(idx);
 
-            this->splitGrid->bxy[idx] *= bCoeffY[idx];
-            this->splitGrid->bxz[idx] *= bCoeffZ[idx];
-            this->splitGrid->byz[idx] *= bCoeffZ[idx];
-            this->splitGrid->byx[idx] *= bCoeffX[idx];
-            this->splitGrid->bzx[idx] *= bCoeffX[idx];
-            this->splitGrid->bzy[idx] *= bCoeffY[idx];
+            const FP3 coeffs = getCoeffs(bCoeffX, bCoeffY, bCoeffZ, bAxisCoeffs, idx, index);
+
+            this->splitGrid->bxy[idx] *= coeffs.y;
+            this->splitGrid->bxz[idx] *= coeffs.z;
+            this->splitGrid->byz[idx] *= coeffs.z;
+            this->splitGrid->byx[idx] *= coeffs.x;
+            this->splitGrid->bzx[idx] *= coeffs.x;
+            this->splitGrid->bzy[idx] *= coeffs.y;
 
             this->grid->Bx(index.x, index.y, index.z) = this->splitGrid->bxy[idx] + this->splitGrid->bxz[idx];
             this->grid->By(index.x, index.y, index.z) = this->splitGrid->byz[idx] + this->splitGrid->byx[idx];
@@ -287,12 +350,14 @@ namespace pfc {
         {
             Int3 index = this->splitGrid->getIndex3d(idx);
 
-            this->splitGrid->exy[idx] *= eCoeffY[idx];
-            this->splitGrid->exz[idx] *= eCoeffZ[idx];
-            this->splitGrid->eyz[idx] *= eCoeffZ[idx];
-            this->splitGrid->eyx[idx] *= eCoeffX[idx];
-            this->splitGrid->ezx[idx] *= eCoeffX[idx];
-            this->splitGrid->ezy[idx] *= eCoeffY[idx];
+            const FP3 coeffs = getCoeffs(eCoeffX, eCoeffY, eCoeffZ, eAxisCoeffs, idx, index);
+
+            this->splitGrid->exy[idx] *= coeffs.y;
+            this->splitGrid->exz[idx] *= coeffs.z;
+            this->splitGrid->eyz[idx] *= coeffs.z;
+            this->splitGrid->eyx[idx] *= coeffs.x;
+            this->splitGrid->ezx[idx] *= coeffs.x;
+            this->splitGrid->ezy[idx] *= coeffs.y;
 
             this->grid->Ex(index.x, index.y, index.z) = this->splitGrid->exy[idx] + this->splitGrid->exz[idx];
             this->grid->Ey(index.x, index.y, index.z) = this->splitGrid->eyz[idx] + this->splitGrid->eyx[idx];
@@ -302,7 +367,7 @@ namespace pfc {
 
     template<class TGrid>
     inline void PmlSpectral<TGrid>::computeCoeffs(
-        std::vector<FP>& coeffX, std::vector<FP>& coeffY, std::vector<FP>& coeffZ,
+        PmlArray& coeffX, PmlArray& coeffY, PmlArray& coeffZ,
         const FP3(TGrid::* positionFX)(int, int, int) const,
         const FP3(TGrid::* positionFY)(int, int, int) const,
         const FP3(TGrid::* positionFZ)(int, int, int) const)
@@ -331,6 +396,29 @@ namespace pfc {
         }
     }
 
+    template<class TGrid>
+    inline void PmlSpectral<TGrid>::computeAxisCoeffs(PmlArray axisCoeffs[3],
+        const FP3(TGrid::* positionFX)(int, int, int) const,
+        const FP3(TGrid::* positionFY)(int, int, int) const,
+        const FP3(TGrid::* positionFZ)(int, int, int) const)
+    {
+        // the same positions as in computeCoeffs: x of FY, y of FZ, z of FX
+        const FP3(TGrid::* positions[3])(int, int, int) const = { positionFY, positionFZ, positionFX };
+        const Int3 domainSize = this->domainIndexEnd - this->domainIndexBegin;
+        const FP cdt = constants::c * this->dt;
+
+        for (int d = 0; d < 3; d++) {
+            axisCoeffs[d].resize(domainSize[d]);
+            for (int i = 0; i < domainSize[d]; i++) {
+                Int3 index = this->domainIndexBegin;
+                index[d] += i;
+                FP sigma = this->computeSigma((this->grid->*positions[d])(index.x, index.y, index.z)[d],
+                    (CoordinateEnum)d);
+                axisCoeffs[d][i] = exp(-sigma * cdt);
+            }
+        }
+    }
+
     template<class TGrid>
     inline void PmlSpectral<TGrid>::save(std::ostream& ostr)
     {
@@ -339,13 +427,30 @@ namespace pfc {
         const int size = this->splitGrid->getNumPmlNodes();
         ostr.write((char*)&size, sizeof(size));
 
-        ostr.write((char*)bCoeffX.data(), sizeof(FP) * size);
-        ostr.write((char*)bCoeffY.data(), sizeof(FP) * size);
-        ostr.write((char*)bCoeffZ.data(), sizeof(FP) * size);
+        if (compactCoeffs) {
+            // the file format is the same in both modes
+            PmlArray coeffX, coeffY, coeffZ;
+            this->computeCoeffs(coeffX, coeffY, coeffZ,
+                &TGrid::BxPosition, &TGrid::ByPosition, &TGrid::BzPosition);
+            writeCoeffs(ostr, coeffX, coeffY, coeffZ);
+            this->computeCoeffs(coeffX, coeffY, coeffZ,
+                &TGrid::ExPosition, &TGrid::EyPosition, &TGrid::EzPosition);
+            writeCoeffs(ostr, coeffX, coeffY, coeffZ);
+        }
+        else {
+            writeCoeffs(ostr, bCoeffX, bCoeffY, bCoeffZ);
+            writeCoeffs(ostr, eCoeffX, eCoeffY, eCoeffZ);
+        }
+    }
 
-        ostr.write((char*)eCoeffX.data(), sizeof(FP) * size);
-        ostr.write((char*)eCoeffY.data(), sizeof(FP) * size);
-        ostr.write((char*)eCoeffZ.data(), sizeof(FP) * size);
+    template<class TGrid>
+    inline void PmlSpectral<TGrid>::writeCoeffs(std::ostream& ostr, const PmlArray& coeffX,
+        const PmlArray& coeffY, const PmlArray& coeffZ) const
+    {
+        const int size = this->splitGrid->getNumPmlNodes();
+        ostr.write((char*)coeffX.data(), sizeof(FP) * size);
+        ostr.write((char*)coeffY.data(), sizeof(FP) * size);
+        ostr.write((char*)coeffZ.data(), sizeof(FP) * size);
     }
 
     template<class TGrid>
@@ -371,5 +476,11 @@ namespace pfc {
         istr.read((char*)eCoeffX.data(), sizeof(FP) * size);
         istr.read((char*)eCoeffY.data(), sizeof(FP) * size);
         istr.read((char*)eCoeffZ.data(), sizeof(FP) * size);
+
+        for (int d = 0; d < 3; d++) {
+            PmlArray().swap(bAxisCoeffs[d]);
+            PmlArray().swap(eAxisCoeffs[d]);
+        }
+        compactCoeffs = false;
     }
 }
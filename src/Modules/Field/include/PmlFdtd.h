@@ -30,8 +30,8 @@ namespace pfc {
         // coefficient pre-computing
         void computeCoeffs();
 
-        std::vector<FP> bCoeff1X, bCoeff1Y, bCoeff1Z, eCoeff1X, eCoeff1Y, eCoeff1Z;  // e^(-sigma*dt)
-        std::vector<FP> bCoeff2X, bCoeff2Y, bCoeff2Z, eCoeff2X, eCoeff2Y, eCoeff2Z;  // (e^(-sigma*dt) - 1) / (sigma*dx)
+        PmlArray bCoeff1X, bCoeff1Y, bCoeff1Z, eCoeff1X, eCoeff1Y, eCoeff1Z;  // e^(-sigma*dt)
+        PmlArray bCoeff2X, bCoeff2Y, bCoeff2Z, eCoeff2X, eCoeff2Y, eCoeff2Z;  // (e^(-sigma*dt) - 1) / (sigma*dx)
 
     private:
 
@@ -43,8 +43,8 @@ namespace pfc {
         void updateE1D();
 
         void computeCoeffs(
-            std::vector<FP>& coeff1X, std::vector<FP>& coeff1Y, std::vector<FP>& coeff1Z,
-            std::vector<FP>& coeff2X, std::vector<FP>& coeff2Y, std::vector<FP>& coeff2Z,
+            PmlArray& coeff1X, PmlArray& coeff1Y, PmlArray& coeff1Z,
+            PmlArray& coeff2X, PmlArray& coeff2Y, PmlArray& coeff2Z,
             const FP3(YeeGrid::* positionFX)(int, int, int) const,
             const FP3(YeeGrid::* positionFY)(int, int, int) const,
             const FP3(YeeGrid::* positionFZ)(int, int, int) const);
@@ -59,8 +59,8 @@ namespace pfc {
     }
 
     inline void PmlFdtd::computeCoeffs(
-        std::vector<FP>& coeff1X, std::vector<FP>& coeff1Y, std::vector<FP>& coeff1Z,
-        std::vector<FP>& coeff2X, std::vector<FP>& coeff2Y, std::vector<FP>& coeff2Z,
+        PmlArray& coeff1X, PmlArray& coeff1Y, PmlArray& coeff1Z,
+        PmlArray& coeff2X, PmlArray& coeff2Y, PmlArray& coeff2Z,
         const FP3(YeeGrid::* positionFX)(int, int, int) const,
         const FP3(YeeGrid::* positionFY)(int, int, int) const,
         const FP3(YeeGrid::* positionFZ)(int, int, int) const)
@@ -13,39 +13,64 @@ namespace pfc {
             PmlSpectralTimeStaggered<TGrid, PmlPsatdTimeStaggered<TGrid>>(grid, complexGrid, dt,
                 domainIndexBegin, domainIndexEnd, complexDomainIndexBegin, complexDomainIndexEnd,
                 sizePML, nPmlParam, r0PmlParam)
-        {}
+        {
+            computeCoeffFactors();
+        }
 
         // constructor for loading
         explicit PmlPsatdTimeStaggered(TGrid* grid, SpectralGrid<FP, complexFP>* complexGrid, FP dt,
             Int3 domainIndexBegin, Int3 domainIndexEnd, Int3 complexDomainIndexBegin, Int3 complexDomainIndexEnd) :
             PmlSpectralTimeStaggered<TGrid, PmlPsatdTimeStaggered<TGrid>>(grid, complexGrid, dt,
                 domainIndexBegin, domainIndexEnd, complexDomainIndexBegin, complexDomainIndexEnd)
-        {}
+        {
+            computeCoeffFactors();
+        }
 
-        void computeTmpField(CoordinateEnum coordK,
-            SpectralScalarField<FP, complexFP>& field, double dt);
+        complexFP getTmpFieldCoeff(CoordinateEnum coordK, const Int3& ind, FP dt);
+
+    private:
+
+        void computeCoeffFactors();
+
+        // 2 * sin(|K| * c * dt / 2) / |K| at the nodes of the complex domain for dt of PML,
+        // the coefficients for the three components differ only by the component of K
+        PmlArray coeffFactors;
     };
 
     template <class TGrid>
-    inline void PmlPsatdTimeStaggered<TGrid>::computeTmpField(
-        CoordinateEnum coordK, SpectralScalarField<FP, complexFP>& field, double dt)
+    inline void PmlPsatdTimeStaggered<TGrid>::computeCoeffFactors()
     {
         const Int3 begin = this->complexDomainIndexBegin;
-        const Int3 end = this->complexDomainIndexEnd;
+        const Int3 size = this->complexDomainIndexEnd - begin;
+        coeffFactors.resize((size_t)size.volume());
 
         OMP_FOR()
-        for (int i = begin.x; i < end.x; i++)
-            for (int j = begin.y; j < end.y; j++)
-                for (int k = begin.z; k < end.z; k++) {
-                    FP3 K = this->getWaveVector(Int3(i, j, k));
-                    FP normK = K.norm();
-                    if (normK == 0) continue;
-                    K = K / normK;
-
-                    this->tmpFieldComplex(i, j, k) = 2.0 * sin(normK * constants::c * dt * 0.5) *
-                        complexFP::i() * (complexFP)(K[(int)coordK]) * field(i, j, k);
+        for (int i = 0; i < size.x; i++)
+            for (int j = 0; j < size.y; j++)
+                for (int k = 0; k < size.z; k++) {
+                    const FP normK = this->getWaveVector(begin + Int3(i, j, k)).norm();
+                    coeffFactors[((size_t)i * size.y + j) * size.z + k] = normK == 0 ? (FP)0 :
+                        (FP)2.0 * sin(normK * constants::c * this->dt * (FP)0.5) / normK;
                 }
+    }
+
+    template <class TGrid>
+    inline complexFP PmlPsatdTimeStaggered<TGrid>::getTmpFieldCoeff(
+        CoordinateEnum coordK, const Int3& ind, FP dt)
+    {
+        if (dt == this->dt) {
+            const Int3 size = this->complexDomainIndexEnd - this->complexDomainIndexBegin;
+            const Int3 index = ind - this->complexDomainIndexBegin;
+            return complexFP::i() * (complexFP)(coeffFactors[((size_t)index.x * size.y + index.y) * size.z + index.z] *
+                this->getWaveVector(ind)[(int)coordK]);
+        }
+
+        FP3 K = this->getWaveVector(ind);
+        FP normK = K.norm();
+        if (normK == 0) return complexFP(0);
+        K = K / normK;
 
-        this->fourierTransform.doFourierTransform(fourier_transform::Direction::CtoR);
+        return 2.0 * sin(normK * constants::c * dt * 0.5) *
+            complexFP::i() * (complexFP)(K[(int)coordK]);
     }
 }
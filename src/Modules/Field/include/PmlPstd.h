@@ -22,25 +22,12 @@ namespace pfc {
                 domainIndexBegin, domainIndexEnd, complexDomainIndexBegin, complexDomainIndexEnd)
         {}
 
-        void computeTmpField(CoordinateEnum coordK,
-            SpectralScalarField<FP, complexFP>& field, double dt);
+        complexFP getTmpFieldCoeff(CoordinateEnum coordK, const Int3& ind, FP dt);
     };
 
-    inline void PmlPstd::computeTmpField(CoordinateEnum coordK,
-        SpectralScalarField<FP, complexFP>& field, double dt)
+    inline complexFP PmlPstd::getTmpFieldCoeff(CoordinateEnum coordK, const Int3& ind, FP dt)
     {
-        const Int3 begin = this->complexDomainIndexBegin;
-        const Int3 end = this->complexDomainIndexEnd;
-
-        OMP_FOR()
-        for (int i = begin.x; i < end.x; i++)
-            for (int j = begin.y; j < end.y; j++)
-                for (int k = begin.z; k < end.z; k++) {
-                    this->tmpFieldComplex(i, j, k) = constants::c * dt * complexFP::i() *
-                        (complexFP)(this->getWaveVector(Int3(i, j, k))[(int)coordK]) * field(i, j, k);
-                }
-
-        this->fourierTransform.doFourierTransform(fourier_transform::Direction::CtoR);
+        return constants::c * dt * complexFP::i() * (complexFP)(this->getWaveVector(ind)[(int)coordK]);
     }
 
 }
@@ -1,6 +1,9 @@
 #pragma once
 #include "Pml.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace pfc {
 
     template<class TGrid, class TDerived>
@@ -17,17 +20,52 @@ namespace pfc {
             Int3 domainIndexBegin, Int3 domainIndexEnd, Int3 complexDomainIndexBegin, Int3 complexDomainIndexEnd);
 
         /* implement the next methods in derived classes
-        void computeTmpField(CoordinateEnum coordK, SpectralScalarField<FP, complexFP>& field, double dt);
+        // multiplier of a spectral field giving the contribution to the split components
+        complexFP getTmpFieldCoeff(CoordinateEnum coordK, const Int3& ind, FP dt);
         */
 
         void updateBSplit();
         void updateESplit();
 
+        /* In the reduced-memory mode the contributions to the split components are computed
+        for groups of x-planes containing PML nodes, numSlabs groups in total: the temporary
+        field holds one group of planes instead of the whole domain. For each group the
+        inverse transform along x is done by 1d FFTs of xz-planes of the spectral field,
+        so a step costs about numSlabs transforms along x instead of one. The storage of
+        the damping coefficients is chosen independently, see PmlSpectral::setCompactCoeffs. */
+        void setReducedMemoryMode(bool enabled, int numSlabs = 4);
+        bool isReducedMemoryMode() const { return reducedMemory; }
+
         FP3 getWaveVector(const Int3& ind);
 
         ScalarField<FP> tmpFieldReal;
         SpectralScalarField<FP, complexFP> tmpFieldComplex;
         FourierTransformField fourierTransform;
+
+        ScalarField<FP> tmpSlabReal;  // a group of planes of the temporary field in the reduced-memory mode
+        PlaneFourierTransform slabFourierTransform;
+        LineFourierTransform lineFourierTransform;  // transforms along x of an xz-plane in the reduced-memory mode
+
+    protected:
+
+        void computeTmpField(CoordinateEnum coordK, SpectralScalarField<FP, complexFP>& field, FP dt);
+        // planes [first, last) of pmlPlanes
+        void computeTmpSlab(CoordinateEnum coordK, SpectralScalarField<FP, complexFP>& field, FP dt,
+            int first, int last);
+        // split += sign * tmpField at the PML nodes
+        void updateSplit(CoordinateEnum coordK, SpectralScalarField<FP, complexFP>& field,
+            PmlArray& split, FP sign);
+
+        void allocateTmpField();
+        void computeWaveNumbers();
+
+        std::vector<FP> waveNumbers[3];  // components of the wave vector along each axis, see getWaveVector
+
+        bool reducedMemory = false;
+        int slabThickness = 0;
+        std::vector<int> pmlPlanes;  // x-indexes of the planes with PML nodes relative to the domain
+        std::vector<int> planeNodes;  // the nodes of pmlPlanes[p] are [planeNodes[p], planeNodes[p + 1])
+        std::vector<int> planeSlot;  // position of an x-plane in pmlPlanes, -1 if it has no PML nodes
     };
 
     template<class TGrid, class TDerived>
@@ -40,7 +78,9 @@ namespace pfc {
         tmpFieldReal(this->grid->numCells, this->grid->sizeStorage),
         tmpFieldComplex(&tmpFieldReal, fourier_transform::getSizeOfComplexArray(domainIndexEnd - domainIndexBegin))
     {
+        tmpFieldReal.setMemoryCategory(MemoryCategory::Pml);
         fourierTransform.initialize(&tmpFieldReal, &tmpFieldComplex, domainIndexEnd - domainIndexBegin);
+        computeWaveNumbers();
     }
 
     template<class TGrid, class TDerived>
@@ -52,96 +92,186 @@ namespace pfc {
         tmpFieldReal(this->grid->numCells, this->grid->sizeStorage),
         tmpFieldComplex(&tmpFieldReal, fourier_transform::getSizeOfComplexArray(domainIndexEnd - domainIndexBegin))
     {
+        tmpFieldReal.setMemoryCategory(MemoryCategory::Pml);
         fourierTransform.initialize(&tmpFieldReal, &tmpFieldComplex, domainIndexEnd - domainIndexBegin);
+        computeWaveNumbers();
     }
 
     template<class TGrid, class TDerived>
-    inline void PmlSpectralTimeStaggered<TGrid, TDerived>::updateBSplit()
+    inline void PmlSpectralTimeStaggered<TGrid, TDerived>::allocateTmpField()
     {
-        TDerived* derived = static_cast<TDerived*>(this);
+        tmpFieldReal = ScalarField<FP>(this->grid->numCells, this->grid->sizeStorage);
+        tmpFieldReal.setMemoryCategory(MemoryCategory::Pml);
+        tmpFieldComplex.updateData();
+        fourierTransform.initialize(&tmpFieldReal, &tmpFieldComplex, this->domainIndexEnd - this->domainIndexBegin);
+    }
 
+    template<class TGrid, class TDerived>
+    inline void PmlSpectralTimeStaggered<TGrid, TDerived>::computeWaveNumbers()
+    {
+        const Int3 domainSize = this->domainIndexEnd - this->domainIndexBegin;
+        for (int d = 0; d < 3; d++) {
+            waveNumbers[d].resize(domainSize[d]);
+            for (int i = 0; i < domainSize[d]; i++)
+                waveNumbers[d][i] = ((FP)2.0 * constants::pi * ((i <= domainSize[d] / 2) ? i : i - domainSize[d])) /
+                    (this->grid->steps[d] * domainSize[d]);
+        }
+    }
+
+    template<class TGrid, class TDerived>
+    inline void PmlSpectralTimeStaggered<TGrid, TDerived>::setReducedMemoryMode(bool enabled, int numSlabs)
+    {
+        if (!enabled) {
+            if (reducedMemory) {
+                slabFourierTransform.release();
+                lineFourierTransform.release();
+                tmpSlabReal = ScalarField<FP>();
+                allocateTmpField();
+            }
+            reducedMemory = false;
+            return;
+        }
+
+        const Int3 domainSize = this->domainIndexEnd - this->domainIndexBegin;
         const int size = this->splitGrid->getNumPmlNodes();
 
-        derived->computeTmpField(CoordinateEnum::y, this->complexGrid->Ez, this->dt);
-        OMP_FOR()
-        for (int idx = 0; idx < size; ++idx)
-            this->splitGrid->bxy[idx] -= this->tmpFieldReal(this->splitGrid->getIndex3d(idx));
+        // the nodes go through the planes in order
+        pmlPlanes.clear();
+        planeNodes.clear();
+        for (int idx = 0; idx < size; ++idx) {
+            const int x = this->splitGrid->getIndex3d(idx).x - this->domainIndexBegin.x;
+            if (pmlPlanes.empty() || pmlPlanes.back() != x) {
+                pmlPlanes.push_back(x);
+                planeNodes.push_back(idx);
+            }
+        }
+        planeNodes.push_back(size);
+        const int numPlanes = (int)pmlPlanes.size();
+        planeSlot.assign(domainSize.x, -1);
+        for (int p = 0; p < numPlanes; p++)
+            planeSlot[pmlPlanes[p]] = p;
 
-        derived->computeTmpField(CoordinateEnum::z, this->complexGrid->Ey, this->dt);
-        OMP_FOR()
-        for (int idx = 0; idx < size; ++idx)
-            this->splitGrid->bxz[idx] += this->tmpFieldReal(this->splitGrid->getIndex3d(idx));
+        slabThickness = std::max(1, (numPlanes + std::max(numSlabs, 1) - 1) / std::max(numSlabs, 1));
+        tmpSlabReal = ScalarField<FP>(Int3(slabThickness, domainSize.y, domainSize.z),
+            Int3(slabThickness, domainSize.y, 2 * (domainSize.z / 2 + 1)));
+        tmpSlabReal.setMemoryCategory(MemoryCategory::Pml);
+        slabFourierTransform.initialize(tmpSlabReal.getData(), reinterpret_cast<complexFP*>(tmpSlabReal.getData()),
+            tmpSlabReal.getSize(), tmpSlabReal.getMemSize());
+        const Int3 complexDomainSize = this->complexDomainIndexEnd - this->complexDomainIndexBegin;
+        lineFourierTransform.initialize(complexDomainSize.x, complexDomainSize.z);
 
-        derived->computeTmpField(CoordinateEnum::z, this->complexGrid->Ex, this->dt);
-        OMP_FOR()
-        for (int idx = 0; idx < size; ++idx)
-            this->splitGrid->byz[idx] -= this->tmpFieldReal(this->splitGrid->getIndex3d(idx));
+        // the full-domain temporary field is not used any more
+        fourierTransform.release();
+        tmpFieldReal = ScalarField<FP>();
+        reducedMemory = true;
+    }
 
-        derived->computeTmpField(CoordinateEnum::x, this->complexGrid->Ez, this->dt);
-        OMP_FOR()
-        for (int idx = 0; idx < size; ++idx)
-            this->splitGrid->byx[idx] += this->tmpFieldReal(this->splitGrid->getIndex3d(idx));
+    template<class TGrid, class TDerived>
+    inline void PmlSpectralTimeStaggered<TGrid, TDerived>::computeTmpField(
+        CoordinateEnum coordK, SpectralScalarField<FP, complexFP>& field, FP dt)
+    {
+        TDerived* derived = static_cast<TDerived*>(this);
 
-        derived->computeTmpField(CoordinateEnum::x, this->complexGrid->Ey, this->dt);
-        OMP_FOR()
-        for (int idx = 0; idx < size; ++idx)
-            this->splitGrid->bzx[idx] -= this->tmpFieldReal(this->splitGrid->getIndex3d(idx));
+        const Int3 begin = this->complexDomainIndexBegin;
+        const Int3 end = this->complexDomainIndexEnd;
 
-        derived->computeTmpField(CoordinateEnum::y, this->complexGrid->Ex, this->dt);
         OMP_FOR()
-        for (int idx = 0; idx < size; ++idx)
-            this->splitGrid->bzy[idx] += this->tmpFieldReal(this->splitGrid->getIndex3d(idx));
+        for (int i = begin.x; i < end.x; i++)
+            for (int j = begin.y; j < end.y; j++)
+                for (int k = begin.z; k < end.z; k++)
+                    this->tmpFieldComplex(i, j, k) = derived->getTmpFieldCoeff(coordK, Int3(i, j, k), dt) *
+                        field(i, j, k);
+
+        this->fourierTransform.doFourierTransform(fourier_transform::Direction::CtoR);
     }
 
     template<class TGrid, class TDerived>
-    inline void PmlSpectralTimeStaggered<TGrid, TDerived>::updateESplit()
+    inline void PmlSpectralTimeStaggered<TGrid, TDerived>::computeTmpSlab(
+        CoordinateEnum coordK, SpectralScalarField<FP, complexFP>& field, FP dt, int first, int last)
     {
         TDerived* derived = static_cast<TDerived*>(this);
 
-        const int size = this->splitGrid->getNumPmlNodes();
+        const Int3 begin = this->complexDomainIndexBegin;
+        const Int3 end = this->complexDomainIndexEnd;
+        const int nx = end.x - begin.x, nz = end.z - begin.z;
+        const FP normCoeff = (FP)1.0 / nx;  // the transforms along yz are normalized by themselves
+        const Int3 memSize = tmpSlabReal.getMemSize();
+        const int rowSize = memSize.z / 2;  // in complex numbers
+        complexFP* slab = reinterpret_cast<complexFP*>(tmpSlabReal.getData());
 
-        derived->computeTmpField(CoordinateEnum::y, this->complexGrid->Bz, this->dt);
-        OMP_FOR()
-        for (int idx = 0; idx < size; ++idx)
-            this->splitGrid->exy[idx] += this->tmpFieldReal(this->splitGrid->getIndex3d(idx));
+        // the inverse transform along x of each xz-plane, the planes of the group are kept,
+        // the yz-planes are transformed after that
+#pragma omp parallel
+        {
+            PmlVector<complexFP> plane((size_t)nx * nz);
+#pragma omp for
+            for (int j = begin.y; j < end.y; j++) {
+                for (int i = begin.x; i < end.x; i++)
+                    for (int k = begin.z; k < end.z; k++)
+                        plane[(size_t)(i - begin.x) * nz + k - begin.z] =
+                            derived->getTmpFieldCoeff(coordK, Int3(i, j, k), dt) * field(i, j, k) * normCoeff;
+                lineFourierTransform.doInverseFourierTransform(plane.data());
+                for (int p = first; p < last; p++) {
+                    const complexFP* row = plane.data() + (size_t)pmlPlanes[p] * nz;
+                    std::copy(row, row + nz, slab + ((p - first) * memSize.y + j) * rowSize);
+                }
+            }
+        }
 
-        derived->computeTmpField(CoordinateEnum::z, this->complexGrid->By, this->dt);
-        OMP_FOR()
-        for (int idx = 0; idx < size; ++idx)
-            this->splitGrid->exz[idx] -= this->tmpFieldReal(this->splitGrid->getIndex3d(idx));
+        this->slabFourierTransform.doFourierTransform(fourier_transform::Direction::CtoR);
+    }
 
-        derived->computeTmpField(CoordinateEnum::z, this->complexGrid->Bx, this->dt);
-        OMP_FOR()
-        for (int idx = 0; idx < size; ++idx)
-            this->splitGrid->eyz[idx] += this->tmpFieldReal(this->splitGrid->getIndex3d(idx));
+    template<class TGrid, class TDerived>
+    inline void PmlSpectralTimeStaggered<TGrid, TDerived>::updateSplit(CoordinateEnum coordK,
+        SpectralScalarField<FP, complexFP>& field, PmlArray& split, FP sign)
+    {
+        if (!reducedMemory) {
+            const int size = this->splitGrid->getNumPmlNodes();
+            computeTmpField(coordK, field, this->dt);
+            OMP_FOR()
+            for (int idx = 0; idx < size; ++idx)
+                split[idx] += sign * this->tmpFieldReal(this->splitGrid->getIndex3d(idx));
+            return;
+        }
 
-        derived->computeTmpField(CoordinateEnum::x, this->complexGrid->Bz, this->dt);
-        OMP_FOR()
-        for (int idx = 0; idx < size; ++idx)
-            this->splitGrid->eyx[idx] -= this->tmpFieldReal(this->splitGrid->getIndex3d(idx));
+        const int numPlanes = (int)pmlPlanes.size();
+        for (int first = 0; first < numPlanes; first += slabThickness) {
+            const int last = std::min(first + slabThickness, numPlanes);
+            computeTmpSlab(coordK, field, this->dt, first, last);
+            OMP_FOR()
+            for (int idx = planeNodes[first]; idx < planeNodes[last]; ++idx) {
+                const Int3 index = this->splitGrid->getIndex3d(idx) - this->domainIndexBegin;
+                split[idx] += sign * this->tmpSlabReal(planeSlot[index.x] - first, index.y, index.z);
+            }
+        }
+    }
 
-        derived->computeTmpField(CoordinateEnum::x, this->complexGrid->By, this->dt);
-        OMP_FOR()
-        for (int idx = 0; idx < size; ++idx)
-            this->splitGrid->ezx[idx] += this->tmpFieldReal(this->splitGrid->getIndex3d(idx));
+    template<class TGrid, class TDerived>
+    inline void PmlSpectralTimeStaggered<TGrid, TDerived>::updateBSplit()
+    {
+        updateSplit(CoordinateEnum::y, this->complexGrid->Ez, this->splitGrid->bxy, -1);
+        updateSplit(CoordinateEnum::z, this->complexGrid->Ey, this->splitGrid->bxz, 1);
+        updateSplit(CoordinateEnum::z, this->complexGrid->Ex, this->splitGrid->byz, -1);
+        updateSplit(CoordinateEnum::x, this->complexGrid->Ez, this->splitGrid->byx, 1);
+        updateSplit(CoordinateEnum::x, this->complexGrid->Ey, this->splitGrid->bzx, -1);
+        updateSplit(CoordinateEnum::y, this->complexGrid->Ex, this->splitGrid->bzy, 1);
+    }
 
-        derived->computeTmpField(CoordinateEnum::y, this->complexGrid->Bx, this->dt);
-        OMP_FOR()
-        for (int idx = 0; idx < size; ++idx)
-            this->splitGrid->ezy[idx] -= this->tmpFieldReal(this->splitGrid->getIndex3d(idx));
+    template<class TGrid, class TDerived>
+    inline void PmlSpectralTimeStaggered<TGrid, TDerived>::updateESplit()
+    {
+        updateSplit(CoordinateEnum::y, this->complexGrid->Bz, this->splitGrid->exy, 1);
+        updateSplit(CoordinateEnum::z, this->complexGrid->By, this->splitGrid->exz, -1);
+        updateSplit(CoordinateEnum::z, this->complexGrid->Bx, this->splitGrid->eyz, 1);
+        updateSplit(CoordinateEnum::x, this->complexGrid->Bz, this->splitGrid->eyx, -1);
+        updateSplit(CoordinateEnum::x, this->complexGrid->By, this->splitGrid->ezx, 1);
+        updateSplit(CoordinateEnum::y, this->complexGrid->Bx, this->splitGrid->ezy, -1);
     }
 
     template<class TGrid, class TDerived>
     inline FP3 PmlSpectralTimeStaggered<TGrid, TDerived>::getWaveVector(const Int3& ind)
     {
-        const Int3 domainSize = this->domainIndexEnd - this->domainIndexBegin;
-        FP kx = ((FP)2.0 * constants::pi * ((ind.x <= domainSize.x / 2) ? ind.x : ind.x - domainSize.x)) /
-            (this->grid->steps.x * domainSize.x);
-        FP ky = ((FP)2.0 * constants::pi * ((ind.y <= domainSize.y / 2) ? ind.y : ind.y - domainSize.y)) /
-            (this->grid->steps.y * domainSize.y);
-        FP kz = ((FP)2.0 * constants::pi * ((ind.z <= domainSize.z / 2) ? ind.z : ind.z - domainSize.z)) /
-            (this->grid->steps.z * domainSize.z);
-        return FP3(kx, ky, kz);
+        return FP3(waveNumbers[0][ind.x], waveNumbers[1][ind.y], waveNumbers[2][ind.z]);
     }
 
 }
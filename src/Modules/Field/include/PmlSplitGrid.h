@@ -1,11 +1,17 @@
 #pragma once
 #include "Vectors.h"
+#include "MemoryAccounting.h"
 #include "macros.h"
 
 #include <vector>
 
 namespace pfc {
 
+    // arrays of PML nodes, accounted to MemoryCategory::Pml
+    template <class T>
+    using PmlVector = std::vector<T, TrackingAllocator<T, MemoryCategory::Pml>>;
+    typedef PmlVector<FP> PmlArray;
+
     class PmlSplitGrid
     {
     public:
@@ -15,18 +21,18 @@ namespace pfc {
 
         forceinline int getNumPmlNodes() const { return index.size(); }
         forceinline Int3 getIndex3d(int idx) { return index[idx]; }
-        forceinline std::vector<Int3>& getIndices() { return index; }
+        forceinline PmlVector<Int3>& getIndices() { return index; }
 
         void save(std::ostream& ostr);
         void load(std::istream& istr);
 
         void resizeFields(int size);
 
-        std::vector<FP> bxy, bxz, byx, byz, bzx, bzy;  // split magnetic field
-        std::vector<FP> exy, exz, eyx, eyz, ezx, ezy;  // split electric field
+        PmlArray bxy, bxz, byx, byz, bzx, bzy;  // split magnetic field
+        PmlArray exy, exz, eyx, eyz, ezx, ezy;  // split electric field
         // first index (x, y, z) is component, second one is propagation direction
 
-        std::vector<Int3> index;  // natural 3d indexes of nodes in PML
+        PmlVector<Int3> index;  // natural 3d indexes of nodes in PML
         // indices go through area from left corner to right corner
     };
 
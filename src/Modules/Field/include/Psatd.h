@@ -136,6 +136,7 @@ namespace pfc {
         if (pml) pml->updateB();
         if (pml) pml->updateE();
 
+        grid->updateInterleavedFields();
         globalTime += dt;
     }
 
@@ -169,6 +170,7 @@ namespace pfc {
                     complexGrid->Ez(i, j, k) -= El.z;
                 }
         doFourierTransform(fourier_transform::Direction::CtoR);
+        grid->markFieldsChanged();
     }
 
     template <bool ifPoisson>
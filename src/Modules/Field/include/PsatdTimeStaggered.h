@@ -7,6 +7,8 @@
 #include "FieldBoundaryConditionSpectral.h"
 #include "FieldGeneratorSpectral.h"
 
+#include <utility>
+
 namespace pfc {
 
     namespace psatd_time_staggered {
@@ -46,6 +48,17 @@ namespace pfc {
 
         void setTimeStep(FP dt);
 
+        void setPML(Int3 sizePML);
+        void setPML(int sizePMLx, int sizePMLy, int sizePMLz);
+
+        /* In the reduced-memory mode J of the previous step is kept by swapping the storage
+        with the grid currents instead of copying it, the grid currents are zero after
+        each update and have to be deposited anew before the next one.
+        PML computes the split components slab by slab and stores the damping coefficients per axis,
+        see PmlSpectralTimeStaggered::setReducedMemoryMode and PmlSpectral::setCompactCoeffs. */
+        void setReducedMemoryMode(bool enabled);
+        bool isReducedMemoryMode() const { return reducedMemory; }
+
         static FP getCourantConditionTimeStep(const FP3& gridSteps) {
             // PSATD is free of the Courant condition
             // but PIC-code requires the following condition
@@ -75,10 +88,21 @@ namespace pfc {
 
         ScalarField<complexFP> tmpJx, tmpJy, tmpJz;
 
+        // J of the previous step in the reduced-memory mode, the storage is swapped with the grid currents
+        ScalarField<FP> prevJx, prevJy, prevJz;
+        SpectralScalarField<FP, complexFP> prevComplexJx, prevComplexJy, prevComplexJz;
+
     protected:
 
         void saveJ();
-        void assignJ(SpectralScalarField<FP, complexFP>& J, ScalarField<complexFP>& tmpJ);
+        void setMemoryCategory();
+        template <class TField, class TPrevField>
+        void assignJ(const TField& J, TPrevField& tmpJ);
+        template <class TPrevField>
+        void updateHalfB(const TPrevField& prevJx, const TPrevField& prevJy, const TPrevField& prevJz);
+        void setPmlReducedMemoryMode(bool enabled);
+
+        bool reducedMemory = false;
     };
 
     typedef PSATDTimeStaggeredT<true> PSATDTimeStaggeredPoisson;
@@ -89,16 +113,37 @@ namespace pfc {
         SpectralFieldSolver<psatd_time_staggered::SchemeParams>(grid, dt),
         tmpJx(this->complexGrid->numCells),
         tmpJy(this->complexGrid->numCells),
-        tmpJz(this->complexGrid->numCells)
-    {}
+        tmpJz(this->complexGrid->numCells),
+        prevComplexJx(&prevJx, this->complexGrid->numCells, this->grid->sizeStorage),
+        prevComplexJy(&prevJy, this->complexGrid->numCells, this->grid->sizeStorage),
+        prevComplexJz(&prevJz, this->complexGrid->numCells, this->grid->sizeStorage)
+    {
+        setMemoryCategory();
+    }
 
     template <bool ifPoisson>
     inline PSATDTimeStaggeredT<ifPoisson>::PSATDTimeStaggeredT(GridType* grid) :
         SpectralFieldSolver<psatd_time_staggered::SchemeParams>(grid),
         tmpJx(this->complexGrid->numCells),
         tmpJy(this->complexGrid->numCells),
-        tmpJz(this->complexGrid->numCells)
-    {}
+        tmpJz(this->complexGrid->numCells),
+        prevComplexJx(&prevJx, this->complexGrid->numCells, this->grid->sizeStorage),
+        prevComplexJy(&prevJy, this->complexGrid->numCells, this->grid->sizeStorage),
+        prevComplexJz(&prevJz, this->complexGrid->numCells, this->grid->sizeStorage)
+    {
+        setMemoryCategory();
+    }
+
+    template <bool ifPoisson>
+    inline void PSATDTimeStaggeredT<ifPoisson>::setMemoryCategory()
+    {
+        tmpJx.setMemoryCategory(MemoryCategory::FieldSolver);
+        tmpJy.setMemoryCategory(MemoryCategory::FieldSolver);
+        tmpJz.setMemoryCategory(MemoryCategory::FieldSolver);
+        prevJx.setMemoryCategory(MemoryCategory::FieldSolver);
+        prevJy.setMemoryCategory(MemoryCategory::FieldSolver);
+        prevJz.setMemoryCategory(MemoryCategory::FieldSolver);
+    }
 
     template <bool ifPoisson>
     inline void PSATDTimeStaggeredT<ifPoisson>::setPeriodicalBoundaryConditions()
@@ -120,13 +165,65 @@ namespace pfc {
     inline void PSATDTimeStaggeredT<ifPoisson>::setTimeStep(FP dt)
     {
         this->dt = dt;
-        if (this->pml) this->resetPML();
+        if (this->pml) this->setPML(this->pml->sizePML);
         if (this->generator) this->resetFieldGenerator();
     }
 
     template <bool ifPoisson>
-    inline void PSATDTimeStaggeredT<ifPoisson>::assignJ(
-        SpectralScalarField<FP, complexFP>& J, ScalarField<complexFP>& tmpJ)
+    inline void PSATDTimeStaggeredT<ifPoisson>::setPML(Int3 sizePML)
+    {
+        SpectralFieldSolver<psatd_time_staggered::SchemeParams>::setPML(sizePML);
+        if (reducedMemory) setPmlReducedMemoryMode(true);
+    }
+
+    template <bool ifPoisson>
+    inline void PSATDTimeStaggeredT<ifPoisson>::setPML(int sizePMLx, int sizePMLy, int sizePMLz)
+    {
+        this->setPML(Int3(sizePMLx, sizePMLy, sizePMLz));
+    }
+
+    template <bool ifPoisson>
+    inline void PSATDTimeStaggeredT<ifPoisson>::setReducedMemoryMode(bool enabled)
+    {
+        if (enabled && !reducedMemory) {
+            prevJx = ScalarField<FP>(this->grid->numCells, this->grid->sizeStorage);
+            prevJy = ScalarField<FP>(this->grid->numCells, this->grid->sizeStorage);
+            prevJz = ScalarField<FP>(this->grid->numCells, this->grid->sizeStorage);
+            prevComplexJx.updateData();
+            prevComplexJy.updateData();
+            prevComplexJz.updateData();
+            assignJ(tmpJx, prevComplexJx);
+            assignJ(tmpJy, prevComplexJy);
+            assignJ(tmpJz, prevComplexJz);
+            tmpJx = ScalarField<complexFP>();
+            tmpJy = ScalarField<complexFP>();
+            tmpJz = ScalarField<complexFP>();
+        }
+        else if (!enabled && reducedMemory) {
+            tmpJx = ScalarField<complexFP>(this->complexGrid->numCells);
+            tmpJy = ScalarField<complexFP>(this->complexGrid->numCells);
+            tmpJz = ScalarField<complexFP>(this->complexGrid->numCells);
+            assignJ(prevComplexJx, tmpJx);
+            assignJ(prevComplexJy, tmpJy);
+            assignJ(prevComplexJz, tmpJz);
+            prevJx = ScalarField<FP>();
+            prevJy = ScalarField<FP>();
+            prevJz = ScalarField<FP>();
+        }
+        reducedMemory = enabled;
+        if (this->pml) setPmlReducedMemoryMode(enabled);
+    }
+
+    template <bool ifPoisson>
+    inline void PSATDTimeStaggeredT<ifPoisson>::setPmlReducedMemoryMode(bool enabled)
+    {
+        this->pml->setReducedMemoryMode(enabled);
+        this->pml->setCompactCoeffs(enabled);
+    }
+
+    template <bool ifPoisson>
+    template <class TField, class TPrevField>
+    inline void PSATDTimeStaggeredT<ifPoisson>::assignJ(const TField& J, TPrevField& tmpJ)
     {
         const Int3 begin = Int3(0, 0, 0);
         const Int3 end = J.getSize();
@@ -141,9 +238,23 @@ namespace pfc {
     template <bool ifPoisson>
     inline void PSATDTimeStaggeredT<ifPoisson>::saveJ()
     {
-        assignJ(complexGrid->Jx, tmpJx);
-        assignJ(complexGrid->Jy, tmpJy);
-        assignJ(complexGrid->Jz, tmpJz);
+        if (!reducedMemory) {
+            assignJ(complexGrid->Jx, tmpJx);
+            assignJ(complexGrid->Jy, tmpJy);
+            assignJ(complexGrid->Jz, tmpJz);
+            return;
+        }
+
+        // the grid gets the storage of J of the previous step
+        std::swap(this->grid->Jx, prevJx);
+        std::swap(this->grid->Jy, prevJy);
+        std::swap(this->grid->Jz, prevJz);
+        this->complexGrid->updateData();
+        prevComplexJx.updateData();
+        prevComplexJy.updateData();
+        prevComplexJz.updateData();
+        this->fourierTransform.setData(this->grid, this->complexGrid.get());
+        this->grid->zeroizeJ();
     }
 
     template <bool ifPoisson>
@@ -167,11 +278,17 @@ namespace pfc {
         // applyBoundaryConditionsB(globalTime + dt);
 
         saveJ();
-        doFourierTransform(fourier_transform::Direction::CtoR);
+        if (reducedMemory) {
+            // the grid currents are zero
+            doFourierTransformE(fourier_transform::Direction::CtoR);
+            doFourierTransformB(fourier_transform::Direction::CtoR);
+        }
+        else doFourierTransform(fourier_transform::Direction::CtoR);
 
         if (pml) pml->updateB();
         if (pml) pml->updateE();
 
+        grid->updateInterleavedFields();
         globalTime += dt;
     }
 
@@ -204,10 +321,22 @@ namespace pfc {
                     complexGrid->Ez(i, j, k) -= El.z;
                 }
         doFourierTransform(fourier_transform::Direction::CtoR);
+        grid->markFieldsChanged();
     }
 
     template <bool ifPoisson>
     inline void PSATDTimeStaggeredT<ifPoisson>::updateHalfB()
+    {
+        if (reducedMemory)
+            updateHalfB(prevComplexJx, prevComplexJy, prevComplexJz);
+        else
+            updateHalfB(tmpJx, tmpJy, tmpJz);
+    }
+
+    template <bool ifPoisson>
+    template <class TPrevField>
+    inline void PSATDTimeStaggeredT<ifPoisson>::updateHalfB(
+        const TPrevField& prevJx, const TPrevField& prevJy, const TPrevField& prevJz)
     {
         const Int3 begin = this->complexDomainIndexBegin;
         const Int3 end = this->complexDomainIndexEnd;
@@ -228,7 +357,7 @@ namespace pfc {
 
                     ComplexFP3 E(complexGrid->Ex(i, j, k), complexGrid->Ey(i, j, k), complexGrid->Ez(i, j, k));
                     ComplexFP3 J(complexGrid->Jx(i, j, k), complexGrid->Jy(i, j, k), complexGrid->Jz(i, j, k)),
-                        prevJ(tmpJx(i, j, k), tmpJy(i, j, k), tmpJz(i, j, k));
+                        prevJ(prevJx(i, j, k), prevJy(i, j, k), prevJz(i, j, k));
                     J = complexFP(4 * constants::pi) * J;
                     prevJ = complexFP(4 * constants::pi) * prevJ;
                     ComplexFP3 crossKE = cross((ComplexFP3)K, E);
@@ -326,9 +455,21 @@ namespace pfc {
     {
         SpectralFieldSolver<psatd_time_staggered::SchemeParams>::save(ostr);
 
-        tmpJx.save(ostr);
-        tmpJy.save(ostr);
-        tmpJz.save(ostr);
+        // J of the previous step is saved in the same format in both modes
+        if (reducedMemory) {
+            ScalarField<complexFP> tmpJ(this->complexGrid->numCells);
+            assignJ(prevComplexJx, tmpJ);
+            tmpJ.save(ostr);
+            assignJ(prevComplexJy, tmpJ);
+            tmpJ.save(ostr);
+            assignJ(prevComplexJz, tmpJ);
+            tmpJ.save(ostr);
+        }
+        else {
+            tmpJx.save(ostr);
+            tmpJy.save(ostr);
+            tmpJz.save(ostr);
+        }
 
         this->saveFieldGenerator(ostr);
         this->savePML(ostr);
@@ -343,9 +484,14 @@ namespace pfc {
         tmpJx.load(istr);
         tmpJy.load(istr);
         tmpJz.load(istr);
+        if (reducedMemory) {
+            reducedMemory = false;
+            setReducedMemoryMode(true);
+        }
 
         this->loadFieldGenerator(istr);
         this->loadPML(istr);
+        if (reducedMemory && this->pml) setPmlReducedMemoryMode(true);
         this->loadBoundaryConditions(istr);
     }
 
@@ -135,6 +135,7 @@ namespace pfc {
         if (pml) pml->updateB();
         if (pml) pml->updateE();
 
+        grid->updateInterleavedFields();
         globalTime += dt;
     }
 
@@ -5,6 +5,7 @@
 #include "ParticleArray.h"
 
 #include <algorithm>
+#include <limits>
 #include <random>
 #include <vector>
 
@@ -16,9 +17,6 @@ namespace pfc
     public:
         static void merge_with_kmeans(ParticleArray& particles, int numClusters, int iteration)
         {
-            std::random_device rd;
-            std::mt19937 generator(rd());
-
             //Copy particle momentum
             vector<FP3> momentums(particles.size());
             for (int idx = 0; idx < particles.size(); idx++)
@@ -26,13 +24,108 @@ namespace pfc
 
             // k-means for getting cluster numbers
             vector<int> clusterDecomposition = kMeans(momentums, numClusters, iteration);
+            mergeClusters(particles, clusterDecomposition, numClusters);
+        }
+
+        /* The same merging as merge_with_kmeans, but clusters are found by the k-means
+        with Hamerly's triangle-inequality bounds: most of the particles skip the search
+        of the nearest centroid. Seeding is k-means++ in O(n*k), assignment runs in parallel
+        with per-thread centroid accumulators, the iterations stop when the centroids move
+        less than tolerance. */
+        static void merge_with_accelerated_kmeans(ParticleArray& particles, int numClusters, int iteration,
+            FP tolerance = 0)
+        {
+            const int n = (int)particles.size();
+            vector<FP3> momentums(n);
+#pragma omp parallel for
+            for (int idx = 0; idx < n; idx++)
+                momentums[idx] = particles[idx].getMomentum();
+
+            vector<int> clusterDecomposition = kMeansHamerly(momentums, numClusters, iteration, tolerance);
+            mergeClusters(particles, clusterDecomposition, numClusters);
+        }
+
+        /* Cell-local merging (M. Vranic et al., Comput. Phys. Commun. 191, 65 (2015)).
+        Particles are binned by spatial cell (minCoords, cellSize, numCells) and, inside
+        each spatial cell, by momentum cell (numMomentumCells cells between the min and max
+        momentum of the cell). Each momentum bin with at least minParticlesToMerge particles
+        is replaced by two particles located at the weighted mean position of the bin
+        that conserve the total weight, momentum and energy of the bin.
+        Particles of different types are never merged together: an AoS array with mixed
+        types is binned by the type as well. Spatial cells are processed in parallel,
+        complexity is O(n). */
+        static void merge_in_cells(ParticleArray& particles, const FP3& minCoords, const FP3& cellSize,
+            const Int3& numCells, const Int3& numMomentumCells, int minParticlesToMerge = 4)
+        {
+            const int n = particles.size();
+            // a cell is split into cells of each particle type
+            const int numSpatialCells = numCells.volume() * sizeParticleTypes;
+
+            // counting sort of particle indices by spatial cells
+            vector<int> cellIndex(n);
+#pragma omp parallel for
+            for (int i = 0; i < n; i++)
+                cellIndex[i] = getCellIndex(particles[i].getPosition(), minCoords, cellSize, numCells)
+                    * sizeParticleTypes + (int)particles[i].getType();
+
+            vector<int> cellStart(numSpatialCells + 1, 0);
+            for (int i = 0; i < n; i++)
+                cellStart[cellIndex[i] + 1]++;
+            for (int cell = 0; cell < numSpatialCells; cell++)
+                cellStart[cell + 1] += cellStart[cell];
+
+            vector<int> sortedIndex(n);
+            vector<int> cellFill(cellStart.begin(), cellStart.end() - 1);
+            for (int i = 0; i < n; i++)
+                sortedIndex[cellFill[cellIndex[i]]++] = i;
+
+            vector<vector<Particle3d>> mergedParticles(numSpatialCells);
+#pragma omp parallel for schedule(dynamic, 16)
+            for (int cell = 0; cell < numSpatialCells; cell++)
+            {
+                const int cellCount = cellStart[cell + 1] - cellStart[cell];
+                if (cellCount == 0)
+                    continue;
+                vector<Particle3d>& result = mergedParticles[cell];
+                result.reserve(cellCount);
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++)
+                    result.push_back(Particle3d(particles[sortedIndex[k]]));
+                if (cellCount >= minParticlesToMerge)
+                    mergeCell(result, numMomentumCells, minParticlesToMerge);
+            }
+
+            particles.clear();
+            for (int cell = 0; cell < numSpatialCells; cell++)
+                for (int k = 0; k < (int)mergedParticles[cell].size(); k++)
+                    particles.pushBackKeepingType(mergedParticles[cell][k]);
+        }
+
+        // linear index of the cell containing the position, positions out of the cells
+        // are attributed to the closest boundary cell
+        static int getCellIndex(const FP3& position, const FP3& minCoords, const FP3& cellSize, const Int3& numCells)
+        {
+            Int3 idx;
+            for (int d = 0; d < 3; d++)
+            {
+                idx[d] = (int)std::floor((position[d] - minCoords[d]) / cellSize[d]);
+                idx[d] = std::min(std::max(idx[d], 0), numCells[d] - 1);
+            }
+            return (idx.x * numCells.y + idx.y) * numCells.z + idx.z;
+        }
+
+    private:
+
+        // Instead of each cluster, we create one particle with a total factor;
+        // the position ones from all, momentum are weighted averages, taking into account the factors
+        static void mergeClusters(ParticleArray& particles, const vector<int>& clusterDecomposition, int numClusters)
+        {
+            std::random_device rd;
+            std::mt19937 generator(rd());
 
             vector<vector<Particle3d>> clusters(numClusters);
-            for (int i = 0; i < particles.size(); i++)
+            for (int i = 0; i < (int)particles.size(); i++)
                 clusters[clusterDecomposition[i]].push_back(Particle3d(particles[i]));
 
-            // Instead of each cluster, we create one particle with a total factor;
-            // the position ones from all, momentum are weighted averages, taking into account the factors
             particles.clear();
             for (int j = 0; j < numClusters; j++) {
                 if (clusters[j].empty())
@@ -41,7 +134,7 @@ namespace pfc
                 FP3 position, momentum;
                 vector<FP3> positions;
                 double weight = 0.0;
-                for (int k = 0; k < clusters[j].size(); k++) {
+                for (int k = 0; k < (int)clusters[j].size(); k++) {
                     positions.push_back(clusters[j][k].getPosition());
                     momentum += clusters[j][k].getMomentum() * clusters[j][k].getWeight();
                     weight += clusters[j][k].getWeight();
@@ -52,7 +145,106 @@ namespace pfc
             }
         }
 
-    private:
+        // merges particles of one spatial cell in place, all particles have the same type
+        static void mergeCell(vector<Particle3d>& cellParticles, const Int3& numMomentumCells, int minParticlesToMerge)
+        {
+            const int n = (int)cellParticles.size();
+            vector<FP3> momentums(n);
+            FP3 minMomentum = cellParticles[0].getMomentum(), maxMomentum = minMomentum;
+            for (int i = 0; i < n; i++)
+            {
+                momentums[i] = cellParticles[i].getMomentum();
+                for (int d = 0; d < 3; d++)
+                {
+                    minMomentum[d] = std::min(minMomentum[d], momentums[i][d]);
+                    maxMomentum[d] = std::max(maxMomentum[d], momentums[i][d]);
+                }
+            }
+            FP3 momentumStep = (maxMomentum - minMomentum) / (FP3)numMomentumCells;
+            for (int d = 0; d < 3; d++)
+                if (momentumStep[d] == 0)
+                    momentumStep[d] = 1;
+
+            // counting sort by momentum cells
+            const int numBins = numMomentumCells.volume();
+            vector<int> binIndex(n), binStart(numBins + 1, 0);
+            for (int i = 0; i < n; i++)
+            {
+                binIndex[i] = getCellIndex(momentums[i], minMomentum, momentumStep, numMomentumCells);
+                binStart[binIndex[i] + 1]++;
+            }
+            for (int bin = 0; bin < numBins; bin++)
+                binStart[bin + 1] += binStart[bin];
+            vector<int> sortedIndex(n);
+            vector<int> binFill(binStart.begin(), binStart.end() - 1);
+            for (int i = 0; i < n; i++)
+                sortedIndex[binFill[binIndex[i]]++] = i;
+
+            vector<Particle3d> result;
+            result.reserve(n);
+            for (int bin = 0; bin < numBins; bin++)
+            {
+                const int binSize = binStart[bin + 1] - binStart[bin];
+                if (binSize < std::max(minParticlesToMerge, 3))
+                {
+                    for (int k = binStart[bin]; k < binStart[bin + 1]; k++)
+                        result.push_back(cellParticles[sortedIndex[k]]);
+                    continue;
+                }
+                mergeBin(cellParticles, momentums, &sortedIndex[binStart[bin]], binSize, result);
+            }
+            cellParticles.swap(result);
+        }
+
+        // replaces the particles of a bin by two particles with the same total weight, momentum and energy
+        static void mergeBin(const vector<Particle3d>& cellParticles, const vector<FP3>& momentums,
+            const int* index, int binSize, vector<Particle3d>& result)
+        {
+            const Particle3d& first = cellParticles[index[0]];
+            const FP mc = first.getMass() * Constants<FP>::lightVelocity();
+            FP weight = 0, energy = 0;
+            FP3 momentum, position;
+            for (int k = 0; k < binSize; k++)
+            {
+                const Particle3d& particle = cellParticles[index[k]];
+                const FP w = particle.getWeight();
+                weight += w;
+                momentum += w * momentums[index[k]];
+                energy += w * sqrt(mc * mc + momentums[index[k]].norm2());
+                position += w * particle.getPosition();
+            }
+            position = position / weight;
+
+            // both new particles have weight / 2 and momentum modulus pt, symmetric about the total momentum
+            const FP meanEnergy = energy / weight;
+            const FP pt = sqrt(std::max(meanEnergy * meanEnergy - mc * mc, (FP)0));
+            const FP totalMomentum = momentum.norm();
+            FP cosTheta = pt > 0 ? std::min(totalMomentum / (weight * pt), (FP)1) : (FP)1;
+            FP sinTheta = sqrt((FP)1 - cosTheta * cosTheta);
+
+            FP3 directionP = totalMomentum > 0 ? momentum / totalMomentum : FP3(1, 0, 0);
+            // the second direction lies in the plane of the total momentum and a momentum of the bin
+            FP3 directionPerp;
+            for (int k = 0; k < binSize && directionPerp.norm2() == 0; k++)
+            {
+                const FP3& p = momentums[index[k]];
+                directionPerp = p - dot(p, directionP) * directionP;
+                if (directionPerp.norm2() <= 1e-12 * p.norm2())
+                    directionPerp = FP3();
+            }
+            if (directionPerp.norm2() == 0)
+            {
+                FP3 axis = std::abs(directionP.x) < 0.5 ? FP3(1, 0, 0) : FP3(0, 1, 0);
+                directionPerp = cross(directionP, axis);
+            }
+            directionPerp.normalize();
+
+            FP3 pa = pt * (cosTheta * directionP + sinTheta * directionPerp);
+            FP3 pb = pt * (cosTheta * directionP - sinTheta * directionPerp);
+            result.push_back(Particle3d(position, pa, weight / 2, first.getType()));
+            result.push_back(Particle3d(position, pb, weight / 2, first.getType()));
+        }
+
         static vector<int> kMeans(const vector<FP3>& Particles, int k, int iteration)
         {
             std::random_device rd;
@@ -154,5 +346,176 @@ namespace pfc
             }
             return Clusters;
         }
+
+        // k-means++ seeding with the incremental update of the distance to the nearest centroid
+        static vector<FP3> kMeansPlusPlusCenters(const vector<FP3>& points, int k)
+        {
+            std::random_device rd;
+            std::mt19937 generator(rd());
+            std::uniform_real_distribution<FP> uniform_dist(0.0, 1.0);
+            const int n = (int)points.size();
+
+            vector<FP3> centers(k);
+            vector<FP> minDist2(n);
+            centers[0] = points[std::uniform_int_distribution<int>(0, n - 1)(generator)];
+            FP sum = 0;
+#pragma omp parallel for reduction(+:sum)
+            for (int i = 0; i < n; i++)
+            {
+                minDist2[i] = (points[i] - centers[0]).norm2();
+                sum += minDist2[i];
+            }
+            for (int j = 1; j < k; j++)
+            {
+                FP threshold = uniform_dist(generator) * sum;
+                int chosen = n - 1;
+                FP partialSum = 0;
+                for (int i = 0; i < n; i++)
+                {
+                    partialSum += minDist2[i];
+                    if (partialSum >= threshold && minDist2[i] > 0)
+                    {
+                        chosen = i;
+                        break;
+                    }
+                }
+                centers[j] = points[chosen];
+                sum = 0;
+#pragma omp parallel for reduction(+:sum)
+                for (int i = 0; i < n; i++)
+                {
+                    minDist2[i] = std::min(minDist2[i], (points[i] - centers[j]).norm2());
+                    sum += minDist2[i];
+                }
+            }
+            return centers;
+        }
+
+        /* Hamerly's k-means (G. Hamerly, Making k-means even faster, SDM 2010).
+        For each point the upper bound of the distance to its centroid and the lower bound
+        of the distance to the second closest centroid are kept; the nearest centroid is
+        searched only when the bounds do not prove that the assignment is unchanged. */
+        static vector<int> kMeansHamerly(const vector<FP3>& points, int k, int iteration, FP tolerance)
+        {
+            const int n = (int)points.size();
+            vector<int> clusters(n, 0);
+            if (n == 0 || k <= 0)
+                return clusters;
+            k = std::min(k, n);
+
+            vector<FP3> centers = kMeansPlusPlusCenters(points, k);
+            vector<FP> upper(n), lower(n);
+            vector<FP> halfMinCenterDist(k), centerShift(k);
+
+            const int numThreads = OMP_GET_MAX_THREADS();
+            vector<FP3> threadSums(numThreads * k);
+            vector<int> threadCounts(numThreads * k);
+
+            for (int iter = 0; iter <= iteration; iter++)
+            {
+                for (int j = 0; j < k; j++)
+                {
+                    FP minDist = std::numeric_limits<FP>::max();
+                    for (int h = 0; h < k; h++)
+                        if (h != j)
+                            minDist = std::min(minDist, (centers[j] - centers[h]).norm());
+                    halfMinCenterDist[j] = (FP)0.5 * minDist;
+                }
+                std::fill(threadSums.begin(), threadSums.end(), FP3());
+                std::fill(threadCounts.begin(), threadCounts.end(), 0);
+
+                int numChanged = 0;
+#pragma omp parallel reduction(+:numChanged)
+                {
+                    int threadId;
+#ifdef __USE_OMP__
+                    threadId = omp_get_thread_num();
+#else
+                    threadId = 0;
+#endif
+                    FP3* sums = &threadSums[threadId * k];
+                    int* counts = &threadCounts[threadId * k];
+#pragma omp for
+                    for (int i = 0; i < n; i++)
+                    {
+                        int a = clusters[i];
+                        bool search = iter == 0;
+                        if (!search)
+                        {
+                            FP bound = std::max(halfMinCenterDist[a], lower[i]);
+                            if (upper[i] > bound)
+                            {
+                                upper[i] = (points[i] - centers[a]).norm();
+                                search = upper[i] > bound;
+                            }
+                        }
+                        if (search)
+                        {
+                            FP d1 = std::numeric_limits<FP>::max(), d2 = d1;
+                            int nearest = 0;
+                            for (int j = 0; j < k; j++)
+                            {
+                                FP d = (points[i] - centers[j]).norm();
+                                if (d < d1)
+                                {
+                                    d2 = d1;
+                                    d1 = d;
+                                    nearest = j;
+                                }
+                                else if (d < d2)
+                                    d2 = d;
+                            }
+                            if (nearest != a)
+                                numChanged++;
+                            clusters[i] = nearest;
+                            upper[i] = d1;
+                            lower[i] = d2;
+                        }
+                        sums[clusters[i]] += points[i];
+                        counts[clusters[i]]++;
+                    }
+                }
+
+                // reduction of per-thread accumulators and centroid update
+                FP maxShift = 0, secondMaxShift = 0;
+                int maxShiftCluster = 0;
+                for (int j = 0; j < k; j++)
+                {
+                    FP3 sum;
+                    int count = 0;
+                    for (int t = 0; t < numThreads; t++)
+                    {
+                        sum += threadSums[t * k + j];
+                        count += threadCounts[t * k + j];
+                    }
+                    centerShift[j] = 0;
+                    if (count > 0)
+                    {
+                        FP3 newCenter = sum / (FP)count;
+                        centerShift[j] = (newCenter - centers[j]).norm();
+                        centers[j] = newCenter;
+                    }
+                    if (centerShift[j] > maxShift)
+                    {
+                        secondMaxShift = maxShift;
+                        maxShift = centerShift[j];
+                        maxShiftCluster = j;
+                    }
+                    else if (centerShift[j] > secondMaxShift)
+                        secondMaxShift = centerShift[j];
+                }
+
+                if (iter > 0 && numChanged == 0 && maxShift <= tolerance)
+                    break;
+
+#pragma omp parallel for
+                for (int i = 0; i < n; i++)
+                {
+                    upper[i] += centerShift[clusters[i]];
+                    lower[i] -= clusters[i] == maxShiftCluster ? secondMaxShift : maxShift;
+                }
+            }
+            return clusters;
+        }
     };
 }
\ No newline at end of file
@@ -12,11 +12,22 @@
 using namespace constants;
 namespace pfc
 {
-    template <class TGrid>  // may be AnalyticalField or any Grid type
+    /* QED handler parametrized by the field source, the pusher and the particle container.
+    TGrid may be AnalyticalField or any Grid type: it is only required to provide
+    getE(const FP3&) and getB(const FP3&).
+    TPusher is a pusher from Pusher.h (BorisPusher, VayPusher) used for the particle push
+    between and during QED events.
+    TParticleArray is any particle array (AoS or SoA), particles are stored in Ensemble<TParticleArray>. */
+    template <class TGrid, class TPusher = BorisPusher, class TParticleArray = ParticleArray3d>
     class ScalarQED_AEG_only_electron : public ParticlePusher
     {
     public:
 
+        typedef TParticleArray ParticleArray;
+        typedef Ensemble<TParticleArray> EnsembleType;
+        typedef typename TParticleArray::ParticleType ParticleType;
+        typedef typename TParticleArray::ParticleProxyType ParticleProxyType;
+
         ScalarQED_AEG_only_electron()
         {
             MinProbability = 5e-4;
@@ -46,7 +57,7 @@ namespace pfc
 
         }
 
-        void processParticles(Ensemble3d* particles, TGrid* grid, FP timeStep)
+        void processParticles(EnsembleType* particles, TGrid* grid, FP timeStep)
         {
             int max_threads;
 #ifdef __USE_OMP__
@@ -83,31 +94,14 @@ namespace pfc
             }
         }
 
-        void Boris(Particle3d&& particle, const FP3& e, const FP3& b, FP timeStep)
-        {
-            FP eCoeff = timeStep * particle.getCharge() / (2 * particle.getMass() * Constants<FP>::lightVelocity());
-            FP3 eMomentum = e * eCoeff;
-            FP3 um = particle.getP() + eMomentum;
-            FP3 t = b * eCoeff / sqrt((FP)1 + um.norm2());
-            FP3 uprime = um + cross(um, t);
-            FP3 s = t * (FP)2 / ((FP)1 + t.norm2());
-            particle.setP(eMomentum + um + cross(uprime, s));
-            particle.setPosition(particle.getPosition() + timeStep * particle.getVelocity());
-        }
-
-        void Boris(ParticleProxy3d&& particle, const FP3& e, const FP3& b, FP timeStep)
+        template <class T_Particle>
+        void push(T_Particle&& particle, const FP3& e, const FP3& b, FP timeStep)
         {
-            FP eCoeff = timeStep * particle.getCharge() / (2 * particle.getMass() * Constants<FP>::lightVelocity());
-            FP3 eMomentum = e * eCoeff;
-            FP3 um = particle.getP() + eMomentum;
-            FP3 t = b * eCoeff / sqrt((FP)1 + um.norm2());
-            FP3 uprime = um + cross(um, t);
-            FP3 s = t * (FP)2 / ((FP)1 + t.norm2());
-            particle.setP(eMomentum + um + cross(uprime, s));
-            particle.setPosition(particle.getPosition() + timeStep * particle.getVelocity());
+            ValueField field(e, b);
+            pusher(&particle, field, timeStep);
         }
 
-        void HandlePhotons(ParticleArray3d& particles, TGrid* grid, FP timeStep)
+        void HandlePhotons(TParticleArray& particles, TGrid* grid, FP timeStep)
         {
             FP dt = timeStep;
 #pragma omp parallel for schedule(dynamic, 1)
@@ -152,7 +146,7 @@ namespace pfc
                     double delta = Pair_Generator(Factor, chi, gamma, dt);
                     if (delta != 0)
                     {
-                        Particle3d NewParticle;
+                        ParticleType NewParticle;
                         NewParticle.setType(Electron);
                         NewParticle.setWeight(particles[i].getWeight());
                         NewParticle.setPosition(particles[i].getPosition());
@@ -172,7 +166,7 @@ namespace pfc
                     //=======handle avalanche========
                     AvalancheParticles[thread_id].clear();
                     AvalanchePhotons[thread_id].clear();
-                    AvalanchePhotons[thread_id].push_back(particles[i]);
+                    AvalanchePhotons[thread_id].push_back(ParticleType(particles[i]));
                     particles[i].setPosition(particles[i].getPosition() - dt * Constants<FP>::lightVelocity() * k); // go back
 
                     RunAvalanche(H_eff, e, b, Photon, pGamma, dt);
@@ -187,7 +181,7 @@ namespace pfc
             }
         }
 
-        void HandleParticles(ParticleArray3d& particles, TGrid* grid, FP timeStep)
+        void HandleParticles(TParticleArray& particles, TGrid* grid, FP timeStep)
         {
             FP dt = timeStep;
 #pragma omp parallel for schedule(dynamic, 1)
@@ -223,7 +217,7 @@ namespace pfc
                     FP r0 = random_number_omp();
                     if (r0 > EstimatedProbability / MinProbability)
                     {
-                        Boris(particles[i], e, b, dt);
+                        push(particles[i], e, b, dt);
                         continue;
                     }
                     else
@@ -237,7 +231,7 @@ namespace pfc
                     double delta = Photon_MGenerator(Factor, chi, gamma, dt);
                     if (delta != 0)
                     {
-                        Particle3d NewParticle;
+                        ParticleType NewParticle;
                         NewParticle.setType(Photon);
                         NewParticle.setWeight(particles[i].getWeight());
                         NewParticle.setPosition(particles[i].getPosition());
@@ -247,14 +241,14 @@ namespace pfc
 
                         particles[i].setMomentum((1 - delta) * particles[i].getMomentum());
                     }
-                    Boris(particles[i], e, b, dt);
+                    push(particles[i], e, b, dt);
                 }
                 else
                 {
                     //=======handle avalanche========
                     AvalancheParticles[thread_id].clear();
                     AvalanchePhotons[thread_id].clear();
-                    AvalancheParticles[thread_id].push_back(particles[i]);
+                    AvalancheParticles[thread_id].push_back(ParticleType(particles[i]));
                     RunAvalanche(H_eff, e, b, particles[i].getType(), pGamma, dt);
 
                     for (int k = 0; k != AvalanchePhotons[thread_id].size(); k++)
@@ -277,8 +271,8 @@ namespace pfc
 #else
             thread_id = 0;
 #endif
-            vector<Particle3d>& AvalancheParticles = this->AvalancheParticles[thread_id];
-            vector<Particle3d>& AvalanchePhotons = this->AvalanchePhotons[thread_id];
+            vector<ParticleType>& AvalancheParticles = this->AvalancheParticles[thread_id];
+            vector<ParticleType>& AvalanchePhotons = this->AvalanchePhotons[thread_id];
             gamma = max(gamma, 1.0);
             FP HE = H_eff_global / SchwingerField;
             FP sub_dt = MaxProbability / estimatedParticles(HE, gamma);
@@ -289,7 +283,7 @@ namespace pfc
             {
                 for (int k = 0; k != AvalancheParticles.size(); k++)
                 {
-                    Boris(AvalancheParticles[k], E, B, sub_dt);
+                    push(AvalancheParticles[k], E, B, sub_dt);
 
                     FP3 v = AvalancheParticles[k].getVelocity();
                     FP H_eff = sqr(E + (1 / Constants<FP>::lightVelocity()) * VP(v, B))
@@ -301,7 +295,7 @@ namespace pfc
                     FP delta = Photon_MGenerator(1, chi, gamma, sub_dt);
                     if (delta != 0)
                     {
-                        Particle3d NewParticle;
+                        ParticleType NewParticle;
                         NewParticle.setType(Photon);
                         NewParticle.setWeight(AvalancheParticles[k].getWeight());
                         NewParticle.setPosition(AvalancheParticles[k].getPosition());
@@ -324,7 +318,7 @@ namespace pfc
                     FP delta = Pair_Generator(1, chi, gamma, sub_dt);
                     if (delta != 0)
                     {
-                        Particle3d NewParticle;
+                        ParticleType NewParticle;
                         NewParticle.setType(Electron);
                         NewParticle.setWeight(AvalanchePhotons[k].getWeight());
                         NewParticle.setPosition(AvalanchePhotons[k].getPosition());
@@ -416,12 +410,12 @@ namespace pfc
         }
 
 
-        void operator()(ParticleProxy3d* particle, ValueField field, FP timeStep)
+        void operator()(ParticleProxyType* particle, ValueField field, FP timeStep)
         {}
 
-        void operator()(Particle3d* particle, ValueField field, FP timeStep)
+        void operator()(ParticleType* particle, ValueField field, FP timeStep)
         {
-            ParticleProxy3d particleProxy(*particle);
+            ParticleProxyType particleProxy(*particle);
             this->operator()(&particleProxy, field, timeStep);
         }
     private:
@@ -440,16 +434,23 @@ namespace pfc
         FP preFactor;
         FP coeffPhoton_probability, coeffPair_probability;
 
+        TPusher pusher;
+
         std::default_random_engine rand_generator;
         std::uniform_real_distribution<FP> distribution;
 
 
-        vector<vector<Particle3d>> AvalanchePhotons, AvalancheParticles;
-        vector<vector<Particle3d>> afterAvalanchePhotons, afterAvalancheParticles;
+        vector<vector<ParticleType>> AvalanchePhotons, AvalancheParticles;
+        vector<vector<ParticleType>> afterAvalanchePhotons, afterAvalancheParticles;
     };
 
     typedef ScalarQED_AEG_only_electron<YeeGrid> ScalarQED_AEG_only_electron_Yee;
     typedef ScalarQED_AEG_only_electron<PSTDGrid> ScalarQED_AEG_only_electron_PSTD;
     typedef ScalarQED_AEG_only_electron<PSATDGrid> ScalarQED_AEG_only_electron_PSATD;
     typedef ScalarQED_AEG_only_electron<AnalyticalField> ScalarQED_AEG_only_electron_Analytical;
+
+    typedef ScalarQED_AEG_only_electron<YeeGrid, VayPusher> ScalarQED_AEG_only_electron_Yee_Vay;
+    typedef ScalarQED_AEG_only_electron<PSTDGrid, VayPusher> ScalarQED_AEG_only_electron_PSTD_Vay;
+    typedef ScalarQED_AEG_only_electron<PSATDGrid, VayPusher> ScalarQED_AEG_only_electron_PSATD_Vay;
+    typedef ScalarQED_AEG_only_electron<AnalyticalField, VayPusher> ScalarQED_AEG_only_electron_Analytical_Vay;
 }
\ No newline at end of file
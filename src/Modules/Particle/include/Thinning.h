@@ -1,10 +1,14 @@
 #pragma once
 #include "Constants.h"
 #include "FP.h"
+#include "Merging.h"
 #include "ParticleArray.h"
 
 #include <algorithm>
+#include <cmath>
 #include <random>
+#include <functional>
+#include <set>
 #include <vector>
 #include <queue>
 
@@ -152,6 +156,103 @@ namespace pfc
             }
         }
 
+        /* Parallel version of simple: every particle gets a random key from a per-thread
+        generator and the m particles with the smallest keys are kept, that is a uniform
+        random subset of size m as in simple. Equal keys are ordered by the index, so exactly
+        m particles are kept. Expected O(n), one compaction pass. */
+        void simpleParallel(ParticleArray& particles, int m)
+        {
+            const int sizeArray = particles.size();
+            if (m >= sizeArray)
+                return;
+            std::vector<std::pair<FP, int>> keys(sizeArray);
+            std::vector<std::mt19937> generators = threadGenerators();
+#pragma omp parallel
+            {
+                std::mt19937& threadGenerator = generators[getThreadId()];
+                std::uniform_real_distribution<FP> dist(0, 1);
+#pragma omp for
+                for (int idx = 0; idx < sizeArray; idx++)
+                    keys[idx] = std::make_pair(dist(threadGenerator), idx);
+            }
+
+            std::vector<std::pair<FP, int>> sortedKeys(keys);
+            std::nth_element(sortedKeys.begin(), sortedKeys.begin() + m, sortedKeys.end());
+            const std::pair<FP, int> threshold = sortedKeys[m];
+
+            FP newCoeff = static_cast<FP>(sizeArray) / (static_cast<FP>(m));
+            std::vector<char> isKept(sizeArray);
+#pragma omp parallel for
+            for (int idx = 0; idx < sizeArray; idx++)
+            {
+                isKept[idx] = keys[idx] < threshold;
+                if (isKept[idx])
+                {
+                    FP weight = particles[idx].getWeight();
+                    particles[idx].setWeight(weight * newCoeff);
+                }
+            }
+            particles.compact(keptIndices(isKept));
+        }
+
+        /* Parallel version of numberConservative based on systematic resampling:
+        m points u, u + W/m, ..., with a single random shift u are laid over the prefix sums
+        of weights, particle i is sampled ki times, E[ki] = m * w_i / W and sum ki = m.
+        O(n), one compaction pass. */
+        void numberConservativeParallel(ParticleArray& particles, int m)
+        {
+            const int sizeArray = particles.size();
+            std::vector<FP> prefixSums(sizeArray);
+#pragma omp parallel for
+            for (int idx = 0; idx < sizeArray; idx++)
+                prefixSums[idx] = particles[idx].getWeight();
+            FP weightSum = inclusivePrefixSum(prefixSums);
+
+            std::vector<int> counts = systematicCounts(prefixSums, m);
+            std::vector<char> isKept(sizeArray);
+#pragma omp parallel for
+            for (int idx = 0; idx < sizeArray; idx++)
+            {
+                isKept[idx] = counts[idx] > 0;
+                if (isKept[idx])
+                {
+                    FP newCoeff = static_cast<FP>(counts[idx]) / static_cast<FP>(m);
+                    particles[idx].setWeight(newCoeff * weightSum);
+                }
+            }
+            particles.compact(keptIndices(isKept));
+        }
+
+        // Parallel version of energyConservative, sampling as in numberConservativeParallel
+        void energyConservativeParallel(ParticleArray& particles, int m)
+        {
+            const int sizeArray = particles.size();
+            std::vector<FP> energys(sizeArray), prefixSums(sizeArray);
+            const FP c = Constants<FP>::lightVelocity();
+#pragma omp parallel for
+            for (int idx = 0; idx < sizeArray; idx++)
+            {
+                FP mc = particles[idx].getMass() * c;
+                energys[idx] = sqrt(mc * mc + particles[idx].getMomentum().norm2());
+                prefixSums[idx] = particles[idx].getWeight() * energys[idx];
+            }
+            FP energySum = inclusivePrefixSum(prefixSums);
+
+            std::vector<int> counts = systematicCounts(prefixSums, m);
+            std::vector<char> isKept(sizeArray);
+#pragma omp parallel for
+            for (int idx = 0; idx < sizeArray; idx++)
+            {
+                isKept[idx] = counts[idx] > 0;
+                if (isKept[idx])
+                {
+                    FP newCoeff = static_cast<FP>(counts[idx]) / static_cast<FP>(m);
+                    particles[idx].setWeight(newCoeff * energySum / energys[idx]);
+                }
+            }
+            particles.compact(keptIndices(isKept));
+        }
+
         enum Features
         {
             Energy,
@@ -166,222 +267,58 @@ namespace pfc
 
         void thinningConservative(ParticleArray& particles, int m, std::set<Features>& features)
         {
-            auto searchM = features.find(Momentum);
-            auto searchP = features.find(Position);
-            auto searchDM = features.find(Dispersion_Momentum);
-            auto searchDP = features.find(Dispersion_Position);
-            if (searchM != features.end()) {
-                features.erase(Momentum);
-                features.insert(Momentum_x);
-                features.insert(Momentum_y);
-                features.insert(Momentum_z);
-            }
-            if (searchP != features.end()) {
-                features.erase(Position);
-                features.insert(Position_x);
-                features.insert(Position_y);
-                features.insert(Position_z);
-            }
-            if (searchDM != features.end()) {
-                features.erase(Dispersion_Momentum);
-                features.insert(Dispersion_Momentum_x);
-                features.insert(Dispersion_Momentum_y);
-                features.insert(Dispersion_Momentum_z);
-            }
-            if (searchDP != features.end()) {
-                features.erase(Dispersion_Position);
-                features.insert(Dispersion_Position_x);
-                features.insert(Dispersion_Position_y);
-                features.insert(Dispersion_Position_z);
-            }
+            expandFeatures(features);
+            const int sizeArray = particles.size();
 
-            std::vector<double> weight;
-            std::vector< vector<double> > components;
-            std::vector<Particle3d> partParticleArray;
-            weight.resize(features.size() + 2);
-            partParticleArray.resize(features.size() + 2);
-            components.resize(features.size() + 1);
-            for (int indComp = 0; indComp < features.size(); indComp++)
+            std::vector<int> indices(sizeArray);
+            std::vector<FP> weights(sizeArray);
+            for (int idx = 0; idx < sizeArray; idx++)
             {
-                components[indComp].resize(features.size() + 2);
+                indices[idx] = idx;
+                weights[idx] = particles[idx].getWeight();
             }
-            vector<double> unit(features.size() + 2, 1);
-            components[components.size() - 1] = unit;
 
-            double c = Constants<FP>::lightVelocity();
+            int reqDel = sizeArray * (1.0 - (FP)m / (FP)sizeArray);
+            thinningConservativeGroup(particles, indices, reqDel, features, weights, generator);
+            applyWeights(particles, weights);
+        }
 
-            struct particleCompare
+        /* Conservative thinning done independently in each spatial cell of the given grid,
+        every cell is thinned by the same fraction m / particles.size(). Cells are processed
+        in parallel with per-thread generators. */
+        void thinningConservativeInCells(ParticleArray& particles, int m, std::set<Features>& features,
+            const FP3& minCoords, const FP3& cellSize, const Int3& numCells)
+        {
+            expandFeatures(features);
+            const int sizeArray = particles.size();
+            const int numSpatialCells = numCells.volume();
+
+            std::vector<FP> weights(sizeArray);
+            std::vector<int> cellIndex(sizeArray);
+#pragma omp parallel for
+            for (int idx = 0; idx < sizeArray; idx++)
             {
-                bool operator()(const Particle3d& lhs, const Particle3d& rhs)
-                {
-                    return lhs.getWeight() > rhs.getWeight();
-                }
-            };
-            typedef std::priority_queue<Particle3d, vector<Particle3d>, particleCompare> queueParticle;
-            queueParticle particles_arrays;
-
-
-            FP mean_energy = (FP)0.0;
-            FP3 mean_position = FP3(0.0, 0.0, 0.0);
-            FP3  mean_momentum = FP3(0.0, 0.0, 0.0);
-
-            for (int particleIdx = 0; particleIdx < particles.size(); particleIdx++) {
-
-                particles_arrays.push(particles[particleIdx]);
-
-                mean_energy += particles[particleIdx].getWeight() * sqrt(c * c *
-                    particles[particleIdx].getMass() * particles[particleIdx].getMass()
-                    + particles[particleIdx].getMomentum().norm2());
-                mean_position += particles[particleIdx].getWeight() * particles[particleIdx].getPosition();
-                mean_momentum += particles[particleIdx].getWeight() * particles[particleIdx].getMomentum();
-
-                particles.deleteParticle(particleIdx);
-                particleIdx--;
+                weights[idx] = particles[idx].getWeight();
+                cellIndex[idx] = Merging<ParticleArray>::getCellIndex(particles[idx].getPosition(),
+                    minCoords, cellSize, numCells);
             }
-            mean_energy /= (FP)particles_arrays.size();
-            mean_position /= (FP)particles_arrays.size();
-            mean_momentum /= (FP)particles_arrays.size();
 
-            int reqDel = particles_arrays.size() * (1.0 - (FP)m / (FP)particles_arrays.size());
-            int delParticles = 0;
-            while ((particles_arrays.size() >= partParticleArray.size()) &&
-                (delParticles < reqDel))
-            {
-                double mass = particles_arrays.top().getMass();
-                double mc2 = mass * c * mass * c;
-                for (int indexPart = 0; indexPart < partParticleArray.size(); indexPart++)
-                {
-                    partParticleArray[indexPart] = particles_arrays.top();
-                    particles_arrays.pop();
-                    weight[indexPart] = partParticleArray[indexPart].getWeight();
-                    int indexFeat = 0;
-                    for (auto it = features.begin(); it != features.end();
-                        ++it, indexFeat++)
-                    {
-                        switch (*it)
-                        {
-                        case Energy:
-                            components[indexFeat][indexPart] = sqrt(mc2 + partParticleArray[indexPart].getMomentum().norm2());
-                            break;
-                        case Momentum_x:
-                            components[indexFeat][indexPart] = partParticleArray[indexPart].getMomentum().x;
-                            break;
-                        case Momentum_y:
-                            components[indexFeat][indexPart] = partParticleArray[indexPart].getMomentum().y;
-                            break;
-                        case Momentum_z:
-                            components[indexFeat][indexPart] = partParticleArray[indexPart].getMomentum().z;
-                            break;
-                        case Position_x:
-                            components[indexFeat][indexPart] = partParticleArray[indexPart].getPosition().x;
-                            break;
-                        case Position_y:
-                            components[indexFeat][indexPart] = partParticleArray[indexPart].getPosition().y;
-                            break;
-                        case Position_z:
-                            components[indexFeat][indexPart] = partParticleArray[indexPart].getPosition().z;
-                            break;
-
-                        case Dispersion_Energy:
-                            components[indexFeat][indexPart] =
-                                sqr(sqrt(mc2 + partParticleArray[indexPart].getMomentum().norm2()) - mean_energy);
-                            break;
-                        case Dispersion_Momentum_x:
-                            components[indexFeat][indexPart] =
-                                sqr(partParticleArray[indexPart].getMomentum().x - mean_momentum.x);
-                            break;
-                        case Dispersion_Momentum_y:
-                            components[indexFeat][indexPart] =
-                                sqr(partParticleArray[indexPart].getMomentum().y - mean_momentum.y);
-                            break;
-                        case Dispersion_Momentum_z:
-                            components[indexFeat][indexPart] =
-                                sqr(partParticleArray[indexPart].getMomentum().z - mean_momentum.z);
-                            break;
-                        case Dispersion_Position_x:
-                            components[indexFeat][indexPart] =
-                                sqr(partParticleArray[indexPart].getPosition().x - mean_position.x);
-                            break;
-                        case Dispersion_Position_y:
-                            components[indexFeat][indexPart] =
-                                sqr(partParticleArray[indexPart].getPosition().y - mean_position.y);
-                            break;
-                        case Dispersion_Position_z:
-                            components[indexFeat][indexPart] =
-                                sqr(partParticleArray[indexPart].getPosition().z - mean_position.z);
-                            break;
-                        }
-                    }
-                }
-                //checked system
-                std::vector<double> weight1;
-                std::vector< vector<double> > components1;
-                for (int indComp = 0; indComp < components.size() - 1; indComp++)
-                {
-                    double max_elem = std::abs(components[indComp][0]);
-                    double min_elem = std::abs(components[indComp][0]);
-                    for (int indexPart = 1; indexPart < partParticleArray.size(); indexPart++)
-                    {
-                        if (max_elem < std::abs(components[indComp][indexPart]))
-                            max_elem = std::abs(components[indComp][indexPart]);
-                        else if (min_elem > std::abs(components[indComp][indexPart]))
-                            min_elem = std::abs(components[indComp][indexPart]);
-
-                    }
-                    if (min_elem != max_elem)
-                    {
-                        for (int indexPart = 0; indexPart < partParticleArray.size(); indexPart++)
-                            components[indComp][indexPart] /= max_elem;
-                        components1.push_back(components[indComp]);
-                    }
-
-                }
-
-                components1.push_back(components[components.size() - 1]); //unit
-
-                for (int indPart = 0; indPart <= components1.size(); indPart++)
-                {
-                    weight1.push_back(weight[indPart]);
-                }
-
-
-                int isNoThin = thinningConservative_reweighing(weight1, components1);
-                if (isNoThin == 0)
-                {
-                    for (int indexPart = 0; indexPart < partParticleArray.size(); indexPart++)
-                    {
-                        if (indexPart < weight1.size())
-                        {
-                            if (weight1[indexPart] != 0.0)
-                            {
-                                partParticleArray[indexPart].setWeight(weight1[indexPart]);
-                                particles_arrays.push(partParticleArray[indexPart]);
-                            }
-                        }
-                        else
-                        {
-                            partParticleArray[indexPart].setWeight(weight[indexPart]);
-                            particles_arrays.push(partParticleArray[indexPart]);
-                        }
-                    }
-                    delParticles++;
-                }
-                else
-                {
-                    int indexPart;
-                    for (indexPart = 0; indexPart < partParticleArray.size() - 1; indexPart++)
-                    {
-                        particles_arrays.push(partParticleArray[indexPart]);
-                    }
-                    particles.pushBack(partParticleArray[indexPart]);
-                }
-            }
+            std::vector<std::vector<int>> cells(numSpatialCells);
+            for (int idx = 0; idx < sizeArray; idx++)
+                cells[cellIndex[idx]].push_back(idx);
 
-            while (particles_arrays.size())
+            const FP delFraction = 1.0 - (FP)m / (FP)sizeArray;
+            std::vector<std::mt19937> generators = threadGenerators();
+#pragma omp parallel for schedule(dynamic, 16)
+            for (int cell = 0; cell < numSpatialCells; cell++)
             {
-                particles.pushBack(particles_arrays.top());
-                particles_arrays.pop();
+                if (cells[cell].empty())
+                    continue;
+                int reqDel = cells[cell].size() * delFraction;
+                thinningConservativeGroup(particles, cells[cell], reqDel, features, weights,
+                    generators[getThreadId()]);
             }
+            applyWeights(particles, weights);
         }
 
         inline double dot(vector<double> v1, vector<double> v2)
@@ -405,6 +342,12 @@ namespace pfc
         }
 
         inline int thinningConservative_reweighing(vector<double>& weight, vector< vector<double> >& components)
+        {
+            return thinningConservative_reweighing(weight, components, generator);
+        }
+
+        inline int thinningConservative_reweighing(vector<double>& weight, vector< vector<double> >& components,
+            std::mt19937& randomGenerator)
         {
             std::uniform_real_distribution<FP> dist(0, 1.0);
          
@@ -478,7 +421,7 @@ namespace pfc
             }
             if (fp && fn)
             {
-                if (dist(generator) < ap / (ap - an))
+                if (dist(randomGenerator) < ap / (ap - an))
                 {
                     weight = sum(weight, mult(an, r));
                     weight[in] = 0;
@@ -493,5 +436,283 @@ namespace pfc
             else
                 return -3;
         }
+
+    private:
+
+        static void expandFeatures(std::set<Features>& features)
+        {
+            auto searchM = features.find(Momentum);
+            auto searchP = features.find(Position);
+            auto searchDM = features.find(Dispersion_Momentum);
+            auto searchDP = features.find(Dispersion_Position);
+            if (searchM != features.end()) {
+                features.erase(Momentum);
+                features.insert(Momentum_x);
+                features.insert(Momentum_y);
+                features.insert(Momentum_z);
+            }
+            if (searchP != features.end()) {
+                features.erase(Position);
+                features.insert(Position_x);
+                features.insert(Position_y);
+                features.insert(Position_z);
+            }
+            if (searchDM != features.end()) {
+                features.erase(Dispersion_Momentum);
+                features.insert(Dispersion_Momentum_x);
+                features.insert(Dispersion_Momentum_y);
+                features.insert(Dispersion_Momentum_z);
+            }
+            if (searchDP != features.end()) {
+                features.erase(Dispersion_Position);
+                features.insert(Dispersion_Position_x);
+                features.insert(Dispersion_Position_y);
+                features.insert(Dispersion_Position_z);
+            }
+        }
+
+        /* Conservative thinning of the particles with given indices. Particles are not copied:
+        a min-heap of (weight, index) pairs selects the lightest features.size() + 2 particles,
+        the system for the new weights is solved and the weights are written back to weights.
+        Removed particles get zero weight, the array is compacted by applyWeights. */
+        void thinningConservativeGroup(ParticleArray& particles, const std::vector<int>& indices, int reqDel,
+            const std::set<Features>& features, std::vector<FP>& weights, std::mt19937& randomGenerator)
+        {
+            const int numFeatures = (int)features.size();
+            const int batchSize = numFeatures + 2;
+            std::vector<double> weight(batchSize);
+            std::vector<int> batch(batchSize);
+            std::vector< vector<double> > components(numFeatures + 1);
+            for (int indComp = 0; indComp < numFeatures; indComp++)
+                components[indComp].resize(batchSize);
+            components[components.size() - 1] = vector<double>(batchSize, 1);
+
+            double c = Constants<FP>::lightVelocity();
+
+            typedef std::pair<FP, int> WeightIndex;
+            std::priority_queue<WeightIndex, vector<WeightIndex>, std::greater<WeightIndex>> heap;
+
+            FP mean_energy = (FP)0.0;
+            FP3 mean_position = FP3(0.0, 0.0, 0.0);
+            FP3  mean_momentum = FP3(0.0, 0.0, 0.0);
+            const int numIndices = (int)indices.size();
+            for (int i = 0; i < numIndices; i++) {
+                const int idx = indices[i];
+                heap.push(WeightIndex(weights[idx], idx));
+                mean_energy += weights[idx] * sqrt(c * c * particles[idx].getMass() * particles[idx].getMass()
+                    + particles[idx].getMomentum().norm2());
+                mean_position += weights[idx] * particles[idx].getPosition();
+                mean_momentum += weights[idx] * particles[idx].getMomentum();
+            }
+            mean_energy /= (FP)numIndices;
+            mean_position /= (FP)numIndices;
+            mean_momentum /= (FP)numIndices;
+
+            int delParticles = 0;
+            while (((int)heap.size() >= batchSize) && (delParticles < reqDel))
+            {
+                double mass = particles[heap.top().second].getMass();
+                double mc2 = mass * c * mass * c;
+                for (int indexPart = 0; indexPart < batchSize; indexPart++)
+                {
+                    batch[indexPart] = heap.top().second;
+                    heap.pop();
+                    weight[indexPart] = weights[batch[indexPart]];
+                    const FP3 momentum = particles[batch[indexPart]].getMomentum();
+                    const FP3 position = particles[batch[indexPart]].getPosition();
+                    int indexFeat = 0;
+                    for (auto it = features.begin(); it != features.end(); ++it, indexFeat++)
+                        components[indexFeat][indexPart] = featureValue(*it, momentum, position, mc2,
+                            mean_energy, mean_momentum, mean_position);
+                }
+                //checked system
+                std::vector<double> weight1;
+                std::vector< vector<double> > components1;
+                for (int indComp = 0; indComp < numFeatures; indComp++)
+                {
+                    double max_elem = std::abs(components[indComp][0]);
+                    double min_elem = std::abs(components[indComp][0]);
+                    for (int indexPart = 1; indexPart < batchSize; indexPart++)
+                    {
+                        if (max_elem < std::abs(components[indComp][indexPart]))
+                            max_elem = std::abs(components[indComp][indexPart]);
+                        else if (min_elem > std::abs(components[indComp][indexPart]))
+                            min_elem = std::abs(components[indComp][indexPart]);
+                    }
+                    if (min_elem != max_elem)
+                    {
+                        for (int indexPart = 0; indexPart < batchSize; indexPart++)
+                            components[indComp][indexPart] /= max_elem;
+                        components1.push_back(components[indComp]);
+                    }
+                }
+                components1.push_back(components[components.size() - 1]); //unit
+
+                const int numComponents = (int)components1.size();
+                for (int indPart = 0; indPart <= numComponents; indPart++)
+                    weight1.push_back(weight[indPart]);
+                const int numWeights = numComponents + 1;
+
+                int isNoThin = thinningConservative_reweighing(weight1, components1, randomGenerator);
+                if (isNoThin == 0)
+                {
+                    for (int indexPart = 0; indexPart < numWeights; indexPart++)
+                    {
+                        weights[batch[indexPart]] = weight1[indexPart];
+                        if (weight1[indexPart] != 0.0)
+                            heap.push(WeightIndex(weight1[indexPart], batch[indexPart]));
+                    }
+                    for (int indexPart = numWeights; indexPart < batchSize; indexPart++)
+                        heap.push(WeightIndex(weight[indexPart], batch[indexPart]));
+                    delParticles++;
+                }
+                else
+                {
+                    // the heaviest particle of the batch is kept as is and leaves the heap
+                    for (int indexPart = 0; indexPart < batchSize - 1; indexPart++)
+                        heap.push(WeightIndex(weight[indexPart], batch[indexPart]));
+                }
+            }
+        }
+
+        static double featureValue(Features feature, const FP3& momentum, const FP3& position, double mc2,
+            FP mean_energy, const FP3& mean_momentum, const FP3& mean_position)
+        {
+            switch (feature)
+            {
+            case Energy:
+                return sqrt(mc2 + momentum.norm2());
+            case Momentum_x:
+                return momentum.x;
+            case Momentum_y:
+                return momentum.y;
+            case Momentum_z:
+                return momentum.z;
+            case Position_x:
+                return position.x;
+            case Position_y:
+                return position.y;
+            case Position_z:
+                return position.z;
+            case Dispersion_Energy:
+                return sqr(sqrt(mc2 + momentum.norm2()) - mean_energy);
+            case Dispersion_Momentum_x:
+                return sqr(momentum.x - mean_momentum.x);
+            case Dispersion_Momentum_y:
+                return sqr(momentum.y - mean_momentum.y);
+            case Dispersion_Momentum_z:
+                return sqr(momentum.z - mean_momentum.z);
+            case Dispersion_Position_x:
+                return sqr(position.x - mean_position.x);
+            case Dispersion_Position_y:
+                return sqr(position.y - mean_position.y);
+            case Dispersion_Position_z:
+                return sqr(position.z - mean_position.z);
+            default:
+                return 0;
+            }
+        }
+
+        // Writes new weights, particles with zero weight are removed in one compaction pass
+        static void applyWeights(ParticleArray& particles, const std::vector<FP>& weights)
+        {
+            const int sizeArray = particles.size();
+            std::vector<char> isKept(sizeArray);
+#pragma omp parallel for
+            for (int idx = 0; idx < sizeArray; idx++)
+            {
+                isKept[idx] = weights[idx] != 0.0;
+                if (isKept[idx])
+                    particles[idx].setWeight(weights[idx]);
+            }
+            particles.compact(keptIndices(isKept));
+        }
+
+        static int getThreadId()
+        {
+#ifdef __USE_OMP__
+            return omp_get_thread_num();
+#else
+            return 0;
+#endif
+        }
+
+        // Independent generators for each thread, seeded from the main generator
+        std::vector<std::mt19937> threadGenerators()
+        {
+            std::vector<std::mt19937> generators;
+            for (int thread = 0; thread < OMP_GET_MAX_THREADS(); thread++)
+                generators.push_back(std::mt19937(generator()));
+            return generators;
+        }
+
+        // Two-pass parallel inclusive scan, returns the total sum
+        template<class T>
+        static T inclusivePrefixSum(std::vector<T>& values)
+        {
+            const int size = values.size();
+            std::vector<T> offsets(OMP_GET_MAX_THREADS() + 1, 0);
+#pragma omp parallel
+            {
+                int threadId = 0, numThreads = 1;
+#ifdef __USE_OMP__
+                threadId = omp_get_thread_num();
+                numThreads = omp_get_num_threads();
+#endif
+                const int begin = (int)((long long)size * threadId / numThreads);
+                const int end = (int)((long long)size * (threadId + 1) / numThreads);
+                T sum = 0;
+                for (int idx = begin; idx < end; idx++)
+                {
+                    sum += values[idx];
+                    values[idx] = sum;
+                }
+                offsets[threadId + 1] = sum;
+#pragma omp barrier
+#pragma omp single
+                for (int thread = 0; thread < numThreads; thread++)
+                    offsets[thread + 1] += offsets[thread];
+                for (int idx = begin; idx < end; idx++)
+                    values[idx] += offsets[threadId];
+            }
+            return size ? values[size - 1] : 0;
+        }
+
+        // Number of points (u + j) * total / m, j = 0..m-1, falling into each segment of the prefix sums
+        std::vector<int> systematicCounts(const std::vector<FP>& prefixSums, int m)
+        {
+            const int size = prefixSums.size();
+            std::vector<int> counts(size, 0);
+            if (size == 0)
+                return counts;
+            const FP total = prefixSums[size - 1];
+            const FP shift = std::uniform_real_distribution<FP>(0, 1)(generator);
+            auto pointsBelow = [&](FP x) {
+                FP value = std::ceil(x * m / total - shift);
+                return (int)std::min(std::max(value, (FP)0), (FP)m);
+            };
+#pragma omp parallel for
+            for (int idx = 0; idx < size; idx++)
+                counts[idx] = (idx + 1 == size ? m : pointsBelow(prefixSums[idx])) -
+                    (idx == 0 ? 0 : pointsBelow(prefixSums[idx - 1]));
+            return counts;
+        }
+
+        // Ascending indices of kept particles, parallel stream compaction of flags
+        static std::vector<int> keptIndices(const std::vector<char>& isKept)
+        {
+            const int size = isKept.size();
+            std::vector<int> positions(size);
+#pragma omp parallel for
+            for (int idx = 0; idx < size; idx++)
+                positions[idx] = isKept[idx];
+            const int numKept = inclusivePrefixSum(positions);
+            std::vector<int> indices(numKept);
+#pragma omp parallel for
+            for (int idx = 0; idx < size; idx++)
+                if (isKept[idx])
+                    indices[positions[idx] - 1] = idx;
+            return indices;
+        }
     };
 }
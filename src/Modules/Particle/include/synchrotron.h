@@ -121,7 +121,7 @@ static double synchrotron2a_coef[13] = {
     -6.94238421837777902
 }; //6e-15
 
-double synchrotron_1(const double x)
+inline double synchrotron_1(const double x)
 {
     if (x < 0.0) {
         return 0.0;
@@ -150,7 +150,7 @@ double synchrotron_1(const double x)
         return 0.0;
     }
 }
-double synchrotron_2(const double x)
+inline double synchrotron_2(const double x)
 {
     if (x < 0.0) {
         return 0.0;
@@ -8,6 +8,9 @@
 #include "FieldValue.h"
 #include "Vectors.h"
 #include "VectorsProxy.h"
+#include "Ensemble.h"
+#include "AnalyticalField.h"
+#include "QED_AEG.h"
 
 #include "benchmark/benchmark.h"
 
@@ -75,7 +78,8 @@ public:
 
         ParticleInfo::typesVector = { { constants::electronMass, constants::electronCharge },
         { constants::electronMass, -constants::electronCharge },
-        { constants::protonMass, -constants::electronCharge } };
+        { constants::protonMass, -constants::electronCharge },
+        { constants::electronMass, 0.0 } };
         ParticleInfo::types = &ParticleInfo::typesVector[0];
         ParticleInfo::numTypes = sizeParticleTypes;
     }
@@ -175,4 +179,46 @@ public:
 
     std::vector<ValueField> fields;
     FP dt;
-};
\ No newline at end of file
+};
+
+template <class ParticleArrayType, class PusherType>
+class QEDTest : public BaseParticleFixture<typename ParticleArrayType::ParticleType> {
+public:
+    typedef ParticleArrayType ParticleArray;
+    typedef typename ParticleArrayType::ParticleType Particle;
+    typedef ScalarQED_AEG_only_electron<AnalyticalField, PusherType, ParticleArrayType> QEDType;
+
+    using BaseFixture::urand;
+    using BaseFixture::urandFP3;
+
+    // Electrons with gamma ~ 10^2..10^3 in a field of ~10^-3 of the Schwinger field,
+    // so that both single events and avalanches are triggered
+    virtual void SetUp(const ::benchmark::State& st)
+    {
+        BaseParticleFixture<Particle>::SetUp(st);
+        dt = 1e-17;
+        FP mc = constants::electronMass * constants::lightVelocity;
+        for (size_t index = 0; index < st.range_x(); index++) {
+            FP3 position = urandFP3(FP3(-1e-4, -1e-4, -1e-4), FP3(1e-4, 1e-4, 1e-4));
+            FP3 direction = urandFP3(FP3(-1, -1, -1), FP3(1, 1, 1));
+            direction.normalize();
+            FP3 momentum = urand(1e2, 1e3) * mc * direction;
+            particles.addParticle(Particle(position, momentum, 1, Electron));
+        }
+        field.setE(fieldValue, zeroValue, zeroValue);
+        field.setB(zeroValue, zeroValue, fieldValue);
+    }
+
+    virtual void TearDown(const ::benchmark::State&)
+    {
+        particles.clear();
+    }
+
+    static FP fieldValue(FP x, FP y, FP z, FP t) { return 1e11; }
+    static FP zeroValue(FP x, FP y, FP z, FP t) { return 0.0; }
+
+    Ensemble<ParticleArray> particles;
+    AnalyticalField field;
+    QEDType qed;
+    FP dt;
+};
@@ -0,0 +1,59 @@
+#include "TestingUtility.h"
+
+#include "PsatdTimeStaggered.h"
+
+#include <memory>
+
+#ifdef __USE_FFT__
+
+// grid size, PML size, reduced-memory mode
+static void PsatdArguments(benchmark::internal::Benchmark* b) {
+    b->Args({ 128, 16, 0 });
+    b->Args({ 128, 16, 1 });
+}
+
+// PSATD with PML in all directions, the memory of the solver and of PML is reported in MB
+class PsatdFixture : public BaseFixture {
+public:
+
+    virtual void SetUp(const ::benchmark::State& st)
+    {
+        BaseFixture::SetUp(st);
+        const Int3 numCells(st.range_x(), st.range_x(), st.range_x());
+        const FP3 steps(constants::c, constants::c, constants::c);
+        grid.reset(new PSATDTimeStaggeredGrid(numCells, FP3(0, 0, 0), steps, numCells));
+        for (int i = 0; i < numCells.x; i++)
+            for (int j = 0; j < numCells.y; j++)
+                for (int k = 0; k < numCells.z; k++) {
+                    grid->Ey(i, j, k) = urand(-1.0, 1.0);
+                    grid->Bz(i, j, k) = urand(-1.0, 1.0);
+                }
+        solver.reset(new PSATDTimeStaggered(grid.get(),
+            0.5 * PSATDTimeStaggered::getCourantConditionTimeStep(steps)));
+        solver->setPML(st.range_y(), st.range_y(), st.range_y());
+        solver->setReducedMemoryMode(st.range(2) != 0);
+        MemoryRegistry::instance().resetPeaks();
+    }
+
+    virtual void TearDown(const ::benchmark::State& st)
+    {
+        solver.reset();
+        grid.reset();
+    }
+
+    std::unique_ptr<PSATDTimeStaggeredGrid> grid;
+    std::unique_ptr<PSATDTimeStaggered> solver;
+};
+
+BENCHMARK_DEFINE_F(PsatdFixture, updateFieldsWithPml)(benchmark::State& state) {
+    while (state.KeepRunning())
+        solver->updateFields();
+    MemoryRegistry& registry = MemoryRegistry::instance();
+    const FP megabyte = 1024.0 * 1024.0;
+    state.counters["solver_MB"] = registry.getStats(MemoryCategory::FieldSolver).allocatedBytes / megabyte;
+    state.counters["pml_MB"] = registry.getStats(MemoryCategory::Pml).allocatedBytes / megabyte;
+    state.counters["peak_MB"] = registry.getTotalStats().peakAllocatedBytes / megabyte;
+}
+BENCHMARK_REGISTER_F(PsatdFixture, updateFieldsWithPml)->Apply(PsatdArguments)->Unit(benchmark::kMillisecond);
+
+#endif
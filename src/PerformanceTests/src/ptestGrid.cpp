@@ -0,0 +1,147 @@
+#include "TestingUtility.h"
+
+#include "Grid.h"
+#include "ParticleArray.h"
+
+#include <memory>
+#include <vector>
+
+static void GatherArguments(benchmark::internal::Benchmark* b) {
+    b->Args({ 64, 1000000 });
+}
+
+// gather of E and B in random points with CIC interpolation,
+// the grid is large enough not to fit in the cache
+template <class TGrid>
+class GatherFixture : public BaseFixture {
+public:
+
+    virtual void SetUp(const ::benchmark::State& st)
+    {
+        BaseFixture::SetUp(st);
+        const Int3 numCells(st.range_x(), st.range_x(), st.range_x());
+        const FP3 minCoords(0.0, 0.0, 0.0), steps(1.0, 1.0, 1.0);
+        grid.reset(new TGrid(numCells, minCoords, steps, numCells));
+        for (int i = 0; i < grid->numCells.x; i++)
+            for (int j = 0; j < grid->numCells.y; j++)
+                for (int k = 0; k < grid->numCells.z; k++) {
+                    grid->Ex(i, j, k) = urand(-1.0, 1.0);
+                    grid->Ey(i, j, k) = urand(-1.0, 1.0);
+                    grid->Ez(i, j, k) = urand(-1.0, 1.0);
+                    grid->Bx(i, j, k) = urand(-1.0, 1.0);
+                    grid->By(i, j, k) = urand(-1.0, 1.0);
+                    grid->Bz(i, j, k) = urand(-1.0, 1.0);
+                }
+        points.resize(st.range_y());
+        for (int i = 0; i < (int)points.size(); i++)
+            points[i] = urandFP3(minCoords + steps, minCoords + (FP3)(numCells - Int3(2, 2, 2)) * steps);
+    }
+
+    virtual void TearDown(const ::benchmark::State& st)
+    {
+        grid.reset();
+        points.clear();
+    }
+
+    void gather(benchmark::State& state) {
+        while (state.KeepRunning()) {
+            FP3 sum;
+            for (int i = 0; i < (int)points.size(); i++) {
+                FP3 e, b;
+                grid->getFields(points[i], e, b);
+                sum += e + b;
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * points.size());
+    }
+
+    // the same gather with the interpolation as a compile-time policy
+    template <InterpolationType type>
+    void gatherPolicy(benchmark::State& state) {
+        while (state.KeepRunning()) {
+            FP3 sum;
+            for (int i = 0; i < (int)points.size(); i++) {
+                FP3 e, b;
+                grid->template getFields<type>(points[i], e, b);
+                sum += e + b;
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * points.size());
+    }
+
+    // the same gather at particles with cell-relative positions and float offsets,
+    // serial as the gathers above
+    void gatherCellPositions(benchmark::State& state) {
+        typedef ParticleArray<Three, ParticleRepresentation_CellSoA, float>::Type CellParticleArray;
+        typedef CellParticleArray::ParticleType Particle;
+        CellParticleArray particles(Electron, grid->getCellGeometry());
+        Particle particle;
+        for (int i = 0; i < (int)points.size(); i++) {
+            particle.setPosition(points[i]);
+            particles.pushBack(particle);
+        }
+        while (state.KeepRunning()) {
+            FP3 sum;
+            for (int i = 0; i < particles.size(); i++) {
+                FP3 e, b;
+                grid->getFields(particles.getCellPosition(i), e, b);
+                sum += e + b;
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * points.size());
+    }
+
+    std::unique_ptr<TGrid> grid;
+    std::vector<FP3> points;
+};
+
+BENCHMARK_TEMPLATE_DEFINE_F(GatherFixture, yeeGridSeparate, YeeGrid)(benchmark::State& state) {
+    gather(state);
+}
+BENCHMARK_REGISTER_F(GatherFixture, yeeGridSeparate)->Apply(GatherArguments)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE_DEFINE_F(GatherFixture, yeeGridInterleaved, YeeGrid)(benchmark::State& state) {
+    grid->setInterleavedFields(true);
+    gather(state);
+}
+BENCHMARK_REGISTER_F(GatherFixture, yeeGridInterleaved)->Apply(GatherArguments)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE_DEFINE_F(GatherFixture, simpleGridSeparate, SimpleGrid)(benchmark::State& state) {
+    gather(state);
+}
+BENCHMARK_REGISTER_F(GatherFixture, simpleGridSeparate)->Apply(GatherArguments)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE_DEFINE_F(GatherFixture, simpleGridInterleaved, SimpleGrid)(benchmark::State& state) {
+    grid->setInterleavedFields(true);
+    gather(state);
+}
+BENCHMARK_REGISTER_F(GatherFixture, simpleGridInterleaved)->Apply(GatherArguments)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE_DEFINE_F(GatherFixture, yeeGridTSCDispatch, YeeGrid)(benchmark::State& state) {
+    grid->setInterpolationType(InterpolationType::Interpolation_TSC);
+    gather(state);
+}
+BENCHMARK_REGISTER_F(GatherFixture, yeeGridTSCDispatch)->Apply(GatherArguments)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE_DEFINE_F(GatherFixture, yeeGridTSCPolicy, YeeGrid)(benchmark::State& state) {
+    gatherPolicy<InterpolationType::Interpolation_TSC>(state);
+}
+BENCHMARK_REGISTER_F(GatherFixture, yeeGridTSCPolicy)->Apply(GatherArguments)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE_DEFINE_F(GatherFixture, simpleGridTSCPolicy, SimpleGrid)(benchmark::State& state) {
+    gatherPolicy<InterpolationType::Interpolation_TSC>(state);
+}
+BENCHMARK_REGISTER_F(GatherFixture, simpleGridTSCPolicy)->Apply(GatherArguments)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE_DEFINE_F(GatherFixture, yeeGridCellPositions, YeeGrid)(benchmark::State& state) {
+    gatherCellPositions(state);
+}
+BENCHMARK_REGISTER_F(GatherFixture, yeeGridCellPositions)->Apply(GatherArguments)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE_DEFINE_F(GatherFixture, simpleGridCellPositions, SimpleGrid)(benchmark::State& state) {
+    gatherCellPositions(state);
+}
+BENCHMARK_REGISTER_F(GatherFixture, simpleGridCellPositions)->Apply(GatherArguments)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,129 @@
+#include "TestingUtility.h"
+
+#include "Mapping.h"
+#include "CompiledMapping.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+static void MappingArguments(benchmark::internal::Benchmark* b) {
+    b->Args({ 1000000 });
+}
+
+// batches are processed by chunks as in the mapped field evaluators
+static const int chunkSize = 256;
+
+class MappingFixture : public BaseFixture {
+public:
+
+    virtual void SetUp(const ::benchmark::State& st)
+    {
+        BaseFixture::SetUp(st);
+        mappings.clear();
+        mappings.push_back(std::make_shared<ShiftMapping>(FP3(1.5, -2.0, 0.5)));
+        mappings.push_back(std::make_shared<RotationMapping>(CoordinateEnum::z, 0.3));
+        mappings.push_back(std::make_shared<ScaleMapping>(CoordinateEnum::x, 2.0));
+        mappings.push_back(std::make_shared<RotationMapping>(CoordinateEnum::x, -1.1));
+        mappings.push_back(std::make_shared<ShiftMapping>(FP3(0.0, 3.0, -1.0)));
+        mappings.push_back(std::make_shared<PeriodicalMapping>(CoordinateEnum::x, -4.0, 4.0));
+        compiledMapping = CompiledMapping();
+        for (int i = 0; i < (int)mappings.size(); i++)
+            compiledMapping.append(mappings[i]);
+
+        points.resize(st.range_x());
+        for (int i = 0; i < (int)points.size(); i++)
+            points[i] = urandFP3(FP3(-10.0, -10.0, -10.0), FP3(10.0, 10.0, 10.0));
+    }
+
+    std::vector<std::shared_ptr<Mapping>> mappings;
+    CompiledMapping compiledMapping;
+    std::vector<FP3> points;
+};
+
+BENCHMARK_DEFINE_F(MappingFixture, mappingChain)(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        FP3 sum;
+        for (int i = 0; i < (int)points.size(); i++) {
+            FP3 coords = points[i];
+            bool status = true;
+            for (int m = 0; m < (int)mappings.size(); m++) {
+                bool stageStatus = true;
+                coords = mappings[m]->getInverseCoords(coords, 0.0, &stageStatus);
+                status = status && stageStatus;
+            }
+            if (status) sum += coords;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK_REGISTER_F(MappingFixture, mappingChain)->Apply(MappingArguments)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(MappingFixture, compiledMapping)(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        FP3 sum;
+        for (int i = 0; i < (int)points.size(); i++) {
+            bool status = true;
+            FP3 coords = compiledMapping.getInverseCoords(points[i], 0.0, &status);
+            if (status) sum += coords;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK_REGISTER_F(MappingFixture, compiledMapping)->Apply(MappingArguments)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(MappingFixture, compiledMappingBatch)(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        FP3 sum;
+        for (int begin = 0; begin < (int)points.size(); begin += chunkSize) {
+            const int length = std::min(chunkSize, (int)points.size() - begin);
+            FP3 coords[chunkSize];
+            bool status[chunkSize];
+            std::fill(status, status + length, true);
+            compiledMapping.getInverseCoordsBatch(points.data() + begin, coords, length, 0.0, status);
+            for (int i = 0; i < length; i++)
+                if (status[i]) sum += coords[i];
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK_REGISTER_F(MappingFixture, compiledMappingBatch)->Apply(MappingArguments)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(MappingFixture, tightFocusing)(benchmark::State& state) {
+    std::shared_ptr<Mapping> mapping = std::make_shared<TightFocusingMapping>(8.0, 4.0, 6.0);
+    FP time = 0.0;
+    while (state.KeepRunning()) {
+        FP3 sum;
+        for (int i = 0; i < (int)points.size(); i++) {
+            bool status = true;
+            FP3 coords = mapping->getDirectCoords(points[i], time, &status);
+            if (status) sum += coords;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK_REGISTER_F(MappingFixture, tightFocusing)->Apply(MappingArguments)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(MappingFixture, tightFocusingBatch)(benchmark::State& state) {
+    TightFocusingMapping mapping(8.0, 4.0, 6.0);
+    FP time = 0.0;
+    while (state.KeepRunning()) {
+        FP3 sum;
+        for (int begin = 0; begin < (int)points.size(); begin += chunkSize) {
+            const int length = std::min(chunkSize, (int)points.size() - begin);
+            FP3 coords[chunkSize];
+            bool status[chunkSize];
+            std::fill(status, status + length, true);
+            mapping.getDirectCoordsBatch(points.data() + begin, coords, length, time, status);
+            for (int i = 0; i < length; i++)
+                if (status[i]) sum += coords[i];
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK_REGISTER_F(MappingFixture, tightFocusingBatch)->Apply(MappingArguments)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,45 @@
+#include "TestingUtility.h"
+
+#include "ParticleArray.h"
+#include "Merging.h"
+
+static void KMeansArguments(benchmark::internal::Benchmark* b) {
+    b->Args({ 100000, 32 });
+    b->Iterations(1);
+}
+
+static void AcceleratedKMeansArguments(benchmark::internal::Benchmark* b) {
+    b->Args({ 100000, 32 });
+    b->Args({ 1000000, 100 });
+    b->Iterations(1);
+}
+
+using mergingAoS = ParticleArrayFixture<ParticleArrayAoS3d>;
+BENCHMARK_DEFINE_F(mergingAoS, kmeans)(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        Merging<ParticleArrayAoS3d>::merge_with_kmeans(*particles, state.range_y(), 30);
+    }
+}
+BENCHMARK_REGISTER_F(mergingAoS, kmeans)->Apply(KMeansArguments)->Unit(benchmark::kSecond);
+
+BENCHMARK_DEFINE_F(mergingAoS, acceleratedKmeans)(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        Merging<ParticleArrayAoS3d>::merge_with_accelerated_kmeans(*particles, state.range_y(), 30);
+    }
+}
+BENCHMARK_REGISTER_F(mergingAoS, acceleratedKmeans)->Apply(AcceleratedKMeansArguments)->Unit(benchmark::kSecond);
+
+using mergingSoA = ParticleArrayFixture<ParticleArray3d>;
+BENCHMARK_DEFINE_F(mergingSoA, kmeans)(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        Merging<ParticleArray3d>::merge_with_kmeans(*particles, state.range_y(), 30);
+    }
+}
+BENCHMARK_REGISTER_F(mergingSoA, kmeans)->Apply(KMeansArguments)->Unit(benchmark::kSecond);
+
+BENCHMARK_DEFINE_F(mergingSoA, acceleratedKmeans)(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        Merging<ParticleArray3d>::merge_with_accelerated_kmeans(*particles, state.range_y(), 30);
+    }
+}
+BENCHMARK_REGISTER_F(mergingSoA, acceleratedKmeans)->Apply(AcceleratedKMeansArguments)->Unit(benchmark::kSecond);
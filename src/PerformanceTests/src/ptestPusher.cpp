@@ -29,3 +29,13 @@ BENCHMARK_DEFINE_F(particleArraySoA, pusher)(benchmark::State& state) {
     }
 }
 BENCHMARK_REGISTER_F(particleArraySoA, pusher)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+using particleArraySoAFloat = PusherTest<ParticleArraySoA<Three, float>>;
+BENCHMARK_DEFINE_F(particleArraySoAFloat, pusher)(benchmark::State& state) {
+    BorisPusher pusher;
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++)
+            pusher(particles, fields, dt);
+    }
+}
+BENCHMARK_REGISTER_F(particleArraySoAFloat, pusher)->Apply(CustomArguments)->Unit(benchmark::kSecond);
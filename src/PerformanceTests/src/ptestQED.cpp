@@ -0,0 +1,46 @@
+#include "TestingUtility.h"
+
+#include "ParticleArray.h"
+#include "Pusher.h"
+#include "QED_AEG.h"
+
+static void CustomArguments(benchmark::internal::Benchmark* b) {
+    b->Args({ 100000, 10 });
+    b->Iterations(1);
+}
+
+using qedBorisAoS = QEDTest<ParticleArrayAoS3d, BorisPusher>;
+BENCHMARK_DEFINE_F(qedBorisAoS, processParticles)(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++)
+            qed.processParticles(&particles, &field, dt);
+    }
+}
+BENCHMARK_REGISTER_F(qedBorisAoS, processParticles)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+using qedBorisSoA = QEDTest<ParticleArray3d, BorisPusher>;
+BENCHMARK_DEFINE_F(qedBorisSoA, processParticles)(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++)
+            qed.processParticles(&particles, &field, dt);
+    }
+}
+BENCHMARK_REGISTER_F(qedBorisSoA, processParticles)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+using qedVayAoS = QEDTest<ParticleArrayAoS3d, VayPusher>;
+BENCHMARK_DEFINE_F(qedVayAoS, processParticles)(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++)
+            qed.processParticles(&particles, &field, dt);
+    }
+}
+BENCHMARK_REGISTER_F(qedVayAoS, processParticles)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+using qedVaySoA = QEDTest<ParticleArray3d, VayPusher>;
+BENCHMARK_DEFINE_F(qedVaySoA, processParticles)(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++)
+            qed.processParticles(&particles, &field, dt);
+    }
+}
+BENCHMARK_REGISTER_F(qedVaySoA, processParticles)->Apply(CustomArguments)->Unit(benchmark::kSecond);
@@ -251,7 +251,7 @@ public:
     {
         for (size_t idx = 0; idx < size; idx++)
         {
-            Particle newParticle = randomParticle(minPosition, maxPosition, type);
+            Particle newParticle = this->randomParticle(minPosition, maxPosition, type);
             particles.pushBack(newParticle);
         }
     }
@@ -266,6 +266,14 @@ public:
         return sumWeights;
     }
 
+    FP3 totalMomentum(ParticleArray& a) const
+    {
+        FP3 sumMomentum;
+        for (int idx = 0; idx < a.size(); idx++)
+            sumMomentum += a[idx].getMomentum() * a[idx].getWeight();
+        return sumMomentum;
+    }
+
     double totalEnergy(ParticleArray& a) const
     {
         FP sumEnergy = 0.0;
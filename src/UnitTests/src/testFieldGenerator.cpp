@@ -253,3 +253,75 @@ TYPED_TEST(FieldGeneratorTestOneBorderConstructor2, FieldGeneratorTestOneBorder)
 
     ASSERT_NEAR(finalAmp, 0, this->relatedAmpThreshold);
 }
+
+
+template <class TTypeDefinitionsFieldTest>
+class FieldGeneratorTestBatchFunctions : public FieldGeneratorTest<TTypeDefinitionsFieldTest> {
+public:
+
+    using FieldSolverType = typename FieldGeneratorTest<TTypeDefinitionsFieldTest>::FieldSolverType;
+    using GridType = typename FieldGeneratorTest<TTypeDefinitionsFieldTest>::GridType;
+    using BatchFunctionType = typename FieldGenerator<YeeGrid>::BatchFunctionType;
+
+    // the same generator set by scalar functions
+    std::unique_ptr<FieldSolverType> referenceFieldSolver;
+    std::unique_ptr<GridType> referenceGrid;
+
+    virtual void setFieldGenerator(
+        Int3 generatorStartIndex, Int3 generatorEndIndex,
+        std::function<FP(FP, FP, FP, FP)> bxFunc,
+        std::function<FP(FP, FP, FP, FP)> byFunc,
+        std::function<FP(FP, FP, FP, FP)> bzFunc,
+        std::function<FP(FP, FP, FP, FP)> exFunc,
+        std::function<FP(FP, FP, FP, FP)> eyFunc,
+        std::function<FP(FP, FP, FP, FP)> ezFunc
+        )
+    {
+        std::function<FP(FP, FP, FP, FP)> zero = field_generator::defaultFieldFunction;
+        this->fieldSolver->setFieldGenerator(generatorStartIndex, generatorEndIndex,
+            zero, zero, zero, zero, zero, zero);
+
+        std::function<FP(FP, FP, FP, FP)> bFuncs[3] = { bxFunc, byFunc, bzFunc };
+        std::function<FP(FP, FP, FP, FP)> eFuncs[3] = { exFunc, eyFunc, ezFunc };
+        for (int c = 0; c < 3; c++) {
+            this->fieldSolver->generator->setBatchFunction(FieldEnum::B, (CoordinateEnum)c,
+                toBatchFunction(bFuncs[c]));
+            this->fieldSolver->generator->setBatchFunction(FieldEnum::E, (CoordinateEnum)c,
+                toBatchFunction(eFuncs[c]));
+        }
+
+        referenceGrid.reset(new GridType(this->gridSize, this->minCoords, this->gridStep, this->gridSize));
+        referenceFieldSolver.reset(new FieldSolverType(referenceGrid.get(), this->timeStep));
+        referenceFieldSolver->setPeriodicalBoundaryConditions();
+        referenceFieldSolver->setFieldGenerator(generatorStartIndex, generatorEndIndex,
+            bxFunc, byFunc, bzFunc, exFunc, eyFunc, ezFunc);
+    }
+
+    static BatchFunctionType toBatchFunction(std::function<FP(FP, FP, FP, FP)> func) {
+        return [func](const FP* x, const FP* y, const FP* z, FP t, FP* result, int size) {
+            for (int i = 0; i < size; i++)
+                result[i] = func(x[i], y[i], z[i], t);
+        };
+    }
+
+};
+TYPED_TEST_CASE(FieldGeneratorTestBatchFunctions, types);
+
+TYPED_TEST(FieldGeneratorTestBatchFunctions, BatchFunctionsMatchScalarFunctions) {
+
+    for (int step = 0; step < this->numSteps / 4; ++step) {
+        this->fieldSolver->updateFields();
+        this->referenceFieldSolver->updateFields();
+    }
+
+    for (int i = 0; i < this->grid->numCells.x; i++)
+        for (int j = 0; j < this->grid->numCells.y; j++)
+            for (int k = 0; k < this->grid->numCells.z; k++) {
+                ASSERT_NEAR(this->referenceGrid->Ex(i, j, k), this->grid->Ex(i, j, k), this->maxAbsoluteError);
+                ASSERT_NEAR(this->referenceGrid->Ey(i, j, k), this->grid->Ey(i, j, k), this->maxAbsoluteError);
+                ASSERT_NEAR(this->referenceGrid->Ez(i, j, k), this->grid->Ez(i, j, k), this->maxAbsoluteError);
+                ASSERT_NEAR(this->referenceGrid->Bx(i, j, k), this->grid->Bx(i, j, k), this->maxAbsoluteError);
+                ASSERT_NEAR(this->referenceGrid->By(i, j, k), this->grid->By(i, j, k), this->maxAbsoluteError);
+                ASSERT_NEAR(this->referenceGrid->Bz(i, j, k), this->grid->Bz(i, j, k), this->maxAbsoluteError);
+            }
+}
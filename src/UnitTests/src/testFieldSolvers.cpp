@@ -212,3 +212,112 @@ TYPED_TEST(FieldSolverTest, SetTimeStepTest) {
     ASSERT_EQ(newTimeStep, this->fieldSolver->pml->dt);
     ASSERT_EQ(newTimeStep, this->fieldSolver->generator->dt);
 }
+
+#ifdef __USE_FFT__
+
+TEST(PSATDTimeStaggeredTest, ReducedMemoryModeGivesSameFields) {
+    const Int3 gridSize(16, 12, 10);
+    const int pmlSize = 3;
+    const FP3 gridStep(constants::c, constants::c, constants::c);
+    const FP timeStep = 0.5 * PSATDTimeStaggered::getCourantConditionTimeStep(gridStep);
+
+    PSATDTimeStaggeredGrid grid(gridSize, FP3(0, 0, 0), gridStep, gridSize),
+        reducedGrid(gridSize, FP3(0, 0, 0), gridStep, gridSize);
+    PSATDTimeStaggered solver(&grid, timeStep), reducedSolver(&reducedGrid, timeStep);
+    solver.setPML(pmlSize, pmlSize, pmlSize);
+    reducedSolver.setPML(pmlSize, pmlSize, pmlSize);
+
+    MemoryRegistry& registry = MemoryRegistry::instance();
+    const size_t bytes = registry.getStats(MemoryCategory::Pml).allocatedBytes +
+        registry.getStats(MemoryCategory::FieldSolver).allocatedBytes;
+    reducedSolver.setReducedMemoryMode(true);
+    ASSERT_TRUE(reducedSolver.pml->isReducedMemoryMode());
+    ASSERT_TRUE(reducedSolver.pml->hasCompactCoeffs());
+    ASSERT_GT(bytes, registry.getStats(MemoryCategory::Pml).allocatedBytes +
+        registry.getStats(MemoryCategory::FieldSolver).allocatedBytes);
+
+    auto func = [&gridSize](int i, int j, int k, FP phase) {
+        return sin(2 * constants::pi * ((FP)i / gridSize.x + 2 * (FP)j / gridSize.y + phase)) *
+            cos(2 * constants::pi * (FP)k / gridSize.z);
+    };
+    for (PSATDTimeStaggeredGrid* g : { &grid, &reducedGrid })
+        for (int i = 0; i < gridSize.x; i++)
+            for (int j = 0; j < gridSize.y; j++)
+                for (int k = 0; k < gridSize.z; k++) {
+                    g->Ey(i, j, k) = func(i, j, k, 0);
+                    g->Bz(i, j, k) = func(i, j, k, 0.25);
+                }
+
+    for (int step = 0; step < 6; step++) {
+        // the currents are deposited anew before each step
+        for (PSATDTimeStaggeredGrid* g : { &grid, &reducedGrid })
+            for (int i = 0; i < gridSize.x; i++)
+                for (int j = 0; j < gridSize.y; j++)
+                    for (int k = 0; k < gridSize.z; k++) {
+                        g->Jx(i, j, k) = 0.1 * func(i, j, k, 0.1 * step);
+                        g->Jz(i, j, k) = 0.1 * func(k, i, j, 0.1 * step);
+                    }
+        solver.updateFields();
+        reducedSolver.updateFields();
+    }
+
+    const FP maxError = 1e-10;
+    for (int i = 0; i < gridSize.x; i++)
+        for (int j = 0; j < gridSize.y; j++)
+            for (int k = 0; k < gridSize.z; k++) {
+                ASSERT_NEAR(grid.Ex(i, j, k), reducedGrid.Ex(i, j, k), maxError);
+                ASSERT_NEAR(grid.Ey(i, j, k), reducedGrid.Ey(i, j, k), maxError);
+                ASSERT_NEAR(grid.Ez(i, j, k), reducedGrid.Ez(i, j, k), maxError);
+                ASSERT_NEAR(grid.Bx(i, j, k), reducedGrid.Bx(i, j, k), maxError);
+                ASSERT_NEAR(grid.By(i, j, k), reducedGrid.By(i, j, k), maxError);
+                ASSERT_NEAR(grid.Bz(i, j, k), reducedGrid.Bz(i, j, k), maxError);
+                ASSERT_EQ(0, reducedGrid.Jx(i, j, k));
+            }
+}
+
+TEST(PSATDTimeStaggeredTest, PmlSlabModeDoesNotDependOnCompactCoeffs) {
+    const Int3 gridSize(16, 12, 10);
+    const int pmlSize = 3;
+    const FP3 gridStep(constants::c, constants::c, constants::c);
+    const FP timeStep = 0.5 * PSATDTimeStaggered::getCourantConditionTimeStep(gridStep);
+
+    PSATDTimeStaggeredGrid grid(gridSize, FP3(0, 0, 0), gridStep, gridSize),
+        slabGrid(gridSize, FP3(0, 0, 0), gridStep, gridSize),
+        compactGrid(gridSize, FP3(0, 0, 0), gridStep, gridSize);
+    PSATDTimeStaggered solver(&grid, timeStep), slabSolver(&slabGrid, timeStep),
+        compactSolver(&compactGrid, timeStep);
+    for (PSATDTimeStaggered* s : { &solver, &slabSolver, &compactSolver })
+        s->setPML(pmlSize, pmlSize, pmlSize);
+
+    slabSolver.pml->setReducedMemoryMode(true);
+    ASSERT_FALSE(slabSolver.pml->hasCompactCoeffs());
+    compactSolver.pml->setCompactCoeffs(true);
+    ASSERT_FALSE(compactSolver.pml->isReducedMemoryMode());
+
+    for (PSATDTimeStaggeredGrid* g : { &grid, &slabGrid, &compactGrid })
+        for (int i = 0; i < gridSize.x; i++)
+            for (int j = 0; j < gridSize.y; j++)
+                for (int k = 0; k < gridSize.z; k++) {
+                    g->Ey(i, j, k) = sin(2 * constants::pi * ((FP)i / gridSize.x + (FP)k / gridSize.z));
+                    g->Bz(i, j, k) = cos(2 * constants::pi * ((FP)i / gridSize.x + 2 * (FP)j / gridSize.y));
+                }
+
+    for (int step = 0; step < 6; step++)
+        for (PSATDTimeStaggered* s : { &solver, &slabSolver, &compactSolver })
+            s->updateFields();
+
+    const FP maxError = 1e-10;
+    for (PSATDTimeStaggeredGrid* g : { &slabGrid, &compactGrid })
+        for (int i = 0; i < gridSize.x; i++)
+            for (int j = 0; j < gridSize.y; j++)
+                for (int k = 0; k < gridSize.z; k++) {
+                    ASSERT_NEAR(grid.Ex(i, j, k), g->Ex(i, j, k), maxError);
+                    ASSERT_NEAR(grid.Ey(i, j, k), g->Ey(i, j, k), maxError);
+                    ASSERT_NEAR(grid.Ez(i, j, k), g->Ez(i, j, k), maxError);
+                    ASSERT_NEAR(grid.Bx(i, j, k), g->Bx(i, j, k), maxError);
+                    ASSERT_NEAR(grid.By(i, j, k), g->By(i, j, k), maxError);
+                    ASSERT_NEAR(grid.Bz(i, j, k), g->Bz(i, j, k), maxError);
+                }
+}
+
+#endif
@@ -1,6 +1,8 @@
 #include "TestingUtility.h"
 
 #include "Grid.h"
+#include "ParticleArray.h"
+#include "ScalarFieldView.h"
 
 template <class gridType>
 class GridTest : public BaseGridFixture<gridType> {
@@ -9,6 +11,77 @@ public:
     FP3 internalPointNotNearBorders() {
         return this->urandFP3(this->minCoords + this->grid->steps, this->maxCoords - this->grid->steps);
     }
+
+    // interpolation with the compile-time policy gives the same values as with the current one
+    template <InterpolationType type>
+    void checkInterpolationPolicy() {
+        this->grid->setInterpolationType(type);
+        const FP3 center = (this->minCoords + this->maxCoords) * 0.5;
+        for (int testIdx = 0; testIdx < 100; ++testIdx) {
+            FP3 coords = this->urandFP3(center - this->grid->steps * 0.5, center + this->grid->steps * 0.5);
+            ASSERT_NEAR_FP3(this->grid->getE(coords), this->grid->template getE<type>(coords));
+            ASSERT_NEAR_FP3(this->grid->getB(coords), this->grid->template getB<type>(coords));
+            ASSERT_NEAR_FP3(this->grid->getJ(coords), this->grid->template getJ<type>(coords));
+            ASSERT_NEAR_FP(this->grid->getEx(coords), this->grid->template getEx<type>(coords));
+            FP3 e, b, expectedE, expectedB;
+            this->grid->getFields(coords, expectedE, expectedB);
+            this->grid->template getFields<type>(coords, e, b);
+            ASSERT_NEAR_FP3(expectedE, e);
+            ASSERT_NEAR_FP3(expectedB, b);
+        }
+    }
+
+    // interpolation in cell-relative positions gives the same values as in coords
+    template <InterpolationType type>
+    void checkCellPositionInterpolation() {
+        this->grid->setInterpolationType(type);
+        const CellGeometry geometry = this->grid->getCellGeometry();
+        for (int testIdx = 0; testIdx < 100; ++testIdx) {
+            // the stencils of all interpolations are inside the grid
+            FP3 coords = this->urandFP3(this->minCoords + this->grid->steps * 2.0,
+                this->maxCoords - this->grid->steps * 2.0);
+            CellPosition position;
+            for (int d = 0; d < 3; d++)
+                geometry.split(coords[d], d, position.cell[d], position.offset[d]);
+            ASSERT_NEAR_FP3(this->grid->getE(coords), this->grid->getE(position));
+            ASSERT_NEAR_FP3(this->grid->getB(coords), this->grid->getB(position));
+            ASSERT_NEAR_FP3(this->grid->getJ(coords), this->grid->getJ(position));
+            FP3 e, b, expectedE, expectedB;
+            this->grid->getFields(coords, expectedE, expectedB);
+            this->grid->template getFields<type>(position, e, b);
+            ASSERT_NEAR_FP3(expectedE, e);
+            ASSERT_NEAR_FP3(expectedB, b);
+        }
+    }
+
+    // the vector getters near the borders of the storage give the values of the per-component ones
+    template <InterpolationType type>
+    void checkInterpolationNearBorders() {
+        const Int3 n = this->grid->numCells;
+        const int numIndices = type == InterpolationType::Interpolation_CIC ? 4 : 3;
+        for (int ii = 0; ii < numIndices; ii++)
+            for (int jj = 0; jj < numIndices; jj++)
+                for (int kk = 0; kk < numIndices; kk++) {
+                    // the PCS stencils of the shifted components at the first index start at node 0
+                    // and at n - 3 end at node n - 1, the last index is checked for CIC only,
+                    // its nodes wrap around the grid
+                    const int x[4] = { 2, n.x - 4, n.x - 3, n.x - 1 };
+                    const int y[4] = { 2, n.y - 4, n.y - 3, n.y - 1 };
+                    const int z[4] = { 2, n.z - 4, n.z - 3, n.z - 1 };
+                    FP3 coords = this->grid->ExPosition(x[ii], y[jj], z[kk]) +
+                        this->urandFP3(FP3(0, 0, 0), this->grid->steps * 0.4);
+                    FP3 expectedE(this->grid->template getEx<type>(coords),
+                        this->grid->template getEy<type>(coords), this->grid->template getEz<type>(coords));
+                    FP3 expectedB(this->grid->template getBx<type>(coords),
+                        this->grid->template getBy<type>(coords), this->grid->template getBz<type>(coords));
+                    ASSERT_NEAR_FP3(expectedE, this->grid->template getE<type>(coords));
+                    ASSERT_NEAR_FP3(expectedB, this->grid->template getB<type>(coords));
+                    FP3 e, b;
+                    this->grid->template getFields<type>(coords, e, b);
+                    ASSERT_NEAR_FP3(expectedE, e);
+                    ASSERT_NEAR_FP3(expectedB, b);
+                }
+    }
 };
 
 typedef ::testing::Types<YeeGrid, SimpleGrid, PSTDGrid, PSATDGrid, PSATDTimeStaggeredGrid> types;
@@ -209,3 +282,217 @@ TYPED_TEST(GridTest, GridInitialization)
                 ASSERT_NEAR_FP3(expectedB, actualB);
             }
 }
+
+TYPED_TEST(GridTest, MoveConstructorAndAssignment)
+{
+    auto grid = this->grid;
+    for (int i = 0; i < grid->numCells.x; i++)
+        for (int j = 0; j < grid->numCells.y; j++)
+            for (int k = 0; k < grid->numCells.z; k++)
+                grid->Ex(i, j, k) = grid->ExPosition(i, j, k).x;
+    const FP3 coords = this->internalPointNotNearBorders();
+    const FP3 expectedE = grid->getE(coords);
+    const FP* data = grid->Ex.getData();
+
+    TypeParam movedGrid(std::move(*grid));
+    ASSERT_EQ(data, movedGrid.Ex.getData());
+    ASSERT_NEAR_FP3(expectedE, movedGrid.getE(coords));
+
+    *grid = std::move(movedGrid);
+    ASSERT_EQ(data, grid->Ex.getData());
+    ASSERT_NEAR_FP3(expectedE, grid->getE(coords));
+}
+
+TYPED_TEST(GridTest, InterpolationPolicy)
+{
+    auto grid = this->grid;
+    for (int i = 0; i < grid->numCells.x; i++)
+        for (int j = 0; j < grid->numCells.y; j++)
+            for (int k = 0; k < grid->numCells.z; k++) {
+                grid->Ex(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Ey(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Ez(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Bx(i, j, k) = this->urand(-1.0, 1.0);
+                grid->By(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Bz(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Jx(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Jy(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Jz(i, j, k) = this->urand(-1.0, 1.0);
+            }
+    this->template checkInterpolationPolicy<InterpolationType::Interpolation_CIC>();
+    this->template checkInterpolationPolicy<InterpolationType::Interpolation_TSC>();
+    this->template checkInterpolationPolicy<InterpolationType::Interpolation_PCS>();
+    this->template checkInterpolationPolicy<InterpolationType::Interpolation_SecondOrder>();
+    this->template checkInterpolationPolicy<InterpolationType::Interpolation_FourthOrder>();
+}
+
+TYPED_TEST(GridTest, InterpolationNearBorders)
+{
+    auto grid = this->grid;
+    for (int i = 0; i < grid->numCells.x; i++)
+        for (int j = 0; j < grid->numCells.y; j++)
+            for (int k = 0; k < grid->numCells.z; k++) {
+                grid->Ex(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Ey(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Ez(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Bx(i, j, k) = this->urand(-1.0, 1.0);
+                grid->By(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Bz(i, j, k) = this->urand(-1.0, 1.0);
+            }
+    this->template checkInterpolationNearBorders<InterpolationType::Interpolation_CIC>();
+    this->template checkInterpolationNearBorders<InterpolationType::Interpolation_TSC>();
+    this->template checkInterpolationNearBorders<InterpolationType::Interpolation_PCS>();
+    this->template checkInterpolationNearBorders<InterpolationType::Interpolation_SecondOrder>();
+    this->template checkInterpolationNearBorders<InterpolationType::Interpolation_FourthOrder>();
+}
+
+TYPED_TEST(GridTest, InterleavedFields)
+{
+    auto grid = this->grid;
+    for (int i = 0; i < grid->numCells.x; i++)
+        for (int j = 0; j < grid->numCells.y; j++)
+            for (int k = 0; k < grid->numCells.z; k++) {
+                grid->Ex(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Ey(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Ez(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Bx(i, j, k) = this->urand(-1.0, 1.0);
+                grid->By(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Bz(i, j, k) = this->urand(-1.0, 1.0);
+            }
+    std::vector<FP3> points(100), expectedE(100), expectedB(100);
+    for (int testIdx = 0; testIdx < 100; ++testIdx) {
+        points[testIdx] = this->internalPointNotNearBorders();
+        grid->getFields(points[testIdx], expectedE[testIdx], expectedB[testIdx]);
+    }
+
+    grid->setInterleavedFields(true);
+    ASSERT_TRUE(grid->isInterleavedFields());
+    for (int testIdx = 0; testIdx < 100; ++testIdx) {
+        FP3 e, b;
+        grid->getFields(points[testIdx], e, b);
+        ASSERT_NEAR_FP3(expectedE[testIdx], e);
+        ASSERT_NEAR_FP3(expectedB[testIdx], b);
+    }
+
+    grid->setInterleavedFields(false);
+    ASSERT_FALSE(grid->isInterleavedFields());
+}
+
+// a write of E or B marked with markFieldsChanged is seen by the next interleaved gather
+TYPED_TEST(GridTest, InterleavedFieldsAfterWrite)
+{
+    auto grid = this->grid;
+    grid->setInterleavedFields(true);
+    std::vector<FP3> points(100);
+    for (int testIdx = 0; testIdx < 100; ++testIdx) {
+        points[testIdx] = this->internalPointNotNearBorders();
+        FP3 e, b;
+        grid->getFields(points[testIdx], e, b);
+    }
+
+    for (int i = 0; i < grid->numCells.x; i++)
+        for (int j = 0; j < grid->numCells.y; j++)
+            for (int k = 0; k < grid->numCells.z; k++) {
+                grid->Ex(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Bz(i, j, k) = this->urand(-1.0, 1.0);
+            }
+    grid->markFieldsChanged();
+
+    for (int testIdx = 0; testIdx < 100; ++testIdx) {
+        FP3 e, b;
+        grid->getFields(points[testIdx], e, b);
+        ASSERT_NEAR_FP3(grid->getE(points[testIdx]), e);
+        ASSERT_NEAR_FP3(grid->getB(points[testIdx]), b);
+    }
+
+    // a view taken before a gather is written, then the grid is marked as the Python arrays require
+    ScalarFieldView<FP> view(grid->Ex);
+    for (int testIdx = 0; testIdx < 100; ++testIdx) {
+        FP3 e, b;
+        grid->getFields(points[testIdx], e, b);
+    }
+    for (int i = 0; i < grid->numCells.x; i++)
+        for (int j = 0; j < grid->numCells.y; j++)
+            for (int k = 0; k < grid->numCells.z; k++)
+                view(i, j, k) = this->urand(-1.0, 1.0);
+    grid->markFieldsChanged();
+    for (int testIdx = 0; testIdx < 100; ++testIdx) {
+        FP3 e, b;
+        grid->getFields(points[testIdx], e, b);
+        ASSERT_NEAR_FP3(grid->getE(points[testIdx]), e);
+    }
+
+    // copyValues marks the target grid
+    TypeParam source(*grid);
+    source.setInterleavedFields(false);
+    for (int i = 0; i < source.numCells.x; i++)
+        for (int j = 0; j < source.numCells.y; j++)
+            for (int k = 0; k < source.numCells.z; k++)
+                source.Ey(i, j, k) = this->urand(-1.0, 1.0);
+    source.copyValues(grid);
+    for (int testIdx = 0; testIdx < 100; ++testIdx) {
+        FP3 e, b;
+        grid->getFields(points[testIdx], e, b);
+        ASSERT_NEAR_FP3(grid->getE(points[testIdx]), e);
+    }
+}
+
+TYPED_TEST(GridTest, CellPositionInterpolation)
+{
+    auto grid = this->grid;
+    for (int i = 0; i < grid->numCells.x; i++)
+        for (int j = 0; j < grid->numCells.y; j++)
+            for (int k = 0; k < grid->numCells.z; k++) {
+                grid->Ex(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Ey(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Ez(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Bx(i, j, k) = this->urand(-1.0, 1.0);
+                grid->By(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Bz(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Jx(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Jy(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Jz(i, j, k) = this->urand(-1.0, 1.0);
+            }
+    this->template checkCellPositionInterpolation<InterpolationType::Interpolation_CIC>();
+    this->template checkCellPositionInterpolation<InterpolationType::Interpolation_TSC>();
+    this->template checkCellPositionInterpolation<InterpolationType::Interpolation_PCS>();
+    this->template checkCellPositionInterpolation<InterpolationType::Interpolation_SecondOrder>();
+    this->template checkCellPositionInterpolation<InterpolationType::Interpolation_FourthOrder>();
+}
+
+TYPED_TEST(GridTest, GatherFieldsAtCellParticles)
+{
+    typedef ParticleArray<Three, ParticleRepresentation_CellSoA, FP>::Type CellParticleArray;
+    typedef CellParticleArray::ParticleType Particle;
+    auto grid = this->grid;
+    for (int i = 0; i < grid->numCells.x; i++)
+        for (int j = 0; j < grid->numCells.y; j++)
+            for (int k = 0; k < grid->numCells.z; k++) {
+                grid->Ex(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Ey(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Ez(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Bx(i, j, k) = this->urand(-1.0, 1.0);
+                grid->By(i, j, k) = this->urand(-1.0, 1.0);
+                grid->Bz(i, j, k) = this->urand(-1.0, 1.0);
+            }
+    CellParticleArray particles(Electron, grid->getCellGeometry());
+    const int numParticles = 100;
+    Particle particle;
+    for (int i = 0; i < numParticles; i++) {
+        particle.setPosition(this->internalPointNotNearBorders());
+        particles.pushBack(particle);
+    }
+    std::vector<FP3> e(numParticles), b(numParticles);
+    grid->gatherFields(particles, e.data(), b.data());
+    for (int i = 0; i < numParticles; i++) {
+        FP3 expectedE, expectedB;
+        grid->getFields(particles[i].getPosition(), expectedE, expectedB);
+        ASSERT_NEAR_FP3(expectedE, e[i]);
+        ASSERT_NEAR_FP3(expectedB, b[i]);
+    }
+
+    // the positions in other cells cannot be gathered without conversion
+    CellParticleArray otherParticles(Electron, CellGeometry(grid->origin, grid->steps * 2.0));
+    otherParticles.pushBack(particle);
+    ASSERT_THROW(grid->gatherFields(otherParticles, e.data(), b.data()), std::logic_error);
+}
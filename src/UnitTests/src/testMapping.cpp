@@ -0,0 +1,173 @@
+#include "TestingUtility.h"
+
+#include "Mapping.h"
+#include "CompiledMapping.h"
+
+#include <memory>
+#include <vector>
+
+using namespace pfc;
+
+
+class CompiledMappingTest : public BaseFixture {
+protected:
+
+    virtual void SetUp() {
+        BaseFixture::SetUp();
+        mappings.push_back(std::make_shared<ShiftMapping>(FP3(1.5, -2.0, 0.5)));
+        mappings.push_back(std::make_shared<RotationMapping>(CoordinateEnum::z, 0.3));
+        mappings.push_back(std::make_shared<ScaleMapping>(CoordinateEnum::x, 2.0));
+        mappings.push_back(std::make_shared<PeriodicalMapping>(CoordinateEnum::x, -4.0, 4.0));
+        mappings.push_back(std::make_shared<RotationMapping>(CoordinateEnum::x, -1.1));
+        mappings.push_back(std::make_shared<ShiftMapping>(FP3(0.0, 3.0, -1.0)));
+        mappings.push_back(std::make_shared<IdentityMapping>(FP3(-5.0, -5.0, -5.0), FP3(5.0, 5.0, 5.0)));
+        for (int i = 0; i < (int)mappings.size(); i++)
+            compiledMapping.append(mappings[i]);
+    }
+
+    FP3 getDirectCoords(const FP3& coords, bool* status) {
+        FP3 result = coords;
+        *status = true;
+        for (int i = 0; i < (int)mappings.size(); i++) {
+            bool stageStatus = true;
+            result = mappings[i]->getDirectCoords(result, 0.0, &stageStatus);
+            *status = *status && stageStatus;
+        }
+        return result;
+    }
+
+    FP3 getInverseCoords(const FP3& coords, bool* status) {
+        FP3 result = coords;
+        *status = true;
+        for (int i = 0; i < (int)mappings.size(); i++) {
+            bool stageStatus = true;
+            result = mappings[i]->getInverseCoords(result, 0.0, &stageStatus);
+            *status = *status && stageStatus;
+        }
+        return result;
+    }
+
+    std::vector<std::shared_ptr<Mapping>> mappings;
+    CompiledMapping compiledMapping;
+};
+
+TEST_F(CompiledMappingTest, FusesAffineMappings)
+{
+    // (shift, rotation, scale), periodical, (rotation, shift), identity
+    ASSERT_EQ(4, compiledMapping.getNumStages());
+}
+
+TEST_F(CompiledMappingTest, DirectCoordsMatchMappingChain)
+{
+    for (int i = 0; i < 1000; i++) {
+        FP3 coords = urandFP3(FP3(-10.0, -10.0, -10.0), FP3(10.0, 10.0, 10.0));
+        bool expectedStatus = true, status = true;
+        FP3 expected = getDirectCoords(coords, &expectedStatus);
+        FP3 actual = compiledMapping.getDirectCoords(coords, 0.0, &status);
+        ASSERT_NEAR_FP3(expected, actual);
+        ASSERT_EQ(expectedStatus, status);
+    }
+}
+
+TEST_F(CompiledMappingTest, InverseCoordsMatchMappingChain)
+{
+    for (int i = 0; i < 1000; i++) {
+        FP3 coords = urandFP3(FP3(-10.0, -10.0, -10.0), FP3(10.0, 10.0, 10.0));
+        bool expectedStatus = true, status = true;
+        FP3 expected = getInverseCoords(coords, &expectedStatus);
+        FP3 actual = compiledMapping.getInverseCoords(coords, 0.0, &status);
+        ASSERT_NEAR_FP3(expected, actual);
+        ASSERT_EQ(expectedStatus, status);
+    }
+}
+
+TEST_F(CompiledMappingTest, BatchCoordsMatchMappingChain)
+{
+    const int size = 1000;
+    std::vector<FP3> coords(size), direct(size), inverse(size);
+    std::unique_ptr<bool[]> directStatus(new bool[size]), inverseStatus(new bool[size]);
+    for (int i = 0; i < size; i++) {
+        coords[i] = urandFP3(FP3(-10.0, -10.0, -10.0), FP3(10.0, 10.0, 10.0));
+        directStatus[i] = true;
+        inverseStatus[i] = true;
+    }
+    compiledMapping.getDirectCoordsBatch(coords.data(), direct.data(), size, 0.0, directStatus.get());
+    compiledMapping.getInverseCoordsBatch(coords.data(), inverse.data(), size, 0.0, inverseStatus.get());
+
+    for (int i = 0; i < size; i++) {
+        bool expectedStatus = true;
+        FP3 expected = getDirectCoords(coords[i], &expectedStatus);
+        ASSERT_NEAR_FP3(expected, direct[i]);
+        ASSERT_EQ(expectedStatus, directStatus[i]);
+        expected = getInverseCoords(coords[i], &expectedStatus);
+        ASSERT_NEAR_FP3(expected, inverse[i]);
+        ASSERT_EQ(expectedStatus, inverseStatus[i]);
+    }
+}
+
+
+class MappingBatchTest : public BaseFixture {
+protected:
+
+    void checkBatch(Mapping& mapping, FP time) {
+        const int size = 1000;
+        std::vector<FP3> coords(size), direct(size), inverse(size);
+        std::unique_ptr<bool[]> directStatus(new bool[size]), inverseStatus(new bool[size]);
+        for (int i = 0; i < size; i++) {
+            coords[i] = urandFP3(FP3(-10.0, -10.0, -10.0), FP3(10.0, 10.0, 10.0));
+            directStatus[i] = true;
+            inverseStatus[i] = true;
+        }
+        mapping.getDirectCoordsBatch(coords.data(), direct.data(), size, time, directStatus.get());
+        mapping.getInverseCoordsBatch(coords.data(), inverse.data(), size, time, inverseStatus.get());
+
+        for (int i = 0; i < size; i++) {
+            bool expectedStatus = true;
+            FP3 expected = mapping.getDirectCoords(coords[i], time, &expectedStatus);
+            ASSERT_NEAR_FP3(expected, direct[i]);
+            ASSERT_EQ(expectedStatus, directStatus[i]);
+            expected = mapping.getInverseCoords(coords[i], time, &expectedStatus);
+            ASSERT_NEAR_FP3(expected, inverse[i]);
+            ASSERT_EQ(expectedStatus, inverseStatus[i]);
+        }
+    }
+};
+
+TEST_F(MappingBatchTest, IdentityMapping)
+{
+    IdentityMapping mapping(FP3(-5.0, -5.0, -5.0), FP3(5.0, 5.0, 5.0));
+    checkBatch(mapping, 0.0);
+}
+
+TEST_F(MappingBatchTest, PeriodicalMapping)
+{
+    PeriodicalMapping mapping(CoordinateEnum::y, -3.0, 4.0);
+    checkBatch(mapping, 0.0);
+}
+
+TEST_F(MappingBatchTest, RotationMapping)
+{
+    RotationMapping mapping(CoordinateEnum::y, 0.7);
+    checkBatch(mapping, 0.0);
+}
+
+TEST_F(MappingBatchTest, ShiftMapping)
+{
+    ShiftMapping mapping(FP3(1.0, -2.0, 3.0));
+    checkBatch(mapping, 0.0);
+}
+
+TEST_F(MappingBatchTest, ScaleMapping)
+{
+    ScaleMapping mapping(CoordinateEnum::z, 0.5);
+    checkBatch(mapping, 0.0);
+}
+
+TEST_F(MappingBatchTest, TightFocusingMapping)
+{
+    TightFocusingMapping mapping(8.0, 4.0, 6.0);
+    for (int step = -3; step <= 3; step++)
+        checkBatch(mapping, 4.0 * step / constants::c);
+    mapping.setIfCut(false);
+    checkBatch(mapping, 0.0);
+}
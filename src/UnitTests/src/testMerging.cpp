@@ -28,3 +28,103 @@ TYPED_TEST(ThinningTest, kmeansMerging)
     ASSERT_NEAR_FP(originalTotalWeight, modifiedTotalWeight);
     ASSERT_TRUE(particles.size() <= numberParticles / 2);
 }
+
+TYPED_TEST(ThinningTest, cellMergingConservesWeightMomentumEnergy)
+{
+    typedef typename ThinningTest<TypeParam>::ParticleArray ParticleArray;
+
+    ParticleArray particles;
+    int numberParticles = 2000;
+    this->addRandomParticles(particles, numberParticles);
+    FP originalTotalWeight = this->totalWeight(particles);
+    FP originalTotalEnergy = this->totalEnergy(particles);
+    FP3 originalTotalMomentum = this->totalMomentum(particles);
+
+    FP3 minCoords(-10, -10, -10), cellSize(10, 10, 10);
+    Merging<ParticleArray>::merge_in_cells(particles, minCoords, cellSize, Int3(2, 2, 2), Int3(2, 2, 2));
+
+    ASSERT_NEAR_FP(originalTotalWeight, this->totalWeight(particles));
+    ASSERT_NEAR_FP(originalTotalEnergy, this->totalEnergy(particles));
+    ASSERT_NEAR_FP3(originalTotalMomentum, this->totalMomentum(particles));
+    ASSERT_TRUE(particles.size() <= 3 * 8 * 8);
+}
+
+TYPED_TEST(ThinningTest, cellMergingKeepsParticlesInCells)
+{
+    typedef typename ThinningTest<TypeParam>::ParticleArray ParticleArray;
+
+    ParticleArray particles;
+    this->addRandomParticles(particles, 500, FP3(-10, -10, -10), FP3(0, 0, 0), Electron);
+    this->addRandomParticles(particles, 500, FP3(0, 0, 0), FP3(10, 10, 10), Electron);
+
+    FP3 minCoords(-10, -10, -10), cellSize(10, 10, 10);
+    Merging<ParticleArray>::merge_in_cells(particles, minCoords, cellSize, Int3(2, 2, 2), Int3(1, 1, 1));
+
+    ASSERT_EQ(4, particles.size());
+    for (int i = 0; i < particles.size(); i++)
+    {
+        FP3 position = particles[i].getPosition();
+        bool isLeft = position < FP3(0, 0, 0);
+        bool isRight = position >= FP3(0, 0, 0);
+        ASSERT_TRUE(isLeft || isRight);
+    }
+}
+
+TYPED_TEST(ThinningTest, acceleratedKmeansMerging)
+{
+    typedef typename ThinningTest<TypeParam>::ParticleArray ParticleArray;
+
+    ParticleArray particles;
+    int numberParticles = 1000;
+    this->addRandomParticles(particles, numberParticles);
+    FP originalTotalWeight = this->totalWeight(particles);
+    FP3 originalTotalMomentum = this->totalMomentum(particles);
+
+    Merging<ParticleArray>::merge_with_accelerated_kmeans(particles, numberParticles / 10, 30);
+
+    ASSERT_NEAR_FP(originalTotalWeight, this->totalWeight(particles));
+    ASSERT_NEAR_FP3(originalTotalMomentum, this->totalMomentum(particles));
+    ASSERT_TRUE(particles.size() <= numberParticles / 10);
+}
+
+// particles of an AoS array can have different types after setType
+class MixedTypeMergingTest : public ThinningTest<ParticleArrayAoS3d> {
+public:
+    FP typeWeight(ParticleArray& particles, ParticleTypes type) const
+    {
+        FP result = 0.0;
+        for (int i = 0; i < particles.size(); i++)
+            if (particles[i].getType() == type)
+                result += particles[i].getWeight();
+        return result;
+    }
+
+    void addMixedParticles(ParticleArray& particles, int numParticles)
+    {
+        addRandomParticles(particles, 3 * numParticles, Electron);
+        for (int i = numParticles; i < 2 * numParticles; i++)
+            particles[i].setType(Positron);
+        for (int i = 2 * numParticles; i < 3 * numParticles; i++)
+            particles[i].setType(Proton);
+    }
+};
+
+TEST_F(MixedTypeMergingTest, cellMergingDoesNotMixTypes)
+{
+    ParticleArray particles;
+    addMixedParticles(particles, 1000);
+    const FP electronWeight = typeWeight(particles, Electron), positronWeight = typeWeight(particles, Positron),
+        protonWeight = typeWeight(particles, Proton);
+    FP originalTotalEnergy = totalEnergy(particles);
+    FP3 originalTotalMomentum = totalMomentum(particles);
+
+    FP3 minCoords(-10, -10, -10), cellSize(10, 10, 10);
+    Merging<ParticleArray>::merge_in_cells(particles, minCoords, cellSize, Int3(2, 2, 2), Int3(2, 2, 2));
+
+    ASSERT_TRUE(particles.size() <= 3 * 2 * 8 * 8);
+    ASSERT_NEAR_FP(electronWeight, typeWeight(particles, Electron));
+    ASSERT_NEAR_FP(positronWeight, typeWeight(particles, Positron));
+    ASSERT_NEAR_FP(protonWeight, typeWeight(particles, Proton));
+    ASSERT_NEAR_FP(originalTotalEnergy, totalEnergy(particles));
+    ASSERT_NEAR_FP3(originalTotalMomentum, totalMomentum(particles));
+}
@@ -224,6 +224,16 @@ TYPED_TEST(PMLTestOnly, CanResetPmlWhenChangeTimeStep) {
     ASSERT_NE(oldDt, this->fieldSolver->pml->dt);
 }
 
+TYPED_TEST(PMLTestOnly, PmlMemoryIsAccounted) {
+    MemoryRegistry& registry = MemoryRegistry::instance();
+    ASSERT_LT(0u, registry.getStats(MemoryCategory::Pml).allocatedBytes);
+
+    // the split fields are released with the solver
+    const size_t pmlBytes = registry.getStats(MemoryCategory::Pml).allocatedBytes;
+    this->fieldSolver.reset();
+    ASSERT_GT(pmlBytes, registry.getStats(MemoryCategory::Pml).allocatedBytes);
+}
+
 
 template <class TTypeDefinitionsPMLTest>
 class PMLTestPeriodical : public PMLTest<TTypeDefinitionsPMLTest> {
@@ -123,6 +123,28 @@ TYPED_TEST(ParticleArrayTest, PushBack)
     ASSERT_TRUE(this->eqParticleArrays(particles, particlesCopy));
 }
 
+TYPED_TEST(ParticleArrayTest, PushBackKeepingType)
+{
+    typedef typename ParticleArrayTest<TypeParam>::ParticleArray ParticleArray;
+
+    ParticleArray particles(Electron);
+    for (int i = 0; i < 10; i++)
+        particles.pushBackKeepingType(this->randomParticle(i % 2 ? Positron : Electron));
+    // only an AoS array stores particles of types other than the array type
+    if (ParticleArray::particleRepresentationType == ParticleRepresentation_AoS)
+    {
+        ASSERT_EQ(10, (int)particles.size());
+        for (int i = 0; i < (int)particles.size(); i++)
+            EXPECT_EQ(i % 2 ? Positron : Electron, particles[i].getType());
+    }
+    else
+    {
+        ASSERT_EQ(5, (int)particles.size());
+        for (int i = 0; i < (int)particles.size(); i++)
+            EXPECT_EQ(Electron, particles[i].getType());
+    }
+}
+
 TYPED_TEST(ParticleArrayTest, PopBack)
 {
     typedef typename ParticleArrayTest<TypeParam>::ParticleArray ParticleArray;
@@ -141,4 +163,210 @@ TYPED_TEST(ParticleArrayTest, PopBack)
             EXPECT_TRUE(this->eqParticles_(particle, particleCopy));
         }
     }
-}
\ No newline at end of file
+}
+TYPED_TEST(ParticleArrayTest, Compact)
+{
+    typedef typename ParticleArrayTest<TypeParam>::ParticleArray ParticleArray;
+    typedef typename ParticleArray::ParticleProxyType ParticleProxyType;
+
+    ParticleArray particles;
+    for (int i = 0; i < 20; i++)
+        particles.pushBack(this->randomParticle());
+    ParticleArray particlesCopy = particles;
+    std::vector<int> indices = { 0, 3, 4, 11, 19 };
+    particles.compact(indices);
+    ASSERT_EQ(indices.size(), particles.size());
+    for (int i = 0; i < (int)indices.size(); i++)
+    {
+        ParticleProxyType particle(particles[i]), particleCopy(particlesCopy[indices[i]]);
+        EXPECT_TRUE(this->eqParticles_(particle, particleCopy));
+    }
+}
+TYPED_TEST(ParticleArrayTest, Resize)
+{
+    typedef typename ParticleArrayTest<TypeParam>::ParticleArray ParticleArray;
+    typedef typename ParticleArray::ParticleProxyType ParticleProxyType;
+
+    ParticleArray particles;
+    for (int i = 0; i < 10; i++)
+        particles.pushBack(this->randomParticle());
+    ParticleArray particlesCopy = particles;
+    particles.resize(25);
+    ASSERT_EQ(25, particles.size());
+    for (int i = 0; i < 10; i++)
+    {
+        ParticleProxyType particle(particles[i]), particleCopy(particlesCopy[i]);
+        EXPECT_TRUE(this->eqParticles_(particle, particleCopy));
+    }
+    for (int i = 10; i < 25; i++)
+        EXPECT_EQ(1.0, particles[i].getGamma());
+    particles.resize(5);
+    ASSERT_EQ(5, particles.size());
+}
+
+TYPED_TEST(ParticleArrayTest, MemoryAccounting)
+{
+    typedef typename ParticleArrayTest<TypeParam>::ParticleArray ParticleArray;
+
+    MemoryRegistry& registry = MemoryRegistry::instance();
+    const size_t bytes = registry.getStats(MemoryCategory::Particles).allocatedBytes;
+    {
+        ParticleArray particles;
+        for (int i = 0; i < 10; i++)
+            particles.pushBack(this->randomParticle());
+        ASSERT_LT(0u, particles.getMemoryUsage());
+        ASSERT_EQ(bytes + particles.getMemoryUsage(),
+            registry.getStats(MemoryCategory::Particles).allocatedBytes);
+    }
+    ASSERT_EQ(bytes, registry.getStats(MemoryCategory::Particles).allocatedBytes);
+}
+
+template <class ParticleArrayType>
+class SinglePrecisionParticleArrayTest : public ParticleArrayTest<ParticleArrayType> {
+};
+
+typedef ::testing::Types<
+    ParticleArray<Three, ParticleRepresentation_AoS, float>::Type,
+    ParticleArray<Three, ParticleRepresentation_SoA, float>::Type
+> singlePrecisionTypes;
+TYPED_TEST_CASE(SinglePrecisionParticleArrayTest, singlePrecisionTypes);
+
+TYPED_TEST(SinglePrecisionParticleArrayTest, MemoryUsageIsProportionalToPrecision)
+{
+    typedef typename ParticleArrayTest<TypeParam>::ParticleArray ParticleArray;
+    typedef typename pfc::ParticleArray<Three, ParticleArray::particleRepresentationType>::Type RealParticleArray;
+
+    ParticleArray particles;
+    RealParticleArray realParticles;
+    for (int i = 0; i < 100; i++)
+    {
+        auto particle = this->randomParticle();
+        particles.pushBack(particle);
+        realParticles.pushBack(Particle3d(particle.getPosition(), particle.getMomentum(),
+            particle.getWeight(), particle.getType()));
+    }
+    ASSERT_EQ(sizeof(float) * realParticles.getMemoryUsage(), sizeof(FP) * particles.getMemoryUsage());
+}
+
+TYPED_TEST(SinglePrecisionParticleArrayTest, AccessIsInRealPrecision)
+{
+    typedef typename ParticleArrayTest<TypeParam>::ParticleArray ParticleArray;
+
+    ParticleArray particles;
+    particles.pushBack(this->randomParticle());
+    const FP3 position(1.0 / 3.0, 2.0 / 3.0, 4.0 / 3.0);
+    const FP3 p(-0.1, 0.7, 1e3);
+    particles[0].setPosition(position);
+    particles[0].setP(p);
+    particles[0].setWeight(1.0 / 7.0);
+    FP3 storedPosition = particles[0].getPosition(), storedP = particles[0].getP();
+    for (int d = 0; d < 3; d++)
+    {
+        ASSERT_EQ((FP)(float)position[d], storedPosition[d]);
+        ASSERT_EQ((FP)(float)p[d], storedP[d]);
+    }
+    ASSERT_EQ((FP)(float)(1.0 / 7.0), particles[0].getWeight());
+    ASSERT_EQ((FP)(float)sqrt(1.0 + p.norm2()), particles[0].getGamma());
+}
+
+class CellParticleArrayTest : public ParticleArrayTest<ParticleArray<Three, ParticleRepresentation_CellSoA, float>::Type> {
+public:
+    CellParticleArrayTest() :
+        geometry(FP3(-1.0, -2.0, -3.0), FP3(0.1, 0.2, 0.3))
+    {}
+
+    CellGeometry geometry;
+};
+
+TEST_F(CellParticleArrayTest, CellPositionIsConsistentWithCoords)
+{
+    ParticleArray particles(Electron, geometry);
+    particles.pushBack(this->randomParticle());
+    const FP3 position(0.25, -0.7, 1.1);
+    particles[0].setPosition(position);
+    CellPosition cellPosition = particles[0].getCellPosition();
+    for (int d = 0; d < 3; d++)
+    {
+        ASSERT_LE(0.0, cellPosition.offset[d]);
+        ASSERT_GT(1.0, cellPosition.offset[d]);
+        ASSERT_NEAR(position[d], geometry.join(cellPosition.cell[d], cellPosition.offset[d], d),
+            geometry.steps[d] * 1e-6);
+    }
+
+    // offsets out of [0, 1) move the particle to the neighbouring cells
+    particles[0].setCellPosition(CellPosition(Int3(3, 4, 5), FP3(-0.5, 1.25, 0.5)));
+    cellPosition = particles.getCellPosition(0);
+    ASSERT_EQ(Int3(2, 5, 5), cellPosition.cell);
+    ASSERT_NEAR_FP3(FP3(0.5, 0.25, 0.5), cellPosition.offset);
+}
+
+TEST_F(CellParticleArrayTest, PrecisionDoesNotDependOnDistanceFromOrigin)
+{
+    // far from the origin a float position loses about 1e-2 cells, an offset in a cell does not
+    const FP3 shift(1e5, -1e5, 1e5);
+    const FP tolerance = 1e-5;
+    ParticleArray particles(Electron, geometry);
+    pfc::ParticleArray<Three, ParticleRepresentation_SoA, float>::Type floatParticles;
+    const int numParticles = 100;
+    std::vector<Particle3d> exactParticles(numParticles);
+    for (int i = 0; i < numParticles; i++)
+    {
+        exactParticles[i].setPosition(FP3(urand(-10, 10), urand(-10, 10), urand(-10, 10)) + shift);
+        // the positions are set through the proxies, pushBack would round them to float
+        particles.pushBack(this->randomParticle());
+        particles.back().setPosition(exactParticles[i].getPosition());
+        floatParticles.pushBack(this->randomParticle());
+        floatParticles.back().setPosition(exactParticles[i].getPosition());
+    }
+
+    FP maxCellError = 0, maxFloatError = 0;
+    for (int i = 0; i < numParticles; i++)
+    {
+        const FP3 exactPosition = exactParticles[i].getPosition();
+        const CellPosition cellPosition = particles.getCellPosition(i);
+        const FP3 floatPosition = floatParticles[i].getPosition();
+        for (int d = 0; d < 3; d++)
+        {
+            const FP exact = (exactPosition[d] - geometry.origin[d]) / geometry.steps[d];
+            maxCellError = std::max(maxCellError, std::fabs(exact - (cellPosition.cell[d] + cellPosition.offset[d])));
+            maxFloatError = std::max(maxFloatError,
+                std::fabs(exact - (floatPosition[d] - geometry.origin[d]) / geometry.steps[d]));
+        }
+    }
+    ASSERT_GT(tolerance, maxCellError);
+    ASSERT_LT(tolerance, maxFloatError);
+}
+
+TEST_F(CellParticleArrayTest, SetCellGeometryKeepsPositions)
+{
+    ParticleArray particles(Electron, geometry);
+    for (int i = 0; i < 10; i++)
+        particles.pushBack(this->randomParticle());
+    std::vector<FP3> positions;
+    for (int i = 0; i < particles.size(); i++)
+        positions.push_back(particles[i].getPosition());
+
+    const CellGeometry newGeometry(FP3(1.0, 1.0, 1.0), FP3(0.5, 0.25, 0.125));
+    particles.setCellGeometry(newGeometry);
+    ASSERT_TRUE(newGeometry == particles.getCellGeometry());
+    for (int i = 0; i < particles.size(); i++)
+        ASSERT_NEAR_FP3(positions[i], particles[i].getPosition());
+}
+
+TEST_F(CellParticleArrayTest, CanSaveAndLoad)
+{
+    ParticleArray particles(Electron, geometry), loadedParticles;
+    for (int i = 0; i < 10; i++)
+        particles.pushBack(this->randomParticle());
+    std::stringstream stream;
+    particles.save(stream);
+    loadedParticles.load(stream);
+
+    ASSERT_TRUE(geometry == loadedParticles.getCellGeometry());
+    ASSERT_TRUE(this->eqParticleArrays(particles, loadedParticles));
+    for (int i = 0; i < particles.size(); i++)
+    {
+        ASSERT_EQ(particles.getCellPosition(i).cell, loadedParticles.getCellPosition(i).cell);
+        ASSERT_EQ(particles.getCellPosition(i).offset, loadedParticles.getCellPosition(i).offset);
+    }
+}
@@ -205,3 +205,51 @@ TYPED_TEST(PusherTest, VayPusherOscillationInStaticMagneticField)
     PositionType finalPosition = { (FP)0, r_final , (FP)0 };
     ASSERT_NEAR_FP(finalPosition[1], r[1]);
 }
+
+template <class ParticleArrayType>
+class SinglePrecisionPusherTest : public ParticleArrayTest<ParticleArrayType> {
+};
+
+typedef ::testing::Types<
+    ParticleArray<Three, ParticleRepresentation_AoS, float>::Type,
+    ParticleArray<Three, ParticleRepresentation_SoA, float>::Type
+> singlePrecisionTypes;
+TYPED_TEST_CASE(SinglePrecisionPusherTest, singlePrecisionTypes);
+
+TYPED_TEST(SinglePrecisionPusherTest, BorisPusherIsCloseToRealPrecision)
+{
+    typedef typename ParticleArrayTest<TypeParam>::ParticleArray ParticleArray;
+    typedef typename pfc::ParticleArray<Three, ParticleArray::particleRepresentationType>::Type RealParticleArray;
+
+    ParticleArray particles;
+    RealParticleArray realParticles;
+    std::vector<ValueField> fields;
+    int numParticles = 12;
+    for (int i = 0; i < numParticles; i++)
+    {
+        auto particle = this->randomParticle();
+        particles.pushBack(particle);
+        realParticles.pushBack(Particle3d(particle.getPosition(), particle.getMomentum(),
+            particle.getWeight(), particle.getType()));
+        fields.push_back(ValueField(this->urandFP3(FP3(-1, -1, -1), FP3(1, 1, 1)),
+            this->urandFP3(FP3(-1, -1, -1), FP3(1, 1, 1))));
+    }
+
+    BorisPusher scalarPusher;
+    FP timeStep = 0.01;
+    for (int step = 0; step < 10; step++)
+    {
+        scalarPusher(&particles, fields, timeStep);
+        scalarPusher(&realParticles, fields, timeStep);
+    }
+
+    // the accumulated error stays at the level of a single rounding to float
+    const FP relativeError = 1e-6;
+    for (int i = 0; i < numParticles; i++)
+    {
+        FP3 position = particles[i].getPosition(), realPosition = realParticles[i].getPosition();
+        FP3 p = particles[i].getP(), realP = realParticles[i].getP();
+        ASSERT_LE((position - realPosition).norm(), relativeError * realPosition.norm());
+        ASSERT_LE((p - realP).norm(), relativeError * realP.norm());
+    }
+}
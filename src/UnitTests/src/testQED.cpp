@@ -0,0 +1,102 @@
+#include "TestingUtility.h"
+
+#include "AnalyticalField.h"
+#include "Ensemble.h"
+#include "ParticleArray.h"
+#include "Pusher.h"
+#include "QED_AEG.h"
+
+template <class TPusher, class TParticleArray>
+struct QEDParams {
+    typedef TPusher PusherType;
+    typedef TParticleArray ParticleArrayType;
+};
+
+template <class Params>
+class QEDTest : public BaseParticleFixture<typename Params::ParticleArrayType::ParticleType> {
+public:
+    typedef typename Params::PusherType PusherType;
+    typedef typename Params::ParticleArrayType ParticleArray;
+    typedef typename ParticleArray::ParticleType Particle;
+    typedef ScalarQED_AEG_only_electron<AnalyticalField, PusherType, ParticleArray> QEDType;
+
+    static FP zeroValue(FP x, FP y, FP z, FP t) { return 0.0; }
+
+    // electrons with gamma ~ 10^2..10^3
+    void addElectrons(Ensemble<ParticleArray>& particles, int numParticles)
+    {
+        const FP mc = constants::electronMass * constants::lightVelocity;
+        for (int i = 0; i < numParticles; i++) {
+            FP3 position = this->urandFP3(FP3(-1e-4, -1e-4, -1e-4), FP3(1e-4, 1e-4, 1e-4));
+            FP3 direction = this->urandFP3(FP3(-1, -1, -1), FP3(1, 1, 1));
+            direction.normalize();
+            particles.addParticle(Particle(position, this->urand(1e2, 1e3) * mc * direction, 1, Electron));
+        }
+    }
+};
+
+typedef ::testing::Types<
+    QEDParams<BorisPusher, ParticleArrayAoS3d>,
+    QEDParams<BorisPusher, ParticleArray3d>,
+    QEDParams<VayPusher, ParticleArrayAoS3d>,
+    QEDParams<VayPusher, ParticleArray3d>
+> types;
+TYPED_TEST_CASE(QEDTest, types);
+
+// far below the Schwinger field no photons are emitted and the particles are moved by the pusher
+TYPED_TEST(QEDTest, WeakFieldGivesPusherMotion)
+{
+    typedef typename QEDTest<TypeParam>::ParticleArray ParticleArray;
+    typedef typename QEDTest<TypeParam>::PusherType PusherType;
+
+    Ensemble<ParticleArray> particles, expectedParticles;
+    this->addElectrons(particles, 20);
+    expectedParticles = particles;
+
+    const FP fieldValue = 1.0, dt = 1e-17;
+    AnalyticalField field([fieldValue](FP, FP, FP, FP) { return fieldValue; }, this->zeroValue, this->zeroValue,
+        this->zeroValue, this->zeroValue, [fieldValue](FP, FP, FP, FP) { return fieldValue; });
+    typename QEDTest<TypeParam>::QEDType qed;
+    qed.processParticles(&particles, &field, dt);
+
+    PusherType pusher;
+    ValueField fieldAtParticle(FP3(fieldValue, 0, 0), FP3(0, 0, fieldValue));
+    for (int i = 0; i < expectedParticles[Electron].size(); i++) {
+        auto particle = expectedParticles[Electron][i];
+        pusher(&particle, fieldAtParticle, dt);
+    }
+
+    ASSERT_EQ(0, particles[Photon].size());
+    ASSERT_EQ(expectedParticles[Electron].size(), particles[Electron].size());
+    for (int i = 0; i < particles[Electron].size(); i++) {
+        ASSERT_NEAR_FP3(expectedParticles[Electron][i].getPosition(), particles[Electron][i].getPosition());
+        ASSERT_NEAR_FP3(expectedParticles[Electron][i].getP(), particles[Electron][i].getP());
+    }
+}
+
+// in a field of ~10^-3 of the Schwinger field the electrons emit photons,
+// the momentum of a photon is taken from the emitting electron
+TYPED_TEST(QEDTest, StrongFieldEmitsPhotons)
+{
+    typedef typename QEDTest<TypeParam>::ParticleArray ParticleArray;
+
+    Ensemble<ParticleArray> particles;
+    const int numElectrons = 100;
+    this->addElectrons(particles, numElectrons);
+
+    const FP fieldValue = 1e11, dt = 1e-17;
+    AnalyticalField field([fieldValue](FP, FP, FP, FP) { return fieldValue; }, this->zeroValue, this->zeroValue,
+        this->zeroValue, this->zeroValue, [fieldValue](FP, FP, FP, FP) { return fieldValue; });
+    typename QEDTest<TypeParam>::QEDType qed;
+    for (int step = 0; step < 10; step++)
+        qed.processParticles(&particles, &field, dt);
+
+    ASSERT_LT(0, particles[Photon].size());
+    ASSERT_LE(numElectrons, particles[Electron].size());
+    for (int i = 0; i < particles[Photon].size(); i++) {
+        ASSERT_EQ(Photon, particles[Photon][i].getType());
+        ASSERT_EQ(1.0, particles[Photon][i].getWeight());
+    }
+    for (int i = 0; i < particles[Electron].size(); i++)
+        ASSERT_LE(1.0, particles[Electron][i].getGamma());
+}
@@ -309,7 +309,10 @@ public:
         this->solver2->load(istr);
     }
 
-    bool compareFPVectors(const std::vector<FP>& v1, const std::vector<FP>& v2, const FP maxAbsError) {
+    // the pml arrays are vectors with a tracking allocator
+    template <class Allocator>
+    bool compareFPVectors(const std::vector<FP, Allocator>& v1, const std::vector<FP, Allocator>& v2,
+        const FP maxAbsError) {
         if (v1.size() != v2.size()) return false;
         for (int i = 0; i < v1.size(); i++)
             if (v1[i] - v2[i] < -maxAbsError || v1[i] - v2[i] >= maxAbsError) return false;
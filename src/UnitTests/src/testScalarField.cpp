@@ -1,6 +1,7 @@
 #include "TestingUtility.h"
 
 #include "ScalarField.h"
+#include "ScalarFieldView.h"
 
 template <class Data>
 class ScalarFieldTest : public BaseFixture {
@@ -47,6 +48,49 @@ TYPED_TEST(ScalarFieldTest, Assignment) {
 
 }
 
+TYPED_TEST(ScalarFieldTest, MoveConstructorAndAssignment) {
+    typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
+    Int3 size(5, 3, 8);
+    ScalarField f(this->createScalarField(size));
+    const TypeParam* data = f.getData();
+    ScalarField g(std::move(f));
+    ASSERT_EQ(data, g.getData());
+    ASSERT_EQ(size, g.getSize());
+    ASSERT_EQ(0, f.getSize().volume());
+
+    ScalarField h(Int3(1, 3, 2));
+    h = std::move(g);
+    ASSERT_EQ(data, h.getData());
+    ASSERT_EQ(0, g.getSize().volume());
+    for (int i = 0; i < size.x; i++)
+        for (int j = 0; j < size.y; j++)
+            for (int k = 0; k < size.z; k++)
+                ASSERT_EQ(h(i, j, k), k + (j + i * size.y) * size.z);
+}
+
+TYPED_TEST(ScalarFieldTest, View) {
+    typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
+    Int3 size(5, 3, 8);
+    ScalarField f(this->createScalarField(size));
+    ScalarFieldView<TypeParam> view(f);
+    ASSERT_EQ(size, view.getSize());
+    ASSERT_TRUE(view.isContiguous());
+
+    Int3 begin(1, 1, 2), boxSize(3, 2, 4);
+    ScalarFieldView<TypeParam> box = view.subView(begin, boxSize);
+    ScalarFieldView<const TypeParam> constBox(box);
+    ASSERT_EQ(boxSize, box.getSize());
+    ASSERT_FALSE(box.isContiguous());
+    for (int i = 0; i < boxSize.x; i++)
+        for (int j = 0; j < boxSize.y; j++)
+            for (int k = 0; k < boxSize.z; k++) {
+                ASSERT_EQ(f(begin + Int3(i, j, k)), box(i, j, k));
+                ASSERT_EQ(f(begin + Int3(i, j, k)), constBox(Int3(i, j, k)));
+            }
+    box(0, 0, 0) = -1;
+    ASSERT_EQ(-1, f(begin));
+}
+
 TYPED_TEST(ScalarFieldTest, IndexAccess) {
     typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
     Int3 size(5, 3, 8);
@@ -62,7 +106,7 @@ TYPED_TEST(ScalarFieldTest, IndexAccess) {
             }
 }
 
-/*TYPED_TEST(ScalarFieldTest, Zeroize) {
+TYPED_TEST(ScalarFieldTest, Zeroize) {
     typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
     Int3 size(5, 3, 8);
     ScalarField f(this->createScalarField(size));
@@ -72,4 +116,176 @@ TYPED_TEST(ScalarFieldTest, IndexAccess) {
         for (int j = 0; j < size.y; j++)
             for (int k = 0; k < size.z; k++)
                 ASSERT_EQ(f(i, j, k), 0);
-}*/
+}
+
+TYPED_TEST(ScalarFieldTest, AlignedStorage) {
+    typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
+    ScalarField f(Int3(5, 3, 7)), g(f);
+    ASSERT_EQ(0, (size_t)f.getData() % fieldAlignment);
+    ASSERT_EQ(0, (size_t)g.getData() % fieldAlignment);
+}
+
+TYPED_TEST(ScalarFieldTest, PaddedStorage) {
+    typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
+    Int3 size(5, 3, 7);
+    Int3 storageSize = ScalarField::getPaddedStorageSize(size);
+    ASSERT_EQ(size.x, storageSize.x);
+    ASSERT_EQ(size.y, storageSize.y);
+    ASSERT_LE(size.z, storageSize.z);
+    ASSERT_EQ(0, storageSize.z * sizeof(TypeParam) % fieldAlignment);
+    ASSERT_EQ(1, ScalarField::getPaddedStorageSize(Int3(5, 3, 1)).z);
+
+    ScalarField f(size, storageSize);
+    for (int i = 0; i < size.x; i++)
+        for (int j = 0; j < size.y; j++) {
+            ASSERT_EQ(0, (size_t)&f(i, j, 0) % fieldAlignment);
+            for (int k = 0; k < size.z; k++)
+                f(i, j, k) = k + (j + i * size.y) * size.z;
+        }
+    ScalarField g(f);
+    for (int i = 0; i < size.x; i++)
+        for (int j = 0; j < size.y; j++)
+            for (int k = 0; k < size.z; k++)
+                ASSERT_EQ(f(i, j, k), g(i, j, k));
+}
+
+TYPED_TEST(ScalarFieldTest, AllocationStats) {
+    typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
+    FieldAllocationRegistry& registry = FieldAllocationRegistry::instance();
+    const FieldAllocationStats before = registry.getStats();
+    {
+        ScalarField f(Int3(5, 3, 7));
+        const FieldAllocationStats stats = registry.getStats();
+        ASSERT_EQ(before.numAllocations + 1, stats.numAllocations);
+        ASSERT_EQ(before.allocatedBytes + 5 * 3 * 7 * sizeof(TypeParam), stats.allocatedBytes);
+        ASSERT_LE(stats.allocatedBytes, stats.peakAllocatedBytes);
+    }
+    ASSERT_EQ(before.numAllocations, registry.getStats().numAllocations);
+    ASSERT_EQ(before.allocatedBytes, registry.getStats().allocatedBytes);
+}
+
+TYPED_TEST(ScalarFieldTest, MemoryCategory) {
+    typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
+    MemoryRegistry& registry = MemoryRegistry::instance();
+    const MemoryStats fields = registry.getStats(MemoryCategory::Fields);
+    const MemoryStats solver = registry.getStats(MemoryCategory::FieldSolver);
+    const size_t bytes = 5 * 3 * 7 * sizeof(TypeParam);
+    {
+        ScalarField f(Int3(5, 3, 7));
+        ASSERT_EQ(fields.allocatedBytes + bytes, registry.getStats(MemoryCategory::Fields).allocatedBytes);
+        f.setMemoryCategory(MemoryCategory::FieldSolver);
+        ASSERT_EQ(MemoryCategory::FieldSolver, f.getMemoryCategory());
+        ASSERT_EQ(fields.allocatedBytes, registry.getStats(MemoryCategory::Fields).allocatedBytes);
+        ASSERT_EQ(solver.allocatedBytes + bytes, registry.getStats(MemoryCategory::FieldSolver).allocatedBytes);
+        ASSERT_EQ(solver.numAllocations + 1, registry.getStats(MemoryCategory::FieldSolver).numAllocations);
+
+        // a copy keeps the category of the original
+        ScalarField copy(f);
+        ASSERT_EQ(solver.allocatedBytes + 2 * bytes, registry.getStats(MemoryCategory::FieldSolver).allocatedBytes);
+    }
+    ASSERT_EQ(fields.allocatedBytes, registry.getStats(MemoryCategory::Fields).allocatedBytes);
+    ASSERT_EQ(solver.allocatedBytes, registry.getStats(MemoryCategory::FieldSolver).allocatedBytes);
+    ASSERT_EQ(solver.numAllocations, registry.getStats(MemoryCategory::FieldSolver).numAllocations);
+}
+
+TYPED_TEST(ScalarFieldTest, HugePages) {
+    typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
+    FieldAllocationRegistry& registry = FieldAllocationRegistry::instance();
+    const size_t hugePageBytes = registry.getStats().hugePageBytes;
+    registry.setHugePagesPolicy(HugePagesPolicy::Advised);
+    {
+        Int3 size(64, 64, 80);
+        ScalarField f(size), small(Int3(5, 3, 7));
+        ASSERT_EQ(0, (size_t)f.getData() % hugePageSize);
+        ASSERT_EQ(hugePageBytes + size.volume() * sizeof(TypeParam), registry.getStats().hugePageBytes);
+        for (int i = 0; i < size.x; i++)
+            for (int j = 0; j < size.y; j++)
+                for (int k = 0; k < size.z; k++)
+                    ASSERT_EQ(0, f(i, j, k));
+
+        // the placement is unknown without NUMA support
+        std::vector<size_t> placement = f.getNumaPlacement();
+        size_t numPages = 0;
+        for (size_t node = 0; node < placement.size(); node++)
+            numPages += placement[node];
+        if (!placement.empty()) {
+            ASSERT_LT(0u, numPages);
+        }
+    }
+    registry.setHugePagesPolicy(HugePagesPolicy::Default);
+    ASSERT_EQ(hugePageBytes, registry.getStats().hugePageBytes);
+}
+
+TYPED_TEST(ScalarFieldTest, SharedWeightInterpolation) {
+    typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
+    const Int3 sizes[3] = { Int3(9, 8, 7), Int3(9, 8, 1), Int3(9, 1, 1) };
+    for (int s = 0; s < 3; s++) {
+        ScalarField f(sizes[s]), g(sizes[s]);
+        for (int i = 0; i < sizes[s].x; i++)
+            for (int j = 0; j < sizes[s].y; j++)
+                for (int k = 0; k < sizes[s].z; k++) {
+                    f(i, j, k) = this->urand(-1.0, 1.0);
+                    g(i, j, k) = this->urand(-1.0, 1.0);
+                }
+        const ScalarField* fields[2] = { &f, &g };
+        for (int testIdx = 0; testIdx < 20; testIdx++) {
+            Int3 baseIdx;
+            for (int d = 0; d < 3; d++)
+                baseIdx[d] = sizes[s][d] > 1 ? this->urandInt(2, sizes[s][d] - 4) : 0;
+            const FP3 coeffs = this->urandFP3(FP3(0, 0, 0), FP3(1, 1, 1));
+            FP result[2];
+
+            InterpolationStencil<2> cic;
+            f.getStencilCIC(baseIdx, coeffs, false, cic);
+            ScalarField::template interpolate<2>(fields, cic, result);
+            ASSERT_NEAR_FP(f.interpolateCIC(baseIdx, coeffs), result[0]);
+            ASSERT_NEAR_FP(g.interpolateCIC(baseIdx, coeffs), result[1]);
+
+            InterpolationStencil<3> tsc, secondOrder;
+            f.getStencilTSC(baseIdx, coeffs, false, tsc);
+            ScalarField::template interpolate<2>(fields, tsc, result);
+            ASSERT_NEAR_FP(f.interpolateTSC(baseIdx, coeffs), result[0]);
+            ASSERT_NEAR_FP(g.interpolateTSC(baseIdx, coeffs), result[1]);
+            f.getStencilSecondOrder(baseIdx, coeffs, false, secondOrder);
+            ScalarField::template interpolate<2>(fields, secondOrder, result);
+            ASSERT_NEAR_FP(f.interpolateSecondOrder(baseIdx, coeffs), result[0]);
+            ASSERT_NEAR_FP(g.interpolateSecondOrder(baseIdx, coeffs), result[1]);
+
+            InterpolationStencil<4> pcs;
+            f.getStencilPCS(baseIdx, coeffs, false, pcs);
+            ScalarField::template interpolate<2>(fields, pcs, result);
+            ASSERT_NEAR_FP(f.interpolatePCS(baseIdx, coeffs), result[0]);
+            ASSERT_NEAR_FP(g.interpolatePCS(baseIdx, coeffs), result[1]);
+
+            InterpolationStencil<5> fourthOrder;
+            f.getStencilFourthOrder(baseIdx, coeffs, false, fourthOrder);
+            ScalarField::template interpolate<2>(fields, fourthOrder, result);
+            ASSERT_NEAR_FP(f.interpolateFourthOrder(baseIdx, coeffs), result[0]);
+            ASSERT_NEAR_FP(g.interpolateFourthOrder(baseIdx, coeffs), result[1]);
+        }
+    }
+}
+
+TYPED_TEST(ScalarFieldTest, SharedWeightInterpolationPeriodic) {
+    typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
+    const Int3 size(6, 5, 4);
+    ScalarField f = this->createScalarField(size);
+    const ScalarField* fields[1] = { &f };
+    const FP3 coeffs(0.25, 0.5, 0.75);
+    FP result;
+    // the nodes of the last cell wrap around to the first ones, as in interpolateCIC
+    InterpolationStencil<2> cic;
+    f.getStencilCIC(size - Int3(1, 1, 1), coeffs, true, cic);
+    ScalarField::template interpolate<1>(fields, cic, &result);
+    ASSERT_NEAR_FP(f.interpolateCIC(size - Int3(1, 1, 1), coeffs), result);
+    // the TSC stencil at the first node is shifted by one period
+    InterpolationStencil<3> shifted, inside;
+    f.getStencilTSC(Int3(0, 0, 0), coeffs, true, shifted);
+    f.getStencilTSC(size, coeffs, true, inside);
+    for (int d = 0; d < 3; d++)
+        for (int i = 0; i < 3; i++) {
+            ASSERT_EQ(inside.index[d][i], shifted.index[d][i]);
+            ASSERT_LE(0, shifted.index[d][i]);
+            ASSERT_GT(size[d], shifted.index[d][i]);
+        }
+}
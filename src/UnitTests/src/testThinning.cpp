@@ -4,9 +4,22 @@
 #include "ParticleArray.h"
 #include "Thinning.h"
 
+#include <algorithm>
 
 using namespace pfc;
 
+// conservative thinning only changes weights: the removed particles have zero weight
+// and are deleted, the other ones keep their momenta
+template <class ParticleArray>
+void checkThinnedParticles(ParticleArray& particles, const std::vector<FP3>& originalMomenta)
+{
+    for (int i = 0; i < particles.size(); i++) {
+        ASSERT_LT(0, particles[i].getWeight());
+        const FP3 momentum = particles[i].getMomentum();
+        ASSERT_TRUE(std::find(originalMomenta.begin(), originalMomenta.end(), momentum) != originalMomenta.end());
+    }
+}
+
 typedef ::testing::Types<
     ParticleArray<Three, ParticleRepresentation_AoS>::Type,
     ParticleArray<Three, ParticleRepresentation_SoA>::Type
@@ -82,4 +95,107 @@ TYPED_TEST(ThinningTest, energyConservativeThinning)
     FP modifiedTotalEnergy = this->totalEnergy(particles);
     ASSERT_NEAR_FP(originalTotalEnergy, modifiedTotalEnergy);
     ASSERT_TRUE(particles.size() <= numberParticles / 2);
-}
\ No newline at end of file
+}
+
+TYPED_TEST(ThinningTest, simpleParallelThinning)
+{
+    typedef typename ThinningTest<TypeParam>::ParticleArray ParticleArray;
+
+    Thinning<ParticleArray> thin;
+
+    ParticleArray particles;
+    int numberParticles = 1000;
+    this->addRandomParticlesWithSameWeight(particles, numberParticles);
+    FP originalTotalWeight = this->totalWeight(particles);
+
+    thin.simpleParallel(particles, numberParticles / 2);
+
+    FP modifiedTotalWeight = this->totalWeight(particles);
+    ASSERT_NEAR_FP(originalTotalWeight, modifiedTotalWeight);
+    ASSERT_TRUE(particles.size() == numberParticles / 2);
+}
+
+TYPED_TEST(ThinningTest, numberConservativeParallelThinning)
+{
+    typedef typename ThinningTest<TypeParam>::ParticleArray ParticleArray;
+
+    Thinning<ParticleArray> thin;
+
+    ParticleArray particles;
+    int numberParticles = 1000;
+    this->addRandomParticles(particles, numberParticles);
+    FP originalTotalWeight = this->totalWeight(particles);
+
+    thin.numberConservativeParallel(particles, numberParticles / 2);
+
+    FP modifiedTotalWeight = this->totalWeight(particles);
+    ASSERT_NEAR_FP(originalTotalWeight, modifiedTotalWeight);
+    ASSERT_TRUE(particles.size() <= numberParticles / 2);
+}
+
+TYPED_TEST(ThinningTest, energyConservativeParallelThinning)
+{
+    typedef typename ThinningTest<TypeParam>::ParticleArray ParticleArray;
+
+    Thinning<ParticleArray> thin;
+
+    ParticleArray particles;
+    int numberParticles = 1000;
+    this->addRandomParticles(particles, numberParticles);
+    FP originalTotalEnergy = this->totalEnergy(particles);
+
+    thin.energyConservativeParallel(particles, numberParticles / 2);
+
+    FP modifiedTotalEnergy = this->totalEnergy(particles);
+    ASSERT_NEAR_FP(originalTotalEnergy, modifiedTotalEnergy);
+    ASSERT_TRUE(particles.size() <= numberParticles / 2);
+}
+
+TYPED_TEST(ThinningTest, conservativeThinning)
+{
+    typedef typename ThinningTest<TypeParam>::ParticleArray ParticleArray;
+
+    Thinning<ParticleArray> thin;
+
+    ParticleArray particles;
+    int numberParticles = 200;
+    this->addRandomParticles(particles, numberParticles);
+    FP originalTotalWeight = this->totalWeight(particles);
+    FP3 originalTotalMomentum = this->totalMomentum(particles);
+    std::vector<FP3> originalMomenta;
+    for (int i = 0; i < particles.size(); i++)
+        originalMomenta.push_back(particles[i].getMomentum());
+
+    std::set<typename Thinning<ParticleArray>::Features> features = { Thinning<ParticleArray>::Momentum };
+    thin.thinningConservative(particles, numberParticles / 2, features);
+
+    ASSERT_NEAR_FP(originalTotalWeight, this->totalWeight(particles));
+    ASSERT_NEAR_FP3(originalTotalMomentum, this->totalMomentum(particles));
+    ASSERT_TRUE(particles.size() < numberParticles);
+    checkThinnedParticles(particles, originalMomenta);
+}
+
+TYPED_TEST(ThinningTest, conservativeThinningInCells)
+{
+    typedef typename ThinningTest<TypeParam>::ParticleArray ParticleArray;
+
+    Thinning<ParticleArray> thin;
+
+    ParticleArray particles;
+    int numberParticles = 800;
+    this->addRandomParticles(particles, numberParticles);
+    FP originalTotalWeight = this->totalWeight(particles);
+    FP3 originalTotalMomentum = this->totalMomentum(particles);
+    std::vector<FP3> originalMomenta;
+    for (int i = 0; i < particles.size(); i++)
+        originalMomenta.push_back(particles[i].getMomentum());
+
+    std::set<typename Thinning<ParticleArray>::Features> features = { Thinning<ParticleArray>::Momentum };
+    FP3 minCoords(-10, -10, -10), cellSize(10, 10, 10);
+    thin.thinningConservativeInCells(particles, numberParticles / 2, features, minCoords, cellSize, Int3(2, 2, 2));
+
+    ASSERT_NEAR_FP(originalTotalWeight, this->totalWeight(particles));
+    ASSERT_NEAR_FP3(originalTotalMomentum, this->totalMomentum(particles));
+    ASSERT_TRUE(particles.size() < numberParticles);
+    checkThinnedParticles(particles, originalMomenta);
+}
@@ -1,42 +1,176 @@
 #pragma once
 #include "pyFieldInterface.h"
 #include "ScalarField.h"
+#include "ScalarFieldView.h"
 #include "Mapping.h"
+#include "CompiledMapping.h"
 
 #include "pybind11/pybind11.h"
 #include "pybind11/numpy.h"
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
 namespace py = pybind11;
 using namespace pybind11::literals;
 
 namespace pfc
 {
-    // wrapper over ScalarField class object
+    /* Read barrier for the field updates started by update_fields_async.
+    While an update runs on the worker thread, any other thread accessing a grid
+    or a field solver waits for its end, so Python never sees half-updated grids.
+    Only one asynchronous update runs at a time. The update reaches no Python callable
+    (field generators are C function pointers) and never takes the GIL; a thread holding
+    the GIL releases it while waiting, so that the other Python threads keep running.
+    The updated object is owned by the barrier and released on a thread holding the GIL,
+    never on the worker thread. */
+    class pyFieldUpdateBarrier {
+    public:
+
+        // never destroyed, so that the owned object is not released after the interpreter finalization
+        static pyFieldUpdateBarrier& instance() {
+            static pyFieldUpdateBarrier* barrier = new pyFieldUpdateBarrier();
+            return *barrier;
+        }
+
+        // the worker calls update, owner keeps the updated object alive until the end of the update
+        std::shared_future<void> start(const std::function<void()>& update, const std::shared_ptr<void>& owner) {
+            wait();
+            std::lock_guard<std::mutex> lock(mutex);
+            this->owner = owner;
+            inProgress.store(true, std::memory_order_release);
+            future = std::async(std::launch::async, [this, update]() {
+                isWorkerThread() = true;
+                struct Finisher {
+                    std::atomic<bool>& flag;
+                    ~Finisher() { flag.store(false, std::memory_order_release); }
+                } finisher{ inProgress };
+                update();
+            }).share();
+            return future;
+        }
+
+        void wait() {
+            if (isWorkerThread())
+                return;
+            const bool hasGIL = PyGILState_Check() != 0;
+            if (inProgress.load(std::memory_order_acquire)) {
+                std::shared_future<void> pending;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    pending = future;
+                }
+                if (pending.valid()) {
+                    if (hasGIL) {
+                        py::gil_scoped_release release;
+                        pending.wait();
+                    }
+                    else
+                        pending.wait();
+                }
+            }
+            // the update is finished, the object may be released only with the GIL
+            if (hasGIL) {
+                std::shared_ptr<void> finishedOwner;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!inProgress.load(std::memory_order_acquire))
+                        finishedOwner.swap(owner);
+                }
+            }
+        }
+
+    private:
+
+        pyFieldUpdateBarrier() : inProgress(false) {}
+
+        static bool& isWorkerThread() {
+            static thread_local bool flag = false;
+            return flag;
+        }
+
+        std::atomic<bool> inProgress;
+        std::mutex mutex;
+        std::shared_future<void> future;
+        std::shared_ptr<void> owner;
+    };
+
+    // handle of an asynchronous field update returned to Python
+    class pyFieldUpdateHandle {
+    public:
+
+        pyFieldUpdateHandle(const std::shared_future<void>& future) : future(future) {}
+
+        // waits for the end of the update, rethrows its exception if any
+        void wait() const {
+            py::gil_scoped_release release;
+            future.get();
+        }
+
+        bool isDone() const {
+            return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+
+    private:
+
+        std::shared_future<void> future;
+    };
+
+    // wrapper over a view of ScalarField class object or of its box
     class pyScalarField {
     public:
 
-        pyScalarField(ScalarField<FP>* scalarField) :scalarField(scalarField) {}
+        pyScalarField(ScalarField<FP>* scalarField) : view(*scalarField) {}
+        pyScalarField(const ScalarFieldView<FP>& view) : view(view) {}
 
         FP* getData() const {
-            return scalarField->getData();
+            return view.getData();
         }
 
         Int3 getSize() const {
-            return scalarField->getSize();
+            return view.getSize();
+        }
+
+        Int3 getMemSize() const {
+            return view.getMemSize();
+        }
+
+        // logical shape with strides of the storage, so that padded fields and boxes are viewed correctly
+        std::vector<py::ssize_t> getShape() const {
+            return { getSize().x, getSize().y, getSize().z };
+        }
+
+        std::vector<py::ssize_t> getStrides() const {
+            return { (py::ssize_t)sizeof(FP) * getMemSize().y * getMemSize().z,
+                (py::ssize_t)sizeof(FP) * getMemSize().z, (py::ssize_t)sizeof(FP) };
+        }
+
+        // box [begin, begin + size) sharing the storage
+        std::shared_ptr<pyScalarField> getSubArray(const FP3& begin, const FP3& size) const {
+            const Int3 boxBegin = (Int3)begin, boxSize = (Int3)size;
+            for (int d = 0; d < 3; d++)
+                if (boxBegin[d] < 0 || boxSize[d] < 0 || boxBegin[d] + boxSize[d] > getSize()[d])
+                    throw py::index_error("the box is out of the array");
+            return std::make_shared<pyScalarField>(view.subView(boxBegin, boxSize));
         }
 
         // read-only accessors
         FP get(const Int3& index) const {
-            return (*scalarField)(index);
+            return view(index);
         }
 
         FP get(int i, int j, int k) const {
-            return (*scalarField)(i, j, k);
+            return view(i, j, k);
         }
 
     private:
 
-        ScalarField<FP>* scalarField;
+        ScalarFieldView<FP> view;
     };
 
 
@@ -68,11 +202,19 @@ namespace pfc
         virtual void updateFields() = 0;
         virtual void advance(FP dt) = 0;
 
+        // the worker gets a raw pointer, the last reference to the field is never dropped on it
+        static pyFieldUpdateHandle updateFieldsAsync(const std::shared_ptr<pyFieldBase>& self) {
+            pyFieldBase* field = self.get();
+            return pyFieldUpdateHandle(pyFieldUpdateBarrier::instance().start(
+                [field]() { field->updateFields(); }, self));
+        }
+
         virtual std::shared_ptr<pyFieldBase> applyMapping(
             const std::shared_ptr<pyFieldBase>& self,
             const std::shared_ptr<Mapping>& mapping) const = 0;
 
-        // functions to get cross sections
+        // functions to get cross sections,
+        // the points of a section are evaluated as one batch
         py::array_t<FP> getSlice1d(
             CoordinateEnum crossAxis1, FP pos1,
             CoordinateEnum crossAxis2, FP pos2,
@@ -80,15 +222,18 @@ namespace pfc
             FP(pyFieldBase::*getFieldValue)(const FP3&) const)
         {
             py::array_t<FP> res({ size });
-            auto accRes = res.mutable_unchecked<1>();
+            FP* resData = res.mutable_data();
             FP step = (maxCoord - minCoord) / (FP)size;
-            OMP_FOR()
-            for (py::ssize_t i = 0; i < size; i++) {
-                FP3 coords;
-                coords[(int)crossAxis1] = pos1;
-                coords[(int)crossAxis1] = pos2;
-                coords[(int)axis] = minCoord + step * i;
-                accRes(i) = (this->*getFieldValue)(coords);
+            {
+                py::gil_scoped_release release;
+                std::vector<FP3> points(size);
+                OMP_FOR()
+                for (py::ssize_t i = 0; i < size; i++) {
+                    points[i][(int)crossAxis1] = pos1;
+                    points[i][(int)crossAxis2] = pos2;
+                    points[i][(int)axis] = minCoord + step * i;
+                }
+                getFieldComponentValues(points, resData, getFieldValue);
             }
             return res;
         }
@@ -100,21 +245,71 @@ namespace pfc
             FP(pyFieldBase::* getFieldValue)(const FP3&) const)
         {
             py::array_t<FP> res({ size1, size2 });
-            auto accRes = res.mutable_unchecked<2>();
+            FP* resData = res.mutable_data();
             FP step1 = (maxCoord1 - minCoord1) / (FP)size1,
                 step2 = (maxCoord2 - minCoord2) / (FP)size2;
-            OMP_FOR()
-            for (py::ssize_t i = 0; i < size1; i++)
-                for (py::ssize_t j = 0; j < size2; j++) {
-                    FP3 coords;
-                    coords[(int)crossAxis] = pos;
-                    coords[(int)axis1] = minCoord1 + step1 * i;
-                    coords[(int)axis2] = minCoord2 + step2 * j;
-                    accRes(i, j) = (this->*getFieldValue)(coords);
+            {
+                py::gil_scoped_release release;
+                std::vector<FP3> points(size1 * size2);
+                OMP_FOR()
+                for (py::ssize_t i = 0; i < size1; i++)
+                    for (py::ssize_t j = 0; j < size2; j++) {
+                        FP3& coords = points[i * size2 + j];
+                        coords[(int)crossAxis] = pos;
+                        coords[(int)axis1] = minCoord1 + step1 * i;
+                        coords[(int)axis2] = minCoord2 + step2 * j;
+                    }
+                getFieldComponentValues(points, resData, getFieldValue);
+            }
+            return res;
+        }
+
+        // evaluates a vector field in an array of points of shape (N, 3),
+        // the work is done in parallel without the GIL
+        py::array_t<FP> getFieldArray(
+            const py::array_t<FP, py::array::c_style | py::array::forcecast>& coords,
+            FP3(pyFieldBase::* getFieldValue)(const FP3&) const) const
+        {
+            if (coords.ndim() != 2 || coords.shape(1) != 3)
+                throw py::value_error("coords must have shape (N, 3)");
+            const py::ssize_t size = coords.shape(0);
+            py::array_t<FP> res({ size, (py::ssize_t)3 });
+            const FP* coordsData = coords.data();
+            FP* resData = res.mutable_data();
+            {
+                py::gil_scoped_release release;
+                std::vector<FP3> points(size), values(size);
+                OMP_FOR()
+                for (py::ssize_t i = 0; i < size; i++)
+                    points[i] = FP3(coordsData[3 * i], coordsData[3 * i + 1], coordsData[3 * i + 2]);
+                getFieldValues(points.data(), values.data(), (int)size, getFieldValue);
+                OMP_FOR()
+                for (py::ssize_t i = 0; i < size; i++) {
+                    resData[3 * i] = values[i].x;
+                    resData[3 * i + 1] = values[i].y;
+                    resData[3 * i + 2] = values[i].z;
                 }
+            }
             return res;
         }
 
+        // values of the field in the points, fields with a faster batch path override it
+        virtual void getFieldValues(const FP3* coords, FP3* values, int size,
+            FP3(pyFieldBase::* getFieldValue)(const FP3&) const) const
+        {
+            OMP_FOR()
+            for (int i = 0; i < size; i++)
+                values[i] = (this->*getFieldValue)(coords[i]);
+        }
+
+        // values of E, B and J in the points at once, null outputs are skipped
+        virtual void getEBJValues(const FP3* coords, FP3* e, FP3* b, FP3* j, int size) const
+        {
+            if (e) getFieldValues(coords, e, size, &pyFieldBase::getE);
+            if (b) getFieldValues(coords, b, size, &pyFieldBase::getB);
+            if (j) getFieldValues(coords, j, size, &pyFieldBase::getJ);
+        }
+
         py::array_t<FP> getSlice3d(
             CoordinateEnum axis1, FP minCoord1, FP maxCoord1, size_t size1,
             CoordinateEnum axis2, FP minCoord2, FP maxCoord2, size_t size2,
@@ -122,22 +317,62 @@ namespace pfc
             FP(pyFieldBase::*getFieldValue)(const FP3&) const)
         {
             py::array_t<FP> res({ size1, size2, size3 });
-            auto accRes = res.mutable_unchecked<3>();
+            FP* resData = res.mutable_data();
             FP step1 = (maxCoord1 - minCoord1) / (FP)size1,
                 step2 = (maxCoord2 - minCoord2) / (FP)size2,
                 step3 = (maxCoord3 - minCoord3) / (FP)size3;
-            OMP_FOR()
-            for (py::ssize_t i = 0; i < size1; i++)
-                for (py::ssize_t j = 0; j < size2; j++)
-                    for (py::ssize_t k = 0; k < size3; k++) {
-                        FP3 coords;
-                        coords[(int)axis1] = minCoord1 + step1 * i;
-                        coords[(int)axis2] = minCoord2 + step2 * j;
-                        coords[(int)axis3] = minCoord3 + step3 * k;
-                        accRes(i, j, k) = (this->*getFieldValue)(coords);
-                    }
+            {
+                py::gil_scoped_release release;
+                std::vector<FP3> points(size1 * size2 * size3);
+                OMP_FOR()
+                for (py::ssize_t i = 0; i < size1; i++)
+                    for (py::ssize_t j = 0; j < size2; j++)
+                        for (py::ssize_t k = 0; k < size3; k++) {
+                            FP3& coords = points[(i * size2 + j) * size3 + k];
+                            coords[(int)axis1] = minCoord1 + step1 * i;
+                            coords[(int)axis2] = minCoord2 + step2 * j;
+                            coords[(int)axis3] = minCoord3 + step3 * k;
+                        }
+                getFieldComponentValues(points, resData, getFieldValue);
+            }
             return res;
         }
+
+    private:
+
+        // a component getter is evaluated through the batch path of its vector field,
+        // so mapped fields map the points with getInverseCoordsBatch
+        void getFieldComponentValues(const std::vector<FP3>& points, FP* values,
+            FP(pyFieldBase::* getFieldValue)(const FP3&) const) const
+        {
+            typedef FP(pyFieldBase::* ComponentGetter)(const FP3&) const;
+            typedef FP3(pyFieldBase::* VectorGetter)(const FP3&) const;
+            static const ComponentGetter componentGetters[9] = {
+                &pyFieldBase::getEx, &pyFieldBase::getEy, &pyFieldBase::getEz,
+                &pyFieldBase::getBx, &pyFieldBase::getBy, &pyFieldBase::getBz,
+                &pyFieldBase::getJx, &pyFieldBase::getJy, &pyFieldBase::getJz
+            };
+            static const VectorGetter vectorGetters[3] = {
+                &pyFieldBase::getE, &pyFieldBase::getB, &pyFieldBase::getJ
+            };
+
+            const int size = (int)points.size();
+            int index = 0;
+            while (index < 9 && componentGetters[index] != getFieldValue) index++;
+            if (index == 9) {
+                OMP_FOR()
+                for (int i = 0; i < size; i++)
+                    values[i] = (this->*getFieldValue)(points[i]);
+                return;
+            }
+
+            std::vector<FP3> vectorValues(size);
+            getFieldValues(points.data(), vectorValues.data(), size, vectorGetters[index / 3]);
+            const int component = index % 3;
+            OMP_FOR()
+            for (int i = 0; i < size; i++)
+                values[i] = vectorValues[i][component];
+        }
     };
 
 
@@ -168,9 +403,11 @@ namespace pfc
         {}
 
         inline typename TFieldSolver::GridType* getGrid() const {
+            pyFieldUpdateBarrier::instance().wait();
             return grid.get();
         }
         inline TFieldSolver* getFieldSolver() const {
+            pyFieldUpdateBarrier::instance().wait();
             return fieldSolver.get();
         }
         inline FP3 convertCoords(const FP3& coords) const {
@@ -235,6 +472,20 @@ namespace pfc
             return BaseInterface::advance(dt);
         }
 
+        // analytical fields call batch functions once per chunk of points,
+        // grid fields choose the interpolation once per call
+        void getFieldValues(const FP3* coords, FP3* values, int size,
+            FP3(pyFieldBase::* getFieldValue)(const FP3&) const) const override
+        {
+            if (getFieldValue == &pyFieldBase::getE)
+                BaseInterface::getFieldValuesBatch(coords, values, size, FieldEnum::E);
+            else if (getFieldValue == &pyFieldBase::getB)
+                BaseInterface::getFieldValuesBatch(coords, values, size, FieldEnum::B);
+            else if (getFieldValue == &pyFieldBase::getJ)
+                BaseInterface::getFieldValuesBatch(coords, values, size, FieldEnum::J);
+            else pyFieldBase::getFieldValues(coords, values, size, getFieldValue);
+        }
+
         std::shared_ptr<pyField<TFieldSolver>> zoom(const FP3& minCoord,
             const FP3& zoomedGridSize, const FP3& zoomedGridStep) const {
             std::shared_ptr<pyField<TFieldSolver>> zoomedField;
@@ -246,23 +497,37 @@ namespace pfc
             return zoomedField;
         }
 
+        /* The arrays share the storage of the grid and can be written. The grid is
+        marked as changed when a view of E or B is taken, but the writes through a view
+        taken earlier are not seen by the grid: after them mark_fields_changed() has
+        to be called, otherwise the interleaved E/B records of the gathers are stale. */
+        void markFieldsChanged() {
+            this->getGrid()->markFieldsChanged();
+        }
+
         std::shared_ptr<pyScalarField> getExArray() {
+            this->getGrid()->markFieldsChanged();
             return std::make_shared<pyScalarField>(&(this->getGrid()->Ex));
         }
         std::shared_ptr<pyScalarField> getEyArray() {
+            this->getGrid()->markFieldsChanged();
             return std::make_shared<pyScalarField>(&(this->getGrid()->Ey));
         }
         std::shared_ptr<pyScalarField> getEzArray() {
+            this->getGrid()->markFieldsChanged();
             return std::make_shared<pyScalarField>(&(this->getGrid()->Ez));
         }
 
         std::shared_ptr<pyScalarField> getBxArray() {
+            this->getGrid()->markFieldsChanged();
             return std::make_shared<pyScalarField>(&(this->getGrid()->Bx));
         }
         std::shared_ptr<pyScalarField> getByArray() {
+            this->getGrid()->markFieldsChanged();
             return std::make_shared<pyScalarField>(&(this->getGrid()->By));
         }
         std::shared_ptr<pyScalarField> getBzArray() {
+            this->getGrid()->markFieldsChanged();
             return std::make_shared<pyScalarField>(&(this->getGrid()->Bz));
         }
 
@@ -277,7 +542,7 @@ namespace pfc
         }
     
     private:
-   
+
         std::unique_ptr<typename TFieldSolver::GridType> grid;
         std::unique_ptr<TFieldSolver> fieldSolver;
     
@@ -303,32 +568,29 @@ namespace pfc
 
     public:
 
+        // the chain of wrapped fields is resolved once here: the mappings are compiled
+        // into a flat program and the underlying pyField is stored
         pyMappedField(const std::shared_ptr<pyFieldBase>& other,
             const std::shared_ptr<Mapping>& mapping) :
             pyWrappedField(other), mapping(mapping)
-        {}
-
-        inline TFieldSolver* getFieldSolver() const {
-            std::shared_ptr<pyField<TFieldSolver>> pyFieldPointer =
-                std::dynamic_pointer_cast<pyField<TFieldSolver>>(pyWrappedField);
-            if (pyFieldPointer) return pyFieldPointer->getFieldSolver();
+        {
+            pyRootField = std::dynamic_pointer_cast<pyField<TFieldSolver>>(pyWrappedField);
 
             std::shared_ptr<pyMappedField<TFieldSolver>> pyMappedFieldPointer =
                 std::dynamic_pointer_cast<pyMappedField<TFieldSolver>>(pyWrappedField);
-            if (pyMappedFieldPointer) return pyMappedFieldPointer->getFieldSolver();
+            if (pyMappedFieldPointer) {
+                pyRootField = pyMappedFieldPointer->pyRootField;
+                compiledMapping = pyMappedFieldPointer->compiledMapping;
+            }
 
-            return nullptr;
+            if (mapping) compiledMapping.append(mapping);
         }
-        inline typename TFieldSolver::GridType* getGrid() const {
-            std::shared_ptr<pyField<TFieldSolver>> pyFieldPointer =
-                std::dynamic_pointer_cast<pyField<TFieldSolver>>(pyWrappedField);
-            if (pyFieldPointer) return pyFieldPointer->getGrid();
 
-            std::shared_ptr<pyMappedField<TFieldSolver>> pyMappedFieldPointer =
-                std::dynamic_pointer_cast<pyMappedField<TFieldSolver>>(pyWrappedField);
-            if (pyMappedFieldPointer) return pyMappedFieldPointer->getGrid();
-
-            return nullptr;
+        inline TFieldSolver* getFieldSolver() const {
+            return pyRootField ? pyRootField->getFieldSolver() : nullptr;
+        }
+        inline typename TFieldSolver::GridType* getGrid() const {
+            return pyRootField ? pyRootField->getGrid() : nullptr;
         }
 
         inline FP3 convertCoords(const FP3& coords) const {
@@ -394,32 +656,63 @@ namespace pfc
             return BaseInterface::advance(dt);
         }
 
+        // the points are mapped by chunks with the batch version of the compiled mapping
+        void getFieldValues(const FP3* coords, FP3* values, int size,
+            FP3(pyFieldBase::* getFieldValue)(const FP3&) const) const override
+        {
+            FP3(BaseInterface::* getBaseFieldValue)(const FP3&) const = 0;
+            if (getFieldValue == &pyFieldBase::getE) getBaseFieldValue = &BaseInterface::getE;
+            else if (getFieldValue == &pyFieldBase::getB) getBaseFieldValue = &BaseInterface::getB;
+            else if (getFieldValue == &pyFieldBase::getJ) getBaseFieldValue = &BaseInterface::getJ;
+            else return pyFieldBase::getFieldValues(coords, values, size, getFieldValue);
+
+            const FP time = getFieldSolver()->getTime();
+            const int chunkSize = 256;
+            const int numChunks = (size + chunkSize - 1) / chunkSize;
+            OMP_FOR()
+            for (int chunk = 0; chunk < numChunks; chunk++) {
+                const int begin = chunk * chunkSize;
+                const int length = std::min(chunkSize, size - begin);
+                FP3 inverseCoords[chunkSize];
+                bool status[chunkSize];
+                std::fill(status, status + length, true);
+                compiledMapping.getInverseCoordsBatch(coords + begin, inverseCoords, length, time, status);
+                for (int i = 0; i < length; i++)
+                    values[begin + i] = status[i] ?
+                        (this->*getBaseFieldValue)(inverseCoords[i]) : FP3(0.0, 0.0, 0.0);
+            }
+        }
+
+        // the points are mapped once for all the requested fields
+        void getEBJValues(const FP3* coords, FP3* e, FP3* b, FP3* j, int size) const override
+        {
+            const FP time = getFieldSolver()->getTime();
+            const int chunkSize = 256;
+            const int numChunks = (size + chunkSize - 1) / chunkSize;
+            OMP_FOR()
+            for (int chunk = 0; chunk < numChunks; chunk++) {
+                const int begin = chunk * chunkSize;
+                const int length = std::min(chunkSize, size - begin);
+                FP3 inverseCoords[chunkSize];
+                bool status[chunkSize];
+                std::fill(status, status + length, true);
+                compiledMapping.getInverseCoordsBatch(coords + begin, inverseCoords, length, time, status);
+                for (int i = 0; i < length; i++) {
+                    if (e) e[begin + i] = status[i] ? BaseInterface::getE(inverseCoords[i]) : FP3(0.0, 0.0, 0.0);
+                    if (b) b[begin + i] = status[i] ? BaseInterface::getB(inverseCoords[i]) : FP3(0.0, 0.0, 0.0);
+                    if (j) j[begin + i] = status[i] ? BaseInterface::getJ(inverseCoords[i]) : FP3(0.0, 0.0, 0.0);
+                }
+            }
+        }
+
     protected:
 
         inline FP3 getDirectCoords(const FP3& coords, FP time, bool* status) const {
-            FP3 coords_ = coords;
-            *status = true;
-            std::shared_ptr<pyMappedField<TFieldSolver>> pyMappedFieldPointer =
-                std::dynamic_pointer_cast<pyMappedField<TFieldSolver>>(pyWrappedField);
-            if (pyMappedFieldPointer)
-                coords_ = pyMappedFieldPointer->getDirectCoords(coords_, time, status);
-            bool status2 = true;
-            if (mapping) coords_ = mapping->getDirectCoords(coords_, time, &status2);
-            *status = *status && status2;
-            return coords_;
+            return compiledMapping.getDirectCoords(coords, time, status);
         }
 
         inline FP3 getInverseCoords(const FP3& coords, FP time, bool* status) const {
-            FP3 coords_ = coords;
-            *status = true;
-            std::shared_ptr<pyMappedField<TFieldSolver>> pyMappedFieldPointer =
-                std::dynamic_pointer_cast<pyMappedField<TFieldSolver>>(pyWrappedField);
-            if (pyMappedFieldPointer)
-                coords_ = pyMappedFieldPointer->getInverseCoords(coords_, time, status);
-            bool status2 = true;
-            if (mapping) coords_ = mapping->getInverseCoords(coords_, time, &status2);
-            *status = *status && status2;
-            return coords_;
+            return compiledMapping.getInverseCoords(coords, time, status);
         }
 
     private:
@@ -427,6 +720,9 @@ namespace pfc
         std::shared_ptr<pyFieldBase> pyWrappedField;
         std::shared_ptr<Mapping> mapping;
 
+        std::shared_ptr<pyField<TFieldSolver>> pyRootField;
+        CompiledMapping compiledMapping;
+
         FP getFieldComp(const FP3& coords,
             FP(BaseInterface::* getFieldValue)(const FP3&) const) const
         {
@@ -459,70 +755,172 @@ namespace pfc
     typedef pyMappedField<AnalyticalFieldSolver> pyMappedAnalyticalField;
 
 
-    // Object returned when summing fields
-    class pySumField : public pyFieldBase
+    // Linear combination of fields, the tree of sums and products is flattened
+    // into a list of leaf fields with factors when the combination is created,
+    // so every leaf is evaluated once per point (or once per batch of points)
+    class pyFieldCombination : public pyFieldBase
     {
     public:
 
-        pySumField(const std::shared_ptr<pyFieldBase>& pyWrappedField1,
-            const std::shared_ptr<pyFieldBase>& pyWrappedField2) :
-            pyWrappedField1(pyWrappedField1), pyWrappedField2(pyWrappedField2)
-        {}
-
-        pySumField(const std::shared_ptr<pySumField>& other,
-            const std::shared_ptr<Mapping>& mapping) :
-            pyWrappedField1(other->pyWrappedField1->applyMapping(other->pyWrappedField1, mapping)),
-            pyWrappedField2(other->pyWrappedField2->applyMapping(other->pyWrappedField2, mapping))
-        {}
-
-        std::shared_ptr<pyFieldBase> applyMapping(
-            const std::shared_ptr<pyFieldBase>& self,
-            const std::shared_ptr<Mapping>& mapping) const override {
-            return std::static_pointer_cast<pyFieldBase>(
-                std::make_shared<pySumField>(
-                    std::static_pointer_cast<pySumField>(self), mapping
-                    )
-                );
-        }
-
         FP3 getE(const FP3& coords) const override {
-            return pyWrappedField1->getE(coords) + pyWrappedField2->getE(coords);
+            return getFieldComp3(coords, &pyFieldBase::getE);
         }
         FP3 getB(const FP3& coords) const override {
-            return pyWrappedField1->getB(coords) + pyWrappedField2->getB(coords);
+            return getFieldComp3(coords, &pyFieldBase::getB);
         }
         FP3 getJ(const FP3& coords) const override {
-            return pyWrappedField1->getJ(coords) + pyWrappedField2->getJ(coords);
+            return getFieldComp3(coords, &pyFieldBase::getJ);
         }
 
         FP getEx(const FP3& coords) const override {
-            return pyWrappedField1->getEx(coords) + pyWrappedField2->getEx(coords);
+            return getFieldComp(coords, &pyFieldBase::getEx);
         }
         FP getEy(const FP3& coords) const override {
-            return pyWrappedField1->getEy(coords) + pyWrappedField2->getEy(coords);
+            return getFieldComp(coords, &pyFieldBase::getEy);
         }
         FP getEz(const FP3& coords) const override {
-            return pyWrappedField1->getEz(coords) + pyWrappedField2->getEz(coords);
+            return getFieldComp(coords, &pyFieldBase::getEz);
         }
 
         FP getBx(const FP3& coords) const override {
-            return pyWrappedField1->getBx(coords) + pyWrappedField2->getBx(coords);
+            return getFieldComp(coords, &pyFieldBase::getBx);
         }
         FP getBy(const FP3& coords) const override {
-            return pyWrappedField1->getBy(coords) + pyWrappedField2->getBy(coords);
+            return getFieldComp(coords, &pyFieldBase::getBy);
         }
         FP getBz(const FP3& coords) const override {
-            return pyWrappedField1->getBz(coords) + pyWrappedField2->getBz(coords);
+            return getFieldComp(coords, &pyFieldBase::getBz);
         }
 
         FP getJx(const FP3& coords) const override {
-            return pyWrappedField1->getJx(coords) + pyWrappedField2->getJx(coords);
+            return getFieldComp(coords, &pyFieldBase::getJx);
         }
         FP getJy(const FP3& coords) const override {
-            return pyWrappedField1->getJy(coords) + pyWrappedField2->getJy(coords);
+            return getFieldComp(coords, &pyFieldBase::getJy);
         }
         FP getJz(const FP3& coords) const override {
-            return pyWrappedField1->getJz(coords) + pyWrappedField2->getJz(coords);
+            return getFieldComp(coords, &pyFieldBase::getJz);
+        }
+
+        // the leaves are evaluated with their own batch paths
+        void getFieldValues(const FP3* coords, FP3* values, int size,
+            FP3(pyFieldBase::* getFieldValue)(const FP3&) const) const override
+        {
+            std::vector<FP3> buffer(terms.size() > 1 ? size : 0);
+            for (size_t t = 0; t < terms.size(); t++) {
+                FP3* termValues = t == 0 ? values : buffer.data();
+                terms[t].field->getFieldValues(coords, termValues, size, getFieldValue);
+                accumulate(values, termValues, terms[t].factor, size, t == 0);
+            }
+            if (terms.empty()) std::fill(values, values + size, FP3(0.0, 0.0, 0.0));
+        }
+
+        void getEBJValues(const FP3* coords, FP3* e, FP3* b, FP3* j, int size) const override
+        {
+            std::vector<FP3> buffer[3];
+            FP3* values[3] = { e, b, j };
+            for (size_t t = 0; t < terms.size(); t++) {
+                FP3* termValues[3];
+                for (int v = 0; v < 3; v++) {
+                    if (t > 0 && values[v] && buffer[v].empty()) buffer[v].resize(size);
+                    termValues[v] = (t == 0 || !values[v]) ? values[v] : buffer[v].data();
+                }
+                terms[t].field->getEBJValues(coords, termValues[0], termValues[1], termValues[2], size);
+                for (int v = 0; v < 3; v++)
+                    if (values[v]) accumulate(values[v], termValues[v], terms[t].factor, size, t == 0);
+            }
+            if (terms.empty())
+                for (int v = 0; v < 3; v++)
+                    if (values[v]) std::fill(values[v], values[v] + size, FP3(0.0, 0.0, 0.0));
+        }
+
+        int getNumTerms() const {
+            return (int)terms.size();
+        }
+
+    protected:
+
+        // adds the leaves of the field, equal leaves are merged
+        void addTerms(const std::shared_ptr<pyFieldBase>& field, FP factor) {
+            std::shared_ptr<pyFieldCombination> combination =
+                std::dynamic_pointer_cast<pyFieldCombination>(field);
+            if (!combination) {
+                addTerm(field, factor);
+                return;
+            }
+            for (size_t t = 0; t < combination->terms.size(); t++)
+                addTerm(combination->terms[t].field, combination->terms[t].factor * factor);
+        }
+
+    private:
+
+        struct Term {
+            std::shared_ptr<pyFieldBase> field;
+            FP factor;
+        };
+
+        std::vector<Term> terms;
+
+        void addTerm(const std::shared_ptr<pyFieldBase>& field, FP factor) {
+            for (size_t t = 0; t < terms.size(); t++)
+                if (terms[t].field == field) {
+                    terms[t].factor += factor;
+                    return;
+                }
+            terms.push_back({ field, factor });
+        }
+
+        FP getFieldComp(const FP3& coords, FP(pyFieldBase::* getFieldValue)(const FP3&) const) const {
+            FP result = 0.0;
+            for (size_t t = 0; t < terms.size(); t++)
+                result += (terms[t].field.get()->*getFieldValue)(coords) * terms[t].factor;
+            return result;
+        }
+
+        FP3 getFieldComp3(const FP3& coords, FP3(pyFieldBase::* getFieldValue)(const FP3&) const) const {
+            FP3 result(0.0, 0.0, 0.0);
+            for (size_t t = 0; t < terms.size(); t++)
+                result += (terms[t].field.get()->*getFieldValue)(coords) * terms[t].factor;
+            return result;
+        }
+
+        // values (+)= factor * termValues
+        static void accumulate(FP3* values, const FP3* termValues, FP factor, int size, bool isFirst) {
+            OMP_FOR()
+            for (int i = 0; i < size; i++)
+                values[i] = isFirst ? termValues[i] * factor : values[i] + termValues[i] * factor;
+        }
+
+    };
+
+
+    // Object returned when summing fields
+    class pySumField : public pyFieldCombination
+    {
+    public:
+
+        pySumField(const std::shared_ptr<pyFieldBase>& pyWrappedField1,
+            const std::shared_ptr<pyFieldBase>& pyWrappedField2) :
+            pyWrappedField1(pyWrappedField1), pyWrappedField2(pyWrappedField2)
+        {
+            addTerms(pyWrappedField1, 1.0);
+            addTerms(pyWrappedField2, 1.0);
+        }
+
+        pySumField(const std::shared_ptr<pySumField>& other,
+            const std::shared_ptr<Mapping>& mapping) :
+            pySumField(other->pyWrappedField1->applyMapping(other->pyWrappedField1, mapping),
+                other->pyWrappedField2->applyMapping(other->pyWrappedField2, mapping))
+        {}
+
+        std::shared_ptr<pyFieldBase> applyMapping(
+            const std::shared_ptr<pyFieldBase>& self,
+            const std::shared_ptr<Mapping>& mapping) const override {
+            return std::static_pointer_cast<pyFieldBase>(
+                std::make_shared<pySumField>(
+                    std::static_pointer_cast<pySumField>(self), mapping
+                    )
+                );
         }
 
         void updateFields() override {
@@ -543,17 +941,19 @@ namespace pfc
 
 
     // Object returned when multiplying fields by factor
-    class pyMulField : public pyFieldBase {
+    class pyMulField : public pyFieldCombination {
     public:
 
         pyMulField(const std::shared_ptr<pyFieldBase>& pyWrappedField, FP factor) :
             pyWrappedField(pyWrappedField),
             factor(factor)
-        {}
+        {
+            addTerms(pyWrappedField, factor);
+        }
 
         pyMulField(const std::shared_ptr<pyMulField>& other,
             const std::shared_ptr<Mapping>& mapping) :
-            pyWrappedField(other->pyWrappedField->applyMapping(other->pyWrappedField, mapping))
+            pyMulField(other->pyWrappedField->applyMapping(other->pyWrappedField, mapping), other->factor)
         {}
 
         std::shared_ptr<pyFieldBase> applyMapping(
@@ -566,46 +966,6 @@ namespace pfc
                 );
         }
 
-        FP3 getE(const FP3& coords) const override {
-            return pyWrappedField->getE(coords) * factor;
-        }
-        FP3 getB(const FP3& coords) const override {
-            return pyWrappedField->getB(coords) * factor;
-        }
-        FP3 getJ(const FP3& coords) const override {
-            return pyWrappedField->getJ(coords) * factor;
-        }
-
-        FP getEx(const FP3& coords) const override {
-            return pyWrappedField->getEx(coords) * factor;
-        }
-        FP getEy(const FP3& coords) const override {
-            return pyWrappedField->getEy(coords) * factor;
-        }
-        FP getEz(const FP3& coords) const override {
-            return pyWrappedField->getEz(coords) * factor;
-        }
-
-        FP getBx(const FP3& coords) const override {
-            return pyWrappedField->getBx(coords) * factor;
-        }
-        FP getBy(const FP3& coords) const override {
-            return pyWrappedField->getBy(coords) * factor;
-        }
-        FP getBz(const FP3& coords) const override {
-            return pyWrappedField->getBz(coords) * factor;
-        }
-
-        FP getJx(const FP3& coords) const override {
-            return pyWrappedField->getJx(coords) * factor;
-        }
-        FP getJy(const FP3& coords) const override {
-            return pyWrappedField->getJy(coords) * factor;
-        }
-        FP getJz(const FP3& coords) const override {
-            return pyWrappedField->getJz(coords) * factor;
-        }
-
         void updateFields() override {
             pyWrappedField->updateFields();
         }
@@ -616,8 +976,8 @@ namespace pfc
 
     private:
 
-        FP factor = 1.0;
         std::shared_ptr<pyFieldBase> pyWrappedField;
+        FP factor = 1.0;
     };
 
 }
@@ -11,6 +11,7 @@
 #include "Pstd.h"
 
 #include "pybind11/pybind11.h"
+#include "pybind11/numpy.h"
 
 namespace py = pybind11;
 using namespace pybind11::literals;
@@ -59,6 +60,172 @@ namespace pfc
     };
 
 
+    // Helpers for array-at-once access to grid components from Python,
+    // arrays have the grid shape (numCells) in C order
+    typedef py::array_t<FP, py::array::c_style | py::array::forcecast> pyNumpyArray;
+
+    // coordinates of the nodes of a field component (after mapping) as arrays (x, y, z)
+    template <class TGrid, class TPyField>
+    py::tuple getNodeCoordsArrays(TPyField* derived, TGrid* grid,
+        const FP3(TGrid::* position)(int, int, int) const)
+    {
+        const Int3 n = grid->numCells;
+        std::vector<py::ssize_t> shape = { n.x, n.y, n.z };
+        pyNumpyArray x(shape), y(shape), z(shape);
+        FP* xData = x.mutable_data();
+        FP* yData = y.mutable_data();
+        FP* zData = z.mutable_data();
+        {
+            py::gil_scoped_release release;
+            OMP_FOR_COLLAPSE()
+            for (int i = 0; i < n.x; i++)
+                for (int j = 0; j < n.y; j++)
+                    for (int k = 0; k < n.z; k++)
+                    {
+                        FP3 coords = derived->convertCoords((grid->*position)(i, j, k));
+                        const int idx = (i * n.y + j) * n.z + k;
+                        xData[idx] = coords.x;
+                        yData[idx] = coords.y;
+                        zData[idx] = coords.z;
+                    }
+        }
+        return py::make_tuple(x, y, z);
+    }
+
+    template <class TGrid, class TPyField>
+    py::object callOnNodes(const py::function& func, TPyField* derived, TGrid* grid,
+        const FP3(TGrid::* position)(int, int, int) const)
+    {
+        py::tuple coords = getNodeCoordsArrays(derived, grid, position);
+        return func("x"_a = coords[0], "y"_a = coords[1], "z"_a = coords[2]);
+    }
+
+    // coordinates of the nodes of three components of a vector field as flat arrays (x, y, z)
+    // of size 3 * numCells.volume(): the nodes of the x component, then of the y and z components
+    template <class TGrid, class TPyField>
+    py::tuple getVectorNodeCoordsArrays(TPyField* derived, TGrid* grid,
+        const FP3(TGrid::* positionX)(int, int, int) const,
+        const FP3(TGrid::* positionY)(int, int, int) const,
+        const FP3(TGrid::* positionZ)(int, int, int) const)
+    {
+        const Int3 n = grid->numCells;
+        const int size = n.volume();
+        pyNumpyArray x(3 * size), y(3 * size), z(3 * size);
+        FP* data[3] = { x.mutable_data(), y.mutable_data(), z.mutable_data() };
+        const FP3(TGrid::* positions[3])(int, int, int) const = { positionX, positionY, positionZ };
+        {
+            py::gil_scoped_release release;
+            for (int c = 0; c < 3; c++)
+            {
+                OMP_FOR_COLLAPSE()
+                for (int i = 0; i < n.x; i++)
+                    for (int j = 0; j < n.y; j++)
+                        for (int k = 0; k < n.z; k++)
+                        {
+                            FP3 coords = derived->convertCoords((grid->*positions[c])(i, j, k));
+                            const int idx = c * size + (i * n.y + j) * n.z + k;
+                            data[0][idx] = coords.x;
+                            data[1][idx] = coords.y;
+                            data[2][idx] = coords.z;
+                        }
+            }
+        }
+        return py::make_tuple(x, y, z);
+    }
+
+    /* Copies the result of a vector function called once on getVectorNodeCoordsArrays
+    into the three components: the result is an array of shape (N, 3) or a sequence
+    of three arrays of size N (or of size 1 for a constant), N = 3 * numCells.volume().
+    The x component takes the x values in the nodes of the x component and so on. */
+    template <class TGrid>
+    void setVectorFieldFromResult(TGrid* grid, ScalarField<FP>& fieldX, ScalarField<FP>& fieldY,
+        ScalarField<FP>& fieldZ, const py::object& result)
+    {
+        const Int3 n = grid->numCells;
+        const int size = n.volume();
+        ScalarField<FP>* fields[3] = { &fieldX, &fieldY, &fieldZ };
+        pyNumpyArray arrays[3];
+        const FP* data[3];
+        int stride[3];
+        if (py::isinstance<py::tuple>(result) || py::isinstance<py::list>(result))
+        {
+            py::sequence components = result;
+            if (components.size() != 3)
+                throw py::value_error("the function must return 3 components");
+            for (int c = 0; c < 3; c++)
+            {
+                arrays[c] = components[c].cast<pyNumpyArray>();
+                if (arrays[c].size() == 1)
+                {
+                    data[c] = arrays[c].data();
+                    stride[c] = 0;
+                    continue;
+                }
+                if (arrays[c].size() != 3 * size)
+                    throw py::value_error("size of each component must be equal to the number of nodes");
+                data[c] = arrays[c].data() + c * size;
+                stride[c] = 1;
+            }
+        }
+        else
+        {
+            arrays[0] = result.cast<pyNumpyArray>();
+            if (arrays[0].ndim() != 2 || arrays[0].shape(0) != 3 * size || arrays[0].shape(1) != 3)
+                throw py::value_error("shape of the result must be (number of nodes, 3)");
+            for (int c = 0; c < 3; c++)
+            {
+                data[c] = arrays[0].data() + 3 * c * size + c;
+                stride[c] = 3;
+            }
+        }
+        py::gil_scoped_release release;
+        for (int c = 0; c < 3; c++)
+        {
+            ScalarField<FP>& field = *fields[c];
+            const FP* values = data[c];
+            const int valueStride = stride[c];
+            OMP_FOR_COLLAPSE()
+            for (int i = 0; i < n.x; i++)
+                for (int j = 0; j < n.y; j++)
+                    for (int k = 0; k < n.z; k++)
+                        field(i, j, k) = values[((i * n.y + j) * n.z + k) * valueStride];
+        }
+    }
+
+    // copies values into the scalar field in parallel, an array of size 1 sets a constant
+    template <class TGrid>
+    void setScalarFieldFromArray(TGrid* grid, ScalarField<FP>& field, const pyNumpyArray& values)
+    {
+        const Int3 n = grid->numCells;
+        const bool isConstant = values.size() == 1;
+        if (!isConstant && (values.ndim() != 3 ||
+            values.shape(0) != n.x || values.shape(1) != n.y || values.shape(2) != n.z))
+            throw py::value_error("shape of the array must be equal to the grid size");
+        const FP* data = values.data();
+        py::gil_scoped_release release;
+        OMP_FOR_COLLAPSE()
+        for (int i = 0; i < n.x; i++)
+            for (int j = 0; j < n.y; j++)
+                for (int k = 0; k < n.z; k++)
+                    field(i, j, k) = isConstant ? data[0] : data[(i * n.y + j) * n.z + k];
+    }
+
+    template <class TGrid>
+    pyNumpyArray getArrayFromScalarField(TGrid* grid, const ScalarField<FP>& field)
+    {
+        const Int3 n = grid->numCells;
+        pyNumpyArray values(std::vector<py::ssize_t>{ n.x, n.y, n.z });
+        FP* data = values.mutable_data();
+        py::gil_scoped_release release;
+        OMP_FOR_COLLAPSE()
+        for (int i = 0; i < n.x; i++)
+            for (int j = 0; j < n.y; j++)
+                for (int k = 0; k < n.z; k++)
+                    data[(i * n.y + j) * n.z + k] = field(i, j, k);
+        return values;
+    }
+
+
     // Interface depending on spatial template (shifted or collocated)
     template <class TFieldSolver, class TPyField, bool ifSpatialStaggered>
     class pySpatialStaggeredFieldInterface {};
@@ -108,6 +275,7 @@ namespace pfc
                             grid->Bz(i, j, k) = fieldConf->getB(cBz[k].x, cBz[k].y, cBz[k].z).z;
                         }
                     }
+            grid->markFieldsChanged();
         }
 
     };
@@ -155,6 +323,7 @@ namespace pfc
                             grid->Bz(i, j, k + chunk * chunkSize) = B.z;
                         }
                     }
+            grid->markFieldsChanged();
         }
 
         void pySetEMField(py::function fValueField)
@@ -178,6 +347,7 @@ namespace pfc
                         grid->By(i, j, k) = field.B.y;
                         grid->Bz(i, j, k) = field.B.z;
                     }
+            grid->markFieldsChanged();
         }
 
         void setEMField(CFunctionPointer _fValueField)
@@ -217,6 +387,7 @@ namespace pfc
                             grid->Bz(i, j, k + chunk * chunkSize) = field.B.z;
                         }
                     }
+            grid->markFieldsChanged();
         }
 
         void pyApplyFunction(py::function func)
@@ -246,6 +417,46 @@ namespace pfc
                         grid->By(i, j, k) = field.B.y;
                         grid->Bz(i, j, k) = field.B.z;
                     }
+            grid->markFieldsChanged();
+        }
+
+        // func(x, y, z) is called once with arrays of node coordinates
+        // and returns arrays (Ex, Ey, Ez, Bx, By, Bz)
+        void pySetEMFieldVectorized(py::function func)
+        {
+            TPyField* derived = static_cast<TPyField*>(this);
+            TGrid* grid = derived->getGrid();
+            py::sequence values = callOnNodes(func, derived, grid, &TGrid::ExPosition);
+            setScalarFieldFromArray(grid, grid->Ex, values[0].cast<pyNumpyArray>());
+            setScalarFieldFromArray(grid, grid->Ey, values[1].cast<pyNumpyArray>());
+            setScalarFieldFromArray(grid, grid->Ez, values[2].cast<pyNumpyArray>());
+            setScalarFieldFromArray(grid, grid->Bx, values[3].cast<pyNumpyArray>());
+            setScalarFieldFromArray(grid, grid->By, values[4].cast<pyNumpyArray>());
+            setScalarFieldFromArray(grid, grid->Bz, values[5].cast<pyNumpyArray>());
+            grid->markFieldsChanged();
+        }
+
+        // func(x, y, z, Ex, Ey, Ez, Bx, By, Bz) is called once with arrays
+        // and returns new arrays (Ex, Ey, Ez, Bx, By, Bz)
+        void pyApplyFunctionVectorized(py::function func)
+        {
+            TPyField* derived = static_cast<TPyField*>(this);
+            TGrid* grid = derived->getGrid();
+            py::tuple coords = getNodeCoordsArrays(derived, grid, &TGrid::ExPosition);
+            py::sequence values = func("x"_a = coords[0], "y"_a = coords[1], "z"_a = coords[2],
+                "Ex"_a = getArrayFromScalarField(grid, grid->Ex),
+                "Ey"_a = getArrayFromScalarField(grid, grid->Ey),
+                "Ez"_a = getArrayFromScalarField(grid, grid->Ez),
+                "Bx"_a = getArrayFromScalarField(grid, grid->Bx),
+                "By"_a = getArrayFromScalarField(grid, grid->By),
+                "Bz"_a = getArrayFromScalarField(grid, grid->Bz));
+            setScalarFieldFromArray(grid, grid->Ex, values[0].cast<pyNumpyArray>());
+            setScalarFieldFromArray(grid, grid->Ey, values[1].cast<pyNumpyArray>());
+            setScalarFieldFromArray(grid, grid->Ez, values[2].cast<pyNumpyArray>());
+            setScalarFieldFromArray(grid, grid->Bx, values[3].cast<pyNumpyArray>());
+            setScalarFieldFromArray(grid, grid->By, values[4].cast<pyNumpyArray>());
+            setScalarFieldFromArray(grid, grid->Bz, values[5].cast<pyNumpyArray>());
+            grid->markFieldsChanged();
         }
 
         void applyFunction(CFunctionPointer _func)
@@ -292,6 +503,7 @@ namespace pfc
                             grid->Bz(i, j, zIndex) = field.B.z;
                         }
                     }
+            grid->markFieldsChanged();
         }
     };
 
@@ -321,6 +533,7 @@ namespace pfc
                         grid->Ey(i, j, k) = fEy("x"_a = cEy.x, "y"_a = cEy.y, "z"_a = cEy.z).template cast<FP>();
                         grid->Ez(i, j, k) = fEz("x"_a = cEz.x, "y"_a = cEz.y, "z"_a = cEz.z).template cast<FP>();
                     }
+            grid->markFieldsChanged();
         }
 
         void pySetE(py::function fE)
@@ -339,6 +552,7 @@ namespace pfc
                         grid->Ey(i, j, k) = fE("x"_a = cEy.x, "y"_a = cEy.y, "z"_a = cEy.z).template cast<FP3>().y;
                         grid->Ez(i, j, k) = fE("x"_a = cEz.x, "y"_a = cEz.y, "z"_a = cEz.z).template cast<FP3>().z;
                     }
+            grid->markFieldsChanged();
         }
 
         void setExyz(CFunctionPointer _fEx, CFunctionPointer _fEy, CFunctionPointer _fEz)
@@ -361,6 +575,7 @@ namespace pfc
                         grid->Ey(i, j, k) = fEy(cEy.x, cEy.y, cEy.z);
                         grid->Ez(i, j, k) = fEz(cEz.x, cEz.y, cEz.z);
                     }
+            grid->markFieldsChanged();
         }
 
         void setExyzt(CFunctionPointer _fEx, CFunctionPointer _fEy, CFunctionPointer _fEz, FP t)
@@ -383,6 +598,7 @@ namespace pfc
                         grid->Ey(i, j, k) = fEy(cEy.x, cEy.y, cEy.z, t);
                         grid->Ez(i, j, k) = fEz(cEz.x, cEz.y, cEz.z, t);
                     }
+            grid->markFieldsChanged();
         }
 
         void setE(CFunctionPointer _fE)
@@ -403,6 +619,7 @@ namespace pfc
                         grid->Ey(i, j, k) = fE(cEy.x, cEy.y, cEy.z).y;
                         grid->Ez(i, j, k) = fE(cEz.x, cEz.y, cEz.z).z;
                     }
+            grid->markFieldsChanged();
         }
 
         void pySetBxyz(py::function fBx, py::function fBy, py::function fBz)
@@ -421,6 +638,7 @@ namespace pfc
                         grid->By(i, j, k) = fBy("x"_a = cBy.x, "y"_a = cBy.y, "z"_a = cBy.z).template cast<FP>();
                         grid->Bz(i, j, k) = fBz("x"_a = cBz.x, "y"_a = cBz.y, "z"_a = cBz.z).template cast<FP>();
                     }
+            grid->markFieldsChanged();
         }
 
         void pySetB(py::function fB)
@@ -439,6 +657,7 @@ namespace pfc
                         grid->By(i, j, k) = fB("x"_a = cBy.x, "y"_a = cBy.y, "z"_a = cBy.z).template cast<FP3>().y;
                         grid->Bz(i, j, k) = fB("x"_a = cBz.x, "y"_a = cBz.y, "z"_a = cBz.z).template cast<FP3>().z;
                     }
+            grid->markFieldsChanged();
         }
 
         void setBxyz(CFunctionPointer _fBx, CFunctionPointer _fBy, CFunctionPointer _fBz)
@@ -461,6 +680,7 @@ namespace pfc
                         grid->By(i, j, k) = fBy(cBy.x, cBy.y, cBy.z);
                         grid->Bz(i, j, k) = fBz(cBz.x, cBz.y, cBz.z);
                     }
+            grid->markFieldsChanged();
         }
 
         void setBxyzt(CFunctionPointer _fBx, CFunctionPointer _fBy, CFunctionPointer _fBz, FP t)
@@ -483,6 +703,7 @@ namespace pfc
                         grid->By(i, j, k) = fBy(cBy.x, cBy.y, cBy.z, t);
                         grid->Bz(i, j, k) = fBz(cBz.x, cBz.y, cBz.z, t);
                     }
+            grid->markFieldsChanged();
         }
 
         void setB(CFunctionPointer _fB)
@@ -503,6 +724,7 @@ namespace pfc
                         grid->By(i, j, k) = fB(cBy.x, cBy.y, cBy.z).y;
                         grid->Bz(i, j, k) = fB(cBz.x, cBz.y, cBz.z).z;
                     }
+            grid->markFieldsChanged();
         }
 
         void pySetJxyz(py::function fJx, py::function fJy, py::function fJz)
@@ -605,6 +827,114 @@ namespace pfc
                     }
         }
 
+        // fEx, fEy, fEz are called once with arrays of coordinates of the corresponding nodes
+        void pySetExyzVectorized(py::function fEx, py::function fEy, py::function fEz)
+        {
+            TPyField* derived = static_cast<TPyField*>(this);
+            TGrid* grid = derived->getGrid();
+            setScalarFieldFromArray(grid, grid->Ex,
+                callOnNodes(fEx, derived, grid, &TGrid::ExPosition).template cast<pyNumpyArray>());
+            setScalarFieldFromArray(grid, grid->Ey,
+                callOnNodes(fEy, derived, grid, &TGrid::EyPosition).template cast<pyNumpyArray>());
+            setScalarFieldFromArray(grid, grid->Ez,
+                callOnNodes(fEz, derived, grid, &TGrid::EzPosition).template cast<pyNumpyArray>());
+            grid->markFieldsChanged();
+        }
+
+        // fE is called once with flat arrays of coordinates of the nodes of all three components
+        // and returns an array of shape (N, 3) or arrays (Ex, Ey, Ez), see setVectorFieldFromResult
+        void pySetEVectorized(py::function fE)
+        {
+            TPyField* derived = static_cast<TPyField*>(this);
+            TGrid* grid = derived->getGrid();
+            py::tuple coords = getVectorNodeCoordsArrays(derived, grid,
+                &TGrid::ExPosition, &TGrid::EyPosition, &TGrid::EzPosition);
+            py::object values = fE("x"_a = coords[0], "y"_a = coords[1], "z"_a = coords[2]);
+            setVectorFieldFromResult(grid, grid->Ex, grid->Ey, grid->Ez, values);
+            grid->markFieldsChanged();
+        }
+
+        // precomputed arrays of the grid shape
+        void setExyzArrays(const pyNumpyArray& Ex, const pyNumpyArray& Ey, const pyNumpyArray& Ez)
+        {
+            TGrid* grid = static_cast<TPyField*>(this)->getGrid();
+            setScalarFieldFromArray(grid, grid->Ex, Ex);
+            setScalarFieldFromArray(grid, grid->Ey, Ey);
+            setScalarFieldFromArray(grid, grid->Ez, Ez);
+            grid->markFieldsChanged();
+        }
+
+        // fBx, fBy, fBz are called once with arrays of coordinates of the corresponding nodes
+        void pySetBxyzVectorized(py::function fBx, py::function fBy, py::function fBz)
+        {
+            TPyField* derived = static_cast<TPyField*>(this);
+            TGrid* grid = derived->getGrid();
+            setScalarFieldFromArray(grid, grid->Bx,
+                callOnNodes(fBx, derived, grid, &TGrid::BxPosition).template cast<pyNumpyArray>());
+            setScalarFieldFromArray(grid, grid->By,
+                callOnNodes(fBy, derived, grid, &TGrid::ByPosition).template cast<pyNumpyArray>());
+            setScalarFieldFromArray(grid, grid->Bz,
+                callOnNodes(fBz, derived, grid, &TGrid::BzPosition).template cast<pyNumpyArray>());
+            grid->markFieldsChanged();
+        }
+
+        // fB is called once with flat arrays of coordinates of the nodes of all three components
+        // and returns an array of shape (N, 3) or arrays (Bx, By, Bz), see setVectorFieldFromResult
+        void pySetBVectorized(py::function fB)
+        {
+            TPyField* derived = static_cast<TPyField*>(this);
+            TGrid* grid = derived->getGrid();
+            py::tuple coords = getVectorNodeCoordsArrays(derived, grid,
+                &TGrid::BxPosition, &TGrid::ByPosition, &TGrid::BzPosition);
+            py::object values = fB("x"_a = coords[0], "y"_a = coords[1], "z"_a = coords[2]);
+            setVectorFieldFromResult(grid, grid->Bx, grid->By, grid->Bz, values);
+            grid->markFieldsChanged();
+        }
+
+        // precomputed arrays of the grid shape
+        void setBxyzArrays(const pyNumpyArray& Bx, const pyNumpyArray& By, const pyNumpyArray& Bz)
+        {
+            TGrid* grid = static_cast<TPyField*>(this)->getGrid();
+            setScalarFieldFromArray(grid, grid->Bx, Bx);
+            setScalarFieldFromArray(grid, grid->By, By);
+            setScalarFieldFromArray(grid, grid->Bz, Bz);
+            grid->markFieldsChanged();
+        }
+
+        // fJx, fJy, fJz are called once with arrays of coordinates of the corresponding nodes
+        void pySetJxyzVectorized(py::function fJx, py::function fJy, py::function fJz)
+        {
+            TPyField* derived = static_cast<TPyField*>(this);
+            TGrid* grid = derived->getGrid();
+            setScalarFieldFromArray(grid, grid->Jx,
+                callOnNodes(fJx, derived, grid, &TGrid::JxPosition).template cast<pyNumpyArray>());
+            setScalarFieldFromArray(grid, grid->Jy,
+                callOnNodes(fJy, derived, grid, &TGrid::JyPosition).template cast<pyNumpyArray>());
+            setScalarFieldFromArray(grid, grid->Jz,
+                callOnNodes(fJz, derived, grid, &TGrid::JzPosition).template cast<pyNumpyArray>());
+        }
+
+        // fJ is called once with flat arrays of coordinates of the nodes of all three components
+        // and returns an array of shape (N, 3) or arrays (Jx, Jy, Jz), see setVectorFieldFromResult
+        void pySetJVectorized(py::function fJ)
+        {
+            TPyField* derived = static_cast<TPyField*>(this);
+            TGrid* grid = derived->getGrid();
+            py::tuple coords = getVectorNodeCoordsArrays(derived, grid,
+                &TGrid::JxPosition, &TGrid::JyPosition, &TGrid::JzPosition);
+            py::object values = fJ("x"_a = coords[0], "y"_a = coords[1], "z"_a = coords[2]);
+            setVectorFieldFromResult(grid, grid->Jx, grid->Jy, grid->Jz, values);
+        }
+
+        // precomputed arrays of the grid shape
+        void setJxyzArrays(const pyNumpyArray& Jx, const pyNumpyArray& Jy, const pyNumpyArray& Jz)
+        {
+            TGrid* grid = static_cast<TPyField*>(this)->getGrid();
+            setScalarFieldFromArray(grid, grid->Jx, Jx);
+            setScalarFieldFromArray(grid, grid->Jy, Jy);
+            setScalarFieldFromArray(grid, grid->Jz, Jz);
+        }
+
         FP3 getE(const FP3& coords) const {
             return static_cast<const TPyField*>(this)->getGrid()->getE(coords);
         }
@@ -648,6 +978,48 @@ namespace pfc
         void getFields(const FP3& coords, FP3& e, FP3& b) const {
             static_cast<const TPyField*>(this)->getGrid()->getFields(coords, e, b);
         }
+
+        // values in an array of points, the interpolation is dispatched once per batch
+        void getFieldValuesBatch(const FP3* coords, FP3* values, int size, FieldEnum field) const {
+            const TGrid* grid = static_cast<const TPyField*>(this)->getGrid();
+            switch (grid->getInterpolationType()) {
+            case InterpolationType::Interpolation_TSC:
+                getFieldValuesBatch<InterpolationType::Interpolation_TSC>(grid, coords, values, size, field); break;
+            case InterpolationType::Interpolation_PCS:
+                getFieldValuesBatch<InterpolationType::Interpolation_PCS>(grid, coords, values, size, field); break;
+            case InterpolationType::Interpolation_SecondOrder:
+                getFieldValuesBatch<InterpolationType::Interpolation_SecondOrder>(grid, coords, values, size, field); break;
+            case InterpolationType::Interpolation_FourthOrder:
+                getFieldValuesBatch<InterpolationType::Interpolation_FourthOrder>(grid, coords, values, size, field); break;
+            default:
+                getFieldValuesBatch<InterpolationType::Interpolation_CIC>(grid, coords, values, size, field);
+            }
+        }
+
+    private:
+
+        template <InterpolationType type>
+        static void getFieldValuesBatch(const TGrid* grid, const FP3* coords, FP3* values,
+            int size, FieldEnum field)
+        {
+            switch (field) {
+            case FieldEnum::E:
+                OMP_FOR()
+                for (int i = 0; i < size; i++)
+                    values[i] = grid->template getE<type>(coords[i]);
+                break;
+            case FieldEnum::B:
+                OMP_FOR()
+                for (int i = 0; i < size; i++)
+                    values[i] = grid->template getB<type>(coords[i]);
+                break;
+            case FieldEnum::J:
+                OMP_FOR()
+                for (int i = 0; i < size; i++)
+                    values[i] = grid->template getJ<type>(coords[i]);
+                break;
+            }
+        }
     };
 
 
@@ -675,7 +1047,8 @@ namespace pfc
     public:
 
         using FunctionType = typename TFieldSolver::FieldGeneratorType::FunctionType;
-        
+        using BatchFunctionType = typename TFieldSolver::FieldGeneratorType::BatchFunctionType;
+
         void setFieldGenerator(
             const Int3& leftGenIndex, const Int3& rightGenIndex,
             CFunctionPointer bxFunc, CFunctionPointer byFunc, CFunctionPointer bzFunc,
@@ -733,12 +1106,41 @@ namespace pfc
             );
         }
 
+        // batch functions f(x[], y[], z[], t, result[], size) are called for whole borders
+        void setFieldGeneratorBatch(
+            const Int3& leftGenIndex, const Int3& rightGenIndex,
+            CFunctionPointer bxFunc, CFunctionPointer byFunc, CFunctionPointer bzFunc,
+            CFunctionPointer exFunc, CFunctionPointer eyFunc, CFunctionPointer ezFunc,
+            bool isXLeftBorderEnabled, bool isYLeftBorderEnabled, bool isZLeftBorderEnabled,
+            bool isXRightBorderEnabled, bool isYRightBorderEnabled, bool isZRightBorderEnabled
+        )
+        {
+            TFieldSolver* fieldSolver = static_cast<TPyField*>(this)->getFieldSolver();
+            FunctionType zero = field_generator::defaultFieldFunction;
+            fieldSolver->setFieldGenerator(
+                leftGenIndex, rightGenIndex,
+                zero, zero, zero, zero, zero, zero,
+                Int3(isXLeftBorderEnabled, isYLeftBorderEnabled, isZLeftBorderEnabled),
+                Int3(isXRightBorderEnabled, isYRightBorderEnabled, isZRightBorderEnabled)
+            );
+            CFunctionPointer bFunc[3] = { bxFunc, byFunc, bzFunc };
+            CFunctionPointer eFunc[3] = { exFunc, eyFunc, ezFunc };
+            for (int c = 0; c < 3; c++) {
+                fieldSolver->generator->setBatchFunction(FieldEnum::B, (CoordinateEnum)c, cppBatchFunc(bFunc[c]));
+                fieldSolver->generator->setBatchFunction(FieldEnum::E, (CoordinateEnum)c, cppBatchFunc(eFunc[c]));
+            }
+        }
+
     protected:
 
         FunctionType cppFunc(CFunctionPointer f) {
             return FunctionType((FP(*)(FP, FP, FP, FP))f);
         };
 
+        BatchFunctionType cppBatchFunc(CFunctionPointer f) {
+            return BatchFunctionType((void(*)(const FP*, const FP*, const FP*, FP, FP*, int))f);
+        };
+
     };
 
 
@@ -864,6 +1266,32 @@ namespace pfc
             );
         }
 
+        // batch functions f(x[], y[], z[], t, result[], size)
+        void setExyzBatch(CFunctionPointer fEx, CFunctionPointer fEy, CFunctionPointer fEz) {
+            static_cast<const TPyField*>(this)->getGrid()->setEBatch(
+                cppBatchFunc(fEx), cppBatchFunc(fEy), cppBatchFunc(fEz));
+        }
+
+        void setBxyzBatch(CFunctionPointer fBx, CFunctionPointer fBy, CFunctionPointer fBz) {
+            static_cast<const TPyField*>(this)->getGrid()->setBBatch(
+                cppBatchFunc(fBx), cppBatchFunc(fBy), cppBatchFunc(fBz));
+        }
+
+        void setJxyzBatch(CFunctionPointer fJx, CFunctionPointer fJy, CFunctionPointer fJz) {
+            static_cast<const TPyField*>(this)->getGrid()->setJBatch(
+                cppBatchFunc(fJx), cppBatchFunc(fJy), cppBatchFunc(fJz));
+        }
+
+        // values in an array of points, the batch functions are called once per chunk
+        void getFieldValuesBatch(const FP3* coords, FP3* values, int size, FieldEnum field) const {
+            AnalyticalField* grid = static_cast<const TPyField*>(this)->getGrid();
+            switch (field) {
+            case FieldEnum::E: grid->getE(coords, values, size); break;
+            case FieldEnum::B: grid->getB(coords, values, size); break;
+            case FieldEnum::J: grid->getJ(coords, values, size); break;
+            }
+        }
+
         FP3 getE(const FP3& coords) const {
             return static_cast<const TPyField*>(this)->getGrid()->getE(coords);
         }
@@ -913,6 +1341,13 @@ namespace pfc
         FP3 getJt(FP x, FP y, FP z, FP t) const {
             return static_cast<const TPyField*>(this)->getGrid()->getJ(x, y, z, t);
         }
+
+    protected:
+
+        AnalyticalField::BatchFunctionType cppBatchFunc(CFunctionPointer f) const {
+            return AnalyticalField::BatchFunctionType(
+                (void(*)(const FP*, const FP*, const FP*, FP, FP*, int))f);
+        }
     };
 
 
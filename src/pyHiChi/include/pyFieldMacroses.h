@@ -32,19 +32,35 @@
         py::arg("Ex"), py::arg("Ey"), py::arg("Ez"), py::arg("t"))         \
     .def("set_B", &pyFieldType::setBxyzt,                                  \
         py::arg("Bx"), py::arg("By"), py::arg("Bz"), py::arg("t"))         \
+    .def("set_J_vectorized", &pyFieldType::pySetJVectorized)               \
+    .def("set_E_vectorized", &pyFieldType::pySetEVectorized)               \
+    .def("set_B_vectorized", &pyFieldType::pySetBVectorized)               \
+    .def("set_J_vectorized", &pyFieldType::pySetJxyzVectorized,            \
+        py::arg("Jx"), py::arg("Jy"), py::arg("Jz"))                       \
+    .def("set_E_vectorized", &pyFieldType::pySetExyzVectorized,            \
+        py::arg("Ex"), py::arg("Ey"), py::arg("Ez"))                       \
+    .def("set_B_vectorized", &pyFieldType::pySetBxyzVectorized,            \
+        py::arg("Bx"), py::arg("By"), py::arg("Bz"))                       \
+    .def("set_J", &pyFieldType::setJxyzArrays,                             \
+        py::arg("Jx"), py::arg("Jy"), py::arg("Jz"))                       \
+    .def("set_E", &pyFieldType::setExyzArrays,                             \
+        py::arg("Ex"), py::arg("Ey"), py::arg("Ez"))                       \
+    .def("set_B", &pyFieldType::setBxyzArrays,                             \
+        py::arg("Bx"), py::arg("By"), py::arg("Bz"))                       \
     SET_FIELD_CONFIGURATIONS_GRID_METHODS(pyFieldType)
 
 
 #define SET_SCALAR_FIELD_METHODS(pyFieldType)                              \
-    .def("get_Jx_array", &pyFieldType::getJxArray)                         \
-    .def("get_Jy_array", &pyFieldType::getJyArray)                         \
-    .def("get_Jz_array", &pyFieldType::getJzArray)                         \
-    .def("get_Ex_array", &pyFieldType::getExArray)                         \
-    .def("get_Ey_array", &pyFieldType::getEyArray)                         \
-    .def("get_Ez_array", &pyFieldType::getEzArray)                         \
-    .def("get_Bx_array", &pyFieldType::getBxArray)                         \
-    .def("get_By_array", &pyFieldType::getByArray)                         \
-    .def("get_Bz_array", &pyFieldType::getBzArray)
+    .def("get_Jx_array", &pyFieldType::getJxArray, py::keep_alive<0, 1>()) \
+    .def("get_Jy_array", &pyFieldType::getJyArray, py::keep_alive<0, 1>()) \
+    .def("get_Jz_array", &pyFieldType::getJzArray, py::keep_alive<0, 1>()) \
+    .def("get_Ex_array", &pyFieldType::getExArray, py::keep_alive<0, 1>()) \
+    .def("get_Ey_array", &pyFieldType::getEyArray, py::keep_alive<0, 1>()) \
+    .def("get_Ez_array", &pyFieldType::getEzArray, py::keep_alive<0, 1>()) \
+    .def("get_Bx_array", &pyFieldType::getBxArray, py::keep_alive<0, 1>()) \
+    .def("get_By_array", &pyFieldType::getByArray, py::keep_alive<0, 1>()) \
+    .def("get_Bz_array", &pyFieldType::getBzArray, py::keep_alive<0, 1>()) \
+    .def("mark_fields_changed", &pyFieldType::markFieldsChanged)
 
 
 #define SET_COMMON_FIELD_METHODS(pyFieldType)                             \
@@ -176,6 +192,13 @@
         py::arg("is_left_x_border_enabled") = true, py::arg("is_left_y_border_enabled") = true,       \
         py::arg("is_left_z_border_enabled") = true, py::arg("is_right_x_border_enabled") = true,      \
         py::arg("is_right_y_border_enabled") = true, py::arg("is_right_z_border_enabled") = true)     \
+    .def("set_field_generator_batch", &pyYeeField::setFieldGeneratorBatch,                            \
+        py::arg("left_index"), py::arg("right_index"),                                                \
+        py::arg("bx_func"), py::arg("by_func"), py::arg("bz_func"),                                   \
+        py::arg("ex_func"), py::arg("ey_func"), py::arg("ez_func"),                                   \
+        py::arg("is_left_x_border_enabled") = true, py::arg("is_left_y_border_enabled") = true,       \
+        py::arg("is_left_z_border_enabled") = true, py::arg("is_right_x_border_enabled") = true,      \
+        py::arg("is_right_y_border_enabled") = true, py::arg("is_right_z_border_enabled") = true)     \
     .def("set_field_generator", &pyYeeField::setFieldGeneratorAllFunctions,                           \
         py::arg("left_index"), py::arg("right_index"),                                                \
         py::arg("left_x_bx_func") = (CFunctionPointer)field_generator::defaultFieldFunction,    \
@@ -0,0 +1,350 @@
+#pragma once
+#include "pyField.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace pfc
+{
+    /* Writer of field snapshots sampled on a regular set of points: a line, a plane or a volume
+    (axes with one point are dropped from the shape). Each call of write() appends a frame,
+    so a time series of a component is stored in one file:
+    "raw" - FP data in C order (float32 with PFC_USE_SINGLE_PRECISION, float64 otherwise),
+    files <path>_<component>.bin and <path>_time.bin;
+    "npy" - NumPy arrays of shape (frames, ...), files <path>_<component>.npy and <path>_time.npy,
+    the header is updated after every frame, so the files are valid while writing;
+    "npz" - the same arrays packed into <path>.npz when the writer is closed. */
+    class pyFieldWriter {
+    public:
+
+        pyFieldWriter(const std::shared_ptr<pyFieldBase>& field,
+            const FP3& minCoords, const FP3& maxCoords, const FP3& size,
+            const std::vector<std::string>& components,
+            const std::string& path, const std::string& format = "npy") :
+            field(field), path(path), numFrames(0)
+        {
+            if (format == "raw") this->format = Format::Raw;
+            else if (format == "npy") this->format = Format::Npy;
+            else if (format == "npz") this->format = Format::Npz;
+            else throw py::value_error("format must be 'raw', 'npy' or 'npz'");
+
+            Int3 numPoints = (Int3)size;
+            for (int d = 0; d < 3; d++) {
+                if (numPoints[d] < 1)
+                    throw py::value_error("size must be positive");
+                if (numPoints[d] > 1) frameShape.push_back(numPoints[d]);
+            }
+            points.reserve(numPoints.x * numPoints.y * numPoints.z);
+            const FP3 step = (maxCoords - minCoords) / (FP3)numPoints;
+            for (int i = 0; i < numPoints.x; i++)
+                for (int j = 0; j < numPoints.y; j++)
+                    for (int k = 0; k < numPoints.z; k++)
+                        points.push_back(minCoords + step * FP3(i, j, k));
+
+            for (size_t c = 0; c < components.size(); c++) {
+                const std::string& name = components[c];
+                if (name.size() != 2 || std::string("EBJ").find(name[0]) == std::string::npos ||
+                    std::string("xyz").find(name[1]) == std::string::npos)
+                    throw py::value_error("unknown field component " + name);
+                Component component;
+                component.name = name;
+                component.vector = (int)std::string("EBJ").find(name[0]);
+                component.coord = name[1] - 'x';
+                component.file = openFile(name);
+                this->components.push_back(component);
+            }
+            timeFile = openFile("time");
+        }
+
+        ~pyFieldWriter() {
+            try {
+                close();
+            }
+            catch (...) {}
+        }
+
+        // evaluates the components in the points and appends the frame
+        void write(FP time = 0.0) {
+            if (!timeFile) throw std::runtime_error("the writer is closed");
+
+            // all the needed vectors are computed in one pass over the points
+            const int size = (int)points.size();
+            std::vector<FP3> values[3];
+            for (size_t c = 0; c < components.size(); c++)
+                values[components[c].vector].resize(size);
+            field->getEBJValues(points.data(), values[0].empty() ? 0 : values[0].data(),
+                values[1].empty() ? 0 : values[1].data(), values[2].empty() ? 0 : values[2].data(), size);
+
+            std::vector<FP> buffer(size);
+            for (size_t c = 0; c < components.size(); c++) {
+                const int v = components[c].vector, coord = components[c].coord;
+                OMP_FOR()
+                for (int i = 0; i < size; i++)
+                    buffer[i] = values[v][i][coord];
+                appendFrame(components[c].file, buffer.data(), size);
+            }
+            appendFrame(timeFile, &time, 1);
+
+            numFrames++;
+            if (format != Format::Raw) {
+                for (size_t c = 0; c < components.size(); c++)
+                    writeNpyHeader(components[c].file, frameShape);
+                writeNpyHeader(timeFile, std::vector<int>());
+            }
+        }
+
+        void close() {
+            if (!timeFile) return;
+            for (size_t c = 0; c < components.size(); c++) {
+                std::fclose(components[c].file);
+                components[c].file = 0;
+            }
+            std::fclose(timeFile);
+            timeFile = 0;
+
+            if (format == Format::Npz) {
+                std::vector<std::string> names;
+                for (size_t c = 0; c < components.size(); c++)
+                    names.push_back(components[c].name);
+                names.push_back("time");
+                packNpz(names);
+            }
+        }
+
+        int getNumFrames() const {
+            return numFrames;
+        }
+
+    private:
+
+        enum class Format { Raw, Npy, Npz };
+
+        struct Component {
+            std::string name;
+            int vector, coord;
+            std::FILE* file;
+        };
+
+        std::shared_ptr<pyFieldBase> field;
+        std::string path;
+        Format format;
+        std::vector<FP3> points;
+        std::vector<int> frameShape;
+        std::vector<Component> components;
+        std::FILE* timeFile;
+        int numFrames;
+
+        // the header has a fixed size to be rewritten in place
+        static const int npyHeaderSize = 128;
+
+        std::string getFileName(const std::string& name) const {
+            return path + "_" + name + (format == Format::Raw ? ".bin" : ".npy");
+        }
+
+        std::FILE* openFile(const std::string& name) {
+            std::FILE* file = std::fopen(getFileName(name).c_str(), "wb+");
+            if (!file) throw std::runtime_error("cannot open file " + getFileName(name));
+            if (format != Format::Raw)
+                writeNpyHeader(file, name == "time" ? std::vector<int>() : frameShape);
+            return file;
+        }
+
+        void appendFrame(std::FILE* file, const FP* data, int size) {
+            std::fseek(file, 0, SEEK_END);
+            if (std::fwrite(data, sizeof(FP), size, file) != (size_t)size)
+                throw std::runtime_error("cannot write to file " + path);
+        }
+
+        void writeNpyHeader(std::FILE* file, const std::vector<int>& shape) {
+            // the data is written as FP, the descr follows its size
+            std::string dict = std::string("{'descr': '") + (sizeof(FP) == 4 ? "<f4" : "<f8") +
+                "', 'fortran_order': False, 'shape': (" +
+                std::to_string(numFrames) + ",";
+            for (size_t d = 0; d < shape.size(); d++)
+                dict += " " + std::to_string(shape[d]) + (d + 1 < shape.size() ? "," : "");
+            dict += "), }";
+            const int headerLength = npyHeaderSize - 10;
+            dict.resize(headerLength - 1, ' ');
+            dict += '\n';
+
+            std::string header("\x93NUMPY\x01\x00", 8);
+            header += (char)(headerLength & 0xff);
+            header += (char)(headerLength >> 8);
+            header += dict;
+            std::fseek(file, 0, SEEK_SET);
+            if (std::fwrite(header.data(), 1, header.size(), file) != header.size() || std::fflush(file) != 0)
+                throw std::runtime_error("cannot write to file " + path);
+        }
+
+        /* npz is a zip archive of npy files, the entries are stored without compression.
+        The npy files are removed only after the whole archive is written and closed,
+        on an error the partial archive is removed and the npy files are kept. The
+        archive has no zip64 records, so it is limited to 4 GB and 65535 entries. */
+        void packNpz(const std::vector<std::string>& names) {
+            const std::string archiveName = path + ".npz";
+            std::FILE* archive = std::fopen(archiveName.c_str(), "wb");
+            if (!archive) throw std::runtime_error("cannot open file " + archiveName);
+
+            try {
+                writeNpzEntries(archive, names);
+            }
+            catch (...) {
+                std::fclose(archive);
+                std::remove(archiveName.c_str());
+                throw;
+            }
+            if (std::fclose(archive) != 0) {
+                std::remove(archiveName.c_str());
+                throw std::runtime_error("cannot write to file " + archiveName);
+            }
+            for (size_t n = 0; n < names.size(); n++)
+                std::remove(getFileName(names[n]).c_str());
+        }
+
+        void writeNpzEntries(std::FILE* archive, const std::vector<std::string>& names) {
+            if (names.size() > 0xffff)
+                throw std::runtime_error("npz archives with more than 65535 entries are not supported");
+            std::string centralDirectory;
+            std::vector<char> buffer(1 << 20);
+            for (size_t n = 0; n < names.size(); n++) {
+                std::FILE* file = std::fopen(getFileName(names[n]).c_str(), "rb");
+                if (!file) throw std::runtime_error("cannot open file " + getFileName(names[n]));
+                try {
+                    const std::string entryName = names[n] + ".npy";
+                    seek64(file, 0, SEEK_END);
+                    const uint32_t fileSize = checkZipOffset(tell64(file));
+                    seek64(file, 0, SEEK_SET);
+                    uint32_t crc = 0xffffffff;
+                    size_t count;
+                    while ((count = std::fread(buffer.data(), 1, buffer.size(), file)) > 0)
+                        crc = updateCrc32(crc, buffer.data(), count);
+                    crc ^= 0xffffffff;
+
+                    const uint32_t offset = checkZipOffset(tell64(archive));
+                    std::string localHeader;
+                    appendInt(localHeader, 0x04034b50, 4);
+                    appendEntryInfo(localHeader, crc, fileSize, entryName);
+                    appendInt(localHeader, 0, 2);  // extra field length
+                    localHeader += entryName;
+                    writeToArchive(archive, localHeader.data(), localHeader.size());
+
+                    seek64(file, 0, SEEK_SET);
+                    long long copied = 0;
+                    while ((count = std::fread(buffer.data(), 1, buffer.size(), file)) > 0) {
+                        writeToArchive(archive, buffer.data(), count);
+                        copied += count;
+                    }
+                    if (std::ferror(file) || copied != fileSize)
+                        throw std::runtime_error("cannot read file " + getFileName(names[n]));
+                    std::fclose(file);
+
+                    appendInt(centralDirectory, 0x02014b50, 4);
+                    appendInt(centralDirectory, 20, 2);  // version made by
+                    appendEntryInfo(centralDirectory, crc, fileSize, entryName);
+                    appendInt(centralDirectory, 0, 2);  // extra field length
+                    appendInt(centralDirectory, 0, 2);  // comment length
+                    appendInt(centralDirectory, 0, 2);  // disk number
+                    appendInt(centralDirectory, 0, 2);  // internal attributes
+                    appendInt(centralDirectory, 0, 4);  // external attributes
+                    appendInt(centralDirectory, offset, 4);
+                    centralDirectory += entryName;
+                }
+                catch (...) {
+                    std::fclose(file);
+                    throw;
+                }
+            }
+
+            const uint32_t centralDirectoryOffset = checkZipOffset(tell64(archive));
+            checkZipOffset((long long)centralDirectoryOffset + (long long)centralDirectory.size());
+            std::string end;
+            appendInt(end, 0x06054b50, 4);
+            appendInt(end, 0, 2);
+            appendInt(end, 0, 2);
+            appendInt(end, (uint32_t)names.size(), 2);
+            appendInt(end, (uint32_t)names.size(), 2);
+            appendInt(end, (uint32_t)centralDirectory.size(), 4);
+            appendInt(end, centralDirectoryOffset, 4);
+            appendInt(end, 0, 2);  // comment length
+            writeToArchive(archive, centralDirectory.data(), centralDirectory.size());
+            writeToArchive(archive, end.data(), end.size());
+            if (std::fflush(archive) != 0)
+                throw std::runtime_error("cannot write to file " + path + ".npz");
+        }
+
+        void writeToArchive(std::FILE* archive, const char* data, size_t size) {
+            if (std::fwrite(data, 1, size, archive) != size)
+                throw std::runtime_error("cannot write to file " + path + ".npz");
+        }
+
+        // sizes and offsets of the archive are 32-bit without zip64 records
+        static uint32_t checkZipOffset(long long offset) {
+            if (offset < 0)
+                throw std::runtime_error("cannot get the position in the npz archive");
+            if (offset > 0xffffffffLL)
+                throw std::runtime_error("npz archives larger than 4 GB are not supported");
+            return (uint32_t)offset;
+        }
+
+        // 64-bit positions in files, long is 32-bit on Windows
+        static long long tell64(std::FILE* file) {
+#ifdef _MSC_VER
+            return _ftelli64(file);
+#else
+            return (long long)ftello(file);
+#endif
+        }
+
+        static void seek64(std::FILE* file, long long offset, int origin) {
+#ifdef _MSC_VER
+            const int result = _fseeki64(file, offset, origin);
+#else
+            const int result = fseeko(file, (off_t)offset, origin);
+#endif
+            if (result != 0)
+                throw std::runtime_error("cannot seek in file");
+        }
+
+        // fields shared by the local and the central headers, starting with "version needed"
+        static void appendEntryInfo(std::string& header, uint32_t crc, uint32_t size,
+            const std::string& name) {
+            appendInt(header, 20, 2);  // version needed to extract
+            appendInt(header, 0, 2);  // flags
+            appendInt(header, 0, 2);  // stored
+            appendInt(header, 0, 2);  // time
+            appendInt(header, 0x21, 2);  // date: 1980-01-01
+            appendInt(header, crc, 4);
+            appendInt(header, size, 4);
+            appendInt(header, size, 4);
+            appendInt(header, (uint32_t)name.size(), 2);
+        }
+
+        static void appendInt(std::string& str, uint32_t value, int numBytes) {
+            for (int i = 0; i < numBytes; i++)
+                str += (char)((value >> (8 * i)) & 0xff);
+        }
+
+        static uint32_t updateCrc32(uint32_t crc, const char* data, size_t size) {
+            static const std::vector<uint32_t> table = createCrc32Table();
+            for (size_t i = 0; i < size; i++)
+                crc = table[(crc ^ (unsigned char)data[i]) & 0xff] ^ (crc >> 8);
+            return crc;
+        }
+
+        static std::vector<uint32_t> createCrc32Table() {
+            std::vector<uint32_t> table(256);
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t value = i;
+                for (int k = 0; k < 8; k++)
+                    value = (value & 1) ? (0xedb88320 ^ (value >> 1)) : (value >> 1);
+                table[i] = value;
+            }
+            return table;
+        }
+
+    };
+}
@@ -0,0 +1,172 @@
+#pragma once
+#include "Constants.h"
+#include "Ensemble.h"
+#include "ParticleArray.h"
+#include "ParticleTypes.h"
+#include "macros.h"
+
+#include "pybind11/pybind11.h"
+#include "pybind11/numpy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace py = pybind11;
+
+namespace pfc
+{
+    /* Bulk exchange of particles with NumPy arrays: positions and momenta have shape (N, 3),
+    weights have shape (N,) or size 1 for a common weight, types of particles in an ensemble
+    have shape (N,). The storage is resized once and filled in parallel without the GIL. */
+    typedef py::array_t<FP, py::array::c_style | py::array::forcecast> pyParticleDataArray;
+    typedef py::array_t<int, py::array::c_style | py::array::forcecast> pyParticleTypeArray;
+
+    // number of particles in the arrays
+    inline int getNumParticles(const pyParticleDataArray& positions,
+        const pyParticleDataArray& momenta, const pyParticleDataArray& weights)
+    {
+        if (positions.ndim() != 2 || positions.shape(1) != 3)
+            throw py::value_error("positions must have shape (N, 3)");
+        const py::ssize_t size = positions.shape(0);
+        if (momenta.ndim() != 2 || momenta.shape(0) != size || momenta.shape(1) != 3)
+            throw py::value_error("momenta must have shape (N, 3)");
+        if (weights.size() != 1 && weights.size() != size)
+            throw py::value_error("weights must have shape (N,) or size 1");
+        return (int)size;
+    }
+
+    // sets particle dst of the array from particle src of the data arrays
+    inline void setParticleFromArrays(ParticleArray3d& particles, int dst, int src,
+        const FP* positions, const FP* momenta, const FP* weights, bool isCommonWeight, FP mc)
+    {
+        FP3 p;
+        for (int d = 0; d < 3; d++) {
+            particles.getPositionData(d)[dst] = positions[3 * src + d];
+            p[d] = momenta[3 * src + d] / mc;
+            particles.getPData(d)[dst] = p[d];
+        }
+        particles.getWeightData()[dst] = isCommonWeight ? weights[0] : weights[src];
+        particles.getGammaData()[dst] = sqrt((FP)1 + p.norm2());
+    }
+
+    inline void extendParticleArray(ParticleArray3d& particles, const pyParticleDataArray& positions,
+        const pyParticleDataArray& momenta, const pyParticleDataArray& weights)
+    {
+        const int size = getNumParticles(positions, momenta, weights);
+        const int begin = particles.size();
+        const FP* positionData = positions.data();
+        const FP* momentumData = momenta.data();
+        const FP* weightData = weights.data();
+        const bool isCommonWeight = weights.size() == 1;
+        const FP mc = constants::c * ParticleInfo::types[particles.getType()].mass;
+
+        py::gil_scoped_release release;
+        particles.resize(begin + size);
+        OMP_FOR()
+        for (int i = 0; i < size; i++)
+            setParticleFromArrays(particles, begin + i, i,
+                positionData, momentumData, weightData, isCommonWeight, mc);
+    }
+
+    inline void extendEnsemble(Ensemble3d& ensemble, const pyParticleDataArray& positions,
+        const pyParticleDataArray& momenta, const pyParticleDataArray& weights,
+        const pyParticleTypeArray& types)
+    {
+        const int size = getNumParticles(positions, momenta, weights);
+        if (types.size() != size)
+            throw py::value_error("types must have shape (N,)");
+        const int* typeData = types.data();
+        for (int i = 0; i < size; i++)
+            if (typeData[i] < 0 || typeData[i] >= sizeParticleTypes)
+                throw py::value_error("unknown particle type " + std::to_string(typeData[i]));
+        const FP* positionData = positions.data();
+        const FP* momentumData = momenta.data();
+        const FP* weightData = weights.data();
+        const bool isCommonWeight = weights.size() == 1;
+
+        py::gil_scoped_release release;
+        // particles keep their order within each type
+        std::vector<int> destination(size);
+        int count[sizeParticleTypes] = {};
+        for (int i = 0; i < size; i++)
+            destination[i] = count[typeData[i]]++;
+        ParticleArray3d* arrays[sizeParticleTypes];
+        FP mc[sizeParticleTypes];
+        for (int t = 0; t < sizeParticleTypes; t++) {
+            arrays[t] = &ensemble[t];
+            mc[t] = constants::c * ParticleInfo::types[t].mass;
+            const int begin = arrays[t]->size();
+            arrays[t]->resize(begin + count[t]);
+            count[t] = begin;
+        }
+        OMP_FOR()
+        for (int i = 0; i < size; i++) {
+            const int t = typeData[i];
+            setParticleFromArrays(*arrays[t], count[t] + destination[i], i,
+                positionData, momentumData, weightData, isCommonWeight, mc[t]);
+        }
+    }
+
+    // copies the particles into the data arrays starting from particle begin of the arrays
+    inline void copyParticlesToArrays(ParticleArray3d& particles, int begin,
+        FP* positions, FP* momenta, FP* weights)
+    {
+        const int size = particles.size();
+        const FP mc = constants::c * ParticleInfo::types[particles.getType()].mass;
+        const FP* x[3] = { particles.getPositionData(0), particles.getPositionData(1),
+            particles.getPositionData(2) };
+        const FP* p[3] = { particles.getPData(0), particles.getPData(1), particles.getPData(2) };
+        const FP* w = particles.getWeightData();
+        OMP_FOR()
+        for (int i = 0; i < size; i++) {
+            const int dst = begin + i;
+            for (int d = 0; d < 3; d++) {
+                positions[3 * dst + d] = x[d][i];
+                momenta[3 * dst + d] = p[d][i] * mc;
+            }
+            weights[dst] = w[i];
+        }
+    }
+
+    // (positions, momenta, weights)
+    inline py::tuple particleArrayToNumpy(ParticleArray3d& particles)
+    {
+        const py::ssize_t size = particles.size();
+        py::array_t<FP> positions({ size, (py::ssize_t)3 }), momenta({ size, (py::ssize_t)3 });
+        py::array_t<FP> weights(size);
+        FP* positionData = positions.mutable_data();
+        FP* momentumData = momenta.mutable_data();
+        FP* weightData = weights.mutable_data();
+        {
+            py::gil_scoped_release release;
+            copyParticlesToArrays(particles, 0, positionData, momentumData, weightData);
+        }
+        return py::make_tuple(positions, momenta, weights);
+    }
+
+    // (positions, momenta, weights, types), particles are ordered by type
+    inline py::tuple ensembleToNumpy(Ensemble3d& ensemble)
+    {
+        const py::ssize_t size = ensemble.size();
+        py::array_t<FP> positions({ size, (py::ssize_t)3 }), momenta({ size, (py::ssize_t)3 });
+        py::array_t<FP> weights(size);
+        py::array_t<int> types(size);
+        FP* positionData = positions.mutable_data();
+        FP* momentumData = momenta.mutable_data();
+        FP* weightData = weights.mutable_data();
+        int* typeData = types.mutable_data();
+        {
+            py::gil_scoped_release release;
+            int begin = 0;
+            for (int t = 0; t < sizeParticleTypes; t++) {
+                ParticleArray3d& particles = ensemble[t];
+                copyParticlesToArrays(particles, begin, positionData, momentumData, weightData);
+                std::fill(typeData + begin, typeData + begin + particles.size(), t);
+                begin += particles.size();
+            }
+        }
+        return py::make_tuple(positions, momenta, weights, types);
+    }
+}
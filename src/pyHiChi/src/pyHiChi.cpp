@@ -9,6 +9,8 @@
 
 #include "pyField.h"
 #include "pyFieldMacroses.h"
+#include "pyFieldWriter.h"
+#include "pyParticleArray.h"
 
 #include "Constants.h"
 #include "Dimension.h"
@@ -30,6 +32,7 @@
 #include "Enums.h"
 #include "Mapping.h"
 #include "FieldConfiguration.h"
+#include "MemoryAccounting.h"
 
 
 namespace py = pybind11;
@@ -54,6 +57,39 @@ void processParticles(QED* self, Ensemble3d* particles,
     }
 }
 
+// maps points given as an (N, 3) array, returns the mapped points and the status mask
+py::tuple mapCoordsArray(Mapping* self,
+    const py::array_t<FP, py::array::c_style | py::array::forcecast>& coords,
+    FP time, bool ifInverse)
+{
+    if (coords.ndim() != 2 || coords.shape(1) != 3)
+        throw py::value_error("coords must have shape (N, 3)");
+    const int size = (int)coords.shape(0);
+    py::array_t<FP> res({ (py::ssize_t)size, (py::ssize_t)3 });
+    py::array_t<bool> status(size);
+    const FP* coordsData = coords.data();
+    FP* resData = res.mutable_data();
+    bool* statusData = status.mutable_data();
+    {
+        py::gil_scoped_release release;
+        std::vector<FP3> points(size);
+        for (int i = 0; i < size; i++) {
+            points[i] = FP3(coordsData[3 * i], coordsData[3 * i + 1], coordsData[3 * i + 2]);
+            statusData[i] = true;
+        }
+        if (ifInverse)
+            self->getInverseCoordsBatch(points.data(), points.data(), size, time, statusData);
+        else
+            self->getDirectCoordsBatch(points.data(), points.data(), size, time, statusData);
+        for (int i = 0; i < size; i++) {
+            resData[3 * i] = points[i].x;
+            resData[3 * i + 1] = points[i].y;
+            resData[3 * i + 2] = points[i].z;
+        }
+    }
+    return py::make_tuple(res, status);
+}
+
 
 PYBIND11_MODULE(pyHiChi, object) {
 
@@ -107,6 +143,15 @@ PYBIND11_MODULE(pyHiChi, object) {
         .def_readwrite("z", &FP3::z)
         ;
 
+    py::class_<Int3>(object, "Vector3i")
+        .def(py::init<>())
+        .def(py::init<int, int, int>())
+        .def("__str__", &Int3::toString)
+        .def_readwrite("x", &Int3::x)
+        .def_readwrite("y", &Int3::y)
+        .def_readwrite("z", &Int3::z)
+        ;
+
     object.def("cross", (const Vector3<FP> (*)(const Vector3Proxy<FP>&, const Vector3Proxy<FP>&)) cross);
     object.def("cross", (FP3(*)(const FP3&, const FP3&)) cross);
     object.def("dot", (FP(*)(const Vector3Proxy<FP>&, const Vector3Proxy<FP>&)) dot);
@@ -125,6 +170,46 @@ PYBIND11_MODULE(pyHiChi, object) {
         .def_readwrite("B", &ValueField::B)
         ;
 
+    // ------------------- memory accounting -------------------
+
+    py::enum_<MemoryCategory>(object, "MemoryCategory")
+        .value("Fields", MemoryCategory::Fields)
+        .value("FieldSolver", MemoryCategory::FieldSolver)
+        .value("Pml", MemoryCategory::Pml)
+        .value("FourierTransform", MemoryCategory::FourierTransform)
+        .value("Particles", MemoryCategory::Particles)
+        ;
+
+    py::class_<MemoryStats>(object, "MemoryStats")
+        .def_readonly("num_allocations", &MemoryStats::numAllocations)
+        .def_readonly("allocated_bytes", &MemoryStats::allocatedBytes)
+        .def_readonly("peak_allocated_bytes", &MemoryStats::peakAllocatedBytes)
+        ;
+
+    object.def("get_memory_stats", [](MemoryCategory category) {
+            return MemoryRegistry::instance().getStats(category);
+        }, py::arg("category"));
+    object.def("get_total_memory_stats", []() {
+            return MemoryRegistry::instance().getTotalStats();
+        });
+    // {component: {"allocated_bytes": .., "peak_allocated_bytes": .., "num_allocations": ..}, "total": ..}
+    object.def("get_memory_report", []() {
+            auto toDict = [](const MemoryStats& stats) {
+                py::dict result;
+                result["allocated_bytes"] = stats.allocatedBytes;
+                result["peak_allocated_bytes"] = stats.peakAllocatedBytes;
+                result["num_allocations"] = stats.numAllocations;
+                return result;
+            };
+            py::dict report;
+            for (int c = 0; c < numMemoryCategories; c++)
+                report[getMemoryCategoryName((MemoryCategory)c)] =
+                    toDict(MemoryRegistry::instance().getStats((MemoryCategory)c));
+            report["total"] = toDict(MemoryRegistry::instance().getTotalStats());
+            return report;
+        });
+    object.def("reset_memory_peaks", []() { MemoryRegistry::instance().resetPeaks(); });
+
     // ------------------- particles -------------------
 
     py::class_<ParticleProxy3d>(object, "ParticleProxy")
@@ -174,6 +259,7 @@ PYBIND11_MODULE(pyHiChi, object) {
         .def("add", &ParticleArray3d::pushBack)
         .def("get_type", &ParticleArray3d::getType)
         .def("size", &ParticleArray3d::size)
+        .def("get_memory_usage", &ParticleArray3d::getMemoryUsage)
         .def("delete", (void (ParticleArray3d::*)(int)) &ParticleArray3d::deleteParticle)
         .def("delete", (void (ParticleArray3d::*)(ParticleArray3d::iterator&)) &ParticleArray3d::deleteParticle)
         .def("__getitem__", [](ParticleArray3d& arr, size_t i) {
@@ -186,6 +272,98 @@ PYBIND11_MODULE(pyHiChi, object) {
     })
         .def("__iter__", [](ParticleArray3d &pArray) { return py::make_iterator(pArray.begin(), pArray.end()); },
             py::keep_alive<0, 1>())
+        // views of the storage without copying, valid until the array is resized
+        .def("get_position_array", [](py::object self, CoordinateEnum axis) {
+                ParticleArray3d& arr = self.cast<ParticleArray3d&>();
+                return py::array_t<FP>(arr.size(), arr.getPositionData((int)axis), self);
+            }, py::arg("axis"))
+        .def("get_p_array", [](py::object self, CoordinateEnum axis) {  // momentum / (mass * c)
+                ParticleArray3d& arr = self.cast<ParticleArray3d&>();
+                return py::array_t<FP>(arr.size(), arr.getPData((int)axis), self);
+            }, py::arg("axis"))
+        .def("get_weight_array", [](py::object self) {
+                ParticleArray3d& arr = self.cast<ParticleArray3d&>();
+                return py::array_t<FP>(arr.size(), arr.getWeightData(), self);
+            })
+        .def("get_gamma_array", [](py::object self) {
+                ParticleArray3d& arr = self.cast<ParticleArray3d&>();
+                return py::array_t<FP>(arr.size(), arr.getGammaData(), self);
+            })
+        // copies of particles from and to arrays: positions (N, 3), momenta (N, 3), weights (N,)
+        .def_static("from_numpy", [](const pyParticleDataArray& positions, const pyParticleDataArray& momenta,
+            const pyParticleDataArray& weights, ParticleTypes type) {
+                ParticleArray3d arr(type);
+                extendParticleArray(arr, positions, momenta, weights);
+                return arr;
+            }, py::arg("positions"), py::arg("momenta"), py::arg("weights") = 1.0,
+            py::arg("type") = ParticleTypes::Electron)
+        .def("extend_numpy", &extendParticleArray,
+            py::arg("positions"), py::arg("momenta"), py::arg("weights") = 1.0)
+        .def("to_numpy", &particleArrayToNumpy)
+        ;
+
+    // cell-relative positions: the index of a cell and the offset in it normalized by the cell size
+    py::class_<CellPosition>(object, "CellPosition")
+        .def(py::init<>())
+        .def(py::init<Int3, FP3>(), py::arg("cell"), py::arg("offset"))
+        .def_readwrite("cell", &CellPosition::cell)
+        .def_readwrite("offset", &CellPosition::offset)
+        ;
+
+    py::class_<CellGeometry>(object, "CellGeometry")
+        .def(py::init<FP3, FP3>(), py::arg("origin"), py::arg("steps"))
+        .def_readonly("origin", &CellGeometry::origin)
+        .def_readonly("steps", &CellGeometry::steps)
+        ;
+
+    py::class_<CellParticleProxy3d>(object, "CellParticleProxy")
+        .def("get_position", &CellParticleProxy3d::getPosition)
+        .def("set_position", &CellParticleProxy3d::setPosition)
+        .def("get_cell_position", &CellParticleProxy3d::getCellPosition)
+        .def("set_cell_position", &CellParticleProxy3d::setCellPosition)
+        .def("get_momentum", &CellParticleProxy3d::getMomentum)
+        .def("set_momentum", &CellParticleProxy3d::setMomentum)
+        .def("get_velocity", &CellParticleProxy3d::getVelocity)
+        .def("set_velocity", &CellParticleProxy3d::setVelocity)
+        .def("get_weight", &CellParticleProxy3d::getWeight)
+        .def("set_weight", &CellParticleProxy3d::setWeight)
+        .def("get_gamma", &CellParticleProxy3d::getGamma)
+        .def("get_mass", &CellParticleProxy3d::getMass)
+        .def("get_charge", &CellParticleProxy3d::getCharge)
+        .def("get_type", &CellParticleProxy3d::getType)
+        ;
+
+    py::class_<ParticleArrayCellSoA3d>(object, "CellParticleArray")
+        .def(py::init<>())
+        .def(py::init<ParticleTypes, const CellGeometry&>(), py::arg("type"), py::arg("geometry"))
+        .def("add", &ParticleArrayCellSoA3d::pushBack)
+        .def("get_type", &ParticleArrayCellSoA3d::getType)
+        .def("size", &ParticleArrayCellSoA3d::size)
+        .def("get_memory_usage", &ParticleArrayCellSoA3d::getMemoryUsage)
+        .def("get_cell_geometry", &ParticleArrayCellSoA3d::getCellGeometry)
+        .def("set_cell_geometry", &ParticleArrayCellSoA3d::setCellGeometry, py::arg("geometry"))
+        .def("get_cell_position", &ParticleArrayCellSoA3d::getCellPosition, py::arg("index"))
+        .def("delete", (void (ParticleArrayCellSoA3d::*)(int)) &ParticleArrayCellSoA3d::deleteParticle)
+        .def("__getitem__", [](ParticleArrayCellSoA3d& arr, size_t i) {
+        if (i >= arr.size()) throw py::index_error();
+        return arr[i];
+    }, py::keep_alive<0, 1>())
+        .def("__setitem__", [](ParticleArrayCellSoA3d &arr, size_t i, Particle3d v) {
+        if (i >= arr.size()) throw py::index_error();
+        CellParticleProxy3d particle = arr[i];
+        particle.setPosition(v.getPosition());
+        particle.setP(v.getP());
+        particle.setWeight(v.getWeight());
+    })
+        // views of the storage without copying, valid until the array is resized
+        .def("get_cell_array", [](py::object self, CoordinateEnum axis) {
+                ParticleArrayCellSoA3d& arr = self.cast<ParticleArrayCellSoA3d&>();
+                return py::array_t<int>(arr.size(), arr.getCellData((int)axis), self);
+            }, py::arg("axis"))
+        .def("get_offset_array", [](py::object self, CoordinateEnum axis) {
+                ParticleArrayCellSoA3d& arr = self.cast<ParticleArrayCellSoA3d&>();
+                return py::array_t<FP>(arr.size(), arr.getOffsetData((int)axis), self);
+            }, py::arg("axis"))
         ;
 
     py::class_<Ensemble3d>(object, "Ensemble")
@@ -193,6 +371,7 @@ PYBIND11_MODULE(pyHiChi, object) {
         .def(py::init<Ensemble3d>())
         .def("add", &Ensemble3d::addParticle)
         .def("size", &Ensemble3d::size)
+        .def("get_memory_usage", &Ensemble3d::getMemoryUsage)
         .def("__getitem__", [](Ensemble3d& arr, size_t i) {
         if (i >= sizeParticleTypes) throw py::index_error();
         return std::reference_wrapper<Ensemble3d::ParticleArray>(arr[i]);
@@ -211,6 +390,16 @@ PYBIND11_MODULE(pyHiChi, object) {
             throw py::index_error();
         arr[name] = v;
     })
+        // the same as for ParticleArray, types (N,) select the arrays of the ensemble
+        .def_static("from_numpy", [](const pyParticleDataArray& positions, const pyParticleDataArray& momenta,
+            const pyParticleDataArray& weights, const pyParticleTypeArray& types) {
+                Ensemble3d ensemble;
+                extendEnsemble(ensemble, positions, momenta, weights, types);
+                return ensemble;
+            }, py::arg("positions"), py::arg("momenta"), py::arg("weights"), py::arg("types"))
+        .def("extend_numpy", &extendEnsemble,
+            py::arg("positions"), py::arg("momenta"), py::arg("weights"), py::arg("types"))
+        .def("to_numpy", &ensembleToNumpy)
         ;
 
     // ------------------- pushers -------------------
@@ -219,14 +408,16 @@ PYBIND11_MODULE(pyHiChi, object) {
         .def(py::init<>())
         .def("__call__", (void (BorisPusher::*)(ParticleProxy3d*, ValueField&, FP)) &BorisPusher::operator())
         .def("__call__", (void (BorisPusher::*)(Particle3d*, ValueField&, FP)) &BorisPusher::operator())
-        .def("__call__", (void (BorisPusher::*)(ParticleArray3d*, std::vector<ValueField>&, FP)) &BorisPusher::operator())
+        .def("__call__", (void (BorisPusher::*)(ParticleArray3d*, std::vector<ValueField>&, FP)) &BorisPusher::operator(),
+            py::call_guard<py::gil_scoped_release>())
         ;
 
     py::class_<VayPusher>(object, "VayPusher")
         .def(py::init<>())
         .def("__call__", (void (VayPusher::*)(ParticleProxy3d*, ValueField&, FP)) &VayPusher::operator())
         .def("__call__", (void (VayPusher::*)(Particle3d*, ValueField&, FP)) &VayPusher::operator())
-        .def("__call__", (void (VayPusher::*)(ParticleArray3d*, std::vector<ValueField>&, FP)) &VayPusher::operator())
+        .def("__call__", (void (VayPusher::*)(ParticleArray3d*, std::vector<ValueField>&, FP)) &VayPusher::operator(),
+            py::call_guard<py::gil_scoped_release>())
         ;
 
     // ------------------- other particle modules -------------------
@@ -235,33 +426,74 @@ PYBIND11_MODULE(pyHiChi, object) {
         .def(py::init<>())
         .def("__call__", (void (RadiationReaction::*)(ParticleProxy3d*, ValueField&, FP)) &RadiationReaction::operator())
         .def("__call__", (void (RadiationReaction::*)(Particle3d*, ValueField&, FP)) &RadiationReaction::operator())
-        .def("__call__", (void (RadiationReaction::*)(ParticleArray3d*, std::vector<ValueField>&, FP)) &RadiationReaction::operator())
+        .def("__call__", (void (RadiationReaction::*)(ParticleArray3d*, std::vector<ValueField>&, FP)) &RadiationReaction::operator(),
+            py::call_guard<py::gil_scoped_release>())
         ;
 
     // -------------------------- QED ---------------------------
 
     py::class_<ScalarQED_AEG_only_electron_Yee>(object, "QED_Yee")
         .def(py::init<>())
-        .def("process_particles", &ScalarQED_AEG_only_electron_Yee::processParticles)
-        .def("process_particles", &processParticles<ScalarQED_AEG_only_electron_Yee, pyYeeField>)
+        .def("process_particles", &ScalarQED_AEG_only_electron_Yee::processParticles,
+            py::call_guard<py::gil_scoped_release>())
+        .def("process_particles", &processParticles<ScalarQED_AEG_only_electron_Yee, pyYeeField>,
+            py::call_guard<py::gil_scoped_release>())
         ;
 
     py::class_<ScalarQED_AEG_only_electron_PSTD>(object, "QED_PSTD")
         .def(py::init<>())
-        .def("process_particles", &ScalarQED_AEG_only_electron_PSTD::processParticles)
-        .def("process_particles", &processParticles<ScalarQED_AEG_only_electron_PSTD, pyPSTDField>)
+        .def("process_particles", &ScalarQED_AEG_only_electron_PSTD::processParticles,
+            py::call_guard<py::gil_scoped_release>())
+        .def("process_particles", &processParticles<ScalarQED_AEG_only_electron_PSTD, pyPSTDField>,
+            py::call_guard<py::gil_scoped_release>())
         ;
 
     py::class_<ScalarQED_AEG_only_electron_PSATD>(object, "QED_PSATD")
         .def(py::init<>())
-        .def("process_particles", &ScalarQED_AEG_only_electron_PSATD::processParticles)
-        .def("process_particles", &processParticles<ScalarQED_AEG_only_electron_PSATD, pyPSATDField>)
+        .def("process_particles", &ScalarQED_AEG_only_electron_PSATD::processParticles,
+            py::call_guard<py::gil_scoped_release>())
+        .def("process_particles", &processParticles<ScalarQED_AEG_only_electron_PSATD, pyPSATDField>,
+            py::call_guard<py::gil_scoped_release>())
         ;
 
     py::class_<ScalarQED_AEG_only_electron_Analytical>(object, "QED_Analytical")
         .def(py::init<>())
-        .def("process_particles", &ScalarQED_AEG_only_electron_Analytical::processParticles)
-        .def("process_particles", &processParticles<ScalarQED_AEG_only_electron_Analytical, pyAnalyticalField>)
+        .def("process_particles", &ScalarQED_AEG_only_electron_Analytical::processParticles,
+            py::call_guard<py::gil_scoped_release>())
+        .def("process_particles", &processParticles<ScalarQED_AEG_only_electron_Analytical, pyAnalyticalField>,
+            py::call_guard<py::gil_scoped_release>())
+        ;
+
+    py::class_<ScalarQED_AEG_only_electron_Yee_Vay>(object, "QED_Yee_Vay")
+        .def(py::init<>())
+        .def("process_particles", &ScalarQED_AEG_only_electron_Yee_Vay::processParticles,
+            py::call_guard<py::gil_scoped_release>())
+        .def("process_particles", &processParticles<ScalarQED_AEG_only_electron_Yee_Vay, pyYeeField>,
+            py::call_guard<py::gil_scoped_release>())
+        ;
+
+    py::class_<ScalarQED_AEG_only_electron_PSTD_Vay>(object, "QED_PSTD_Vay")
+        .def(py::init<>())
+        .def("process_particles", &ScalarQED_AEG_only_electron_PSTD_Vay::processParticles,
+            py::call_guard<py::gil_scoped_release>())
+        .def("process_particles", &processParticles<ScalarQED_AEG_only_electron_PSTD_Vay, pyPSTDField>,
+            py::call_guard<py::gil_scoped_release>())
+        ;
+
+    py::class_<ScalarQED_AEG_only_electron_PSATD_Vay>(object, "QED_PSATD_Vay")
+        .def(py::init<>())
+        .def("process_particles", &ScalarQED_AEG_only_electron_PSATD_Vay::processParticles,
+            py::call_guard<py::gil_scoped_release>())
+        .def("process_particles", &processParticles<ScalarQED_AEG_only_electron_PSATD_Vay, pyPSATDField>,
+            py::call_guard<py::gil_scoped_release>())
+        ;
+
+    py::class_<ScalarQED_AEG_only_electron_Analytical_Vay>(object, "QED_Analytical_Vay")
+        .def(py::init<>())
+        .def("process_particles", &ScalarQED_AEG_only_electron_Analytical_Vay::processParticles,
+            py::call_guard<py::gil_scoped_release>())
+        .def("process_particles", &processParticles<ScalarQED_AEG_only_electron_Analytical_Vay, pyAnalyticalField>,
+            py::call_guard<py::gil_scoped_release>())
         ;
 
     // ------------------- thinnings -------------------
@@ -278,17 +510,48 @@ PYBIND11_MODULE(pyHiChi, object) {
 
     py::class_<Thinning<ParticleArray3d>>(object, "Thinout")
         .def(py::init<>())
-        .def("simple_thinning", &Thinning<ParticleArray3d>::simple)
-        .def("leveling_thinning", &Thinning<ParticleArray3d>::leveling)
-        .def("number_conservative_thinning", &Thinning<ParticleArray3d>::numberConservative)
-        .def("energy_conservative_thinning", &Thinning<ParticleArray3d>::energyConservative)
-        .def("conservative_thinning", &Thinning<ParticleArray3d>::thinningConservative)
+        .def("simple_thinning", &Thinning<ParticleArray3d>::simple,
+            py::call_guard<py::gil_scoped_release>())
+        .def("leveling_thinning", &Thinning<ParticleArray3d>::leveling,
+            py::call_guard<py::gil_scoped_release>())
+        .def("number_conservative_thinning", &Thinning<ParticleArray3d>::numberConservative,
+            py::call_guard<py::gil_scoped_release>())
+        .def("energy_conservative_thinning", &Thinning<ParticleArray3d>::energyConservative,
+            py::call_guard<py::gil_scoped_release>())
+        .def("simple_thinning_parallel", &Thinning<ParticleArray3d>::simpleParallel,
+            py::call_guard<py::gil_scoped_release>())
+        .def("number_conservative_thinning_parallel", &Thinning<ParticleArray3d>::numberConservativeParallel,
+            py::call_guard<py::gil_scoped_release>())
+        .def("energy_conservative_thinning_parallel", &Thinning<ParticleArray3d>::energyConservativeParallel,
+            py::call_guard<py::gil_scoped_release>())
+        .def("conservative_thinning", &Thinning<ParticleArray3d>::thinningConservative,
+            py::call_guard<py::gil_scoped_release>())
+        .def("conservative_thinning_in_cells", &Thinning<ParticleArray3d>::thinningConservativeInCells,
+            py::arg("particles"), py::arg("m"), py::arg("features"), py::arg("min_coords"),
+            py::arg("cell_size"), py::arg("num_cells"), py::call_guard<py::gil_scoped_release>())
         .def("k_means_mergining", &Merging<ParticleArray3d>::merge_with_kmeans)
+        .def_static("cell_merging", &Merging<ParticleArray3d>::merge_in_cells,
+            py::arg("particles"), py::arg("min_coords"), py::arg("cell_size"), py::arg("num_cells"),
+            py::arg("num_momentum_cells"), py::arg("min_particles_to_merge") = 4,
+            py::call_guard<py::gil_scoped_release>())
+        .def_static("accelerated_k_means_merging", &Merging<ParticleArray3d>::merge_with_accelerated_kmeans,
+            py::arg("particles"), py::arg("num_clusters"), py::arg("iteration"), py::arg("tolerance") = 0.0,
+            py::call_guard<py::gil_scoped_release>())
         ; 
 
     // ------------------- mappings -------------------
 
     py::class_<Mapping, std::shared_ptr<Mapping>> pyMapping(object, "Mapping");
+    pyMapping
+        .def("get_direct_coords_array", [](Mapping* self,
+            const py::array_t<FP, py::array::c_style | py::array::forcecast>& coords, FP time) {
+            return mapCoordsArray(self, coords, time, false);
+        }, py::arg("coords"), py::arg("time") = 0.0)
+        .def("get_inverse_coords_array", [](Mapping* self,
+            const py::array_t<FP, py::array::c_style | py::array::forcecast>& coords, FP time) {
+            return mapCoordsArray(self, coords, time, true);
+        }, py::arg("coords"), py::arg("time") = 0.0)
+        ;
 
     py::class_<IdentityMapping, std::shared_ptr<IdentityMapping>>(object, "IdentityMapping", pyMapping)
         .def(py::init<const FP3&, const FP3&>(), py::arg("a"), py::arg("b"))
@@ -353,20 +616,26 @@ PYBIND11_MODULE(pyHiChi, object) {
                     sizeof(FP),                                 // Size of one scalar
                     py::format_descriptor<FP>::format(),        // Python struct-style format descriptor
                     3,                                          // Number of dimensions
-                    { sf.getSize().x, sf.getSize().y, sf.getSize().z },  // Buffer dimensions
-                    {                                                    // Strides (in bytes) for each index
-                        sizeof(FP) * sf.getSize().y * sf.getSize().z,    
-                        sizeof(FP) * sf.getSize().z,
-                        sizeof(FP)
-                    }
+                    sf.getShape(),                              // Buffer dimensions
+                    sf.getStrides()                             // Strides (in bytes) for each index
                 );
             })
+        .def("to_numpy", [](py::object self) {  // view without copying, keeps the field alive
+                pyScalarField& sf = self.cast<pyScalarField&>();
+                return py::array_t<FP>(sf.getShape(), sf.getStrides(), sf.getData(), self);
+            })
         .def("get_size", &pyScalarField::getSize)
+        .def("get_sub_array", &pyScalarField::getSubArray, py::arg("begin"), py::arg("size"))
         .def("get", static_cast<FP(pyScalarField::*)(int, int, int) const>(&pyScalarField::get))
         ;
 
     // ------------------- py fields -------------------
 
+    py::class_<pyFieldUpdateHandle>(object, "FieldUpdate")
+        .def("wait", &pyFieldUpdateHandle::wait)
+        .def("done", &pyFieldUpdateHandle::isDone)
+        ;
+
     // abstract class
     py::class_<pyFieldBase, std::shared_ptr<pyFieldBase>> pyClassFieldBase(object, "FieldBase");
     pyClassFieldBase.def("get_fields", &pyFieldBase::getFields)
@@ -418,9 +687,23 @@ PYBIND11_MODULE(pyHiChi, object) {
         .def("get_Jz", [](std::shared_ptr<pyFieldBase> self, FP x, FP y, FP z) {
                 return self->getJz(FP3(x, y, z));
             }, py::arg("x"), py::arg("y"), py::arg("z"))
+        .def("get_E", [](std::shared_ptr<pyFieldBase> self,
+            const py::array_t<FP, py::array::c_style | py::array::forcecast>& coords) {
+                return self->getFieldArray(coords, &pyFieldBase::getE);
+            }, py::arg("coords"))
+        .def("get_B", [](std::shared_ptr<pyFieldBase> self,
+            const py::array_t<FP, py::array::c_style | py::array::forcecast>& coords) {
+                return self->getFieldArray(coords, &pyFieldBase::getB);
+            }, py::arg("coords"))
+        .def("get_J", [](std::shared_ptr<pyFieldBase> self,
+            const py::array_t<FP, py::array::c_style | py::array::forcecast>& coords) {
+                return self->getFieldArray(coords, &pyFieldBase::getJ);
+            }, py::arg("coords"))
         
-        .def("update_fields", &pyFieldBase::updateFields)
-        .def("advance", &pyFieldBase::advance, py::arg("time_step"))
+        .def("update_fields", &pyFieldBase::updateFields, py::call_guard<py::gil_scoped_release>())
+        .def("advance", &pyFieldBase::advance, py::arg("time_step"),
+            py::call_guard<py::gil_scoped_release>())
+        .def("update_fields_async", &pyFieldBase::updateFieldsAsync)
 
         SET_ALL_PYFIELDBASE_SECTION_METHODS()
         ;
@@ -450,6 +733,12 @@ PYBIND11_MODULE(pyHiChi, object) {
             py::arg("Bx"), py::arg("By"), py::arg("Bz"))
         .def("set_J", &pyAnalyticalField::setJxyz,
             py::arg("Jx"), py::arg("Jy"), py::arg("Jz"))
+        .def("set_E_batch", &pyAnalyticalField::setExyzBatch,
+            py::arg("Ex"), py::arg("Ey"), py::arg("Ez"))
+        .def("set_B_batch", &pyAnalyticalField::setBxyzBatch,
+            py::arg("Bx"), py::arg("By"), py::arg("Bz"))
+        .def("set_J_batch", &pyAnalyticalField::setJxyzBatch,
+            py::arg("Jx"), py::arg("Jy"), py::arg("Jz"))
         .def("get_E", &pyAnalyticalField::getEt,
             py::arg("x"), py::arg("y"), py::arg("z"), py::arg("t"))
         .def("get_B", &pyAnalyticalField::getBt,
@@ -501,10 +790,14 @@ PYBIND11_MODULE(pyHiChi, object) {
             &pyPSTDField::setPeriodicalBoundaryCondition)
         .def("set_periodical_BC", (void (pyPSTDField::*)(CoordinateEnum))
             &pyPSTDField::setPeriodicalBoundaryCondition, py::arg("axis"))
-        .def("set", &pyPSTDField::setEMField, py::arg("func"))
+        .def("set", &pyPSTDField::setEMField, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("set", &pyPSTDField::pySetEMField, py::arg("func"))
-        .def("apply_function", &pyPSTDField::applyFunction, py::arg("func"))
+        .def("apply_function", &pyPSTDField::applyFunction, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("apply_function", &pyPSTDField::pyApplyFunction, py::arg("func"))
+        .def("set_vectorized", &pyPSTDField::pySetEMFieldVectorized, py::arg("func"))
+        .def("apply_function_vectorized", &pyPSTDField::pyApplyFunctionVectorized, py::arg("func"))
         .def("zoom", &pyPSTDField::zoom, py::arg("min_coord"), \
             py::arg("zoomed_grid_size"), py::arg("zoomed_grid_step"))
         ;
@@ -525,11 +818,16 @@ PYBIND11_MODULE(pyHiChi, object) {
         .def("set_periodical_BC", (void (pyPSATDField::*)())& pyPSATDField::setPeriodicalBoundaryCondition)
         .def("set_periodical_BC", (void (pyPSATDField::*)(CoordinateEnum))& pyPSATDField::setPeriodicalBoundaryCondition,
             py::arg("axis"))
-        .def("convert_fields_poisson_equation", &pyPSATDField::convertFieldsPoissonEquation)
-        .def("set", &pyPSATDField::setEMField, py::arg("func"))
+        .def("convert_fields_poisson_equation", &pyPSATDField::convertFieldsPoissonEquation,
+            py::call_guard<py::gil_scoped_release>())
+        .def("set", &pyPSATDField::setEMField, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("set", &pyPSATDField::pySetEMField, py::arg("func"))
-        .def("apply_function", &pyPSATDField::applyFunction, py::arg("func"))
+        .def("apply_function", &pyPSATDField::applyFunction, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("apply_function", &pyPSATDField::pyApplyFunction, py::arg("func"))
+        .def("set_vectorized", &pyPSATDField::pySetEMFieldVectorized, py::arg("func"))
+        .def("apply_function_vectorized", &pyPSATDField::pyApplyFunctionVectorized, py::arg("func"))
         .def("zoom", &pyPSATDField::zoom, py::arg("min_coord"), \
             py::arg("zoomed_grid_size"), py::arg("zoomed_grid_step"))
         ;
@@ -550,11 +848,16 @@ PYBIND11_MODULE(pyHiChi, object) {
         .def("set_periodical_BC", (void (pyPSATDPoissonField::*)())& pyPSATDPoissonField::setPeriodicalBoundaryCondition)
         .def("set_periodical_BC", (void (pyPSATDPoissonField::*)(CoordinateEnum))
             &pyPSATDPoissonField::setPeriodicalBoundaryCondition, py::arg("axis"))
-        .def("convert_fields_poisson_equation", &pyPSATDPoissonField::convertFieldsPoissonEquation)
-        .def("set", &pyPSATDPoissonField::setEMField, py::arg("func"))
+        .def("convert_fields_poisson_equation", &pyPSATDPoissonField::convertFieldsPoissonEquation,
+            py::call_guard<py::gil_scoped_release>())
+        .def("set", &pyPSATDPoissonField::setEMField, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("set", &pyPSATDPoissonField::pySetEMField, py::arg("func"))
-        .def("apply_function", &pyPSATDPoissonField::applyFunction, py::arg("func"))
+        .def("apply_function", &pyPSATDPoissonField::applyFunction, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("apply_function", &pyPSATDPoissonField::pyApplyFunction, py::arg("func"))
+        .def("set_vectorized", &pyPSATDPoissonField::pySetEMFieldVectorized, py::arg("func"))
+        .def("apply_function_vectorized", &pyPSATDPoissonField::pyApplyFunctionVectorized, py::arg("func"))
         .def("zoom", &pyPSATDPoissonField::zoom, py::arg("min_coord"), \
             py::arg("zoomed_grid_size"), py::arg("zoomed_grid_step"))
         ;
@@ -576,11 +879,16 @@ PYBIND11_MODULE(pyHiChi, object) {
             &pyPSATDTimeStaggeredField::setPeriodicalBoundaryCondition)
         .def("set_periodical_BC", (void (pyPSATDTimeStaggeredField::*)(CoordinateEnum))
             &pyPSATDTimeStaggeredField::setPeriodicalBoundaryCondition, py::arg("axis"))
-        .def("convert_fields_poisson_equation", &pyPSATDTimeStaggeredField::convertFieldsPoissonEquation)
-        .def("set", &pyPSATDTimeStaggeredField::setEMField, py::arg("func"))
+        .def("convert_fields_poisson_equation", &pyPSATDTimeStaggeredField::convertFieldsPoissonEquation,
+            py::call_guard<py::gil_scoped_release>())
+        .def("set", &pyPSATDTimeStaggeredField::setEMField, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("set", &pyPSATDTimeStaggeredField::pySetEMField, py::arg("func"))
-        .def("apply_function", &pyPSATDTimeStaggeredField::applyFunction, py::arg("func"))
+        .def("apply_function", &pyPSATDTimeStaggeredField::applyFunction, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("apply_function", &pyPSATDTimeStaggeredField::pyApplyFunction, py::arg("func"))
+        .def("set_vectorized", &pyPSATDTimeStaggeredField::pySetEMFieldVectorized, py::arg("func"))
+        .def("apply_function_vectorized", &pyPSATDTimeStaggeredField::pyApplyFunctionVectorized, py::arg("func"))
         .def("zoom", &pyPSATDTimeStaggeredField::zoom, py::arg("min_coord"), \
             py::arg("zoomed_grid_size"), py::arg("zoomed_grid_step"))
         ;
@@ -602,11 +910,16 @@ PYBIND11_MODULE(pyHiChi, object) {
             &pyPSATDTimeStaggeredPoissonField::setPeriodicalBoundaryCondition)
         .def("set_periodical_BC", (void (pyPSATDTimeStaggeredPoissonField::*)(CoordinateEnum))
             &pyPSATDTimeStaggeredPoissonField::setPeriodicalBoundaryCondition, py::arg("axis"))
-        .def("convert_fields_poisson_equation", &pyPSATDTimeStaggeredPoissonField::convertFieldsPoissonEquation)
-        .def("set", &pyPSATDTimeStaggeredPoissonField::setEMField, py::arg("func"))
+        .def("convert_fields_poisson_equation", &pyPSATDTimeStaggeredPoissonField::convertFieldsPoissonEquation,
+            py::call_guard<py::gil_scoped_release>())
+        .def("set", &pyPSATDTimeStaggeredPoissonField::setEMField, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("set", &pyPSATDTimeStaggeredPoissonField::pySetEMField, py::arg("func"))
-        .def("apply_function", &pyPSATDTimeStaggeredPoissonField::applyFunction, py::arg("func"))
+        .def("apply_function", &pyPSATDTimeStaggeredPoissonField::applyFunction, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("apply_function", &pyPSATDTimeStaggeredPoissonField::pyApplyFunction, py::arg("func"))
+        .def("set_vectorized", &pyPSATDTimeStaggeredPoissonField::pySetEMFieldVectorized, py::arg("func"))
+        .def("apply_function_vectorized", &pyPSATDTimeStaggeredPoissonField::pyApplyFunctionVectorized, py::arg("func"))
         .def("zoom", &pyPSATDTimeStaggeredPoissonField::zoom, py::arg("min_coord"), \
             py::arg("zoomed_grid_size"), py::arg("zoomed_grid_step"))
         ;
@@ -643,10 +956,14 @@ PYBIND11_MODULE(pyHiChi, object) {
         SET_COMPUTATIONAL_GRID_METHODS(pyMappedPSTDField)
         SET_SUM_AND_MAP_FIELD_METHODS(pyMappedPSTDField)
         SET_COMMON_FIELD_METHODS(pyMappedPSTDField)
-        .def("set", &pyMappedPSTDField::setEMField, py::arg("func"))
+        .def("set", &pyMappedPSTDField::setEMField, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("set", &pyMappedPSTDField::pySetEMField, py::arg("func"))
-        .def("apply_function", &pyMappedPSTDField::applyFunction, py::arg("func"))
+        .def("apply_function", &pyMappedPSTDField::applyFunction, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("apply_function", &pyMappedPSTDField::pyApplyFunction, py::arg("func"))
+        .def("set_vectorized", &pyMappedPSTDField::pySetEMFieldVectorized, py::arg("func"))
+        .def("apply_function_vectorized", &pyMappedPSTDField::pyApplyFunctionVectorized, py::arg("func"))
         ;
 
     py::class_<pyMappedPSATDField, std::shared_ptr<pyMappedPSATDField>>(
@@ -654,11 +971,16 @@ PYBIND11_MODULE(pyHiChi, object) {
         SET_COMPUTATIONAL_GRID_METHODS(pyMappedPSATDField)
         SET_SUM_AND_MAP_FIELD_METHODS(pyMappedPSATDField)
         SET_COMMON_FIELD_METHODS(pyMappedPSATDField)
-        .def("convert_fields_poisson_equation", &pyMappedPSATDField::convertFieldsPoissonEquation)
-        .def("set", &pyMappedPSATDField::setEMField, py::arg("func"))
+        .def("convert_fields_poisson_equation", &pyMappedPSATDField::convertFieldsPoissonEquation,
+            py::call_guard<py::gil_scoped_release>())
+        .def("set", &pyMappedPSATDField::setEMField, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("set", &pyMappedPSATDField::pySetEMField, py::arg("func"))
-        .def("apply_function", &pyMappedPSATDField::applyFunction, py::arg("func"))
+        .def("apply_function", &pyMappedPSATDField::applyFunction, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("apply_function", &pyMappedPSATDField::pyApplyFunction, py::arg("func"))
+        .def("set_vectorized", &pyMappedPSATDField::pySetEMFieldVectorized, py::arg("func"))
+        .def("apply_function_vectorized", &pyMappedPSATDField::pyApplyFunctionVectorized, py::arg("func"))
         ;
 
     py::class_<pyMappedPSATDPoissonField, std::shared_ptr<pyMappedPSATDPoissonField>>(
@@ -666,11 +988,16 @@ PYBIND11_MODULE(pyHiChi, object) {
         SET_COMPUTATIONAL_GRID_METHODS(pyMappedPSATDPoissonField)
         SET_SUM_AND_MAP_FIELD_METHODS(pyMappedPSATDPoissonField)
         SET_COMMON_FIELD_METHODS(pyMappedPSATDPoissonField)
-        .def("convert_fields_poisson_equation", &pyMappedPSATDPoissonField::convertFieldsPoissonEquation)
-        .def("set", &pyMappedPSATDPoissonField::setEMField, py::arg("func"))
+        .def("convert_fields_poisson_equation", &pyMappedPSATDPoissonField::convertFieldsPoissonEquation,
+            py::call_guard<py::gil_scoped_release>())
+        .def("set", &pyMappedPSATDPoissonField::setEMField, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("set", &pyMappedPSATDPoissonField::pySetEMField, py::arg("func"))
-        .def("apply_function", &pyMappedPSATDPoissonField::applyFunction, py::arg("func"))
+        .def("apply_function", &pyMappedPSATDPoissonField::applyFunction, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("apply_function", &pyMappedPSATDPoissonField::pyApplyFunction, py::arg("func"))
+        .def("set_vectorized", &pyMappedPSATDPoissonField::pySetEMFieldVectorized, py::arg("func"))
+        .def("apply_function_vectorized", &pyMappedPSATDPoissonField::pyApplyFunctionVectorized, py::arg("func"))
         ;
 
     py::class_<pyMappedPSATDTimeStaggeredField, std::shared_ptr<pyMappedPSATDTimeStaggeredField>>(
@@ -678,11 +1005,16 @@ PYBIND11_MODULE(pyHiChi, object) {
         SET_COMPUTATIONAL_GRID_METHODS(pyMappedPSATDTimeStaggeredField)
         SET_SUM_AND_MAP_FIELD_METHODS(pyMappedPSATDTimeStaggeredField)
         SET_COMMON_FIELD_METHODS(pyMappedPSATDTimeStaggeredField)
-        .def("convert_fields_poisson_equation", &pyMappedPSATDTimeStaggeredField::convertFieldsPoissonEquation)
-        .def("set", &pyMappedPSATDTimeStaggeredField::setEMField, py::arg("func"))
+        .def("convert_fields_poisson_equation", &pyMappedPSATDTimeStaggeredField::convertFieldsPoissonEquation,
+            py::call_guard<py::gil_scoped_release>())
+        .def("set", &pyMappedPSATDTimeStaggeredField::setEMField, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("set", &pyMappedPSATDTimeStaggeredField::pySetEMField, py::arg("func"))
-        .def("apply_function", &pyMappedPSATDTimeStaggeredField::applyFunction, py::arg("func"))
+        .def("apply_function", &pyMappedPSATDTimeStaggeredField::applyFunction, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("apply_function", &pyMappedPSATDTimeStaggeredField::pyApplyFunction, py::arg("func"))
+        .def("set_vectorized", &pyMappedPSATDTimeStaggeredField::pySetEMFieldVectorized, py::arg("func"))
+        .def("apply_function_vectorized", &pyMappedPSATDTimeStaggeredField::pyApplyFunctionVectorized, py::arg("func"))
         ;
 
     py::class_<pyMappedPSATDTimeStaggeredPoissonField, std::shared_ptr<pyMappedPSATDTimeStaggeredPoissonField>>(
@@ -690,11 +1022,31 @@ PYBIND11_MODULE(pyHiChi, object) {
         SET_COMPUTATIONAL_GRID_METHODS(pyMappedPSATDTimeStaggeredPoissonField)
         SET_SUM_AND_MAP_FIELD_METHODS(pyMappedPSATDTimeStaggeredPoissonField)
         SET_COMMON_FIELD_METHODS(pyMappedPSATDTimeStaggeredPoissonField)
-        .def("convert_fields_poisson_equation", &pyMappedPSATDTimeStaggeredPoissonField::convertFieldsPoissonEquation)
-        .def("set", &pyMappedPSATDTimeStaggeredPoissonField::setEMField, py::arg("func"))
+        .def("convert_fields_poisson_equation", &pyMappedPSATDTimeStaggeredPoissonField::convertFieldsPoissonEquation,
+            py::call_guard<py::gil_scoped_release>())
+        .def("set", &pyMappedPSATDTimeStaggeredPoissonField::setEMField, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("set", &pyMappedPSATDTimeStaggeredPoissonField::pySetEMField, py::arg("func"))
-        .def("apply_function", &pyMappedPSATDTimeStaggeredPoissonField::applyFunction, py::arg("func"))
+        .def("apply_function", &pyMappedPSATDTimeStaggeredPoissonField::applyFunction, py::arg("func"),
+            py::call_guard<py::gil_scoped_release>())
         .def("apply_function", &pyMappedPSATDTimeStaggeredPoissonField::pyApplyFunction, py::arg("func"))
+        .def("set_vectorized", &pyMappedPSATDTimeStaggeredPoissonField::pySetEMFieldVectorized, py::arg("func"))
+        .def("apply_function_vectorized", &pyMappedPSATDTimeStaggeredPoissonField::pyApplyFunctionVectorized, py::arg("func"))
+        ;
+
+    // ------------------- field diagnostics -------------------
+
+    py::class_<pyFieldWriter, std::shared_ptr<pyFieldWriter>>(object, "FieldWriter")
+        .def(py::init<const std::shared_ptr<pyFieldBase>&, const FP3&, const FP3&, const FP3&,
+            const std::vector<std::string>&, const std::string&, const std::string&>(),
+            py::arg("field"), py::arg("min_coords"), py::arg("max_coords"), py::arg("size"),
+            py::arg("components"), py::arg("path"), py::arg("format") = "npy")
+        .def("write", &pyFieldWriter::write, py::arg("time") = 0.0,
+            py::call_guard<py::gil_scoped_release>())
+        .def("close", &pyFieldWriter::close, py::call_guard<py::gil_scoped_release>())
+        .def("get_num_frames", &pyFieldWriter::getNumFrames)
+        .def("__enter__", [](std::shared_ptr<pyFieldWriter> self) { return self; })
+        .def("__exit__", [](pyFieldWriter& self, py::args) { self.close(); })
         ;
 
     // ------------------- field configurations -------------------